@@ -1,10 +1,27 @@
 #include "pch.h"
 #include "Application.h"
 
+#include "BindlessDescriptorHeap.h"
 #include "Game.h"
 #include "CommandQueue.h"
+#include "DescriptorAllocator.h"
+#include "DynamicDescriptorHeap.h"
+#include "FrameContext.h"
+#include "FramePipeline.h"
+#include "FrameScheduler.h"
+#include "Hash.h"
+#include "PipelineStateCache.h"
+#include "PipelineStateCompiler.h"
+#include "Profiler.h"
+#include "QueueDependencyTracker.h"
+#include "RootSignatureCache.h"
+#include "ResourceHeapAllocator.h"
+#include "ThreadPool.h"
+#include "UploadBuffer.h"
 #include "Window.h"
 
+#include <vector>
+
 constexpr wchar_t WINDOW_CLASS_NAME[] = L"DX12RenderWindowClass";
 
 using WindowPtr = std::shared_ptr<Window>;
@@ -19,13 +36,15 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
 
 struct MakeWindow : public Window
 {
-	MakeWindow(HWND hwnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync)
-		: Window(hwnd, windowName, clientWidth, clientHeight, vSync)
+	MakeWindow(HWND hwnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync, UINT bufferCount)
+		: Window(hwnd, windowName, clientWidth, clientHeight, vSync, bufferCount)
 	{}
 };
 
-Application::Application(HINSTANCE hInst)
+Application::Application(HINSTANCE hInst, uint32_t frameCount)
 	: mHinstance(hInst)
+	, mFrameCount(std::max(frameCount, 1u))
+	, mRenderThreadEvent(nullptr)
 	, mTearingSupported(false)
 {
 	SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
@@ -61,19 +80,66 @@ Application::Application(HINSTANCE hInst)
 	}
 	if (mDevice)
 	{
-		mDirectCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_DIRECT);
-		mComputeCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_COMPUTE);
-		mCopyCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_COPY);
+		mThreadPool = std::make_shared<ThreadPool>();
+		mResourceAllocator = std::make_unique<ResourceHeapAllocator>(mDevice);
+		for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+		{
+			mDescriptorAllocators[i] = std::make_unique<DescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
+		}
+
+		// Only one shader-visible heap of each type can be bound at a time, so
+		// the bindless table and the descriptor ring share one.
+		const UINT numBindlessDescriptors = 64 * 1024;
+		const UINT numRingDescriptors = 64 * 1024;
+		const UINT numFrameDescriptors = 4 * 1024;
+		auto cbvSrvUavHeap = CreateDescriptorHeap(numBindlessDescriptors + numRingDescriptors + mFrameCount * numFrameDescriptors,
+			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+		auto samplerHeap = CreateDescriptorHeap(D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE,
+			D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+
+		mBindlessDescriptorHeap = std::make_unique<BindlessDescriptorHeap>(mDevice, cbvSrvUavHeap, 0, numBindlessDescriptors);
+
+		mDirectCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_DIRECT, mThreadPool);
+		mComputeCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_COMPUTE, mThreadPool);
+		mCopyCommandQueue = std::make_shared<CommandQueue>(mDevice, D3D12_COMMAND_LIST_TYPE_COPY, mThreadPool);
+
+		mDependencyTracker = std::make_unique<QueueDependencyTracker>();
+		mUploadBuffer = std::make_unique<UploadBuffer>(mDevice, mCopyCommandQueue->GetFence());
+
+		mDescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = std::make_unique<DescriptorRing>(mDevice,
+			cbvSrvUavHeap, numBindlessDescriptors, numRingDescriptors, mDirectCommandQueue->GetFence());
+		mDescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER] = std::make_unique<DescriptorRing>(mDevice,
+			samplerHeap, 0, D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE, mDirectCommandQueue->GetFence());
+		mFrameContextManager = std::make_unique<FrameContextManager>(mDevice, mDirectCommandQueue, mFrameCount,
+			cbvSrvUavHeap, numBindlessDescriptors + numRingDescriptors, numFrameDescriptors);
+		mFrameScheduler = std::make_unique<FrameScheduler>();
+		mFramePipeline = std::make_unique<FramePipeline>();
+		mFrameWindows.resize(mFramePipeline->GetDepth());
+		mRenderThreadEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+		assert(mRenderThreadEvent && "Failed to create render thread event handle.");
+
+		// Cached pipelines and root signatures are only valid for the GPU and
+		// driver that created them.
+		DXGI_ADAPTER_DESC1 adapterDesc = {};
+		ThrowIfFailed(mAdapter->GetDesc1(&adapterDesc));
+		LARGE_INTEGER driverVersion = {};
+		mAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+		uint64_t pipelineCacheVersion = HashCombine(HashOffsetBasis, adapterDesc.VendorId);
+		pipelineCacheVersion = HashCombine(pipelineCacheVersion, adapterDesc.DeviceId);
+		pipelineCacheVersion = HashCombine(pipelineCacheVersion, driverVersion.QuadPart);
+		mRootSignatureCache = std::make_unique<RootSignatureCache>(mDevice, L"RootSignatureCache.bin", pipelineCacheVersion);
+		mPipelineStateCache = std::make_unique<PipelineStateCache>(mDevice, L"PipelineStateCache.bin", pipelineCacheVersion);
+		mPipelineStateCompiler = std::make_unique<PipelineStateCompiler>(*mPipelineStateCache, mThreadPool);
 
 		mTearingSupported = CheckTearingSupport();
 	}
 }
 
-void Application::Create(HINSTANCE hInst)
+void Application::Create(HINSTANCE hInst, uint32_t frameCount)
 {
 	if (!gSingleton)
 	{
-		gSingleton = new Application(hInst);
+		gSingleton = new Application(hInst, frameCount);
 	}
 }
 
@@ -97,7 +163,13 @@ void Application::Destroy()
 
 Application::~Application()
 {
+	StopRenderThread();
 	Flush();
+
+	if (mRenderThreadEvent)
+	{
+		::CloseHandle(mRenderThreadEvent);
+	}
 }
 
 Microsoft::WRL::ComPtr<IDXGIAdapter4> Application::GetAdapter(bool bUseWarp)
@@ -232,7 +304,9 @@ std::shared_ptr<Window> Application::CreateRenderWindow(const std::wstring& wind
 		return nullptr;
 	}
 
-	WindowPtr pWindow = std::make_shared<MakeWindow>(hWnd, windowName, clientWidth, clientHeight, vSync);
+	// A frame in flight keeps its back buffer until it is presented.
+	UINT bufferCount = std::max(mFrameCount, 2u);
+	WindowPtr pWindow = std::make_shared<MakeWindow>(hWnd, windowName, clientWidth, clientHeight, vSync, bufferCount);
 
 	gWindows.insert(WindowMap::value_type(hWnd, pWindow));
 	gWindowByName.insert(WindowNameMap::value_type(windowName, pWindow));
@@ -269,28 +343,196 @@ std::shared_ptr<Window> Application::GetWindowByName(const std::wstring& windowN
 
 int Application::Run(std::shared_ptr<Game> pGame)
 {
+	Profiler::SetThreadName("Main");
+
 	if (!pGame->Initialize()) return 1;
-	if (!pGame->LoadContent()) return 2;
+	{
+		PROFILE_SCOPE("LoadContent");
+		if (!pGame->LoadContent()) return 2;
+	}
+
+	// Wakes the loop up when the next frame is due. High resolution timers
+	// are accurate to well below a millisecond but need Windows 10 1803.
+	HANDLE frameTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!frameTimer)
+	{
+		frameTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+
+	// Occlusion ends without a message, so occluded windows are polled.
+	const DWORD occludedPollMilliseconds = 100;
+
+	mRenderThread = std::thread(&Application::RenderThread, this);
 
 	MSG msg = { 0 };
+	bool idle = false;
 	while (msg.message != WM_QUIT)
 	{
-		if (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			PROFILE_SCOPE("Messages");
+			while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE) && msg.message != WM_QUIT)
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+		}
+		if (msg.message == WM_QUIT || mFramePipeline->IsStopped())
+		{
+			break;
+		}
+
+		// Minimized windows are not drawn. Occluded windows are only checked
+		// by the render thread until they can be seen again.
+		std::vector<WindowPtr> windows;
+		bool visible = false;
+		for (auto& window : gWindows)
+		{
+			if (!window.second->IsMinimized())
+			{
+				visible = visible || !window.second->IsOccluded();
+				windows.push_back(window.second);
+			}
+		}
+
+		if (!visible)
+		{
+			// Nothing to draw. Sleep until a message arrives, or poll the
+			// occluded windows with a frame every now and then.
+			DWORD result = MsgWaitForMultipleObjectsEx(1, &mRenderThreadEvent, windows.empty() ? INFINITE : occludedPollMilliseconds,
+				QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+			idle = true;
+			if (windows.empty() || result != WAIT_TIMEOUT)
+			{
+				continue;
+			}
+			mFrameScheduler->Reset();
+		}
+		else if (idle)
+		{
+			// Don't count the idle time as missed frames.
+			mFrameScheduler->Reset();
+			idle = false;
+		}
+
+		FrameScheduler::Duration timeUntilNextFrame = mFrameScheduler->GetTimeUntilNextFrame();
+		if (timeUntilNextFrame.count() > 0)
+		{
+			// Relative due times are negative, in 100 nanosecond units.
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -std::max<LONGLONG>(timeUntilNextFrame.count() / 100, 1);
+			SetWaitableTimer(frameTimer, &dueTime, 0, nullptr, nullptr, FALSE);
+
+			// Messages that arrive in the meantime are handled right away.
+			HANDLE handles[] = { frameTimer, mRenderThreadEvent };
+			MsgWaitForMultipleObjectsEx(_countof(handles), handles, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+			continue;
+		}
+
+		// Update the frame while the render thread draws the last one. When it
+		// falls behind by the whole pipeline, wait for it to free a slot.
+		if (!UpdateFrame(windows))
+		{
+			MsgWaitForMultipleObjectsEx(1, &mRenderThreadEvent, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
 		}
 	}
 
+	CloseHandle(frameTimer);
+
+	StopRenderThread();
+
 	// Flush any commands in the commands queues before quiting.
 	Flush();
 
 	pGame->UnloadContent();
 	pGame->Destroy();
 
+	if (mRenderThreadException)
+	{
+		std::rethrow_exception(mRenderThreadException);
+	}
+
 	return static_cast<int>(msg.wParam);
 }
 
+bool Application::UpdateFrame(const std::vector<WindowPtr>& windows)
+{
+	PROFILE_FUNCTION();
+
+	uint32_t slot = mFramePipeline->TryBeginUpdate();
+	if (slot == FramePipeline::InvalidSlot)
+	{
+		return false;
+	}
+
+	mFrameScheduler->BeginFrame();
+	for (auto& window : windows)
+	{
+		// Delta time will be filled in by the Window.
+		UpdateEventArgs updateEventArgs(0.0f, 0.0f, slot);
+		window->OnUpdate(updateEventArgs);
+	}
+	mFrameWindows[slot] = windows;
+
+	mFramePipeline->EndUpdate();
+
+	return true;
+}
+
+void Application::RenderThread()
+{
+	Profiler::SetThreadName("Render");
+
+	try
+	{
+		for (;;)
+		{
+			uint32_t slot = mFramePipeline->BeginRender();
+			if (slot == FramePipeline::InvalidSlot)
+			{
+				break;
+			}
+
+			{
+				PROFILE_SCOPE("RenderFrame");
+				for (auto& window : mFrameWindows[slot])
+				{
+					// Delta time will be filled in by the Window.
+					RenderEventArgs renderEventArgs(0.0f, 0.0f, slot);
+					window->OnRender(renderEventArgs);
+				}
+				mFrameWindows[slot].clear();
+			}
+
+			mFramePipeline->EndRender();
+			::SetEvent(mRenderThreadEvent);
+
+			// Collect the zones of all threads once per rendered frame.
+			Profiler::EndFrame();
+		}
+	}
+	catch (...)
+	{
+		// Run stops and throws it again.
+		mRenderThreadException = std::current_exception();
+		mFramePipeline->Stop();
+		::SetEvent(mRenderThreadEvent);
+	}
+}
+
+void Application::StopRenderThread()
+{
+	if (mRenderThread.joinable())
+	{
+		mFramePipeline->Stop();
+		mRenderThread.join();
+	}
+
+	for (auto& windows : mFrameWindows)
+	{
+		windows.clear();
+	}
+}
+
 void Application::Quit(int exitCode)
 {
 	PostQuitMessage(exitCode);
@@ -322,6 +564,77 @@ std::shared_ptr<CommandQueue> Application::GetCommandQueue(D3D12_COMMAND_LIST_TY
 	return commandQueue;
 }
 
+std::shared_ptr<ThreadPool> Application::GetThreadPool() const
+{
+	return mThreadPool;
+}
+
+QueueDependencyTracker& Application::GetDependencyTracker()
+{
+	return *mDependencyTracker;
+}
+
+UploadBuffer& Application::GetUploadBuffer()
+{
+	return *mUploadBuffer;
+}
+
+ResourceHeapAllocator& Application::GetResourceAllocator()
+{
+	return *mResourceAllocator;
+}
+
+DescriptorAllocator& Application::GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+	return *mDescriptorAllocators[type];
+}
+
+BindlessDescriptorHeap& Application::GetBindlessDescriptorHeap()
+{
+	return *mBindlessDescriptorHeap;
+}
+
+RootSignatureCache& Application::GetRootSignatureCache()
+{
+	return *mRootSignatureCache;
+}
+
+PipelineStateCache& Application::GetPipelineStateCache()
+{
+	return *mPipelineStateCache;
+}
+
+PipelineStateCompiler& Application::GetPipelineStateCompiler()
+{
+	return *mPipelineStateCompiler;
+}
+
+DescriptorRing& Application::GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+	assert(type <= D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER && mDescriptorRings[type] && "Invalid descriptor ring type.");
+	return *mDescriptorRings[type];
+}
+
+FrameContextManager& Application::GetFrameContextManager()
+{
+	return *mFrameContextManager;
+}
+
+uint32_t Application::GetFrameCount() const
+{
+	return mFrameCount;
+}
+
+FrameScheduler& Application::GetFrameScheduler()
+{
+	return *mFrameScheduler;
+}
+
+FramePipeline& Application::GetFramePipeline()
+{
+	return *mFramePipeline;
+}
+
 void Application::Flush()
 {
 	mDirectCommandQueue->Flush();
@@ -329,12 +642,13 @@ void Application::Flush()
 	mCopyCommandQueue->Flush();
 }
 
-Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type)
+Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type,
+	D3D12_DESCRIPTOR_HEAP_FLAGS flags)
 {
 	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
 	desc.Type = type;
 	desc.NumDescriptors = numDescriptors;
-	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	desc.Flags = flags;
 	desc.NodeMask = 0;
 
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
@@ -410,12 +724,15 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
 		{
 		case WM_PAINT:
 		{
-			// Delta time will be filled in by the Window.
-			UpdateEventArgs updateEventArgs(0.0f, 0.0f);
-			pWindow->OnUpdate(updateEventArgs);
-			RenderEventArgs renderEventArgs(0.0f, 0.0f);
-			// Delta time will be filled in by the Window.
-			pWindow->OnRender(renderEventArgs);
+			// Frames are updated by Application::Run. Windows only asks for a
+			// paint when the window needs redrawing, e.g. while it runs its
+			// own message loop during a resize. The render thread keeps
+			// drawing whatever frames it is given.
+			if (!pWindow->IsMinimized())
+			{
+				Application::Get().UpdateFrame({ pWindow });
+			}
+			::ValidateRect(hwnd, nullptr);
 		}
 		break;
 		case WM_SYSKEYDOWN:
@@ -560,6 +877,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
 		{
 			// If a window is being destroyed, remove it from the 
 			// window maps.
+			pWindow->StopRendering();
 			RemoveWindow(hwnd);
 
 			if (gWindows.empty())
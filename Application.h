@@ -4,12 +4,29 @@
 #include <dxgi1_6.h>
 #include <wrl.h>
 
+#include <cstdint>
+#include <exception>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 class Window;
 class Game;
 class CommandQueue;
+class ThreadPool;
+class QueueDependencyTracker;
+class UploadBuffer;
+class ResourceHeapAllocator;
+class DescriptorAllocator;
+class DescriptorRing;
+class FrameContextManager;
+class FrameScheduler;
+class FramePipeline;
+class BindlessDescriptorHeap;
+class RootSignatureCache;
+class PipelineStateCache;
+class PipelineStateCompiler;
 
 using Microsoft::WRL::ComPtr;
 
@@ -17,7 +34,8 @@ class Application
 {
 public:
 
-	static void Create(HINSTANCE hInst);
+	// frameCount is the number of frames that can be in flight at once.
+	static void Create(HINSTANCE hInst, uint32_t frameCount = 3);
 
 	static void Destroy();
 	static Application& Get();
@@ -31,40 +49,121 @@ public:
 
 	std::shared_ptr<Window> GetWindowByName(const std::wstring& windowName);
 
+	// Handle window messages and update the windows at the pace of the frame
+	// scheduler until the application quits. The frames are rendered on a
+	// separate render thread, overlapping the update of the next frame.
 	int Run(std::shared_ptr<Game> pGame);
 
+	// Update the windows and hand the frame to the render thread. Returns
+	// false, without updating, if the render thread already has as many
+	// frames as the frame pipeline holds.
+	bool UpdateFrame(const std::vector<std::shared_ptr<Window>>& windows);
+
 	void Quit(int exitCode = 0);
 
 	ComPtr<ID3D12Device2> GetDevice() const;
 	std::shared_ptr<CommandQueue> GetCommandQueue(D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT) const;
 
+	// Worker threads for background jobs and for resuming coroutines that
+	// are waiting on a command queue fence.
+	std::shared_ptr<ThreadPool> GetThreadPool() const;
+
+	// Tracks resource accesses across the direct, compute and copy queues
+	// so they can synchronize with each other on the GPU.
+	QueueDependencyTracker& GetDependencyTracker();
+
+	// Staging memory for uploads executed on the copy queue. Retire the
+	// allocations with the copy queue fence value after submitting.
+	UploadBuffer& GetUploadBuffer();
+
+	// Creates default heap buffers and textures as placed resources.
+	ResourceHeapAllocator& GetResourceAllocator();
+
+	// Allocates CPU descriptors of the given type from shared heap pages.
+	DescriptorAllocator& GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type);
+
+	// Shader-visible descriptors for command lists executed on the direct
+	// queue. Only CBV_SRV_UAV and SAMPLER are valid types.
+	DescriptorRing& GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE type);
+
+	// Shader-indexed CBV/SRV/UAV descriptors. Shares its heap with the
+	// CBV_SRV_UAV descriptor ring, so both can be bound at the same time.
+	BindlessDescriptorHeap& GetBindlessDescriptorHeap();
+
+	// Shares root signatures with identical layouts and keeps them on disk between runs.
+	RootSignatureCache& GetRootSignatureCache();
+	// Creates pipeline state objects and keeps them on disk between runs.
+	PipelineStateCache& GetPipelineStateCache();
+	// Compiles pipeline state objects through the cache on the thread pool.
+	PipelineStateCompiler& GetPipelineStateCompiler();
+
+	// Memory for the frames in flight, recycled once the GPU has finished them.
+	FrameContextManager& GetFrameContextManager();
+	uint32_t GetFrameCount() const;
+	// Paces the frames of Run. Unlimited by default.
+	FrameScheduler& GetFrameScheduler();
+	// Hands the updated frames to the render thread.
+	FramePipeline& GetFramePipeline();
+
 	void Flush();
 
-	ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type);
+	ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type,
+		D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
 	UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const;
 
 protected:
 
-	Application(HINSTANCE hInst);
+	Application(HINSTANCE hInst, uint32_t frameCount);
 	virtual ~Application();
 
 	ComPtr<IDXGIAdapter4> GetAdapter(bool bUseWarp);
 	ComPtr<ID3D12Device2> CreateDevice(ComPtr<IDXGIAdapter4> adapter);
 	bool CheckTearingSupport();
 
+	void RenderThread();
+	// Stop the render thread and wait for it to finish its frame.
+	void StopRenderThread();
+
 private:
 	Application(const Application& copy) = delete;
 	Application& operator=(const Application& other) = delete;
 
 	// The application instance handle that this application was created with.
 	HINSTANCE mHinstance;
+	uint32_t mFrameCount;
 
 	ComPtr<IDXGIAdapter4> mAdapter;
 	ComPtr<ID3D12Device2> mDevice;
 
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	// Declared before the command queues so they outlive any fence callbacks
+	// that release resources and descriptors into them.
+	std::unique_ptr<ResourceHeapAllocator> mResourceAllocator;
+	std::unique_ptr<DescriptorAllocator> mDescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	std::unique_ptr<BindlessDescriptorHeap> mBindlessDescriptorHeap;
+
 	std::shared_ptr<CommandQueue> mDirectCommandQueue;
 	std::shared_ptr<CommandQueue> mComputeCommandQueue;
 	std::shared_ptr<CommandQueue> mCopyCommandQueue;
 
+	std::unique_ptr<QueueDependencyTracker> mDependencyTracker;
+	std::unique_ptr<UploadBuffer> mUploadBuffer;
+	std::unique_ptr<DescriptorRing> mDescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER + 1];
+	std::unique_ptr<FrameContextManager> mFrameContextManager;
+	std::unique_ptr<FrameScheduler> mFrameScheduler;
+
+	std::unique_ptr<FramePipeline> mFramePipeline;
+	// The windows to render, for each slot of the frame pipeline.
+	std::vector<std::vector<std::shared_ptr<Window>>> mFrameWindows;
+	std::thread mRenderThread;
+	// Signaled by the render thread whenever it frees a slot or stops.
+	HANDLE mRenderThreadEvent;
+	// Thrown again by Run once the render thread has stopped.
+	std::exception_ptr mRenderThreadException;
+	std::unique_ptr<RootSignatureCache> mRootSignatureCache;
+	std::unique_ptr<PipelineStateCache> mPipelineStateCache;
+	std::unique_ptr<PipelineStateCompiler> mPipelineStateCompiler;
+
 	bool mTearingSupported;
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "BindlessDescriptorHeap.h"
+
+#include "CommandQueue.h"
+
+BindlessDescriptorHeap::BindlessDescriptorHeap(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> heap,
+	uint32_t firstDescriptor, uint32_t numDescriptors)
+	: mDevice(device)
+	, mDescriptorHeap(heap)
+	, mHandleAllocator(numDescriptors)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = mDescriptorHeap->GetDesc();
+	assert(heapDesc.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV &&
+		(heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) &&
+		firstDescriptor + numDescriptors <= heapDesc.NumDescriptors);
+
+	mDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mCPUBase = CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+	mGPUBase = CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+}
+
+BindlessDescriptorHeap::~BindlessDescriptorHeap()
+{
+}
+
+BindlessDescriptorHeap::Handle BindlessDescriptorHeap::Allocate()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mHandleAllocator.Allocate();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetCPUDescriptorHandle(Handle handle) const
+{
+	assert(IsValid(handle) && "Stale or invalid bindless handle.");
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mCPUBase, HandleAllocator::GetIndex(handle), mDescriptorSize);
+}
+
+void BindlessDescriptorHeap::CreateShaderResourceView(Handle handle, ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+	mDevice->CreateShaderResourceView(resource, desc, GetCPUDescriptorHandle(handle));
+}
+
+void BindlessDescriptorHeap::CreateUnorderedAccessView(Handle handle, ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc)
+{
+	mDevice->CreateUnorderedAccessView(resource, nullptr, desc, GetCPUDescriptorHandle(handle));
+}
+
+void BindlessDescriptorHeap::CreateConstantBufferView(Handle handle, const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc)
+{
+	mDevice->CreateConstantBufferView(desc, GetCPUDescriptorHandle(handle));
+}
+
+void BindlessDescriptorHeap::CopyDescriptor(Handle handle, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+	mDevice->CopyDescriptorsSimple(1, GetCPUDescriptorHandle(handle), srcDescriptor,
+		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+void BindlessDescriptorHeap::Free(Handle handle, CommandQueue& commandQueue)
+{
+	assert(IsValid(handle) && "Stale or invalid bindless handle.");
+
+	commandQueue.AddFenceCallback(commandQueue.GetLastSignaledFenceValue(), [this, handle]()
+	{
+		Free(handle);
+	});
+}
+
+void BindlessDescriptorHeap::Free(Handle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	bool freed = mHandleAllocator.Free(handle);
+	assert(freed && "Stale or invalid bindless handle.");
+	(void)freed;
+}
+
+bool BindlessDescriptorHeap::IsValid(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mHandleAllocator.IsValid(handle);
+}
+
+ID3D12DescriptorHeap* BindlessDescriptorHeap::GetDescriptorHeap() const
+{
+	return mDescriptorHeap.Get();
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetGPUDescriptorTable() const
+{
+	return mGPUBase;
+}
+
+uint32_t BindlessDescriptorHeap::GetCapacity() const
+{
+	return mHandleAllocator.GetCapacity();
+}
+
+uint32_t BindlessDescriptorHeap::GetAllocatedCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mHandleAllocator.GetAllocatedCount();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "HandleAllocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+
+using Microsoft::WRL::ComPtr;
+
+class CommandQueue;
+
+// A table of CBV/SRV/UAV descriptors in a shader-visible heap that shaders
+// index directly.
+// Each descriptor is identified by a 32-bit HandleAllocator handle that is
+// passed to shaders as a root constant, so binding a resource for a draw is a
+// single SetGraphicsRoot32BitConstant. Shaders get the descriptor index with
+// handle & HandleAllocator::IndexMask. Bind GetGPUDescriptorTable() to a
+// descriptor table with an unbounded, DESCRIPTORS_VOLATILE range starting at
+// offset 0, once per command list.
+class BindlessDescriptorHeap
+{
+public:
+	using Handle = HandleAllocator::Handle;
+
+	// Use numDescriptors descriptors of heap, starting at firstDescriptor.
+	// The rest of the heap can be shared with e.g. a DescriptorRing.
+	BindlessDescriptorHeap(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> heap,
+		uint32_t firstDescriptor, uint32_t numDescriptors);
+	virtual ~BindlessDescriptorHeap();
+
+	// Returns HandleAllocator::InvalidHandle if the table is full.
+	Handle Allocate();
+
+	// Write views to the descriptor of a handle.
+	void CreateShaderResourceView(Handle handle, ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+	void CreateUnorderedAccessView(Handle handle, ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+	void CreateConstantBufferView(Handle handle, const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc);
+	void CopyDescriptor(Handle handle, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+	// The handle stays valid until all work submitted to the queue so far has
+	// completed, then its slot is reused under a new generation.
+	void Free(Handle handle, CommandQueue& commandQueue);
+	// Free the handle immediately. The GPU must not be using it anymore.
+	void Free(Handle handle);
+
+	bool IsValid(Handle handle) const;
+
+	ID3D12DescriptorHeap* GetDescriptorHeap() const;
+	// The start of the table, for SetGraphicsRootDescriptorTable/SetComputeRootDescriptorTable.
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorTable() const;
+
+	uint32_t GetCapacity() const;
+	uint32_t GetAllocatedCount() const;
+
+private:
+	BindlessDescriptorHeap(const BindlessDescriptorHeap& copy) = delete;
+	BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap& other) = delete;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle(Handle handle) const;
+
+	ComPtr<ID3D12Device2> mDevice;
+	ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
+	uint32_t mDescriptorSize;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE mCPUBase;
+	D3D12_GPU_DESCRIPTOR_HANDLE mGPUBase;
+
+	mutable std::mutex mMutex;
+	HandleAllocator mHandleAllocator;
+};
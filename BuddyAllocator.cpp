@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "BuddyAllocator.h"
+
+static bool IsPowerOfTwo(uint64_t value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint64_t NextPowerOfTwo(uint64_t value)
+{
+	uint64_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minBlockSize)
+	: mSize(size)
+	, mMinBlockSize(minBlockSize)
+	, mMaxOrder(0)
+	, mAllocatedSize(0)
+	, mRequestedSize(0)
+{
+	assert(IsPowerOfTwo(size) && IsPowerOfTwo(minBlockSize) && minBlockSize <= size);
+
+	mMaxOrder = GetOrder(size);
+	mFreeBlocks.resize(mMaxOrder + 1);
+	mFreeBlocks[mMaxOrder].insert(0);
+}
+
+uint32_t BuddyAllocator::GetOrder(uint64_t blockSize) const
+{
+	uint32_t order = 0;
+	while ((mMinBlockSize << order) < blockSize)
+	{
+		++order;
+	}
+	return order;
+}
+
+uint64_t BuddyAllocator::GetBlockSize(uint32_t order) const
+{
+	return mMinBlockSize << order;
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	uint64_t blockSize = std::max({ NextPowerOfTwo(size), NextPowerOfTwo(alignment), mMinBlockSize });
+	if (size == 0 || blockSize > mSize)
+	{
+		return InvalidOffset;
+	}
+
+	uint32_t order = GetOrder(blockSize);
+
+	// Find the smallest free block that fits.
+	uint32_t freeOrder = order;
+	while (freeOrder <= mMaxOrder && mFreeBlocks[freeOrder].empty())
+	{
+		++freeOrder;
+	}
+	if (freeOrder > mMaxOrder)
+	{
+		return InvalidOffset;
+	}
+
+	uint64_t offset = *mFreeBlocks[freeOrder].begin();
+	mFreeBlocks[freeOrder].erase(mFreeBlocks[freeOrder].begin());
+
+	// Split it down to the requested size, freeing the upper halves.
+	while (freeOrder > order)
+	{
+		--freeOrder;
+		mFreeBlocks[freeOrder].insert(offset + GetBlockSize(freeOrder));
+	}
+
+	mAllocatedBlocks[offset] = AllocatedBlock{ order, size };
+	mAllocatedSize += GetBlockSize(order);
+	mRequestedSize += size;
+
+	return offset;
+}
+
+void BuddyAllocator::Free(uint64_t offset)
+{
+	auto iter = mAllocatedBlocks.find(offset);
+	assert(iter != mAllocatedBlocks.end() && "Offset was not allocated by this allocator.");
+	if (iter == mAllocatedBlocks.end())
+	{
+		return;
+	}
+
+	uint32_t order = iter->second.order;
+	mAllocatedSize -= GetBlockSize(order);
+	mRequestedSize -= iter->second.requestedSize;
+	mAllocatedBlocks.erase(iter);
+
+	// Merge with the buddy for as long as it is free.
+	while (order < mMaxOrder)
+	{
+		uint64_t buddy = offset ^ GetBlockSize(order);
+		auto buddyIter = mFreeBlocks[order].find(buddy);
+		if (buddyIter == mFreeBlocks[order].end())
+		{
+			break;
+		}
+
+		mFreeBlocks[order].erase(buddyIter);
+		offset = std::min(offset, buddy);
+		++order;
+	}
+
+	mFreeBlocks[order].insert(offset);
+}
+
+BuddyAllocator::Stats BuddyAllocator::GetStats() const
+{
+	Stats stats = {};
+	stats.Size = mSize;
+	stats.AllocatedSize = mAllocatedSize;
+	stats.RequestedSize = mRequestedSize;
+	stats.AllocationCount = mAllocatedBlocks.size();
+
+	for (uint32_t order = 0; order <= mMaxOrder; ++order)
+	{
+		if (!mFreeBlocks[order].empty())
+		{
+			stats.FreeBlockCount += mFreeBlocks[order].size();
+			stats.LargestFreeBlock = GetBlockSize(order);
+		}
+	}
+
+	uint64_t freeSize = mSize - mAllocatedSize;
+	stats.Fragmentation = freeSize > 0 ? 1.0 - static_cast<double>(stats.LargestFreeBlock) / freeSize : 0.0;
+
+	return stats;
+}
+
+uint64_t BuddyAllocator::GetSize() const
+{
+	return mSize;
+}
+
+bool BuddyAllocator::IsEmpty() const
+{
+	return mAllocatedBlocks.empty();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// A binary buddy allocator over an abstract range of memory.
+// Every block is a power of two in size and aligned to its size, so any
+// alignment up to the block size is satisfied for free.
+class BuddyAllocator
+{
+public:
+	static const uint64_t InvalidOffset = ~0ull;
+
+	// size and minBlockSize must be powers of two.
+	BuddyAllocator(uint64_t size, uint64_t minBlockSize);
+
+	// Returns the offset of the allocation or InvalidOffset if there is no
+	// free block that is large enough.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	void Free(uint64_t offset);
+
+	struct Stats
+	{
+		uint64_t Size;
+		uint64_t AllocatedSize;		// Sum of the allocated block sizes.
+		uint64_t RequestedSize;		// Sum of the requested sizes.
+		uint64_t AllocationCount;
+		uint64_t FreeBlockCount;
+		uint64_t LargestFreeBlock;
+		// 0 when all free memory is in one block, approaching 1 as free
+		// memory is split into many small blocks.
+		double Fragmentation;
+	};
+	Stats GetStats() const;
+
+	uint64_t GetSize() const;
+	bool IsEmpty() const;
+
+private:
+	uint32_t GetOrder(uint64_t blockSize) const;
+	uint64_t GetBlockSize(uint32_t order) const;
+
+	uint64_t mSize;
+	uint64_t mMinBlockSize;
+	uint32_t mMaxOrder;
+
+	// Free block offsets for every order. Sets keep the lowest offset first,
+	// which keeps allocations packed towards the start of the range.
+	std::vector<std::set<uint64_t>> mFreeBlocks;
+
+	struct AllocatedBlock
+	{
+		uint32_t order;
+		uint64_t requestedSize;
+	};
+	std::unordered_map<uint64_t, AllocatedBlock> mAllocatedBlocks;
+
+	uint64_t mAllocatedSize;
+	uint64_t mRequestedSize;
+};
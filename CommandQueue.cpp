@@ -1,10 +1,43 @@
 #include "CommandQueue.h"
 #include "pch.h"
 
-CommandQueue::CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+#include "ResourceStateTracker.h"
+#include "ThreadPool.h"
+
+// Private data tag used to find the pool a command list was taken from.
+// {5E0A4C9B-8F1D-4B7A-9C43-2A6D1E7F3B10}
+static const GUID CommandListPoolGuid =
+{ 0x5e0a4c9b, 0x8f1d, 0x4b7a, { 0x9c, 0x43, 0x2a, 0x6d, 0x1e, 0x7f, 0x3b, 0x10 } };
+
+static std::atomic<uint64_t> gNextQueueId{ 0 };
+
+bool FenceValue::await_ready() const
+{
+	return mCommandQueue->IsFenceComplete(mValue);
+}
+
+void FenceValue::await_suspend(std::coroutine_handle<> handle) const
+{
+	std::shared_ptr<ThreadPool> threadPool = mCommandQueue->GetThreadPool();
+	mCommandQueue->AddFenceCallback(mValue, [handle, threadPool]()
+	{
+		if (threadPool)
+		{
+			threadPool->Enqueue([handle]() { handle.resume(); });
+		}
+		else
+		{
+			handle.resume();
+		}
+	});
+}
+
+CommandQueue::CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type, std::shared_ptr<ThreadPool> threadPool)
 	: mFenceValue(0)
 	, mCommandListType(type)
 	, mDevice(device)
+	, mThreadPool(threadPool)
+	, mQueueId(++gNextQueueId)
 {
 	D3D12_COMMAND_QUEUE_DESC desc = {};
 	desc.Type = type;
@@ -15,12 +48,69 @@ CommandQueue::CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE
 	ThrowIfFailed(mDevice->CreateCommandQueue(&desc, IID_PPV_ARGS(&mCommandQueue)));
 	ThrowIfFailed(mDevice->CreateFence(mFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
 
-	mFenceEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
-	assert(mFenceEvent && "Failed to create fence event handle.");
+	mFenceWatcher = std::make_unique<FenceWatcher>(mFence);
 }
 
 CommandQueue::~CommandQueue()
 {
+	for (auto& pool : mCommandListPools)
+	{
+		if (pool->fenceEvent)
+		{
+			::CloseHandle(pool->fenceEvent);
+		}
+	}
+}
+
+CommandQueue::CommandListPool& CommandQueue::GetThreadCommandListPool()
+{
+	// Each thread remembers the pools it has used, so after the first call
+	// on a thread finding its pool does not take any locks.
+	thread_local std::vector<std::pair<uint64_t, CommandListPool*>> threadPools;
+
+	for (auto& entry : threadPools)
+	{
+		if (entry.first == mQueueId)
+		{
+			return *entry.second;
+		}
+	}
+
+	auto pool = std::make_unique<CommandListPool>();
+	pool->fenceEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	assert(pool->fenceEvent && "Failed to create fence event handle.");
+
+	CommandListPool* pPool = pool.get();
+	{
+		std::lock_guard<std::mutex> lock(mPoolsMutex);
+		mCommandListPools.push_back(std::move(pool));
+	}
+	threadPools.emplace_back(mQueueId, pPool);
+
+	return *pPool;
+}
+
+void CommandQueue::DrainReturned(CommandListPool& pool)
+{
+	if (!pool.hasReturned.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(pool.returnMutex);
+	// Returned entries are pushed in fence order, and only drained once the
+	// local queue is empty, so the local queue stays sorted by fence value.
+	for (auto& entry : pool.returnedAllocators)
+	{
+		pool.commandAllocatorQueue.push(std::move(entry));
+	}
+	for (auto& commandList : pool.returnedLists)
+	{
+		pool.commandListQueue.push(std::move(commandList));
+	}
+	pool.returnedAllocators.clear();
+	pool.returnedLists.clear();
+	pool.hasReturned.store(false, std::memory_order_release);
 }
 
 ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
@@ -28,10 +118,19 @@ ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
 	ComPtr<ID3D12CommandAllocator> commandAllocator;
 	ComPtr<ID3D12GraphicsCommandList2> commandList;
 
-	if (!mCommandAllocatorQueue.empty() && IsFenceComplete(mCommandAllocatorQueue.front().fenceValue))
+	CommandListPool& pool = GetThreadCommandListPool();
+
+	ReleaseCompletedObjects();
+
+	if (pool.commandAllocatorQueue.empty() || pool.commandListQueue.empty())
+	{
+		DrainReturned(pool);
+	}
+
+	if (!pool.commandAllocatorQueue.empty() && IsFenceComplete(pool.commandAllocatorQueue.front().fenceValue))
 	{
-		commandAllocator = mCommandAllocatorQueue.front().commandAllocator;
-		mCommandAllocatorQueue.pop();
+		commandAllocator = pool.commandAllocatorQueue.front().commandAllocator;
+		pool.commandAllocatorQueue.pop();
 		ThrowIfFailed(commandAllocator->Reset());
 	}
 	else
@@ -39,10 +138,10 @@ ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
 		commandAllocator = CreateCommandAllocator();
 	}
 
-	if (!mCommandListQueue.empty())
+	if (!pool.commandListQueue.empty())
 	{
-		commandList = mCommandListQueue.front();
-		mCommandListQueue.pop();
+		commandList = pool.commandListQueue.front();
+		pool.commandListQueue.pop();
 		ThrowIfFailed(commandList->Reset(commandAllocator.Get(), nullptr));
 	}
 	else
@@ -50,36 +149,117 @@ ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
 		commandList = CreateCommandList(commandAllocator);
 	}
 
+	CommandListPool* pPool = &pool;
 	ThrowIfFailed(commandList->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), commandAllocator.Get()));
+	ThrowIfFailed(commandList->SetPrivateData(CommandListPoolGuid, sizeof(pPool), &pPool));
 	return commandList;
 }
 
-uint64_t CommandQueue::ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList)
+FenceValue CommandQueue::ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList)
 {
-	commandList->Close();
+	return ExecuteCommandLists({ commandList });
+}
 
-	ID3D12CommandAllocator* commandAllocator;
-	UINT dataSize = sizeof(commandAllocator);
-	ThrowIfFailed(commandList->GetPrivateData(__uuidof(ID3D12CommandAllocator), &dataSize, &commandAllocator));
+FenceValue CommandQueue::ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList, ResourceStateTracker& resourceStateTracker)
+{
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
 
-	ID3D12CommandList* const ppCommandLists[] = {
-		commandList.Get()
-	};
+	std::vector<ComPtr<ID3D12GraphicsCommandList2>> commandLists;
+	FenceValue fenceValue(this, 0);
+	{
+		// No other command list may change the global states between resolving
+		// the pending transitions and submitting.
+		auto lock = ResourceStateTracker::LockGlobalState();
 
-	mCommandQueue->ExecuteCommandLists(1, ppCommandLists);
-	uint64_t fenceValue = Signal();
+		std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers = resourceStateTracker.ResolvePendingResourceBarriers();
+		if (!pendingBarriers.empty())
+		{
+			auto pendingCommandList = GetCommandList();
+			pendingCommandList->ResourceBarrier(static_cast<UINT>(pendingBarriers.size()), pendingBarriers.data());
+			commandLists.push_back(pendingCommandList);
+		}
+		commandLists.push_back(commandList);
 
-	mCommandAllocatorQueue.emplace(CommandAllocatorEntry{ fenceValue, commandAllocator });
-	mCommandListQueue.push(commandList);
-	// release temp ptr here since it's held in queue
-	commandAllocator->Release();
+		resourceStateTracker.CommitFinalResourceStates();
+		fenceValue = ExecuteCommandLists(commandLists);
+	}
+
+	resourceStateTracker.Reset();
 	return fenceValue;
 }
 
-uint64_t CommandQueue::Signal()
+FenceValue CommandQueue::ExecuteCommandLists(const std::vector<ComPtr<ID3D12GraphicsCommandList2>>& commandLists)
+{
+	struct PendingReturn
+	{
+		CommandListPool* pool;
+		ID3D12CommandAllocator* commandAllocator;
+	};
+
+	std::vector<ID3D12CommandList*> ppCommandLists;
+	std::vector<PendingReturn> pendingReturns;
+	ppCommandLists.reserve(commandLists.size());
+	pendingReturns.reserve(commandLists.size());
+
+	for (auto& commandList : commandLists)
+	{
+		commandList->Close();
+
+		PendingReturn pending;
+		UINT dataSize = sizeof(pending.commandAllocator);
+		ThrowIfFailed(commandList->GetPrivateData(__uuidof(ID3D12CommandAllocator), &dataSize, &pending.commandAllocator));
+		dataSize = sizeof(pending.pool);
+		ThrowIfFailed(commandList->GetPrivateData(CommandListPoolGuid, &dataSize, &pending.pool));
+
+		ppCommandLists.push_back(commandList.Get());
+		pendingReturns.push_back(pending);
+	}
+
+	uint64_t fenceValue;
+	{
+		std::lock_guard<std::mutex> lock(mSubmitMutex);
+
+		mCommandQueue->ExecuteCommandLists(static_cast<UINT>(ppCommandLists.size()), ppCommandLists.data());
+		fenceValue = SignalLocked();
+
+		// Hand the allocators and lists back to the pools of the threads that
+		// recorded them. This happens under the submit lock so each pool
+		// receives its allocators in fence order.
+		for (size_t i = 0; i < commandLists.size(); ++i)
+		{
+			CommandListPool* pool = pendingReturns[i].pool;
+
+			std::lock_guard<std::mutex> returnLock(pool->returnMutex);
+			pool->returnedAllocators.emplace_back(CommandAllocatorEntry{ fenceValue, pendingReturns[i].commandAllocator });
+			pool->returnedLists.push_back(commandLists[i]);
+			pool->hasReturned.store(true, std::memory_order_release);
+		}
+	}
+
+	mSubmissionCount.fetch_add(1, std::memory_order_relaxed);
+	mCommandListCount.fetch_add(commandLists.size(), std::memory_order_relaxed);
+
+	// release temp ptrs here since they're held in the pools
+	for (auto& pending : pendingReturns)
+	{
+		pending.commandAllocator->Release();
+	}
+
+	ReleaseCompletedObjects();
+	return FenceValue(this, fenceValue);
+}
+
+FenceValue CommandQueue::Signal()
+{
+	std::lock_guard<std::mutex> lock(mSubmitMutex);
+	return FenceValue(this, SignalLocked());
+}
+
+uint64_t CommandQueue::SignalLocked()
 {
 	uint64_t fenceValueForSignal = ++mFenceValue;
 	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), fenceValueForSignal));
+	mSignalCount.fetch_add(1, std::memory_order_relaxed);
 	return fenceValueForSignal;
 }
 
@@ -92,14 +272,82 @@ void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
 	if (mFence->GetCompletedValue() < fenceValue)
 	{
-		ThrowIfFailed(mFence->SetEventOnCompletion(fenceValue, mFenceEvent));
-		::WaitForSingleObject(mFenceEvent, DWORD_MAX);
+		// Every thread waits on its own event so concurrent waits don't steal
+		// each other's wake-ups.
+		HANDLE fenceEvent = GetThreadCommandListPool().fenceEvent;
+		ThrowIfFailed(mFence->SetEventOnCompletion(fenceValue, fenceEvent));
+		::WaitForSingleObject(fenceEvent, DWORD_MAX);
+	}
+}
+
+void CommandQueue::Wait(CommandQueue& other, uint64_t fenceValue)
+{
+	// Work on the same queue is already ordered.
+	if (&other == this || other.IsFenceComplete(fenceValue))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mSubmitMutex);
+
+	auto iter = std::find_if(mWaitedFenceValues.begin(), mWaitedFenceValues.end(),
+		[&other](const std::pair<const CommandQueue*, uint64_t>& entry) { return entry.first == &other; });
+	if (iter != mWaitedFenceValues.end() && iter->second >= fenceValue)
+	{
+		return;
+	}
+
+	ThrowIfFailed(mCommandQueue->Wait(other.mFence.Get(), fenceValue));
+	mWaitCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (iter != mWaitedFenceValues.end())
+	{
+		iter->second = fenceValue;
+	}
+	else
+	{
+		mWaitedFenceValues.emplace_back(&other, fenceValue);
+	}
+}
+
+void CommandQueue::Wait(const FenceValue& fenceValue)
+{
+	Wait(*fenceValue.GetCommandQueue(), fenceValue.GetValue());
+}
+
+void CommandQueue::AddFenceCallback(uint64_t fenceValue, std::function<void()> callback)
+{
+	mFenceWatcher->AddCallback(fenceValue, std::move(callback));
+}
+
+void CommandQueue::ReleaseWhenComplete(ComPtr<IUnknown> object, uint64_t fenceValue)
+{
+	mDeferredReleases.Enqueue(fenceValue, std::move(object));
+}
+
+void CommandQueue::ReleaseWhenComplete(ComPtr<IUnknown> object)
+{
+	ReleaseWhenComplete(std::move(object), GetLastSignaledFenceValue());
+}
+
+uint64_t CommandQueue::GetLastSignaledFenceValue()
+{
+	std::lock_guard<std::mutex> lock(mSubmitMutex);
+	return mFenceValue;
+}
+
+void CommandQueue::ReleaseCompletedObjects()
+{
+	if (mDeferredReleases.GetPendingCount() > 0)
+	{
+		mDeferredReleases.ReleaseCompleted(mFence->GetCompletedValue());
 	}
 }
 
 void CommandQueue::Flush()
 {
 	WaitForFenceValue(Signal());
+	ReleaseCompletedObjects();
 }
 
 ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue() const
@@ -107,6 +355,31 @@ ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue() const
 	return mCommandQueue;
 }
 
+ComPtr<ID3D12Fence> CommandQueue::GetFence() const
+{
+	return mFence;
+}
+
+D3D12_COMMAND_LIST_TYPE CommandQueue::GetCommandListType() const
+{
+	return mCommandListType;
+}
+
+std::shared_ptr<ThreadPool> CommandQueue::GetThreadPool() const
+{
+	return mThreadPool;
+}
+
+CommandQueue::SubmissionStats CommandQueue::GetSubmissionStats() const
+{
+	SubmissionStats stats;
+	stats.Submissions = mSubmissionCount.load(std::memory_order_relaxed);
+	stats.Signals = mSignalCount.load(std::memory_order_relaxed);
+	stats.Waits = mWaitCount.load(std::memory_order_relaxed);
+	stats.CommandLists = mCommandListCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
 ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAllocator()
 {
 	ComPtr<ID3D12CommandAllocator> allocator;
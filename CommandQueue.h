@@ -3,24 +3,106 @@
 #include <d3d12.h>
 #include <wrl.h>
 
+#include "DeferredReleaseQueue.h"
+#include "FenceWatcher.h"
+
+#include <atomic>
+#include <coroutine>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 using namespace Microsoft::WRL;
 
+class CommandQueue;
+class ResourceStateTracker;
+class ThreadPool;
+
+// A fence value signaled on a command queue.
+// Converts to the plain uint64_t value, and can be co_awaited from a
+// coroutine to suspend until the GPU has passed it.
+class FenceValue
+{
+public:
+	FenceValue(CommandQueue* commandQueue, uint64_t value)
+		: mCommandQueue(commandQueue)
+		, mValue(value)
+	{}
+
+	operator uint64_t() const { return mValue; }
+	uint64_t GetValue() const { return mValue; }
+	CommandQueue* GetCommandQueue() const { return mCommandQueue; }
+
+	bool await_ready() const;
+	void await_suspend(std::coroutine_handle<> handle) const;
+	void await_resume() const {}
+
+private:
+	CommandQueue* mCommandQueue;
+	uint64_t mValue;
+};
+
 class CommandQueue
 {
 public:
-	CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
+	// Coroutines that co_await a FenceValue of this queue are resumed on
+	// threadPool. Without one they resume on the fence watcher thread.
+	CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type, std::shared_ptr<ThreadPool> threadPool = nullptr);
 	virtual ~CommandQueue();
 
+	// Get a command list that is ready for recording. Each thread records
+	// from its own pool of allocators and lists so this can be called from
+	// any number of threads at once.
 	ComPtr<ID3D12GraphicsCommandList2> GetCommandList();
-	uint64_t ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList);
-	uint64_t Signal();
+	// Close and submit a command list. Safe to call from any thread.
+	FenceValue ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList);
+	// Flush the tracker's barriers into the command list and submit it. Its
+	// pending transitions are recorded in an extra command list that runs
+	// first, and its final states become the global states. The tracker is
+	// reset for the next command list.
+	FenceValue ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList, ResourceStateTracker& resourceStateTracker);
+	// Close and submit a batch of command lists with a single ExecuteCommandLists
+	// call and a single fence signal. All of their allocators are retired
+	// on the returned fence value.
+	FenceValue ExecuteCommandLists(const std::vector<ComPtr<ID3D12GraphicsCommandList2>>& commandLists);
+	FenceValue Signal();
 	bool IsFenceComplete(uint64_t fenceValue);
 	void WaitForFenceValue(uint64_t fenceValue);
+	// Make this queue wait on the GPU until another queue's fence reaches
+	// fenceValue. Work submitted to this queue afterwards will not start
+	// before then. The CPU is never blocked, and waits that are already
+	// satisfied are skipped.
+	void Wait(CommandQueue& other, uint64_t fenceValue);
+	void Wait(const FenceValue& fenceValue);
+	// Run a callback once the fence reaches fenceValue without blocking the
+	// caller. Callbacks run on this queue's fence watcher thread.
+	void AddFenceCallback(uint64_t fenceValue, std::function<void()> callback);
+	// Keep an object alive until this queue's fence reaches fenceValue.
+	// Without a fence value, the object is kept until all work submitted so
+	// far has completed. Objects are released from GetCommandList and
+	// ExecuteCommandLists once their fence value is reached.
+	void ReleaseWhenComplete(ComPtr<IUnknown> object, uint64_t fenceValue);
+	void ReleaseWhenComplete(ComPtr<IUnknown> object);
+	// The value of the last fence signal submitted to the queue.
+	uint64_t GetLastSignaledFenceValue();
 	void Flush();
 	ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
+	ComPtr<ID3D12Fence> GetFence() const;
+	D3D12_COMMAND_LIST_TYPE GetCommandListType() const;
+	std::shared_ptr<ThreadPool> GetThreadPool() const;
+
+	// Running totals of the work submitted to this queue.
+	struct SubmissionStats
+	{
+		uint64_t Submissions;	// Calls to ID3D12CommandQueue::ExecuteCommandLists.
+		uint64_t Signals;		// Fence signals.
+		uint64_t Waits;			// GPU-side waits on other queues.
+		uint64_t CommandLists;	// Command lists executed.
+	};
+	SubmissionStats GetSubmissionStats() const;
 
 protected:
 
@@ -38,12 +120,55 @@ private:
 	using CommandAllocatorQueue = std::queue<CommandAllocatorEntry>;
 	using CommandListQueue = std::queue<ComPtr<ID3D12GraphicsCommandList2>>;
 
+	// The allocators and lists used by a single recording thread.
+	// The local queues are only touched by the owning thread. Allocators and
+	// lists that are submitted (possibly from another thread) are handed back
+	// through the returned lists, which the owner only drains once its local
+	// queues run dry.
+	struct CommandListPool
+	{
+		CommandAllocatorQueue		commandAllocatorQueue;
+		CommandListQueue			commandListQueue;
+
+		std::mutex					returnMutex;
+		std::atomic_bool			hasReturned{ false };
+		std::vector<CommandAllocatorEntry> returnedAllocators;
+		std::vector<ComPtr<ID3D12GraphicsCommandList2>> returnedLists;
+
+		// Used by the owning thread to wait on the fence.
+		HANDLE						fenceEvent = nullptr;
+	};
+
+	CommandListPool& GetThreadCommandListPool();
+	void DrainReturned(CommandListPool& pool);
+
+	// Signal the fence. mSubmitMutex must be held by the caller.
+	uint64_t SignalLocked();
+
+	void ReleaseCompletedObjects();
+
 	D3D12_COMMAND_LIST_TYPE		mCommandListType;
 	ComPtr<ID3D12Device2>		mDevice;
 	ComPtr<ID3D12CommandQueue>	mCommandQueue;
 	ComPtr<ID3D12Fence>			mFence;
-	HANDLE						mFenceEvent;
 	uint64_t					mFenceValue;
-	CommandAllocatorQueue		mCommandAllocatorQueue;
-	CommandListQueue			mCommandListQueue;
-};
\ No newline at end of file
+	std::unique_ptr<FenceWatcher> mFenceWatcher;
+	std::shared_ptr<ThreadPool>	mThreadPool;
+	DeferredReleaseQueue		mDeferredReleases;
+
+	// Unique across all queues so stale thread-local cache entries never match.
+	uint64_t					mQueueId;
+
+	// Serializes ExecuteCommandLists/Signal/Wait so fence values stay in submission order.
+	std::mutex					mSubmitMutex;
+	// The highest fence value of each other queue that this queue already waits for.
+	std::vector<std::pair<const CommandQueue*, uint64_t>> mWaitedFenceValues;
+
+	std::atomic<uint64_t>		mSubmissionCount{ 0 };
+	std::atomic<uint64_t>		mSignalCount{ 0 };
+	std::atomic<uint64_t>		mWaitCount{ 0 };
+	std::atomic<uint64_t>		mCommandListCount{ 0 };
+
+	std::mutex					mPoolsMutex;
+	std::vector<std::unique_ptr<CommandListPool>> mCommandListPools;
+};
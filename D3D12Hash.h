@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Hash.h"
+
+#include <d3d12.h>
+
+#include <cstring>
+
+// Stable hashes of D3D12 descriptions, for keys that are written to disk.
+// Descriptions are hashed field by field. Hashing their bytes would include
+// padding, which is whatever was on the stack, and would tell 0.0f and -0.0f
+// apart even though D3D12 treats them the same.
+
+// Mix in the bits of a float. -0 is hashed as 0.
+inline uint64_t HashFloat(uint64_t seed, float value)
+{
+	if (value == 0.0f)
+	{
+		value = 0.0f;
+	}
+
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return HashCombine(seed, bits);
+}
+
+// Every render target blend desc ends in a UINT8 write mask and 3 bytes of padding.
+inline uint64_t HashBlendDesc(const D3D12_BLEND_DESC& desc, uint64_t seed = HashOffsetBasis)
+{
+	uint64_t hash = HashCombine(seed, desc.AlphaToCoverageEnable);
+	hash = HashCombine(hash, desc.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.RenderTarget)
+	{
+		hash = HashCombine(hash, renderTarget.BlendEnable);
+		hash = HashCombine(hash, renderTarget.LogicOpEnable);
+		hash = HashCombine(hash, renderTarget.SrcBlend);
+		hash = HashCombine(hash, renderTarget.DestBlend);
+		hash = HashCombine(hash, renderTarget.BlendOp);
+		hash = HashCombine(hash, renderTarget.SrcBlendAlpha);
+		hash = HashCombine(hash, renderTarget.DestBlendAlpha);
+		hash = HashCombine(hash, renderTarget.BlendOpAlpha);
+		hash = HashCombine(hash, renderTarget.LogicOp);
+		hash = HashCombine(hash, renderTarget.RenderTargetWriteMask);
+	}
+	return hash;
+}
+
+inline uint64_t HashDepthStencilOpDesc(const D3D12_DEPTH_STENCILOP_DESC& desc, uint64_t seed)
+{
+	uint64_t hash = HashCombine(seed, desc.StencilFailOp);
+	hash = HashCombine(hash, desc.StencilDepthFailOp);
+	hash = HashCombine(hash, desc.StencilPassOp);
+	return HashCombine(hash, desc.StencilFunc);
+}
+
+// The two UINT8 stencil masks are followed by 2 bytes of padding.
+template<typename DepthStencilDesc>
+uint64_t HashDepthStencilFields(const DepthStencilDesc& desc, uint64_t seed)
+{
+	uint64_t hash = HashCombine(seed, desc.DepthEnable);
+	hash = HashCombine(hash, desc.DepthWriteMask);
+	hash = HashCombine(hash, desc.DepthFunc);
+	hash = HashCombine(hash, desc.StencilEnable);
+	hash = HashCombine(hash, desc.StencilReadMask);
+	hash = HashCombine(hash, desc.StencilWriteMask);
+	hash = HashDepthStencilOpDesc(desc.FrontFace, hash);
+	return HashDepthStencilOpDesc(desc.BackFace, hash);
+}
+
+inline uint64_t HashDepthStencilDesc(const D3D12_DEPTH_STENCIL_DESC& desc, uint64_t seed = HashOffsetBasis)
+{
+	return HashDepthStencilFields(desc, seed);
+}
+
+inline uint64_t HashDepthStencilDesc1(const D3D12_DEPTH_STENCIL_DESC1& desc, uint64_t seed = HashOffsetBasis)
+{
+	return HashCombine(HashDepthStencilFields(desc, seed), desc.DepthBoundsTestEnable);
+}
+
+inline uint64_t HashRasterizerDesc(const D3D12_RASTERIZER_DESC& desc, uint64_t seed = HashOffsetBasis)
+{
+	uint64_t hash = HashCombine(seed, desc.FillMode);
+	hash = HashCombine(hash, desc.CullMode);
+	hash = HashCombine(hash, desc.FrontCounterClockwise);
+	hash = HashCombine(hash, static_cast<uint32_t>(desc.DepthBias));
+	hash = HashFloat(hash, desc.DepthBiasClamp);
+	hash = HashFloat(hash, desc.SlopeScaledDepthBias);
+	hash = HashCombine(hash, desc.DepthClipEnable);
+	hash = HashCombine(hash, desc.MultisampleEnable);
+	hash = HashCombine(hash, desc.AntialiasedLineEnable);
+	hash = HashCombine(hash, desc.ForcedSampleCount);
+	return HashCombine(hash, desc.ConservativeRaster);
+}
+
+inline uint64_t HashRTFormatArray(const D3D12_RT_FORMAT_ARRAY& formats, uint64_t seed = HashOffsetBasis)
+{
+	uint64_t hash = HashCombine(seed, formats.NumRenderTargets);
+	for (DXGI_FORMAT format : formats.RTFormats)
+	{
+		hash = HashCombine(hash, format);
+	}
+	return hash;
+}
+
+inline uint64_t HashSampleDesc(const DXGI_SAMPLE_DESC& desc, uint64_t seed = HashOffsetBasis)
+{
+	return HashCombine(HashCombine(seed, desc.Count), desc.Quality);
+}
+
+inline uint64_t HashStaticSamplerDesc(const D3D12_STATIC_SAMPLER_DESC& desc, uint64_t seed = HashOffsetBasis)
+{
+	uint64_t hash = HashCombine(seed, desc.Filter);
+	hash = HashCombine(hash, desc.AddressU);
+	hash = HashCombine(hash, desc.AddressV);
+	hash = HashCombine(hash, desc.AddressW);
+	hash = HashFloat(hash, desc.MipLODBias);
+	hash = HashCombine(hash, desc.MaxAnisotropy);
+	hash = HashCombine(hash, desc.ComparisonFunc);
+	hash = HashCombine(hash, desc.BorderColor);
+	hash = HashFloat(hash, desc.MinLOD);
+	hash = HashFloat(hash, desc.MaxLOD);
+	hash = HashCombine(hash, desc.ShaderRegister);
+	hash = HashCombine(hash, desc.RegisterSpace);
+	return HashCombine(hash, desc.ShaderVisibility);
+}
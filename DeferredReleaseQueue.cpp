@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "DeferredReleaseQueue.h"
+
+void DeferredReleaseQueue::Enqueue(uint64_t fenceValue, ComPtr<IUnknown> object)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// Objects are almost always enqueued in fence order, so search from the back.
+	auto iter = mPendingReleases.end();
+	while (iter != mPendingReleases.begin() && std::prev(iter)->fenceValue > fenceValue)
+	{
+		--iter;
+	}
+	mPendingReleases.insert(iter, PendingRelease{ fenceValue, std::move(object) });
+}
+
+size_t DeferredReleaseQueue::ReleaseCompleted(uint64_t completedFenceValue)
+{
+	std::deque<PendingRelease> completed;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		while (!mPendingReleases.empty() && mPendingReleases.front().fenceValue <= completedFenceValue)
+		{
+			completed.push_back(std::move(mPendingReleases.front()));
+			mPendingReleases.pop_front();
+		}
+	}
+
+	// The objects are released here, outside of the lock, oldest first.
+	for (PendingRelease& pending : completed)
+	{
+		pending.object.Reset();
+	}
+	return completed.size();
+}
+
+void DeferredReleaseQueue::ReleaseAll()
+{
+	std::deque<PendingRelease> pendingReleases;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		pendingReleases.swap(mPendingReleases);
+	}
+
+	for (PendingRelease& pending : pendingReleases)
+	{
+		pending.object.Reset();
+	}
+}
+
+size_t DeferredReleaseQueue::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPendingReleases.size();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Unknwn.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+using Microsoft::WRL::ComPtr;
+
+// Holds on to objects until a fence value has been reached.
+// Use this to drop resources that the GPU may still be using instead of
+// flushing the command queue first.
+class DeferredReleaseQueue
+{
+public:
+	// Keep the object alive until the fence reaches fenceValue.
+	void Enqueue(uint64_t fenceValue, ComPtr<IUnknown> object);
+
+	// Release all objects whose fence value is less than or equal to
+	// completedFenceValue, in fence order. Objects with the same fence value
+	// are released in the order they were enqueued. Returns the number of
+	// objects released.
+	size_t ReleaseCompleted(uint64_t completedFenceValue);
+
+	// Release everything regardless of the fence. Only safe once the GPU is idle.
+	void ReleaseAll();
+
+	size_t GetPendingCount() const;
+
+private:
+	struct PendingRelease
+	{
+		uint64_t fenceValue;
+		ComPtr<IUnknown> object;
+	};
+
+	mutable std::mutex mMutex;
+	// Sorted by fence value.
+	std::deque<PendingRelease> mPendingReleases;
+};
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "DescriptorAllocator.h"
+
+#include "Application.h"
+#include "CommandQueue.h"
+
+DescriptorAllocation::DescriptorAllocation()
+	: mDescriptor{ 0 }
+	, mNumHandles(0)
+	, mDescriptorSize(0)
+	, mPageIndex(0)
+	, mOffset(0)
+{
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocation::GetDescriptorHandle(uint32_t offset) const
+{
+	assert(offset < mNumHandles);
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptor, offset, mDescriptorSize);
+}
+
+uint32_t DescriptorAllocation::GetNumHandles() const
+{
+	return mNumHandles;
+}
+
+bool DescriptorAllocation::IsNull() const
+{
+	return mDescriptor.ptr == 0;
+}
+
+DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage)
+	: mHeapType(type)
+	, mNumDescriptorsPerPage(numDescriptorsPerPage)
+	, mDescriptorSize(0)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(uint32_t numDescriptors)
+{
+	assert(numDescriptors > 0);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	uint32_t pageIndex = 0;
+	uint32_t offset = FreeListAllocator::InvalidOffset;
+	for (; pageIndex < mPages.size(); ++pageIndex)
+	{
+		offset = mPages[pageIndex]->allocator.Allocate(numDescriptors);
+		if (offset != FreeListAllocator::InvalidOffset)
+		{
+			break;
+		}
+	}
+
+	if (offset == FreeListAllocator::InvalidOffset)
+	{
+		// Pages are created on first use, after the application has been created.
+		Application& app = Application::Get();
+		if (mDescriptorSize == 0)
+		{
+			mDescriptorSize = app.GetDescriptorHandleIncrementSize(mHeapType);
+		}
+
+		uint32_t pageSize = std::max(numDescriptors, mNumDescriptorsPerPage);
+		auto heap = app.CreateDescriptorHeap(pageSize, mHeapType);
+		mPages.push_back(std::unique_ptr<Page>(new Page{ heap,
+			heap->GetCPUDescriptorHandleForHeapStart(), FreeListAllocator(pageSize) }));
+
+		pageIndex = static_cast<uint32_t>(mPages.size() - 1);
+		offset = mPages[pageIndex]->allocator.Allocate(numDescriptors);
+		assert(offset != FreeListAllocator::InvalidOffset);
+	}
+
+	DescriptorAllocation allocation;
+	allocation.mDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(mPages[pageIndex]->baseDescriptor, offset, mDescriptorSize);
+	allocation.mNumHandles = numDescriptors;
+	allocation.mDescriptorSize = mDescriptorSize;
+	allocation.mPageIndex = pageIndex;
+	allocation.mOffset = offset;
+
+	return allocation;
+}
+
+void DescriptorAllocator::Free(DescriptorAllocation&& allocation, CommandQueue& commandQueue)
+{
+	if (allocation.IsNull())
+	{
+		return;
+	}
+
+	uint32_t pageIndex = allocation.mPageIndex;
+	uint32_t offset = allocation.mOffset;
+	uint32_t numHandles = allocation.mNumHandles;
+	allocation = DescriptorAllocation();
+
+	commandQueue.AddFenceCallback(commandQueue.GetLastSignaledFenceValue(), [this, pageIndex, offset, numHandles]()
+	{
+		FreeRange(pageIndex, offset, numHandles);
+	});
+}
+
+void DescriptorAllocator::Free(DescriptorAllocation&& allocation)
+{
+	if (allocation.IsNull())
+	{
+		return;
+	}
+
+	FreeRange(allocation.mPageIndex, allocation.mOffset, allocation.mNumHandles);
+	allocation = DescriptorAllocation();
+}
+
+void DescriptorAllocator::FreeRange(uint32_t pageIndex, uint32_t offset, uint32_t numHandles)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	assert(pageIndex < mPages.size() && "Descriptors were not allocated by this allocator.");
+	mPages[pageIndex]->allocator.Free(offset, numHandles);
+}
+
+D3D12_DESCRIPTOR_HEAP_TYPE DescriptorAllocator::GetHeapType() const
+{
+	return mHeapType;
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	Stats stats = {};
+	stats.PageCount = static_cast<uint32_t>(mPages.size());
+	for (auto& page : mPages)
+	{
+		stats.TotalDescriptors += page->allocator.GetSize();
+		stats.AllocatedDescriptors += page->allocator.GetSize() - page->allocator.GetFreeCount();
+		stats.FreeRangeCount += page->allocator.GetFreeRangeCount();
+		stats.LargestFreeRange = std::max(stats.LargestFreeRange, page->allocator.GetLargestFreeRange());
+	}
+	stats.Occupancy = stats.TotalDescriptors > 0 ?
+		static_cast<double>(stats.AllocatedDescriptors) / stats.TotalDescriptors : 0.0;
+
+	return stats;
+}
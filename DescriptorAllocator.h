@@ -0,0 +1,94 @@
+#pragma once
+
+#include "FreeListAllocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class CommandQueue;
+class DescriptorAllocator;
+
+// A contiguous range of CPU descriptors handed out by a DescriptorAllocator.
+// A default constructed allocation is null.
+class DescriptorAllocation
+{
+public:
+	DescriptorAllocation();
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandle(uint32_t offset = 0) const;
+	uint32_t GetNumHandles() const;
+	bool IsNull() const;
+
+private:
+	friend class DescriptorAllocator;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE mDescriptor;
+	uint32_t mNumHandles;
+	uint32_t mDescriptorSize;
+	// Index of the page in the allocator and the first descriptor in the page.
+	uint32_t mPageIndex;
+	uint32_t mOffset;
+};
+
+// Allocates ranges of CPU (non shader visible) descriptors of one type.
+// Descriptors come from large heap pages created with
+// Application::CreateDescriptorHeap, each managed by a free list, instead
+// of one small heap per user.
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage = 256);
+	virtual ~DescriptorAllocator();
+
+	// Allocate a number of contiguous descriptors. Requests larger than a
+	// page get a page of their own.
+	DescriptorAllocation Allocate(uint32_t numDescriptors = 1);
+
+	// Return the descriptors to the allocator once all work submitted to the
+	// queue so far has completed.
+	void Free(DescriptorAllocation&& allocation, CommandQueue& commandQueue);
+	// Return the descriptors to the allocator immediately. The GPU must not
+	// be using them anymore.
+	void Free(DescriptorAllocation&& allocation);
+
+	D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType() const;
+
+	struct Stats
+	{
+		uint32_t PageCount;
+		uint32_t TotalDescriptors;
+		uint32_t AllocatedDescriptors;
+		uint32_t FreeRangeCount;
+		uint32_t LargestFreeRange;
+		// Allocated descriptors / total descriptors.
+		double Occupancy;
+	};
+	Stats GetStats() const;
+
+private:
+	DescriptorAllocator(const DescriptorAllocator& copy) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+	struct Page
+	{
+		ComPtr<ID3D12DescriptorHeap> heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE baseDescriptor;
+		FreeListAllocator allocator;
+	};
+
+	void FreeRange(uint32_t pageIndex, uint32_t offset, uint32_t numHandles);
+
+	D3D12_DESCRIPTOR_HEAP_TYPE mHeapType;
+	uint32_t mNumDescriptorsPerPage;
+	uint32_t mDescriptorSize;
+
+	mutable std::mutex mMutex;
+	std::vector<std::unique_ptr<Page>> mPages;
+};
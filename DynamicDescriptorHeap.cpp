@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "DynamicDescriptorHeap.h"
+
+#include "FrameContext.h"
+
+DescriptorRing::DescriptorRing(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> heap,
+	uint32_t firstDescriptor, uint32_t numDescriptors, ComPtr<ID3D12Fence> fence)
+	: mDevice(device)
+	, mFence(fence)
+	, mDescriptorHeap(heap)
+	, mRing(numDescriptors)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = mDescriptorHeap->GetDesc();
+	assert((heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) &&
+		firstDescriptor + numDescriptors <= heapDesc.NumDescriptors);
+
+	mHeapType = heapDesc.Type;
+	mDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(mHeapType);
+	mCPUBase = CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+	mGPUBase = CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+}
+
+DescriptorRing::~DescriptorRing()
+{
+}
+
+DescriptorRing::Allocation DescriptorRing::Allocate(uint32_t numDescriptors)
+{
+	uint64_t offset = mRing.Allocate(numDescriptors, 1);
+	if (offset == RingAllocator::InvalidOffset)
+	{
+		// Give back whatever the GPU has finished with and try again.
+		Reclaim();
+		offset = mRing.Allocate(numDescriptors, 1);
+	}
+
+	// Only one shader-visible heap of a type can be bound at a time, so
+	// there is nothing to fall back to. Size the ring for the frames in flight.
+	if (offset == RingAllocator::InvalidOffset)
+	{
+		throw std::exception();
+	}
+
+	INT index = static_cast<INT>(offset);
+	return Allocation{
+		CD3DX12_CPU_DESCRIPTOR_HANDLE(mCPUBase, index, mDescriptorSize),
+		CD3DX12_GPU_DESCRIPTOR_HANDLE(mGPUBase, index, mDescriptorSize) };
+}
+
+void DescriptorRing::Retire(uint64_t fenceValue)
+{
+	mRing.Retire(fenceValue);
+}
+
+void DescriptorRing::Reclaim()
+{
+	mRing.Reclaim(mFence->GetCompletedValue());
+}
+
+ID3D12Device2* DescriptorRing::GetDevice() const
+{
+	return mDevice.Get();
+}
+
+ID3D12DescriptorHeap* DescriptorRing::GetDescriptorHeap() const
+{
+	return mDescriptorHeap.Get();
+}
+
+D3D12_DESCRIPTOR_HEAP_TYPE DescriptorRing::GetHeapType() const
+{
+	return mHeapType;
+}
+
+uint32_t DescriptorRing::GetDescriptorSize() const
+{
+	return mDescriptorSize;
+}
+
+uint32_t DescriptorRing::GetCapacity() const
+{
+	return static_cast<uint32_t>(mRing.GetCapacity());
+}
+
+uint32_t DescriptorRing::GetUsedCount() const
+{
+	return static_cast<uint32_t>(mRing.GetUsedSize());
+}
+
+DynamicDescriptorHeap::DynamicDescriptorHeap(DescriptorRing& descriptorRing)
+	: mDescriptorRing(descriptorRing)
+	, mFrameContext(nullptr)
+	, mDescriptorTables{}
+	, mDescriptorTableMask(0)
+	, mDirtyTableMask(0)
+{
+}
+
+DynamicDescriptorHeap::~DynamicDescriptorHeap()
+{
+}
+
+void DynamicDescriptorHeap::ParseRootSignature(const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc)
+{
+	assert(rootSignatureDesc.NumParameters <= MaxRootParameters);
+
+	bool samplerHeap = mDescriptorRing.GetHeapType() == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+
+	mDescriptorTableMask = 0;
+	mDirtyTableMask = 0;
+	mStagedDescriptors.clear();
+
+	for (uint32_t i = 0; i < rootSignatureDesc.NumParameters; ++i)
+	{
+		mDescriptorTables[i] = DescriptorTable{};
+
+		const D3D12_ROOT_PARAMETER1& rootParameter = rootSignatureDesc.pParameters[i];
+		if (rootParameter.ParameterType != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE ||
+			rootParameter.DescriptorTable.NumDescriptorRanges == 0)
+		{
+			continue;
+		}
+
+		// Samplers can't share a table with other descriptor types.
+		const D3D12_ROOT_DESCRIPTOR_TABLE1& table = rootParameter.DescriptorTable;
+		bool samplerTable = table.pDescriptorRanges[0].RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+		if (samplerTable != samplerHeap)
+		{
+			continue;
+		}
+
+		uint32_t numDescriptors = 0;
+		uint32_t rangeEnd = 0;
+		for (uint32_t r = 0; r < table.NumDescriptorRanges; ++r)
+		{
+			const D3D12_DESCRIPTOR_RANGE1& range = table.pDescriptorRanges[r];
+			if (range.NumDescriptors == UINT_MAX)
+			{
+				numDescriptors = MaxDescriptorsPerTable;
+				break;
+			}
+			uint32_t rangeStart = range.OffsetInDescriptorsFromTableStart == D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND ?
+				rangeEnd : range.OffsetInDescriptorsFromTableStart;
+			rangeEnd = rangeStart + range.NumDescriptors;
+			numDescriptors = std::max(numDescriptors, rangeEnd);
+		}
+		numDescriptors = std::min(numDescriptors, MaxDescriptorsPerTable);
+
+		mDescriptorTables[i].firstStaged = static_cast<uint32_t>(mStagedDescriptors.size());
+		mDescriptorTables[i].numDescriptors = numDescriptors;
+		mStagedDescriptors.resize(mStagedDescriptors.size() + numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE{ 0 });
+
+		mDescriptorTableMask |= 1ull << i;
+	}
+}
+
+void DynamicDescriptorHeap::StageDescriptors(uint32_t rootParameterIndex, uint32_t offset,
+	uint32_t numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+	assert(rootParameterIndex < MaxRootParameters && (mDescriptorTableMask & (1ull << rootParameterIndex)) &&
+		"Root parameter is not a descriptor table of this heap type.");
+
+	DescriptorTable& table = mDescriptorTables[rootParameterIndex];
+	if (offset + numDescriptors > table.numDescriptors)
+	{
+		// More descriptors than the table can hold.
+		throw std::exception();
+	}
+
+	UINT descriptorSize = mDescriptorRing.GetDescriptorSize();
+	for (uint32_t i = 0; i < numDescriptors; ++i)
+	{
+		mStagedDescriptors[table.firstStaged + offset + i] =
+			CD3DX12_CPU_DESCRIPTOR_HANDLE(srcDescriptor, i, descriptorSize);
+	}
+
+	table.numStaged = std::max(table.numStaged, offset + numDescriptors);
+	mDirtyTableMask |= 1ull << rootParameterIndex;
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptorsForDraw(ID3D12GraphicsCommandList* commandList)
+{
+	CommitStagedDescriptors([commandList](UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+	{
+		commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	});
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptorsForDispatch(ID3D12GraphicsCommandList* commandList)
+{
+	CommitStagedDescriptors([commandList](UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+	{
+		commandList->SetComputeRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	});
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptorsForDraw(GraphicsCommandList& commandList)
+{
+	CommitStagedDescriptors([&commandList](UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+	{
+		commandList.SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	});
+}
+
+template<typename SetRootDescriptorTable>
+void DynamicDescriptorHeap::CommitStagedDescriptors(SetRootDescriptorTable setRootDescriptorTable)
+{
+	uint64_t dirtyTableMask = mDirtyTableMask & mDescriptorTableMask;
+	if (dirtyTableMask == 0)
+	{
+		return;
+	}
+
+	// Gather the staged descriptors of every dirty table so they can be
+	// copied into one contiguous range of the ring.
+	mSrcDescriptors.clear();
+	for (uint64_t mask = dirtyTableMask; mask != 0; mask &= mask - 1)
+	{
+		unsigned long rootParameterIndex;
+		_BitScanForward64(&rootParameterIndex, mask);
+
+		const DescriptorTable& table = mDescriptorTables[rootParameterIndex];
+		for (uint32_t i = 0; i < table.numStaged; ++i)
+		{
+			assert(mStagedDescriptors[table.firstStaged + i].ptr != 0 && "Descriptor table has a gap.");
+			mSrcDescriptors.push_back(mStagedDescriptors[table.firstStaged + i]);
+		}
+	}
+
+	UINT numDescriptors = static_cast<UINT>(mSrcDescriptors.size());
+	if (numDescriptors == 0)
+	{
+		mDirtyTableMask = 0;
+		return;
+	}
+
+	DescriptorRing::Allocation allocation = mFrameContext ?
+		mFrameContext->AllocateDescriptors(numDescriptors) : mDescriptorRing.Allocate(numDescriptors);
+
+	// A null array of source range sizes means every source range is one descriptor.
+	mDescriptorRing.GetDevice()->CopyDescriptors(1, &allocation.CPU, &numDescriptors,
+		numDescriptors, mSrcDescriptors.data(), nullptr, mDescriptorRing.GetHeapType());
+
+	INT offset = 0;
+	UINT descriptorSize = mDescriptorRing.GetDescriptorSize();
+	for (uint64_t mask = dirtyTableMask; mask != 0; mask &= mask - 1)
+	{
+		unsigned long rootParameterIndex;
+		_BitScanForward64(&rootParameterIndex, mask);
+
+		uint32_t numStaged = mDescriptorTables[rootParameterIndex].numStaged;
+		if (numStaged > 0)
+		{
+			setRootDescriptorTable(rootParameterIndex, CD3DX12_GPU_DESCRIPTOR_HANDLE(allocation.GPU, offset, descriptorSize));
+			offset += numStaged;
+		}
+	}
+
+	mDirtyTableMask = 0;
+}
+
+void DynamicDescriptorHeap::Reset()
+{
+	mFrameContext = nullptr;
+	mDirtyTableMask = mDescriptorTableMask;
+}
+
+void DynamicDescriptorHeap::Reset(FrameContext& frameContext)
+{
+	assert(frameContext.GetDescriptorHeap() == mDescriptorRing.GetDescriptorHeap() &&
+		"The frame's descriptors are in another heap.");
+
+	Reset();
+	mFrameContext = &frameContext;
+}
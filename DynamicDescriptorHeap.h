@@ -0,0 +1,142 @@
+#pragma once
+
+#include "GraphicsCommandList.h"
+#include "RingAllocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class FrameContext;
+
+// A shader-visible descriptor heap used as a ring.
+// Descriptor tables are copied into it right before a draw or dispatch and
+// the space is retired against the fence of the queue that executes them,
+// the same way UploadBuffer retires upload memory.
+class DescriptorRing
+{
+public:
+	struct Allocation
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE CPU;
+		D3D12_GPU_DESCRIPTOR_HANDLE GPU;
+	};
+
+	// Use numDescriptors descriptors of a shader-visible heap, starting at
+	// firstDescriptor. fence is the fence of the queue that executes the
+	// command lists.
+	DescriptorRing(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> heap,
+		uint32_t firstDescriptor, uint32_t numDescriptors, ComPtr<ID3D12Fence> fence);
+	virtual ~DescriptorRing();
+
+	// Allocate a number of contiguous descriptors. Thread-safe.
+	// Throws if the ring is still full after reclaiming.
+	Allocation Allocate(uint32_t numDescriptors);
+
+	// Everything allocated so far stays in use until the fence reaches fenceValue.
+	// Call this after the command lists that use the descriptors are submitted.
+	void Retire(uint64_t fenceValue);
+
+	// Free everything retired with a fence value the GPU has passed.
+	void Reclaim();
+
+	ID3D12Device2* GetDevice() const;
+	ID3D12DescriptorHeap* GetDescriptorHeap() const;
+	D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType() const;
+	uint32_t GetDescriptorSize() const;
+
+	uint32_t GetCapacity() const;
+	uint32_t GetUsedCount() const;
+
+private:
+	DescriptorRing(const DescriptorRing& copy) = delete;
+	DescriptorRing& operator=(const DescriptorRing& other) = delete;
+
+	ComPtr<ID3D12Device2> mDevice;
+	ComPtr<ID3D12Fence> mFence;
+	ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
+	D3D12_DESCRIPTOR_HEAP_TYPE mHeapType;
+	uint32_t mDescriptorSize;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE mCPUBase;
+	D3D12_GPU_DESCRIPTOR_HANDLE mGPUBase;
+
+	// Offsets and sizes are in descriptors.
+	RingAllocator mRing;
+};
+
+// Stages CPU descriptors for the descriptor tables of a root signature and
+// copies the tables that changed into a DescriptorRing before each draw or
+// dispatch, with a single CopyDescriptors call.
+// Staging is not thread-safe; use one instance per command list being recorded.
+class DynamicDescriptorHeap
+{
+public:
+	// Tables with an unbounded range stage at most this many descriptors.
+	static const uint32_t MaxDescriptorsPerTable = 256;
+
+	DynamicDescriptorHeap(DescriptorRing& descriptorRing);
+	virtual ~DynamicDescriptorHeap();
+
+	// Find the descriptor tables in the root signature that hold descriptors
+	// of the ring's heap type. Clears everything that was staged.
+	void ParseRootSignature(const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc);
+
+	// Stage contiguous CPU descriptors for a descriptor table.
+	// offset is the first descriptor in the table to update.
+	void StageDescriptors(uint32_t rootParameterIndex, uint32_t offset,
+		uint32_t numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+	// Copy the dirty tables into the ring and bind them. The ring's heap must
+	// be bound with SetDescriptorHeaps.
+	void CommitStagedDescriptorsForDraw(ID3D12GraphicsCommandList* commandList);
+	void CommitStagedDescriptorsForDispatch(ID3D12GraphicsCommandList* commandList);
+	// Bind the tables through the wrapper, so it knows they are bound.
+	void CommitStagedDescriptorsForDraw(GraphicsCommandList& commandList);
+
+	// Mark every table as dirty, e.g. when starting a new command list.
+	// Commits go to the ring.
+	void Reset();
+	// Same, but commits go to the frame's descriptors until the next Reset.
+	// They are freed with the frame, so nothing has to be retired. The
+	// frame's descriptors must be in the ring's heap.
+	void Reset(FrameContext& frameContext);
+
+private:
+	DynamicDescriptorHeap(const DynamicDescriptorHeap& copy) = delete;
+	DynamicDescriptorHeap& operator=(const DynamicDescriptorHeap& other) = delete;
+
+	// setRootDescriptorTable(rootParameterIndex, baseDescriptor) binds a table.
+	template<typename SetRootDescriptorTable>
+	void CommitStagedDescriptors(SetRootDescriptorTable setRootDescriptorTable);
+
+	// The root signature can have at most 64 DWORDs, and a table takes one.
+	static const uint32_t MaxRootParameters = 64;
+
+	struct DescriptorTable
+	{
+		// Where the table starts in mStagedDescriptors.
+		uint32_t firstStaged;
+		uint32_t numDescriptors;
+		// One past the highest staged descriptor. Only this much is copied.
+		uint32_t numStaged;
+	};
+
+	DescriptorRing& mDescriptorRing;
+	// Null while committing into the ring.
+	FrameContext* mFrameContext;
+
+	DescriptorTable mDescriptorTables[MaxRootParameters];
+	// Root parameters that are descriptor tables of the ring's heap type.
+	uint64_t mDescriptorTableMask;
+	// Tables that changed since they were last committed.
+	uint64_t mDirtyTableMask;
+
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> mStagedDescriptors;
+	// Scratch space for the source descriptors of a commit.
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> mSrcDescriptors;
+};
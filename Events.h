@@ -1,6 +1,8 @@
 #pragma once
 #include "KeyCodes.h"
 
+#include <cstdint>
+
 class EventArgs
 {
 public:
@@ -142,24 +144,35 @@ class UpdateEventArgs : public EventArgs
 {
 public:
 	typedef EventArgs base;
-	UpdateEventArgs(double delta, double total)
+	UpdateEventArgs(double delta, double total, uint32_t frameSlot = 0, double alpha = 0.0)
 		: ElapsedTime(delta)
 		, TotalTime(total)
+		, FrameSlot(frameSlot)
+		, Alpha(alpha)
 	{}
 	double ElapsedTime;
 	double TotalTime;
+	// The slot of the frame in the frame pipeline. Per frame snapshots are
+	// written to and read from this slot.
+	uint32_t FrameSlot;
+	// How far the frame lies between the last two fixed updates, from 0 to 1.
+	double Alpha;
 };
 
 class RenderEventArgs : public EventArgs
 {
 public:
 	typedef EventArgs base;
-	RenderEventArgs(double delta, double total)
+	RenderEventArgs(double delta, double total, uint32_t frameSlot = 0)
 		: ElapsedTime(delta)
 		, TotalTime(total)
+		, FrameSlot(frameSlot)
 	{}
 	double ElapsedTime;
 	double TotalTime;
+	// The slot of the frame in the frame pipeline. Per frame snapshots are
+	// written to and read from this slot.
+	uint32_t FrameSlot;
 };
 
 class UserEventArgs : public EventArgs
@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "FenceWatcher.h"
+
+FenceWatcher::FenceWatcher(ComPtr<ID3D12Fence> fence)
+	: mFence(fence)
+	, mNextOrder(0)
+	, mStop(false)
+{
+	mFenceEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	assert(mFenceEvent && "Failed to create fence event handle.");
+	mWakeEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	assert(mWakeEvent && "Failed to create wake event handle.");
+
+	mThread = std::thread(&FenceWatcher::WaiterThread, this);
+}
+
+FenceWatcher::~FenceWatcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	::SetEvent(mWakeEvent);
+	mThread.join();
+
+	// Run whatever has completed by now. Callbacks whose fence was never
+	// reached are dropped, which still releases anything they captured.
+	uint64_t completedValue = mFence->GetCompletedValue();
+	while (!mPendingCallbacks.empty() && mPendingCallbacks.top().fenceValue <= completedValue)
+	{
+		Callback callback = std::move(const_cast<PendingCallback&>(mPendingCallbacks.top()).callback);
+		mPendingCallbacks.pop();
+		callback();
+	}
+
+	::CloseHandle(mFenceEvent);
+	::CloseHandle(mWakeEvent);
+}
+
+void FenceWatcher::AddCallback(uint64_t fenceValue, Callback callback)
+{
+	if (mFence->GetCompletedValue() >= fenceValue)
+	{
+		callback();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPendingCallbacks.push(PendingCallback{ fenceValue, mNextOrder++, std::move(callback) });
+	}
+	::SetEvent(mWakeEvent);
+}
+
+size_t FenceWatcher::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPendingCallbacks.size();
+}
+
+void FenceWatcher::WaiterThread()
+{
+	std::vector<Callback> readyCallbacks;
+
+	for (;;)
+	{
+		uint64_t nextFenceValue = 0;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mStop)
+			{
+				break;
+			}
+
+			uint64_t completedValue = mFence->GetCompletedValue();
+			while (!mPendingCallbacks.empty() && mPendingCallbacks.top().fenceValue <= completedValue)
+			{
+				// priority_queue::top is const, but the entry is popped right after.
+				readyCallbacks.push_back(std::move(const_cast<PendingCallback&>(mPendingCallbacks.top()).callback));
+				mPendingCallbacks.pop();
+			}
+
+			if (!mPendingCallbacks.empty())
+			{
+				nextFenceValue = mPendingCallbacks.top().fenceValue;
+			}
+		}
+
+		// Callbacks are run outside of the lock so they may register new callbacks.
+		if (!readyCallbacks.empty())
+		{
+			for (auto& callback : readyCallbacks)
+			{
+				callback();
+			}
+			readyCallbacks.clear();
+			continue;
+		}
+
+		HANDLE handles[] = { mWakeEvent, mFenceEvent };
+		DWORD handleCount = 1;
+		if (nextFenceValue)
+		{
+			// A stale completion event from an earlier, higher fence value
+			// only causes a spurious wake-up; the completed value is rechecked.
+			ThrowIfFailed(mFence->SetEventOnCompletion(nextFenceValue, mFenceEvent));
+			handleCount = 2;
+		}
+		::WaitForMultipleObjects(handleCount, handles, FALSE, INFINITE);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// Runs callbacks once a fence reaches a given value.
+// A single waiter thread sleeps on the fence for the lowest pending value,
+// so callers never have to block on the fence themselves.
+class FenceWatcher
+{
+public:
+	using Callback = std::function<void()>;
+
+	FenceWatcher(ComPtr<ID3D12Fence> fence);
+	virtual ~FenceWatcher();
+
+	// Run the callback once the fence reaches fenceValue. Callbacks run on the
+	// waiter thread in fence order. If the fence value has already been
+	// reached, the callback runs immediately on the calling thread.
+	void AddCallback(uint64_t fenceValue, Callback callback);
+
+	// The number of callbacks that are still waiting on the fence.
+	size_t GetPendingCount() const;
+
+private:
+	FenceWatcher(const FenceWatcher& copy) = delete;
+	FenceWatcher& operator=(const FenceWatcher& other) = delete;
+
+	void WaiterThread();
+
+	struct PendingCallback
+	{
+		uint64_t fenceValue;
+		// Keeps callbacks for the same fence value in registration order.
+		uint64_t order;
+		Callback callback;
+	};
+
+	struct Later
+	{
+		bool operator()(const PendingCallback& a, const PendingCallback& b) const
+		{
+			return a.fenceValue > b.fenceValue || (a.fenceValue == b.fenceValue && a.order > b.order);
+		}
+	};
+
+	using PendingQueue = std::priority_queue<PendingCallback, std::vector<PendingCallback>, Later>;
+
+	ComPtr<ID3D12Fence>	mFence;
+	HANDLE				mFenceEvent;
+	// Signaled when a callback is added or the watcher shuts down.
+	HANDLE				mWakeEvent;
+
+	mutable std::mutex	mMutex;
+	PendingQueue		mPendingCallbacks;
+	uint64_t			mNextOrder;
+	bool				mStop;
+
+	std::thread			mThread;
+};
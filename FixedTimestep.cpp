@@ -0,0 +1,100 @@
+#include "pch.h"
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double tickRate, uint32_t maxTicksPerFrame)
+	: mMaxTicksPerFrame(std::max(maxTicksPerFrame, 1u))
+	, mAccumulatedTime(0)
+	, mTickCount(0)
+	, mDroppedTime(0)
+{
+	SetTickRate(tickRate);
+}
+
+FixedTimestep::~FixedTimestep()
+{
+}
+
+void FixedTimestep::SetTickRate(double tickRate)
+{
+	assert(tickRate > 0.0);
+
+	mTickRate = tickRate;
+	mTickInterval = std::max(std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / tickRate)), Duration(1));
+}
+
+double FixedTimestep::GetTickRate() const
+{
+	return mTickRate;
+}
+
+void FixedTimestep::SetMaxTicksPerFrame(uint32_t maxTicksPerFrame)
+{
+	mMaxTicksPerFrame = std::max(maxTicksPerFrame, 1u);
+}
+
+uint32_t FixedTimestep::GetMaxTicksPerFrame() const
+{
+	return mMaxTicksPerFrame;
+}
+
+void FixedTimestep::Advance(Duration elapsed)
+{
+	mAccumulatedTime += std::max(elapsed, Duration(0));
+
+	Duration maxTime = mTickInterval * mMaxTicksPerFrame;
+	if (mAccumulatedTime > maxTime)
+	{
+		mDroppedTime += mAccumulatedTime - maxTime;
+		mAccumulatedTime = maxTime;
+	}
+}
+
+bool FixedTimestep::Step()
+{
+	if (mAccumulatedTime < mTickInterval)
+	{
+		return false;
+	}
+
+	mAccumulatedTime -= mTickInterval;
+	++mTickCount;
+
+	return true;
+}
+
+double FixedTimestep::GetAlpha() const
+{
+	return std::min(static_cast<double>(mAccumulatedTime.count()) / mTickInterval.count(), 1.0);
+}
+
+FixedTimestep::Duration FixedTimestep::GetTickInterval() const
+{
+	return mTickInterval;
+}
+
+double FixedTimestep::GetTickSeconds() const
+{
+	return std::chrono::duration<double>(mTickInterval).count();
+}
+
+double FixedTimestep::GetTotalSeconds() const
+{
+	return mTickCount * GetTickSeconds();
+}
+
+uint64_t FixedTimestep::GetTickCount() const
+{
+	return mTickCount;
+}
+
+FixedTimestep::Duration FixedTimestep::GetDroppedTime() const
+{
+	return mDroppedTime;
+}
+
+void FixedTimestep::Reset()
+{
+	mAccumulatedTime = Duration(0);
+	mTickCount = 0;
+	mDroppedTime = Duration(0);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Runs a simulation in steps of a fixed length, however long frames take.
+// The time of each frame is added with Advance and used up by Step, one
+// tick at a time. What is left over, less than a tick, says how far the
+// frame lies between the last two simulated states, so rendering can blend
+// them.
+//
+// Simulated time only ever moves in whole ticks, so a simulation that only
+// depends on the ticks gives the same results at any frame rate. When the
+// simulation can't keep up, time beyond a number of ticks per frame is
+// dropped; the simulation slows down instead of falling further and further
+// behind.
+class FixedTimestep
+{
+public:
+	using Duration = std::chrono::nanoseconds;
+
+	FixedTimestep(double tickRate = 60.0, uint32_t maxTicksPerFrame = 8);
+	virtual ~FixedTimestep();
+
+	// Ticks per second.
+	void SetTickRate(double tickRate);
+	double GetTickRate() const;
+	void SetMaxTicksPerFrame(uint32_t maxTicksPerFrame);
+	uint32_t GetMaxTicksPerFrame() const;
+
+	// Add the time that passed since the last frame.
+	void Advance(Duration elapsed);
+	// Take a tick if there is enough time left for one.
+	bool Step();
+
+	// How far the time left is into the next tick, from 0 to 1.
+	double GetAlpha() const;
+
+	Duration GetTickInterval() const;
+	double GetTickSeconds() const;
+	// The simulated time, in whole ticks.
+	double GetTotalSeconds() const;
+	uint64_t GetTickCount() const;
+	// Time that was dropped because there were too many ticks in a frame.
+	Duration GetDroppedTime() const;
+
+	// Start again at tick 0.
+	void Reset();
+
+private:
+	FixedTimestep(const FixedTimestep& copy) = delete;
+	FixedTimestep& operator=(const FixedTimestep& other) = delete;
+
+	double mTickRate;
+	Duration mTickInterval;
+	uint32_t mMaxTicksPerFrame;
+
+	// Time that has not been simulated yet.
+	Duration mAccumulatedTime;
+	uint64_t mTickCount;
+	Duration mDroppedTime;
+};
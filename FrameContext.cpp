@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "FrameContext.h"
+
+#include "CommandQueue.h"
+#include "Profiler.h"
+
+static ComPtr<ID3D12Resource> CreateUploadResource(ID3D12Device2* device, uint64_t size)
+{
+	ComPtr<ID3D12Resource> resource;
+
+	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(device->CreateCommittedResource(
+		&heapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&resource)));
+
+	return resource;
+}
+
+FrameContext::FrameContext(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> descriptorHeap,
+	uint32_t firstDescriptor, uint32_t numDescriptors, uint64_t uploadSize)
+	: mDevice(device)
+	, mUploadAllocator(uploadSize)
+	, mDescriptorHeap(descriptorHeap)
+	, mDescriptorAllocator(numDescriptors)
+	, mGPUTimerBegun(false)
+	, mGPUTimerEnded(false)
+	, mFrameNumber(0)
+	, mFenceValue(0)
+	, mCPUTime(0.0)
+{
+	mUploadResource = CreateUploadResource(mDevice.Get(), uploadSize);
+
+	// Upload heaps can stay mapped for their whole lifetime.
+	CD3DX12_RANGE readRange(0, 0);
+	void* cpuBase = nullptr;
+	ThrowIfFailed(mUploadResource->Map(0, &readRange, &cpuBase));
+	mUploadCPUBase = static_cast<uint8_t*>(cpuBase);
+	mUploadGPUBase = mUploadResource->GetGPUVirtualAddress();
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = mDescriptorHeap->GetDesc();
+	assert((heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) &&
+		firstDescriptor + numDescriptors <= heapDesc.NumDescriptors);
+
+	mDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(heapDesc.Type);
+	mDescriptorCPUBase = CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+	mDescriptorGPUBase = CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(),
+		firstDescriptor, mDescriptorSize);
+
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = 2;
+	ThrowIfFailed(mDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&mTimestampQueryHeap)));
+
+	auto readbackHeapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(2 * sizeof(uint64_t));
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&readbackHeapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&readbackDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mTimestampReadback)));
+}
+
+FrameContext::~FrameContext()
+{
+	mUploadResource->Unmap(0, nullptr);
+}
+
+UploadBuffer::Allocation FrameContext::AllocateUpload(uint64_t size, uint64_t alignment)
+{
+	uint64_t offset = mUploadAllocator.Allocate(size, alignment);
+	if (offset != LinearAllocator::InvalidOffset)
+	{
+		return UploadBuffer::Allocation{ mUploadCPUBase + offset, mUploadGPUBase + offset, mUploadResource.Get(), offset };
+	}
+
+	// The arena is full. Resource addresses are aligned to 64KB.
+	ComPtr<ID3D12Resource> resource = CreateUploadResource(mDevice.Get(), size);
+
+	CD3DX12_RANGE readRange(0, 0);
+	void* cpu = nullptr;
+	ThrowIfFailed(resource->Map(0, &readRange, &cpu));
+
+	UploadBuffer::Allocation allocation{ cpu, resource->GetGPUVirtualAddress(), resource.Get(), 0 };
+
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	mFallbackUploads.push_back(resource);
+
+	return allocation;
+}
+
+DescriptorRing::Allocation FrameContext::AllocateDescriptors(uint32_t numDescriptors)
+{
+	// Only one shader-visible heap of a type can be bound at a time, so
+	// there is nothing to fall back to.
+	uint64_t offset = mDescriptorAllocator.Allocate(numDescriptors, 1);
+	if (offset == LinearAllocator::InvalidOffset)
+	{
+		throw std::exception();
+	}
+
+	INT index = static_cast<INT>(offset);
+	return DescriptorRing::Allocation{
+		CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptorCPUBase, index, mDescriptorSize),
+		CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorGPUBase, index, mDescriptorSize) };
+}
+
+ID3D12DescriptorHeap* FrameContext::GetDescriptorHeap() const
+{
+	return mDescriptorHeap.Get();
+}
+
+void FrameContext::BeginGPUTimer(ID3D12GraphicsCommandList* commandList)
+{
+	commandList->EndQuery(mTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+	mGPUTimerBegun = true;
+}
+
+void FrameContext::EndGPUTimer(ID3D12GraphicsCommandList* commandList)
+{
+	assert(mGPUTimerBegun && "BeginGPUTimer was not called.");
+
+	commandList->EndQuery(mTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+	commandList->ResolveQueryData(mTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, mTimestampReadback.Get(), 0);
+	mGPUTimerEnded = true;
+}
+
+double FrameContext::ReadGPUTime(uint64_t timestampFrequency) const
+{
+	if (!mGPUTimerEnded || timestampFrequency == 0)
+	{
+		return 0.0;
+	}
+
+	CD3DX12_RANGE readRange(0, 2 * sizeof(uint64_t));
+	void* data = nullptr;
+	ThrowIfFailed(mTimestampReadback->Map(0, &readRange, &data));
+	const uint64_t* timestamps = static_cast<const uint64_t*>(data);
+	uint64_t ticks = timestamps[1] > timestamps[0] ? timestamps[1] - timestamps[0] : 0;
+	CD3DX12_RANGE writeRange(0, 0);
+	mTimestampReadback->Unmap(0, &writeRange);
+
+	return ticks * 1000.0 / timestampFrequency;
+}
+
+void FrameContext::Reset(uint64_t frameNumber)
+{
+	mUploadAllocator.Reset();
+	mDescriptorAllocator.Reset();
+
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	mFallbackUploads.clear();
+
+	mGPUTimerBegun = false;
+	mGPUTimerEnded = false;
+
+	mFrameNumber = frameNumber;
+	mFenceValue = 0;
+	mCPUTime = 0.0;
+}
+
+uint64_t FrameContext::GetFrameNumber() const
+{
+	return mFrameNumber;
+}
+
+uint64_t FrameContext::GetFenceValue() const
+{
+	return mFenceValue;
+}
+
+FrameContext::Stats FrameContext::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	return Stats{
+		mUploadAllocator.GetUsedSize(),
+		static_cast<uint32_t>(mDescriptorAllocator.GetUsedSize()),
+		static_cast<uint32_t>(mFallbackUploads.size()) };
+}
+
+FrameContextManager::FrameContextManager(ComPtr<ID3D12Device2> device, std::shared_ptr<CommandQueue> commandQueue, uint32_t frameCount,
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap, uint32_t firstDescriptor, uint32_t numDescriptorsPerFrame,
+	uint64_t uploadSizePerFrame)
+	: mCommandQueue(commandQueue)
+	, mTimestampFrequency(0)
+	, mFrameNumber(0)
+	, mInFrame(false)
+{
+	assert(frameCount > 0 && "At least one frame is needed.");
+
+	ThrowIfFailed(mCommandQueue->GetD3D12CommandQueue()->GetTimestampFrequency(&mTimestampFrequency));
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		mFrameContexts.push_back(std::make_unique<FrameContext>(device, descriptorHeap,
+			firstDescriptor + i * numDescriptorsPerFrame, numDescriptorsPerFrame, uploadSizePerFrame));
+	}
+}
+
+FrameContextManager::~FrameContextManager()
+{
+	// The GPU may still read the memory of the frames in flight.
+	for (const auto& frameContext : mFrameContexts)
+	{
+		mCommandQueue->WaitForFenceValue(frameContext->GetFenceValue());
+	}
+}
+
+FrameContext& FrameContextManager::BeginFrame()
+{
+	assert(!mInFrame && "EndFrame was not called for the last frame.");
+
+	FrameContext& frameContext = *mFrameContexts[mFrameNumber % mFrameContexts.size()];
+	{
+		PROFILE_SCOPE("WaitForFrame");
+		mCommandQueue->WaitForFenceValue(frameContext.GetFenceValue());
+	}
+
+	// The GPU is done with the frame that used the context last, so its times
+	// are known now.
+	if (frameContext.GetFenceValue() != 0)
+	{
+		mStatistics.AddFrame(frameContext.GetFrameNumber(), frameContext.mCPUTime,
+			frameContext.ReadGPUTime(mTimestampFrequency));
+	}
+
+	frameContext.Reset(mFrameNumber);
+	frameContext.mCPUStartTime = std::chrono::steady_clock::now();
+
+	++mFrameNumber;
+	mInFrame = true;
+
+	return frameContext;
+}
+
+void FrameContextManager::EndFrame(uint64_t fenceValue)
+{
+	assert(mInFrame && "BeginFrame was not called.");
+
+	FrameContext& frameContext = GetCurrentFrame();
+	frameContext.mFenceValue = fenceValue;
+	frameContext.mCPUTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - frameContext.mCPUStartTime).count();
+	mInFrame = false;
+}
+
+FrameContext& FrameContextManager::GetCurrentFrame()
+{
+	assert(mFrameNumber > 0 && "No frame was begun yet.");
+	return *mFrameContexts[(mFrameNumber - 1) % mFrameContexts.size()];
+}
+
+uint32_t FrameContextManager::GetFrameCount() const
+{
+	return static_cast<uint32_t>(mFrameContexts.size());
+}
+
+FrameStatistics& FrameContextManager::GetStatistics()
+{
+	return mStatistics;
+}
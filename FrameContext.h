@@ -0,0 +1,146 @@
+#pragma once
+
+#include "DynamicDescriptorHeap.h"
+#include "FrameStatistics.h"
+#include "LinearAllocator.h"
+#include "UploadBuffer.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class CommandQueue;
+
+// The memory a frame uses while it is recorded and executed.
+// Uploads and descriptors are handed out from linear arenas that are reset
+// in bulk once the GPU has finished the frame, instead of being retired
+// allocation by allocation. Allocating is thread-safe.
+class FrameContext
+{
+public:
+	// descriptorHeap is a shader-visible heap; the frame uses numDescriptors
+	// of it, starting at firstDescriptor.
+	FrameContext(ComPtr<ID3D12Device2> device, ComPtr<ID3D12DescriptorHeap> descriptorHeap,
+		uint32_t firstDescriptor, uint32_t numDescriptors, uint64_t uploadSize);
+	virtual ~FrameContext();
+
+	// Upload memory the GPU reads during the frame, e.g. constant buffers.
+	// Requests that don't fit get a dedicated upload resource.
+	UploadBuffer::Allocation AllocateUpload(uint64_t size, uint64_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	// Shader-visible descriptors. Throws if the frame runs out of them.
+	DescriptorRing::Allocation AllocateDescriptors(uint32_t numDescriptors);
+	// The heap the descriptors are in, for SetDescriptorHeaps.
+	ID3D12DescriptorHeap* GetDescriptorHeap() const;
+
+	// Time the frame on the GPU. Begin at the start of the first command list
+	// of the frame and end at the end of the last one, both submitted to the
+	// direct queue.
+	void BeginGPUTimer(ID3D12GraphicsCommandList* commandList);
+	void EndGPUTimer(ID3D12GraphicsCommandList* commandList);
+
+	// The number of the frame using the context, counting from 0.
+	uint64_t GetFrameNumber() const;
+	// The fence value of the frame's last submission to the direct queue.
+	uint64_t GetFenceValue() const;
+
+	struct Stats
+	{
+		uint64_t UploadSize;
+		uint32_t Descriptors;
+		uint32_t Fallbacks;		// Uploads that didn't fit.
+	};
+	Stats GetStats() const;
+
+private:
+	friend class FrameContextManager;
+
+	FrameContext(const FrameContext& copy) = delete;
+	FrameContext& operator=(const FrameContext& other) = delete;
+
+	// Start a new frame. The GPU must be done with the last one.
+	void Reset(uint64_t frameNumber);
+	// Milliseconds between the GPU timestamps of the last frame, or 0 if it
+	// wasn't timed. The GPU must be done with the frame.
+	double ReadGPUTime(uint64_t timestampFrequency) const;
+
+	ComPtr<ID3D12Device2> mDevice;
+
+	ComPtr<ID3D12Resource> mUploadResource;
+	uint8_t* mUploadCPUBase;
+	D3D12_GPU_VIRTUAL_ADDRESS mUploadGPUBase;
+	LinearAllocator mUploadAllocator;
+
+	ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
+	uint32_t mDescriptorSize;
+	D3D12_CPU_DESCRIPTOR_HANDLE mDescriptorCPUBase;
+	D3D12_GPU_DESCRIPTOR_HANDLE mDescriptorGPUBase;
+	// Offsets and sizes are in descriptors.
+	LinearAllocator mDescriptorAllocator;
+
+	// Uploads that didn't fit, released when the frame is reset.
+	mutable std::mutex mFallbackMutex;
+	std::vector<ComPtr<ID3D12Resource>> mFallbackUploads;
+
+	// Two timestamps, resolved into a readback buffer.
+	ComPtr<ID3D12QueryHeap> mTimestampQueryHeap;
+	ComPtr<ID3D12Resource> mTimestampReadback;
+	bool mGPUTimerBegun;
+	bool mGPUTimerEnded;
+
+	uint64_t mFrameNumber;
+	uint64_t mFenceValue;
+
+	// From BeginFrame to EndFrame.
+	std::chrono::steady_clock::time_point mCPUStartTime;
+	double mCPUTime;
+};
+
+// Cycles through a number of frame contexts chosen at runtime. That many
+// frames can be recorded or executing at once: more keep the GPU busy
+// when frame times vary, fewer lower the latency between input and display.
+class FrameContextManager
+{
+public:
+	// Each frame gets numDescriptorsPerFrame descriptors of descriptorHeap,
+	// one frame after the other starting at firstDescriptor.
+	FrameContextManager(ComPtr<ID3D12Device2> device, std::shared_ptr<CommandQueue> commandQueue, uint32_t frameCount,
+		ComPtr<ID3D12DescriptorHeap> descriptorHeap, uint32_t firstDescriptor, uint32_t numDescriptorsPerFrame,
+		uint64_t uploadSizePerFrame = 4 * 1024 * 1024);
+	virtual ~FrameContextManager();
+
+	// Wait until the GPU has finished the frame that last used the next
+	// context, then reset the context and make it current.
+	FrameContext& BeginFrame();
+	// Finish the current frame. fenceValue is the value of its last
+	// submission to the direct queue.
+	void EndFrame(uint64_t fenceValue);
+
+	FrameContext& GetCurrentFrame();
+	uint32_t GetFrameCount() const;
+
+	// The CPU and GPU times of the last frames. The CPU time is the time from
+	// BeginFrame, after waiting for the GPU, to EndFrame. A frame is added
+	// once its context is reused, when its GPU time is known.
+	FrameStatistics& GetStatistics();
+
+private:
+	FrameContextManager(const FrameContextManager& copy) = delete;
+	FrameContextManager& operator=(const FrameContextManager& other) = delete;
+
+	std::shared_ptr<CommandQueue> mCommandQueue;
+	std::vector<std::unique_ptr<FrameContext>> mFrameContexts;
+
+	FrameStatistics mStatistics;
+	uint64_t mTimestampFrequency;
+
+	// The number of frames begun so far.
+	uint64_t mFrameNumber;
+	bool mInFrame;
+};
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "FramePipeline.h"
+
+FramePipeline::FramePipeline(uint32_t depth)
+	: mDepth(std::max(depth, 1u))
+	, mUpdatedFrames(0)
+	, mRenderedFrames(0)
+	, mUpdating(false)
+	, mRendering(false)
+	, mStopped(false)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+}
+
+bool FramePipeline::CanBeginUpdate() const
+{
+	return mUpdatedFrames - mRenderedFrames < mDepth;
+}
+
+uint32_t FramePipeline::TryBeginUpdate()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	assert(!mUpdating && "A frame is already being updated.");
+
+	if (mStopped || !CanBeginUpdate())
+	{
+		return InvalidSlot;
+	}
+
+	mUpdating = true;
+	return static_cast<uint32_t>(mUpdatedFrames % mDepth);
+}
+
+uint32_t FramePipeline::BeginUpdate()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	assert(!mUpdating && "A frame is already being updated.");
+
+	mCondition.wait(lock, [this]() { return mStopped || CanBeginUpdate(); });
+	if (mStopped)
+	{
+		return InvalidSlot;
+	}
+
+	mUpdating = true;
+	return static_cast<uint32_t>(mUpdatedFrames % mDepth);
+}
+
+void FramePipeline::EndUpdate()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		assert(mUpdating && "No frame is being updated.");
+
+		mUpdating = false;
+		++mUpdatedFrames;
+	}
+	mCondition.notify_all();
+}
+
+uint32_t FramePipeline::BeginRender()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	assert(!mRendering && "A frame is already being rendered.");
+
+	mCondition.wait(lock, [this]() { return mStopped || mRenderedFrames < mUpdatedFrames; });
+	if (mStopped)
+	{
+		return InvalidSlot;
+	}
+
+	mRendering = true;
+	return static_cast<uint32_t>(mRenderedFrames % mDepth);
+}
+
+void FramePipeline::EndRender()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		assert(mRendering && "No frame is being rendered.");
+
+		mRendering = false;
+		++mRenderedFrames;
+	}
+	mCondition.notify_all();
+}
+
+void FramePipeline::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopped = true;
+	}
+	mCondition.notify_all();
+}
+
+bool FramePipeline::IsStopped() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStopped;
+}
+
+uint32_t FramePipeline::GetDepth() const
+{
+	return mDepth;
+}
+
+uint64_t FramePipeline::GetUpdatedFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mUpdatedFrames;
+}
+
+uint64_t FramePipeline::GetRenderedFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRenderedFrames;
+}
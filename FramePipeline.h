@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Hands frames from the update thread to the render thread.
+//
+// Every frame in the pipeline owns a slot. The update thread writes what the
+// render thread needs to draw the frame, a snapshot of the simulation, into
+// the storage of its slot and publishes it. The render thread renders the
+// published frames in order and gives their slots back. Snapshots are kept
+// by the caller, one per slot, so the pipeline only decides which slot each
+// thread may touch.
+//
+// The depth is the number of slots. With two, the next frame is updated
+// while the last one is rendered; the update thread never gets more than
+// depth frames ahead of the render thread.
+class FramePipeline
+{
+public:
+	static const uint32_t InvalidSlot = ~0u;
+
+	FramePipeline(uint32_t depth = 2);
+	virtual ~FramePipeline();
+
+	// Update thread. The slot to write the next frame to, or InvalidSlot if
+	// every slot is in use or the pipeline is stopped.
+	uint32_t TryBeginUpdate();
+	// Wait for a free slot. Returns InvalidSlot once the pipeline is stopped.
+	uint32_t BeginUpdate();
+	// Publish the frame being updated.
+	void EndUpdate();
+
+	// Render thread. Wait for the next published frame and return its slot.
+	// Returns InvalidSlot once the pipeline is stopped.
+	uint32_t BeginRender();
+	// Give the slot of the frame being rendered back.
+	void EndRender();
+
+	// Wake up both threads. Frames that are not being rendered yet are dropped.
+	void Stop();
+	bool IsStopped() const;
+
+	uint32_t GetDepth() const;
+	// Frames published and rendered so far.
+	uint64_t GetUpdatedFrameCount() const;
+	uint64_t GetRenderedFrameCount() const;
+
+private:
+	FramePipeline(const FramePipeline& copy) = delete;
+	FramePipeline& operator=(const FramePipeline& other) = delete;
+
+	// Frames go through the slots in turn, so frame n always uses slot n % depth.
+	bool CanBeginUpdate() const;
+
+	const uint32_t mDepth;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
+	uint64_t mUpdatedFrames;
+	uint64_t mRenderedFrames;
+	bool mUpdating;
+	bool mRendering;
+	bool mStopped;
+};
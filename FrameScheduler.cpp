@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(double targetFrameRate, ClockFunction clock)
+	: mClock(clock)
+	, mStarted(false)
+	, mNextFrameTime(0)
+	, mFrameCount(0)
+	, mMissedFrameCount(0)
+{
+	if (!mClock)
+	{
+		mClock = []()
+		{
+			return std::chrono::duration_cast<Duration>(std::chrono::steady_clock::now().time_since_epoch());
+		};
+	}
+
+	SetTargetFrameRate(targetFrameRate);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+}
+
+void FrameScheduler::SetTargetFrameRate(double targetFrameRate)
+{
+	assert(targetFrameRate >= 0.0);
+
+	mTargetFrameRate = targetFrameRate;
+	mFrameInterval = targetFrameRate > 0.0 ?
+		std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / targetFrameRate)) : Duration(0);
+	mStarted = false;
+}
+
+double FrameScheduler::GetTargetFrameRate() const
+{
+	return mTargetFrameRate;
+}
+
+FrameScheduler::Duration FrameScheduler::GetTimeUntilNextFrame() const
+{
+	if (!mStarted || mFrameInterval.count() == 0)
+	{
+		return Duration(0);
+	}
+
+	return std::max(mNextFrameTime - mClock(), Duration(0));
+}
+
+bool FrameScheduler::IsFrameDue() const
+{
+	return GetTimeUntilNextFrame().count() == 0;
+}
+
+void FrameScheduler::BeginFrame()
+{
+	Duration now = mClock();
+
+	if (!mStarted || mFrameInterval.count() == 0)
+	{
+		mNextFrameTime = now + mFrameInterval;
+		mStarted = true;
+	}
+	else if (now - mNextFrameTime >= mFrameInterval)
+	{
+		// Too late to keep the cadence.
+		mNextFrameTime = now + mFrameInterval;
+		++mMissedFrameCount;
+	}
+	else
+	{
+		mNextFrameTime += mFrameInterval;
+	}
+
+	++mFrameCount;
+}
+
+void FrameScheduler::Reset()
+{
+	mStarted = false;
+}
+
+uint64_t FrameScheduler::GetFrameCount() const
+{
+	return mFrameCount;
+}
+
+uint64_t FrameScheduler::GetMissedFrameCount() const
+{
+	return mMissedFrameCount;
+}
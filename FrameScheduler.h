@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Decides when the next frame is due for a target frame rate.
+// Frames are paced against a fixed cadence rather than the end of the last
+// frame, so short and long frames even out. A frame that starts more than a
+// whole interval late restarts the cadence instead of being caught up with
+// a burst of frames.
+//
+// This only does the timing. Time comes from a clock function, so the
+// scheduler can be driven by a fake clock; waiting is up to the caller.
+class FrameScheduler
+{
+public:
+	using Duration = std::chrono::nanoseconds;
+	// Returns the current time, measured from any fixed point.
+	using ClockFunction = std::function<Duration()>;
+
+	// A target frame rate of 0 runs frames back to back. Without a clock
+	// function std::chrono::steady_clock is used.
+	FrameScheduler(double targetFrameRate = 0.0, ClockFunction clock = nullptr);
+	virtual ~FrameScheduler();
+
+	void SetTargetFrameRate(double targetFrameRate);
+	double GetTargetFrameRate() const;
+
+	// Zero once the next frame is due.
+	Duration GetTimeUntilNextFrame() const;
+	bool IsFrameDue() const;
+
+	// A frame starts now.
+	void BeginFrame();
+	// Start a new cadence with the next frame, e.g. after being idle.
+	void Reset();
+
+	uint64_t GetFrameCount() const;
+	// Frames that started more than a whole interval late.
+	uint64_t GetMissedFrameCount() const;
+
+private:
+	FrameScheduler(const FrameScheduler& copy) = delete;
+	FrameScheduler& operator=(const FrameScheduler& other) = delete;
+
+	ClockFunction mClock;
+	double mTargetFrameRate;
+	Duration mFrameInterval;
+
+	bool mStarted;
+	// When the next frame is due.
+	Duration mNextFrameTime;
+
+	uint64_t mFrameCount;
+	uint64_t mMissedFrameCount;
+};
@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Nearest rank of a sorted list.
+static double Percentile(const std::vector<double>& sorted, double percentile)
+{
+	if (sorted.empty())
+	{
+		return 0.0;
+	}
+
+	size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+	return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+}
+
+static FrameStatistics::Percentiles ComputePercentiles(std::vector<double>& times)
+{
+	FrameStatistics::Percentiles percentiles = {};
+	if (times.empty())
+	{
+		return percentiles;
+	}
+
+	std::sort(times.begin(), times.end());
+
+	double sum = 0.0;
+	for (double time : times)
+	{
+		sum += time;
+	}
+
+	percentiles.Mean = sum / times.size();
+	percentiles.P50 = Percentile(times, 50.0);
+	percentiles.P95 = Percentile(times, 95.0);
+	percentiles.P99 = Percentile(times, 99.0);
+	percentiles.Max = times.back();
+
+	return percentiles;
+}
+
+static std::vector<uint32_t> ComputeHistogram(const std::vector<double>& times, double bucketWidth, uint32_t numBuckets)
+{
+	std::vector<uint32_t> histogram(numBuckets, 0);
+	for (double time : times)
+	{
+		double bucket = std::floor(std::max(time, 0.0) / bucketWidth);
+		++histogram[static_cast<size_t>(std::min(bucket, numBuckets - 1.0))];
+	}
+
+	return histogram;
+}
+
+static void WriteJSONArray(std::ostream& stream, const std::vector<uint32_t>& values)
+{
+	stream << "[";
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		stream << (i > 0 ? ", " : "") << values[i];
+	}
+	stream << "]";
+}
+
+static void WriteJSONPercentiles(std::ostream& stream, const FrameStatistics::Percentiles& percentiles)
+{
+	stream << "{ \"mean\": " << percentiles.Mean
+		<< ", \"p50\": " << percentiles.P50
+		<< ", \"p95\": " << percentiles.P95
+		<< ", \"p99\": " << percentiles.P99
+		<< ", \"max\": " << percentiles.Max << " }";
+}
+
+FrameStatistics::FrameStatistics(uint32_t capacity)
+	: mCapacity(std::max(capacity, 1u))
+	, mEntries(std::make_unique<Entry[]>(mCapacity))
+	, mFrameCount(0)
+{
+	for (uint32_t i = 0; i < mCapacity; ++i)
+	{
+		mEntries[i].Sequence.store(0, std::memory_order_relaxed);
+		mEntries[i].Index.store(0, std::memory_order_relaxed);
+	}
+}
+
+FrameStatistics::~FrameStatistics()
+{
+}
+
+void FrameStatistics::AddFrame(uint64_t frame, double cpuTime, double gpuTime)
+{
+	uint64_t index = mFrameCount.load(std::memory_order_relaxed);
+	Entry& entry = mEntries[index % mCapacity];
+
+	uint64_t sequence = entry.Sequence.load(std::memory_order_relaxed);
+	entry.Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	entry.Index.store(index, std::memory_order_relaxed);
+	entry.Frame.store(frame, std::memory_order_relaxed);
+	entry.CPUTime.store(cpuTime, std::memory_order_relaxed);
+	entry.GPUTime.store(gpuTime, std::memory_order_relaxed);
+
+	entry.Sequence.store(sequence + 2, std::memory_order_release);
+	mFrameCount.store(index + 1, std::memory_order_release);
+}
+
+std::vector<FrameStatistics::FrameTime> FrameStatistics::GetFrames() const
+{
+	uint64_t frameCount = mFrameCount.load(std::memory_order_acquire);
+	uint64_t first = frameCount > mCapacity ? frameCount - mCapacity : 0;
+
+	std::vector<FrameTime> frames;
+	frames.reserve(static_cast<size_t>(frameCount - first));
+	for (uint64_t index = first; index < frameCount; ++index)
+	{
+		const Entry& entry = mEntries[index % mCapacity];
+
+		uint64_t sequence = entry.Sequence.load(std::memory_order_acquire);
+		FrameTime frameTime = {
+			entry.Frame.load(std::memory_order_relaxed),
+			entry.CPUTime.load(std::memory_order_relaxed),
+			entry.GPUTime.load(std::memory_order_relaxed) };
+		uint64_t entryIndex = entry.Index.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// Skip the entry if it was written to in the meantime or already
+		// holds a newer frame.
+		if ((sequence & 1) == 0 && entry.Sequence.load(std::memory_order_relaxed) == sequence && entryIndex == index)
+		{
+			frames.push_back(frameTime);
+		}
+	}
+
+	return frames;
+}
+
+FrameStatistics::Report FrameStatistics::GetReport(double hitchFactor, double bucketWidth, uint32_t numBuckets) const
+{
+	return ComputeReport(GetFrames(), hitchFactor, bucketWidth, numBuckets);
+}
+
+uint32_t FrameStatistics::GetCapacity() const
+{
+	return mCapacity;
+}
+
+uint64_t FrameStatistics::GetFrameCount() const
+{
+	return mFrameCount.load(std::memory_order_acquire);
+}
+
+FrameStatistics::Report FrameStatistics::ComputeReport(const std::vector<FrameTime>& frames,
+	double hitchFactor, double bucketWidth, uint32_t numBuckets)
+{
+	assert(bucketWidth > 0.0 && numBuckets > 0);
+
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	cpuTimes.reserve(frames.size());
+	gpuTimes.reserve(frames.size());
+	for (const FrameTime& frame : frames)
+	{
+		cpuTimes.push_back(frame.CPUTime);
+		gpuTimes.push_back(frame.GPUTime);
+	}
+
+	Report report;
+	report.NumFrames = static_cast<uint32_t>(frames.size());
+	report.BucketWidth = bucketWidth;
+	report.CPUHistogram = ComputeHistogram(cpuTimes, bucketWidth, numBuckets);
+	report.GPUHistogram = ComputeHistogram(gpuTimes, bucketWidth, numBuckets);
+	report.CPU = ComputePercentiles(cpuTimes);
+	report.GPU = ComputePercentiles(gpuTimes);
+
+	report.HitchFactor = hitchFactor;
+	for (const FrameTime& frame : frames)
+	{
+		if ((report.CPU.P50 > 0.0 && frame.CPUTime > hitchFactor * report.CPU.P50) ||
+			(report.GPU.P50 > 0.0 && frame.GPUTime > hitchFactor * report.GPU.P50))
+		{
+			report.Hitches.push_back(frame);
+		}
+	}
+
+	return report;
+}
+
+void FrameStatistics::WriteCSV(std::ostream& stream, const std::vector<FrameTime>& frames)
+{
+	stream << "frame,cpu_ms,gpu_ms\n";
+	for (const FrameTime& frame : frames)
+	{
+		stream << frame.Frame << "," << frame.CPUTime << "," << frame.GPUTime << "\n";
+	}
+}
+
+void FrameStatistics::WriteJSON(std::ostream& stream, const Report& report)
+{
+	stream << "{\n";
+	stream << "  \"frames\": " << report.NumFrames << ",\n";
+	stream << "  \"cpu_ms\": ";
+	WriteJSONPercentiles(stream, report.CPU);
+	stream << ",\n  \"gpu_ms\": ";
+	WriteJSONPercentiles(stream, report.GPU);
+	stream << ",\n  \"histogram_bucket_ms\": " << report.BucketWidth << ",\n";
+	stream << "  \"cpu_histogram\": ";
+	WriteJSONArray(stream, report.CPUHistogram);
+	stream << ",\n  \"gpu_histogram\": ";
+	WriteJSONArray(stream, report.GPUHistogram);
+	stream << ",\n  \"hitch_factor\": " << report.HitchFactor << ",\n";
+	stream << "  \"hitches\": [";
+	for (size_t i = 0; i < report.Hitches.size(); ++i)
+	{
+		const FrameTime& hitch = report.Hitches[i];
+		stream << (i > 0 ? ",\n    " : "\n    ")
+			<< "{ \"frame\": " << hitch.Frame << ", \"cpu_ms\": " << hitch.CPUTime << ", \"gpu_ms\": " << hitch.GPUTime << " }";
+	}
+	stream << (report.Hitches.empty() ? "]\n" : "\n  ]\n");
+	stream << "}\n";
+}
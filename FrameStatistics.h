@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Keeps the CPU and GPU times of the most recent frames and summarizes
+// them as percentiles, histograms and hitches. Averages hide the odd slow
+// frame that makes a game stutter; the tail of the distribution doesn't.
+//
+// Frames are kept in a ring of fixed size. One thread adds them and any
+// number of threads read them at the same time, without locks: a reader
+// skips frames that were overwritten while it copied them.
+class FrameStatistics
+{
+public:
+	struct FrameTime
+	{
+		uint64_t Frame;
+		// In milliseconds. 0 if it wasn't measured.
+		double CPUTime;
+		double GPUTime;
+	};
+
+	struct Percentiles
+	{
+		double Mean;
+		double P50;
+		double P95;
+		double P99;
+		double Max;
+	};
+
+	struct Report
+	{
+		uint32_t NumFrames;
+		Percentiles CPU;
+		Percentiles GPU;
+		// Frames per bucket of BucketWidth milliseconds. The last bucket also
+		// counts all longer frames.
+		double BucketWidth;
+		std::vector<uint32_t> CPUHistogram;
+		std::vector<uint32_t> GPUHistogram;
+		// Frames whose CPU or GPU time is more than HitchFactor times the
+		// median.
+		double HitchFactor;
+		std::vector<FrameTime> Hitches;
+	};
+
+	FrameStatistics(uint32_t capacity = 1024);
+	virtual ~FrameStatistics();
+
+	// Only one thread may add frames.
+	void AddFrame(uint64_t frame, double cpuTime, double gpuTime);
+
+	// The frames in the ring, oldest first.
+	std::vector<FrameTime> GetFrames() const;
+	Report GetReport(double hitchFactor = 2.0, double bucketWidth = 1.0, uint32_t numBuckets = 64) const;
+
+	uint32_t GetCapacity() const;
+	// All frames added so far, including the ones no longer in the ring.
+	uint64_t GetFrameCount() const;
+
+	static Report ComputeReport(const std::vector<FrameTime>& frames,
+		double hitchFactor = 2.0, double bucketWidth = 1.0, uint32_t numBuckets = 64);
+
+	// One line per frame, with a header.
+	static void WriteCSV(std::ostream& stream, const std::vector<FrameTime>& frames);
+	static void WriteJSON(std::ostream& stream, const Report& report);
+
+private:
+	FrameStatistics(const FrameStatistics& copy) = delete;
+	FrameStatistics& operator=(const FrameStatistics& other) = delete;
+
+	// Sequence is odd while the entry is written. Readers check that it
+	// didn't change while they read the rest.
+	struct Entry
+	{
+		std::atomic<uint64_t> Sequence;
+		// The position in the ring the entry was written for.
+		std::atomic<uint64_t> Index;
+		std::atomic<uint64_t> Frame;
+		std::atomic<double> CPUTime;
+		std::atomic<double> GPUTime;
+	};
+
+	const uint32_t mCapacity;
+	std::unique_ptr<Entry[]> mEntries;
+	std::atomic<uint64_t> mFrameCount;
+};
@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "FreeListAllocator.h"
+
+FreeListAllocator::FreeListAllocator(uint32_t size)
+	: mSize(size)
+	, mFreeCount(0)
+{
+	AddFreeRange(0, size);
+}
+
+void FreeListAllocator::AddFreeRange(uint32_t offset, uint32_t count)
+{
+	mFreeByOffset.emplace(offset, count);
+	mFreeBySize.emplace(count, offset);
+	mFreeCount += count;
+}
+
+void FreeListAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIter)
+{
+	uint32_t offset = offsetIter->first;
+	uint32_t count = offsetIter->second;
+
+	auto sizeRange = mFreeBySize.equal_range(count);
+	for (auto sizeIter = sizeRange.first; sizeIter != sizeRange.second; ++sizeIter)
+	{
+		if (sizeIter->second == offset)
+		{
+			mFreeBySize.erase(sizeIter);
+			break;
+		}
+	}
+
+	mFreeByOffset.erase(offsetIter);
+	mFreeCount -= count;
+}
+
+uint32_t FreeListAllocator::Allocate(uint32_t count)
+{
+	if (count == 0 || count > mFreeCount)
+	{
+		return InvalidOffset;
+	}
+
+	// The smallest free range that is large enough.
+	auto sizeIter = mFreeBySize.lower_bound(count);
+	if (sizeIter == mFreeBySize.end())
+	{
+		return InvalidOffset;
+	}
+
+	uint32_t offset = sizeIter->second;
+	uint32_t rangeCount = sizeIter->first;
+
+	RemoveFreeRange(mFreeByOffset.find(offset));
+
+	// Return the rest of the range to the free list.
+	if (rangeCount > count)
+	{
+		AddFreeRange(offset + count, rangeCount - count);
+	}
+
+	return offset;
+}
+
+void FreeListAllocator::Free(uint32_t offset, uint32_t count)
+{
+	assert(offset + count <= mSize && "Range is out of bounds.");
+
+	// The first free range after this one.
+	auto nextIter = mFreeByOffset.upper_bound(offset);
+
+	// Merge with the previous free range if it ends where this one starts.
+	if (nextIter != mFreeByOffset.begin())
+	{
+		auto prevIter = std::prev(nextIter);
+		assert(prevIter->first + prevIter->second <= offset && "Range is already free.");
+		if (prevIter->first + prevIter->second == offset)
+		{
+			offset = prevIter->first;
+			count += prevIter->second;
+			RemoveFreeRange(prevIter);
+		}
+	}
+
+	// Merge with the next free range if it starts where this one ends.
+	if (nextIter != mFreeByOffset.end())
+	{
+		assert(offset + count <= nextIter->first && "Range is already free.");
+		if (offset + count == nextIter->first)
+		{
+			count += nextIter->second;
+			RemoveFreeRange(nextIter);
+		}
+	}
+
+	AddFreeRange(offset, count);
+}
+
+uint32_t FreeListAllocator::GetSize() const
+{
+	return mSize;
+}
+
+uint32_t FreeListAllocator::GetFreeCount() const
+{
+	return mFreeCount;
+}
+
+uint32_t FreeListAllocator::GetFreeRangeCount() const
+{
+	return static_cast<uint32_t>(mFreeByOffset.size());
+}
+
+uint32_t FreeListAllocator::GetLargestFreeRange() const
+{
+	return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+// Allocates contiguous ranges from a fixed number of slots.
+// Free ranges are kept sorted both by offset, so neighbours can be merged
+// when a range is freed, and by size, so allocation is a best fit.
+class FreeListAllocator
+{
+public:
+	static const uint32_t InvalidOffset = ~0u;
+
+	FreeListAllocator(uint32_t size);
+
+	// Returns the offset of the first slot or InvalidOffset if no free range is large enough.
+	uint32_t Allocate(uint32_t count);
+	void Free(uint32_t offset, uint32_t count);
+
+	uint32_t GetSize() const;
+	uint32_t GetFreeCount() const;
+	uint32_t GetFreeRangeCount() const;
+	uint32_t GetLargestFreeRange() const;
+
+private:
+	void AddFreeRange(uint32_t offset, uint32_t count);
+	void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIter);
+
+	uint32_t mSize;
+	uint32_t mFreeCount;
+
+	// Offset -> count.
+	std::map<uint32_t, uint32_t> mFreeByOffset;
+	// Count -> offset.
+	std::multimap<uint32_t, uint32_t> mFreeBySize;
+};
@@ -39,6 +39,11 @@ void Game::Destroy()
 	mWindow.reset();
 }
 
+void Game::OnFixedUpdate(UpdateEventArgs& e)
+{
+
+}
+
 void Game::OnUpdate(UpdateEventArgs& e)
 {
 
@@ -20,6 +20,15 @@ public:
 protected:
 	friend class Window;
 
+	// OnUpdate and the input events are called on the message thread,
+	// OnRender and OnResize on the render thread. OnUpdate writes what the
+	// frame needs into a snapshot for e.FrameSlot, which OnRender reads back
+	// while the next frame is already being updated.
+	//
+	// The simulation belongs in OnFixedUpdate, which is called at the tick
+	// rate of the window's fixed timestep, zero or more times before each
+	// OnUpdate. OnUpdate then blends the last two states by e.Alpha.
+	virtual void OnFixedUpdate(UpdateEventArgs& e);
 	virtual void OnUpdate(UpdateEventArgs& e);
 	virtual void OnRender(RenderEventArgs& e);
 	virtual void OnKeyPressed(KeyEventArgs& e);
@@ -0,0 +1,397 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+// Records into a graphics command list and drops state changes that don't
+// change anything, e.g. binding the PSO that is already bound.
+//
+// The wrapper only knows about state set through it. Calls made on the
+// command list directly (Get) that change tracked state must be followed by
+// Invalidate. That includes descriptor tables committed by a
+// DynamicDescriptorHeap: the wrapper would keep the table it bound last, and
+// drop a later call that binds that table again. Commit through the wrapper
+// instead, with CommitStagedDescriptorsForDraw(GraphicsCommandList&).
+//
+// CommandList is ID3D12GraphicsCommandList2 in the engine (GraphicsCommandList
+// below), but any type with the same methods works, e.g. one that records the
+// calls it receives.
+template<typename CommandList>
+class GraphicsCommandListT
+{
+public:
+	// Calls to methods that shadow state since the last Reset.
+	struct Stats
+	{
+		uint32_t Issued;	// Forwarded to the command list.
+		uint32_t Elided;	// Dropped because they changed nothing.
+	};
+
+	GraphicsCommandListT()
+		: mCommandList(nullptr)
+		, mStats{}
+	{
+		Invalidate();
+	}
+
+	// Start recording into a newly reset command list. Forgets the bound
+	// state and the counters.
+	void Reset(CommandList* commandList)
+	{
+		mCommandList = commandList;
+		mStats = {};
+		Invalidate();
+	}
+
+	// Forget the bound state, so the next call of each kind is issued.
+	void Invalidate()
+	{
+		mPipelineState = nullptr;
+		mPipelineStateValid = false;
+		mRootSignature = nullptr;
+		mRootSignatureValid = false;
+		mNumDescriptorHeaps = 0;
+		mDescriptorHeapsValid = false;
+		mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		mPrimitiveTopologyValid = false;
+		mVertexBufferValidMask = 0;
+		mIndexBufferValid = false;
+		mNumViewports = 0;
+		mViewportsValid = false;
+		mNumScissorRects = 0;
+		mScissorRectsValid = false;
+		mRenderTargetsValid = false;
+		InvalidateRootArguments();
+	}
+
+	CommandList* Get() const
+	{
+		return mCommandList;
+	}
+
+	Stats GetStats() const
+	{
+		return mStats;
+	}
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState)
+	{
+		if (Elide(mPipelineStateValid && mPipelineState == pipelineState))
+		{
+			return;
+		}
+		mPipelineState = pipelineState;
+		mPipelineStateValid = true;
+		mCommandList->SetPipelineState(pipelineState);
+	}
+
+	// Changing the root signature unbinds all root arguments.
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature)
+	{
+		if (Elide(mRootSignatureValid && mRootSignature == rootSignature))
+		{
+			return;
+		}
+		mRootSignature = rootSignature;
+		mRootSignatureValid = true;
+		InvalidateRootArguments();
+		mCommandList->SetGraphicsRootSignature(rootSignature);
+	}
+
+	// Descriptor tables set before changing heaps point into the old heaps,
+	// so root arguments are forgotten too.
+	void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps)
+	{
+		assert(numDescriptorHeaps <= MaxDescriptorHeaps);
+
+		if (Elide(mDescriptorHeapsValid && mNumDescriptorHeaps == numDescriptorHeaps &&
+			std::equal(descriptorHeaps, descriptorHeaps + numDescriptorHeaps, mDescriptorHeaps)))
+		{
+			return;
+		}
+		std::copy(descriptorHeaps, descriptorHeaps + numDescriptorHeaps, mDescriptorHeaps);
+		mNumDescriptorHeaps = numDescriptorHeaps;
+		mDescriptorHeapsValid = true;
+		InvalidateRootArguments();
+		mCommandList->SetDescriptorHeaps(numDescriptorHeaps, descriptorHeaps);
+	}
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
+	{
+		if (Elide(mPrimitiveTopologyValid && mPrimitiveTopology == primitiveTopology))
+		{
+			return;
+		}
+		mPrimitiveTopology = primitiveTopology;
+		mPrimitiveTopologyValid = true;
+		mCommandList->IASetPrimitiveTopology(primitiveTopology);
+	}
+
+	// views may be null to unbind the slots.
+	void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views)
+	{
+		assert(startSlot + numViews <= D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+
+		bool unchanged = true;
+		for (UINT i = 0; i < numViews && unchanged; ++i)
+		{
+			D3D12_VERTEX_BUFFER_VIEW view = views ? views[i] : D3D12_VERTEX_BUFFER_VIEW{};
+			unchanged = (mVertexBufferValidMask & (1u << (startSlot + i))) &&
+				memcmp(&mVertexBuffers[startSlot + i], &view, sizeof(view)) == 0;
+		}
+		if (Elide(unchanged))
+		{
+			return;
+		}
+
+		for (UINT i = 0; i < numViews; ++i)
+		{
+			mVertexBuffers[startSlot + i] = views ? views[i] : D3D12_VERTEX_BUFFER_VIEW{};
+			mVertexBufferValidMask |= 1u << (startSlot + i);
+		}
+		mCommandList->IASetVertexBuffers(startSlot, numViews, views);
+	}
+
+	// view may be null to unbind the index buffer.
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+	{
+		D3D12_INDEX_BUFFER_VIEW indexBuffer = view ? *view : D3D12_INDEX_BUFFER_VIEW{};
+		if (Elide(mIndexBufferValid && memcmp(&mIndexBuffer, &indexBuffer, sizeof(indexBuffer)) == 0))
+		{
+			return;
+		}
+		mIndexBuffer = indexBuffer;
+		mIndexBufferValid = true;
+		mCommandList->IASetIndexBuffer(view);
+	}
+
+	void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports)
+	{
+		assert(numViewports <= D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
+
+		if (Elide(mViewportsValid && mNumViewports == numViewports &&
+			memcmp(mViewports, viewports, numViewports * sizeof(D3D12_VIEWPORT)) == 0))
+		{
+			return;
+		}
+		std::copy(viewports, viewports + numViewports, mViewports);
+		mNumViewports = numViewports;
+		mViewportsValid = true;
+		mCommandList->RSSetViewports(numViewports, viewports);
+	}
+
+	void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects)
+	{
+		assert(numRects <= D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
+
+		if (Elide(mScissorRectsValid && mNumScissorRects == numRects &&
+			memcmp(mScissorRects, rects, numRects * sizeof(D3D12_RECT)) == 0))
+		{
+			return;
+		}
+		std::copy(rects, rects + numRects, mScissorRects);
+		mNumScissorRects = numRects;
+		mScissorRectsValid = true;
+		mCommandList->RSSetScissorRects(numRects, rects);
+	}
+
+	void OMSetRenderTargets(UINT numRenderTargets, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargets,
+		BOOL singleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil)
+	{
+		assert(numRenderTargets <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+
+		// A single handle to a range is the same as listing the handles, but
+		// comparing the first handle is enough to tell them apart.
+		UINT numHandles = singleHandleToDescriptorRange ? std::min(numRenderTargets, 1u) : numRenderTargets;
+		SIZE_T depthStencilHandle = depthStencil ? depthStencil->ptr : 0;
+
+		bool unchanged = mRenderTargetsValid &&
+			mNumRenderTargets == numRenderTargets &&
+			mSingleHandleToDescriptorRange == !!singleHandleToDescriptorRange &&
+			mDepthStencil == depthStencilHandle;
+		for (UINT i = 0; i < numHandles && unchanged; ++i)
+		{
+			unchanged = mRenderTargets[i] == renderTargets[i].ptr;
+		}
+		if (Elide(unchanged))
+		{
+			return;
+		}
+
+		for (UINT i = 0; i < numHandles; ++i)
+		{
+			mRenderTargets[i] = renderTargets[i].ptr;
+		}
+		mNumRenderTargets = numRenderTargets;
+		mSingleHandleToDescriptorRange = !!singleHandleToDescriptorRange;
+		mDepthStencil = depthStencilHandle;
+		mRenderTargetsValid = true;
+		mCommandList->OMSetRenderTargets(numRenderTargets, renderTargets, singleHandleToDescriptorRange, depthStencil);
+	}
+
+	void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues, const void* data, UINT destOffsetIn32BitValues)
+	{
+		assert(rootParameterIndex < MaxRootParameters);
+		assert(destOffsetIn32BitValues + num32BitValues <= MaxRootConstants);
+
+		RootParameter& parameter = mRootParameters[rootParameterIndex];
+		uint64_t mask = ConstantMask(destOffsetIn32BitValues, num32BitValues);
+		if (Elide((parameter.ConstantValidMask & mask) == mask &&
+			memcmp(&parameter.Constants[destOffsetIn32BitValues], data, num32BitValues * sizeof(uint32_t)) == 0))
+		{
+			return;
+		}
+		memcpy(&parameter.Constants[destOffsetIn32BitValues], data, num32BitValues * sizeof(uint32_t));
+		parameter.ConstantValidMask |= mask;
+		mCommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, data, destOffsetIn32BitValues);
+	}
+
+	void SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT srcData, UINT destOffsetIn32BitValues)
+	{
+		SetGraphicsRoot32BitConstants(rootParameterIndex, 1, &srcData, destOffsetIn32BitValues);
+	}
+
+	void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+	{
+		if (SetRootArgument(rootParameterIndex, baseDescriptor.ptr))
+		{
+			mCommandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+		}
+	}
+
+	void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+	{
+		if (SetRootArgument(rootParameterIndex, bufferLocation))
+		{
+			mCommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+		}
+	}
+
+	void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+	{
+		if (SetRootArgument(rootParameterIndex, bufferLocation))
+		{
+			mCommandList->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+		}
+	}
+
+	void SetGraphicsRootUnorderedAccessView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+	{
+		if (SetRootArgument(rootParameterIndex, bufferLocation))
+		{
+			mCommandList->SetGraphicsRootUnorderedAccessView(rootParameterIndex, bufferLocation);
+		}
+	}
+
+	// Draws are always forwarded.
+	void DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation)
+	{
+		mCommandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+	}
+
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+		INT baseVertexLocation, UINT startInstanceLocation)
+	{
+		mCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation,
+			baseVertexLocation, startInstanceLocation);
+	}
+
+private:
+	GraphicsCommandListT(const GraphicsCommandListT& copy) = delete;
+	GraphicsCommandListT& operator=(const GraphicsCommandListT& other) = delete;
+
+	static const UINT MaxDescriptorHeaps = 2;
+	// A root signature is at most 64 DWORDs, so it can't have more
+	// parameters or constants than that.
+	static const UINT MaxRootParameters = 64;
+	static const UINT MaxRootConstants = 64;
+
+	struct RootParameter
+	{
+		// Descriptor table handle or root descriptor address.
+		uint64_t Argument;
+		bool ArgumentValid;
+		uint32_t Constants[MaxRootConstants];
+		uint64_t ConstantValidMask;
+	};
+
+	static uint64_t ConstantMask(UINT offset, UINT count)
+	{
+		uint64_t bits = count >= 64 ? ~0ull : (1ull << count) - 1;
+		return bits << offset;
+	}
+
+	// Count the call, and return true if it should be dropped.
+	bool Elide(bool unchanged)
+	{
+		++(unchanged ? mStats.Elided : mStats.Issued);
+		return unchanged;
+	}
+
+	// Returns true if the call should be issued.
+	bool SetRootArgument(UINT rootParameterIndex, uint64_t argument)
+	{
+		assert(rootParameterIndex < MaxRootParameters);
+
+		RootParameter& parameter = mRootParameters[rootParameterIndex];
+		if (Elide(parameter.ArgumentValid && parameter.Argument == argument))
+		{
+			return false;
+		}
+		parameter.Argument = argument;
+		parameter.ArgumentValid = true;
+		return true;
+	}
+
+	void InvalidateRootArguments()
+	{
+		for (RootParameter& parameter : mRootParameters)
+		{
+			parameter.ArgumentValid = false;
+			parameter.ConstantValidMask = 0;
+		}
+	}
+
+	CommandList* mCommandList;
+	Stats mStats;
+
+	ID3D12PipelineState* mPipelineState;
+	bool mPipelineStateValid;
+
+	ID3D12RootSignature* mRootSignature;
+	bool mRootSignatureValid;
+	RootParameter mRootParameters[MaxRootParameters];
+
+	ID3D12DescriptorHeap* mDescriptorHeaps[MaxDescriptorHeaps];
+	UINT mNumDescriptorHeaps;
+	bool mDescriptorHeapsValid;
+
+	D3D12_PRIMITIVE_TOPOLOGY mPrimitiveTopology;
+	bool mPrimitiveTopologyValid;
+
+	D3D12_VERTEX_BUFFER_VIEW mVertexBuffers[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+	uint32_t mVertexBufferValidMask;
+
+	D3D12_INDEX_BUFFER_VIEW mIndexBuffer;
+	bool mIndexBufferValid;
+
+	D3D12_VIEWPORT mViewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT mNumViewports;
+	bool mViewportsValid;
+
+	D3D12_RECT mScissorRects[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT mNumScissorRects;
+	bool mScissorRectsValid;
+
+	SIZE_T mRenderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+	UINT mNumRenderTargets;
+	bool mSingleHandleToDescriptorRange;
+	SIZE_T mDepthStencil;
+	bool mRenderTargetsValid;
+};
+
+using GraphicsCommandList = GraphicsCommandListT<ID3D12GraphicsCommandList2>;
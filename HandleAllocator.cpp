@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "HandleAllocator.h"
+
+HandleAllocator::HandleAllocator(uint32_t capacity)
+	: mGenerations(capacity, 0)
+	, mAllocated(capacity, false)
+{
+	assert(capacity < (1u << IndexBits) && "Capacity does not fit in the index bits.");
+
+	for (uint32_t i = 0; i < capacity; ++i)
+	{
+		mFreeIndices.push_back(i);
+	}
+}
+
+HandleAllocator::Handle HandleAllocator::Allocate()
+{
+	if (mFreeIndices.empty())
+	{
+		return InvalidHandle;
+	}
+
+	uint32_t index = mFreeIndices.front();
+	mFreeIndices.pop_front();
+	mAllocated[index] = true;
+
+	return (static_cast<uint32_t>(mGenerations[index]) << IndexBits) | index;
+}
+
+bool HandleAllocator::Free(Handle handle)
+{
+	if (!IsValid(handle))
+	{
+		return false;
+	}
+
+	uint32_t index = GetIndex(handle);
+	mAllocated[index] = false;
+	mGenerations[index] = static_cast<uint16_t>((mGenerations[index] + 1) & GenerationMask);
+	mFreeIndices.push_back(index);
+
+	return true;
+}
+
+bool HandleAllocator::IsValid(Handle handle) const
+{
+	uint32_t index = GetIndex(handle);
+	return index < mAllocated.size() && mAllocated[index] &&
+		mGenerations[index] == GetGeneration(handle);
+}
+
+uint32_t HandleAllocator::GetIndex(Handle handle)
+{
+	return handle & IndexMask;
+}
+
+uint32_t HandleAllocator::GetGeneration(Handle handle)
+{
+	return (handle >> IndexBits) & GenerationMask;
+}
+
+uint32_t HandleAllocator::GetCapacity() const
+{
+	return static_cast<uint32_t>(mAllocated.size());
+}
+
+uint32_t HandleAllocator::GetAllocatedCount() const
+{
+	return GetCapacity() - static_cast<uint32_t>(mFreeIndices.size());
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Hands out 32-bit handles to slots of a fixed size table.
+// The low IndexBits of a handle are the slot index and the remaining bits a
+// generation that changes every time the slot is freed, so a handle that
+// outlives its slot is detected as stale instead of aliasing the next user.
+// Freed slots are reused in FIFO order to keep generations apart.
+// Not thread-safe.
+class HandleAllocator
+{
+public:
+	using Handle = uint32_t;
+
+	static const uint32_t IndexBits = 20;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t GenerationMask = ~0u >> IndexBits;
+	static const Handle InvalidHandle = ~0u;
+
+	// capacity must be less than 2^IndexBits.
+	HandleAllocator(uint32_t capacity);
+
+	// Returns InvalidHandle if every slot is in use.
+	Handle Allocate();
+	// Returns false, and does nothing, if the handle is stale or invalid.
+	bool Free(Handle handle);
+
+	bool IsValid(Handle handle) const;
+
+	static uint32_t GetIndex(Handle handle);
+	static uint32_t GetGeneration(Handle handle);
+
+	uint32_t GetCapacity() const;
+	uint32_t GetAllocatedCount() const;
+
+private:
+	// The generation of the current (or next) handle of each slot.
+	std::vector<uint16_t> mGenerations;
+	std::vector<bool> mAllocated;
+	std::deque<uint32_t> mFreeIndices;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// 64-bit FNV-1a hashing.
+// Unlike std::hash, the result is the same on every run and platform, so it
+// can be used for keys that are written to disk.
+
+constexpr uint64_t HashOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t HashPrime = 0x100000001b3ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = HashOffsetBasis)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= HashPrime;
+	}
+	return hash;
+}
+
+constexpr uint64_t HashString(std::string_view string, uint64_t seed = HashOffsetBasis)
+{
+	uint64_t hash = seed;
+	for (char c : string)
+	{
+		hash ^= static_cast<uint8_t>(c);
+		hash *= HashPrime;
+	}
+	return hash;
+}
+
+// Mix a value into a hash one byte at a time, lowest byte first, so the
+// result does not depend on the platform's byte order.
+constexpr uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+	uint64_t hash = seed;
+	for (int i = 0; i < 8; ++i)
+	{
+		hash ^= (value >> (i * 8)) & 0xff;
+		hash *= HashPrime;
+	}
+	return hash;
+}
+
+// Hash the bytes of a trivially copyable value. T must not have padding.
+template<typename T>
+uint64_t HashValue(const T& value, uint64_t seed = HashOffsetBasis)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be hashed as bytes.");
+	return HashBytes(&value, sizeof(T), seed);
+}
@@ -5,12 +5,12 @@ HighResolutionClock::HighResolutionClock()
 	: mDeltaTime(0)
 	, mTotalTime(0)
 {
-	mT0 = std::chrono::high_resolution_clock::now();
+	mT0 = std::chrono::steady_clock::now();
 }
 
 void HighResolutionClock::Tick()
 {
-	auto t1 = std::chrono::high_resolution_clock::now();
+	auto t1 = std::chrono::steady_clock::now();
 	mDeltaTime = t1 - mT0;
 	mTotalTime += mDeltaTime;
 	mT0 = t1;
@@ -18,9 +18,9 @@ void HighResolutionClock::Tick()
 
 void HighResolutionClock::Reset()
 {
-	mT0 = std::chrono::high_resolution_clock::now();
-	mDeltaTime = std::chrono::high_resolution_clock::duration();
-	mTotalTime = std::chrono::high_resolution_clock::duration();
+	mT0 = std::chrono::steady_clock::now();
+	mDeltaTime = std::chrono::steady_clock::duration();
+	mTotalTime = std::chrono::steady_clock::duration();
 }
 
 double HighResolutionClock::GetDeltaNanoseconds() const
@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+// Measures the time between ticks. Uses a steady clock, which never jumps
+// or runs backwards, unlike high_resolution_clock on some platforms.
 class HighResolutionClock
 {
 public:
@@ -22,7 +24,7 @@ public:
 	double GetTotalSeconds() const;
 
 private:
-	std::chrono::high_resolution_clock::time_point mT0;
-	std::chrono::high_resolution_clock::duration mDeltaTime;
-	std::chrono::high_resolution_clock::duration mTotalTime;
+	std::chrono::steady_clock::time_point mT0;
+	std::chrono::steady_clock::duration mDeltaTime;
+	std::chrono::steady_clock::duration mTotalTime;
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "LinearAllocator.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearAllocator::LinearAllocator(uint64_t capacity)
+	: mCapacity(capacity)
+	, mHead(0)
+{
+}
+
+uint64_t LinearAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+	uint64_t head = mHead.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		uint64_t offset = AlignUp(head, alignment);
+		if (offset + size > mCapacity)
+		{
+			return InvalidOffset;
+		}
+
+		if (mHead.compare_exchange_weak(head, offset + size, std::memory_order_relaxed))
+		{
+			return offset;
+		}
+	}
+}
+
+void LinearAllocator::Reset()
+{
+	mHead.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LinearAllocator::GetCapacity() const
+{
+	return mCapacity;
+}
+
+uint64_t LinearAllocator::GetUsedSize() const
+{
+	return mHead.load(std::memory_order_relaxed);
+}
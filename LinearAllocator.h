@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Suballocates aligned ranges from a fixed size block by bumping an offset.
+// Allocations are made lock-free from any number of threads. Nothing is
+// freed on its own; Reset gives back everything at once.
+class LinearAllocator
+{
+public:
+	static const uint64_t InvalidOffset = ~0ull;
+
+	LinearAllocator(uint64_t capacity);
+
+	// Returns the offset of the allocation, or InvalidOffset if there is not
+	// enough space left. alignment must be a power of two.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	// Free everything. Nothing may use the allocations anymore.
+	void Reset();
+
+	uint64_t GetCapacity() const;
+	// The number of bytes allocated since the last Reset, including padding.
+	uint64_t GetUsedSize() const;
+
+private:
+	LinearAllocator(const LinearAllocator& copy) = delete;
+	LinearAllocator& operator=(const LinearAllocator& other) = delete;
+
+	const uint64_t mCapacity;
+	std::atomic<uint64_t> mHead;
+};
@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "PipelineStateArchive.h"
+
+#include "Hash.h"
+
+#include <fstream>
+#include <iterator>
+
+static void WriteUInt(std::vector<uint8_t>& data, uint64_t value, int numBytes)
+{
+	for (int i = 0; i < numBytes; ++i)
+	{
+		data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+}
+
+static bool ReadUInt(const uint8_t* data, size_t size, size_t& offset, int numBytes, uint64_t& value)
+{
+	if (size - offset < static_cast<size_t>(numBytes))
+	{
+		return false;
+	}
+
+	value = 0;
+	for (int i = 0; i < numBytes; ++i)
+	{
+		value |= static_cast<uint64_t>(data[offset + i]) << (i * 8);
+	}
+	offset += numBytes;
+	return true;
+}
+
+PipelineStateArchive::PipelineStateArchive(uint64_t version)
+	: mVersion(version)
+{
+}
+
+uint64_t PipelineStateArchive::Checksum(uint64_t key, const uint8_t* data, size_t size)
+{
+	uint64_t seed = HashCombine(HashCombine(HashOffsetBasis, key), size);
+	return HashBytes(data, size, seed);
+}
+
+bool PipelineStateArchive::Deserialize(const uint8_t* data, size_t size)
+{
+	mEntries.clear();
+
+	size_t offset = 0;
+	uint64_t magic, formatVersion, version, entryCount;
+	if (!ReadUInt(data, size, offset, 4, magic) || magic != Magic ||
+		!ReadUInt(data, size, offset, 4, formatVersion) || formatVersion != FormatVersion ||
+		!ReadUInt(data, size, offset, 8, version) || version != mVersion ||
+		!ReadUInt(data, size, offset, 8, entryCount))
+	{
+		return false;
+	}
+
+	for (uint64_t i = 0; i < entryCount; ++i)
+	{
+		uint64_t key, entrySize, checksum;
+		if (!ReadUInt(data, size, offset, 8, key) ||
+			!ReadUInt(data, size, offset, 8, entrySize) ||
+			!ReadUInt(data, size, offset, 8, checksum) ||
+			entrySize > size - offset)
+		{
+			// Truncated. Keep the entries read so far.
+			break;
+		}
+
+		const uint8_t* entryData = data + offset;
+		offset += static_cast<size_t>(entrySize);
+
+		if (Checksum(key, entryData, static_cast<size_t>(entrySize)) == checksum)
+		{
+			mEntries[key].assign(entryData, entryData + entrySize);
+		}
+	}
+
+	return true;
+}
+
+std::vector<uint8_t> PipelineStateArchive::Serialize() const
+{
+	// Sort the keys so the same contents always produce the same file.
+	std::vector<uint64_t> keys;
+	keys.reserve(mEntries.size());
+	for (auto& entry : mEntries)
+	{
+		keys.push_back(entry.first);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<uint8_t> data;
+	WriteUInt(data, Magic, 4);
+	WriteUInt(data, FormatVersion, 4);
+	WriteUInt(data, mVersion, 8);
+	WriteUInt(data, keys.size(), 8);
+
+	for (uint64_t key : keys)
+	{
+		const std::vector<uint8_t>& entryData = mEntries.at(key);
+		WriteUInt(data, key, 8);
+		WriteUInt(data, entryData.size(), 8);
+		WriteUInt(data, Checksum(key, entryData.data(), entryData.size()), 8);
+		data.insert(data.end(), entryData.begin(), entryData.end());
+	}
+
+	return data;
+}
+
+bool PipelineStateArchive::Load(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		mEntries.clear();
+		return false;
+	}
+
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return Deserialize(data.data(), data.size());
+}
+
+bool PipelineStateArchive::Save(const std::filesystem::path& path) const
+{
+	std::vector<uint8_t> data = Serialize();
+
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<const char*>(data.data()), data.size()))
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
+
+const std::vector<uint8_t>* PipelineStateArchive::Find(uint64_t key) const
+{
+	auto iter = mEntries.find(key);
+	return iter != mEntries.end() ? &iter->second : nullptr;
+}
+
+void PipelineStateArchive::Add(uint64_t key, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	mEntries[key].assign(bytes, bytes + size);
+}
+
+void PipelineStateArchive::Remove(uint64_t key)
+{
+	mEntries.erase(key);
+}
+
+void PipelineStateArchive::Clear()
+{
+	mEntries.clear();
+}
+
+uint64_t PipelineStateArchive::GetVersion() const
+{
+	return mVersion;
+}
+
+size_t PipelineStateArchive::GetEntryCount() const
+{
+	return mEntries.size();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+// A set of binary blobs keyed by 64-bit hash, stored in one file.
+//
+// File layout, all integers little-endian:
+//   Header: magic, format version (uint32 each), version, entry count (uint64 each)
+//   Entries: key, size, checksum (uint64 each), followed by size bytes of data
+//
+// version identifies whatever the blobs depend on (e.g. the GPU and driver).
+// A file with a different magic, format version or version is ignored as a
+// whole; an entry whose checksum doesn't match is dropped on its own.
+class PipelineStateArchive
+{
+public:
+	static const uint32_t Magic = 0x4f535053;	// "SPSO"
+	static const uint32_t FormatVersion = 1;
+
+	PipelineStateArchive(uint64_t version);
+
+	// Replaces the contents of the archive. Returns false if the data is not
+	// an archive of this version; corrupt entries are skipped silently.
+	bool Deserialize(const uint8_t* data, size_t size);
+	std::vector<uint8_t> Serialize() const;
+
+	bool Load(const std::filesystem::path& path);
+	// Writes to a temporary file first, so a failed save never leaves a
+	// truncated archive behind.
+	bool Save(const std::filesystem::path& path) const;
+
+	// Returns nullptr if there is no entry for the key.
+	const std::vector<uint8_t>* Find(uint64_t key) const;
+	void Add(uint64_t key, const void* data, size_t size);
+	void Remove(uint64_t key);
+	void Clear();
+
+	uint64_t GetVersion() const;
+	size_t GetEntryCount() const;
+
+	static uint64_t Checksum(uint64_t key, const uint8_t* data, size_t size);
+
+private:
+	uint64_t mVersion;
+	std::unordered_map<uint64_t, std::vector<uint8_t>> mEntries;
+};
@@ -0,0 +1,368 @@
+#include "pch.h"
+#include "PipelineStateCache.h"
+
+#include "D3D12Hash.h"
+#include "Hash.h"
+
+// {5E9C3B1A-7F2D-4C8E-9A61-3B0D2E4F8C17}
+static const GUID RootSignatureHashGuid =
+{ 0x5e9c3b1a, 0x7f2d, 0x4c8e, { 0x9a, 0x61, 0x3b, 0x0d, 0x2e, 0x4f, 0x8c, 0x17 } };
+
+// The archive key of the serialized pipeline library.
+static const uint64_t PipelineLibraryKey = HashString("ID3D12PipelineLibrary");
+
+// Hashes every subobject of a stream as the parser visits it. The values
+// go into Hash and the subobject types into Layout, computed the same way as
+// PipelineStateStream::LayoutHash, so streams with the same values in a
+// different layout don't collide.
+class PipelineStreamHasher : public ID3DX12PipelineParserCallbacks
+{
+public:
+	uint64_t Hash = HashOffsetBasis;
+	uint64_t Layout = HashOffsetBasis;
+	// False when the layout hash is already known.
+	bool HashLayout = true;
+	// False if the hash is only stable within this run.
+	bool Persistent = true;
+
+	void FlagsCb(D3D12_PIPELINE_STATE_FLAGS flags) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS, flags); }
+	void NodeMaskCb(UINT nodeMask) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK, nodeMask); }
+	void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE, value); }
+	void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE type) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY, type); }
+	void DSVFormatCb(DXGI_FORMAT format) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, format); }
+	void SampleMaskCb(UINT sampleMask) override { Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, sampleMask); }
+
+	void VSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, shader); }
+	void GSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, shader); }
+	void HSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, shader); }
+	void DSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, shader); }
+	void PSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, shader); }
+	void CSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, shader); }
+	void ASCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, shader); }
+	void MSCb(const D3D12_SHADER_BYTECODE& shader) override { AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, shader); }
+
+	// Blend and depth stencil descs have padding after their UINT8 masks and
+	// rasterizer descs hold floats, so these are hashed field by field.
+	void BlendStateCb(const D3D12_BLEND_DESC& desc) override { Hash = HashBlendDesc(desc, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND)); }
+	void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& desc) override { Hash = HashDepthStencilDesc(desc, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL)); }
+	void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& desc) override { Hash = HashDepthStencilDesc1(desc, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1)); }
+	void RasterizerStateCb(const D3D12_RASTERIZER_DESC& desc) override { Hash = HashRasterizerDesc(desc, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER)); }
+	void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& formats) override { Hash = HashRTFormatArray(formats, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS)); }
+	void SampleDescCb(const DXGI_SAMPLE_DESC& desc) override { Hash = HashSampleDesc(desc, Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC)); }
+
+	void RootSignatureCb(ID3D12RootSignature* rootSignature) override
+	{
+		uint64_t rootSignatureHash = 0;
+		if (rootSignature && !PipelineStateCache::GetRootSignatureHash(rootSignature, rootSignatureHash))
+		{
+			// The pointer identifies the root signature within this run only,
+			// so the PSO must not be looked up in or written to disk.
+			rootSignatureHash = reinterpret_cast<uint64_t>(rootSignature);
+			Persistent = false;
+		}
+		Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, rootSignatureHash);
+	}
+
+	void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& desc) override
+	{
+		Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT, desc.NumElements);
+		for (UINT i = 0; i < desc.NumElements; ++i)
+		{
+			const D3D12_INPUT_ELEMENT_DESC& element = desc.pInputElementDescs[i];
+			Hash = HashString(element.SemanticName, Hash);
+			Hash = HashCombine(Hash, element.SemanticIndex);
+			Hash = HashCombine(Hash, element.Format);
+			Hash = HashCombine(Hash, element.InputSlot);
+			Hash = HashCombine(Hash, element.AlignedByteOffset);
+			Hash = HashCombine(Hash, element.InputSlotClass);
+			Hash = HashCombine(Hash, element.InstanceDataStepRate);
+		}
+	}
+
+	void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& desc) override
+	{
+		Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT, desc.NumEntries);
+		for (UINT i = 0; i < desc.NumEntries; ++i)
+		{
+			const D3D12_SO_DECLARATION_ENTRY& entry = desc.pSODeclaration[i];
+			Hash = HashCombine(Hash, entry.Stream);
+			Hash = HashString(entry.SemanticName ? entry.SemanticName : "", Hash);
+			Hash = HashCombine(Hash, entry.SemanticIndex);
+			Hash = HashCombine(Hash, entry.StartComponent);
+			Hash = HashCombine(Hash, entry.ComponentCount);
+			Hash = HashCombine(Hash, entry.OutputSlot);
+		}
+		Hash = HashBytes(desc.pBufferStrides, desc.NumStrides * sizeof(UINT), Hash);
+		Hash = HashCombine(Hash, desc.RasterizedStream);
+	}
+
+	void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& desc) override
+	{
+		Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING, desc.ViewInstanceCount);
+		Hash = HashBytes(desc.pViewInstanceLocations, desc.ViewInstanceCount * sizeof(D3D12_VIEW_INSTANCE_LOCATION), Hash);
+		Hash = HashCombine(Hash, desc.Flags);
+	}
+
+	// A cached blob doesn't change what the PSO does, so only its place in
+	// the layout is part of the key.
+	void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE&) override { Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO); }
+
+private:
+	// Add the subobject type to the layout and return the hash to continue from.
+	uint64_t Type(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type)
+	{
+		if (HashLayout)
+		{
+			Layout = HashCombine(Layout, type);
+		}
+		return Hash;
+	}
+
+	void Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, uint64_t value)
+	{
+		Hash = HashCombine(Type(type), value);
+	}
+
+	void AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const D3D12_SHADER_BYTECODE& shader)
+	{
+		Add(type, shader.BytecodeLength);
+		Hash = HashBytes(shader.pShaderBytecode, shader.BytecodeLength, Hash);
+	}
+};
+
+static std::wstring GetPipelineName(uint64_t key)
+{
+	wchar_t name[17];
+	swprintf_s(name, L"%016llx", key);
+	return name;
+}
+
+PipelineStateCache::PipelineStateCache(ComPtr<ID3D12Device2> device, const std::filesystem::path& path, uint64_t version)
+	: mDevice(device)
+	, mPath(path)
+	, mArchive(version)
+	, mDirty(false)
+	, mStats{}
+{
+	mArchive.Load(mPath);
+
+	if (const std::vector<uint8_t>* libraryData = mArchive.Find(PipelineLibraryKey))
+	{
+		mPipelineLibraryData = *libraryData;
+		if (FAILED(mDevice->CreatePipelineLibrary(mPipelineLibraryData.data(), mPipelineLibraryData.size(),
+			IID_PPV_ARGS(&mPipelineLibrary))))
+		{
+			// Corrupt, or written by a different driver.
+			mPipelineLibraryData.clear();
+			mArchive.Remove(PipelineLibraryKey);
+			++mStats.DiskRejects;
+		}
+	}
+
+	if (!mPipelineLibrary)
+	{
+		// Fails with DXGI_ERROR_UNSUPPORTED on drivers without pipeline
+		// libraries, in which case PSOs are cached as individual blobs.
+		mDevice->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mPipelineLibrary));
+	}
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+	Save();
+}
+
+uint64_t PipelineStateCache::HashPipelineStateStream(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, bool* persistent)
+{
+	PipelineStreamHasher hasher;
+	ThrowIfFailed(D3DX12ParsePipelineStream(desc, &hasher));
+	if (persistent)
+	{
+		*persistent = hasher.Persistent;
+	}
+	return HashCombine(hasher.Layout, hasher.Hash);
+}
+
+uint64_t PipelineStateCache::HashPipelineStateStream(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, uint64_t layoutHash, bool* persistent)
+{
+	PipelineStreamHasher hasher;
+	hasher.HashLayout = false;
+	ThrowIfFailed(D3DX12ParsePipelineStream(desc, &hasher));
+	if (persistent)
+	{
+		*persistent = hasher.Persistent;
+	}
+	return HashCombine(layoutHash, hasher.Hash);
+}
+
+void PipelineStateCache::SetRootSignatureHash(ID3D12RootSignature* rootSignature, uint64_t hash)
+{
+	ThrowIfFailed(rootSignature->SetPrivateData(RootSignatureHashGuid, sizeof(hash), &hash));
+}
+
+bool PipelineStateCache::GetRootSignatureHash(ID3D12RootSignature* rootSignature, uint64_t& hash)
+{
+	UINT dataSize = sizeof(hash);
+	return SUCCEEDED(rootSignature->GetPrivateData(RootSignatureHashGuid, &dataSize, &hash)) && dataSize == sizeof(hash);
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::GetPipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+	bool persistent = true;
+	uint64_t key = HashPipelineStateStream(desc, &persistent);
+	return GetPipelineState(key, persistent, desc);
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::GetPipelineState(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto iter = mPipelineStates.find(key);
+		if (iter != mPipelineStates.end())
+		{
+			++mStats.MemoryHits;
+			return iter->second;
+		}
+	}
+
+	// Compile without holding the lock, so other threads can use the cache
+	// meanwhile. If two threads compile the same PSO, the first one wins.
+	ComPtr<ID3D12PipelineState> pipelineState = CreatePipelineState(key, persistent, desc);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPipelineStates.emplace(key, pipelineState).first->second;
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::FindPipelineState(uint64_t key) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto iter = mPipelineStates.find(key);
+	return iter != mPipelineStates.end() ? iter->second : nullptr;
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::CreatePipelineState(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+	ComPtr<ID3D12PipelineState> pipelineState;
+
+	if (!persistent)
+	{
+		// The key may match an unrelated PSO stored by another run.
+		ThrowIfFailed(mDevice->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStats.Compiles;
+		return pipelineState;
+	}
+
+	if (mPipelineLibrary)
+	{
+		// Pipeline libraries synchronize internally.
+		std::wstring name = GetPipelineName(key);
+		if (SUCCEEDED(mPipelineLibrary->LoadPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			++mStats.DiskHits;
+			return pipelineState;
+		}
+
+		ThrowIfFailed(mDevice->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+
+		// Fails if a pipeline with the name is already stored, which only
+		// happens if the stored one no longer matches its description.
+		HRESULT hr = mPipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get());
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStats.Compiles;
+		mDirty |= SUCCEEDED(hr);
+		return pipelineState;
+	}
+
+	pipelineState = CreateFromCachedBlob(key, desc);
+	if (pipelineState)
+	{
+		return pipelineState;
+	}
+
+	ThrowIfFailed(mDevice->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+
+	ComPtr<ID3DBlob> cachedBlob;
+	HRESULT hr = pipelineState->GetCachedBlob(&cachedBlob);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mStats.Compiles;
+	if (SUCCEEDED(hr))
+	{
+		mArchive.Add(key, cachedBlob->GetBufferPointer(), cachedBlob->GetBufferSize());
+		mDirty = true;
+	}
+	return pipelineState;
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::CreateFromCachedBlob(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+	std::vector<uint8_t> cachedBlob;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const std::vector<uint8_t>* entry = mArchive.Find(key);
+		if (!entry)
+		{
+			return nullptr;
+		}
+		cachedBlob = *entry;
+	}
+
+	// Append the cached blob to a copy of the stream. Subobjects are
+	// pointer aligned, so the copy can be extended at the end.
+	CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO cachedPSO = D3D12_CACHED_PIPELINE_STATE{ cachedBlob.data(), cachedBlob.size() };
+	std::vector<uint8_t> stream(desc.SizeInBytes + sizeof(cachedPSO));
+	memcpy(stream.data(), desc.pPipelineStateSubobjectStream, desc.SizeInBytes);
+	// operator& of stream subobjects returns the inner struct.
+	memcpy(stream.data() + desc.SizeInBytes, std::addressof(cachedPSO), sizeof(cachedPSO));
+
+	D3D12_PIPELINE_STATE_STREAM_DESC cachedDesc = { stream.size(), stream.data() };
+
+	ComPtr<ID3D12PipelineState> pipelineState;
+	HRESULT hr = mDevice->CreatePipelineState(&cachedDesc, IID_PPV_ARGS(&pipelineState));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (FAILED(hr))
+	{
+		// The blob doesn't match this driver or description. Replace it.
+		mArchive.Remove(key);
+		mDirty = true;
+		++mStats.DiskRejects;
+		return nullptr;
+	}
+
+	++mStats.DiskHits;
+	return pipelineState;
+}
+
+bool PipelineStateCache::Save()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!mDirty)
+	{
+		return true;
+	}
+
+	if (mPipelineLibrary)
+	{
+		std::vector<uint8_t> libraryData(mPipelineLibrary->GetSerializedSize());
+		if (FAILED(mPipelineLibrary->Serialize(libraryData.data(), libraryData.size())))
+		{
+			return false;
+		}
+		mArchive.Add(PipelineLibraryKey, libraryData.data(), libraryData.size());
+	}
+
+	mDirty = !mArchive.Save(mPath);
+	return !mDirty;
+}
+
+PipelineStateCache::Stats PipelineStateCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "PipelineStateArchive.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "PipelineStateStream.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// Creates pipeline state objects from pipeline state streams, keyed by a
+// stable hash of the stream contents.
+// Identical streams share one PSO. Compiled PSOs are persisted to disk in a
+// PipelineStateArchive, through an ID3D12PipelineLibrary when the driver
+// supports one and as individual cached blobs otherwise, so the next run
+// doesn't have to compile them again.
+//
+// Root signatures are hashed by the hash stored with SetRootSignatureHash.
+// Streams whose root signature has no hash are only cached in memory.
+class PipelineStateCache
+{
+public:
+	// version identifies the GPU and driver. Archives written with a
+	// different version are ignored.
+	PipelineStateCache(ComPtr<ID3D12Device2> device, const std::filesystem::path& path, uint64_t version);
+	// Saves the archive if anything was added.
+	virtual ~PipelineStateCache();
+
+	// Return the PSO for the stream, compiling it if it isn't cached.
+	ComPtr<ID3D12PipelineState> GetPipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+	// key and persistent as returned by HashPipelineStateStream.
+	ComPtr<ID3D12PipelineState> GetPipelineState(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+	// Return the PSO if it has already been created, or nullptr.
+	ComPtr<ID3D12PipelineState> FindPipelineState(uint64_t key) const;
+
+	// Write the compiled PSOs to disk.
+	bool Save();
+
+	// Hash the contents of a pipeline state stream. Pointers are followed,
+	// so the hash is the same across runs for the same shaders and state.
+	// persistent is set to false if the root signature has no hash, in which
+	// case the hash is only stable within this run.
+	//
+	// The key combines a hash of the subobject types in stream order, the
+	// layout, with a hash of the subobject values.
+	static uint64_t HashPipelineStateStream(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, bool* persistent = nullptr);
+	// The same key for a PipelineStateStream. Its layout hash is known at
+	// compile time, so only the values are hashed at runtime.
+	template<typename... Subobjects>
+	static uint64_t HashPipelineStateStream(const PipelineStateStream<Subobjects...>& stream, bool* persistent = nullptr)
+	{
+		return HashPipelineStateStream(stream.GetDesc(), PipelineStateStream<Subobjects...>::LayoutHash, persistent);
+	}
+	// layoutHash must be the LayoutHash of the stream's subobject types.
+	static uint64_t HashPipelineStateStream(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, uint64_t layoutHash, bool* persistent = nullptr);
+
+	// Store a stable hash, e.g. of the serialized root signature, with the root signature.
+	static void SetRootSignatureHash(ID3D12RootSignature* rootSignature, uint64_t hash);
+	// Returns false if no hash was stored.
+	static bool GetRootSignatureHash(ID3D12RootSignature* rootSignature, uint64_t& hash);
+
+	struct Stats
+	{
+		uint64_t MemoryHits;	// Returned a PSO that was already created.
+		uint64_t DiskHits;		// Created a PSO from the archive.
+		uint64_t Compiles;		// Created a PSO from scratch.
+		uint64_t DiskRejects;	// Archived PSOs the driver refused.
+	};
+	Stats GetStats() const;
+
+private:
+	PipelineStateCache(const PipelineStateCache& copy) = delete;
+	PipelineStateCache& operator=(const PipelineStateCache& other) = delete;
+
+	ComPtr<ID3D12PipelineState> CreatePipelineState(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+	ComPtr<ID3D12PipelineState> CreateFromCachedBlob(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+
+	ComPtr<ID3D12Device2> mDevice;
+	std::filesystem::path mPath;
+
+	// Null if the driver doesn't support pipeline libraries.
+	ComPtr<ID3D12PipelineLibrary1> mPipelineLibrary;
+	// The library reads from this for its whole lifetime.
+	std::vector<uint8_t> mPipelineLibraryData;
+
+	mutable std::mutex mMutex;
+	PipelineStateArchive mArchive;
+	std::unordered_map<uint64_t, ComPtr<ID3D12PipelineState>> mPipelineStates;
+	bool mDirty;
+	Stats mStats;
+};
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "PipelineStateCompiler.h"
+
+#include "ThreadPool.h"
+
+AsyncPipelineState::AsyncPipelineState(uint64_t key, ComPtr<ID3D12PipelineState> fallback)
+	: mKey(key)
+	, mFallback(fallback)
+	, mStatus(Status::Pending)
+{
+}
+
+AsyncPipelineState::Status AsyncPipelineState::GetStatus() const
+{
+	return mStatus.load(std::memory_order_acquire);
+}
+
+bool AsyncPipelineState::IsReady() const
+{
+	return GetStatus() == Status::Ready;
+}
+
+ID3D12PipelineState* AsyncPipelineState::Get() const
+{
+	return IsReady() ? mPipelineState.Get() : mFallback.Get();
+}
+
+uint64_t AsyncPipelineState::GetKey() const
+{
+	return mKey;
+}
+
+PipelineStateCompiler::PipelineStateCompiler(PipelineStateCache& pipelineStateCache, std::shared_ptr<ThreadPool> threadPool)
+	: mPipelineStateCache(pipelineStateCache)
+	, mThreadPool(threadPool)
+	, mStats{}
+	, mTotalLatency(0.0)
+{
+}
+
+PipelineStateCompiler::~PipelineStateCompiler()
+{
+	WaitForAll();
+}
+
+std::shared_ptr<AsyncPipelineState> PipelineStateCompiler::Compile(const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+	std::vector<ComPtr<IUnknown>> keepAlive, ComPtr<ID3D12PipelineState> fallback)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	bool persistent = true;
+	uint64_t key = PipelineStateCache::HashPipelineStateStream(desc, &persistent);
+	return Compile(key, persistent, desc, startTime, std::move(keepAlive), fallback);
+}
+
+std::shared_ptr<AsyncPipelineState> PipelineStateCompiler::Compile(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+	std::chrono::steady_clock::time_point startTime, std::vector<ComPtr<IUnknown>> keepAlive, ComPtr<ID3D12PipelineState> fallback)
+{
+	std::shared_ptr<AsyncPipelineState> pipelineState(new AsyncPipelineState(key, fallback));
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStats.Requests;
+
+		if (ComPtr<ID3D12PipelineState> cached = mPipelineStateCache.FindPipelineState(key))
+		{
+			++mStats.ImmediateHits;
+			pipelineState->mPipelineState = cached;
+			pipelineState->mStatus.store(AsyncPipelineState::Status::Ready, std::memory_order_release);
+			return pipelineState;
+		}
+
+		// The objects of a request that joins a running compile are held
+		// until that compile finishes.
+		auto pending = mPending.find(key);
+		if (pending != mPending.end())
+		{
+			pending->second.requests.push_back(pipelineState);
+			pending->second.keepAlive.insert(pending->second.keepAlive.end(), keepAlive.begin(), keepAlive.end());
+			return pipelineState;
+		}
+
+		mPending[key] = PendingCompile{ { pipelineState }, std::move(keepAlive) };
+		mStats.QueueDepth = mPending.size();
+		mStats.MaxQueueDepth = std::max(mStats.MaxQueueDepth, mStats.QueueDepth);
+	}
+
+	// The stream usually lives on the caller's stack.
+	std::shared_ptr<std::vector<uint8_t>> stream = std::make_shared<std::vector<uint8_t>>(
+		static_cast<const uint8_t*>(desc.pPipelineStateSubobjectStream),
+		static_cast<const uint8_t*>(desc.pPipelineStateSubobjectStream) + desc.SizeInBytes);
+
+	mThreadPool->Enqueue([this, key, persistent, stream, startTime]()
+	{
+		D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { stream->size(), stream->data() };
+
+		ComPtr<ID3D12PipelineState> compiled;
+		bool succeeded = true;
+		try
+		{
+			compiled = mPipelineStateCache.GetPipelineState(key, persistent, streamDesc);
+		}
+		catch (...)
+		{
+			succeeded = false;
+		}
+
+		OnCompiled(key, compiled, startTime, succeeded);
+	});
+
+	return pipelineState;
+}
+
+void PipelineStateCompiler::OnCompiled(uint64_t key, ComPtr<ID3D12PipelineState> compiled, std::chrono::steady_clock::time_point startTime, bool succeeded)
+{
+	double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Released after the lock, once no request is pending anymore.
+	std::vector<ComPtr<IUnknown>> keepAlive;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// No more requests can join once the lock is held, so every request
+	// gets the result.
+	auto pending = mPending.find(key);
+	for (const std::shared_ptr<AsyncPipelineState>& pipelineState : pending->second.requests)
+	{
+		pipelineState->mPipelineState = compiled;
+		pipelineState->mStatus.store(succeeded ? AsyncPipelineState::Status::Ready : AsyncPipelineState::Status::Failed,
+			std::memory_order_release);
+	}
+	keepAlive = std::move(pending->second.keepAlive);
+
+	mPending.erase(pending);
+	mStats.QueueDepth = mPending.size();
+
+	if (succeeded)
+	{
+		++mStats.Completed;
+		mTotalLatency += latency;
+		mStats.MaxLatency = std::max(mStats.MaxLatency, latency);
+	}
+	else
+	{
+		++mStats.Failed;
+	}
+
+	if (mPending.empty())
+	{
+		mIdleCondition.notify_all();
+	}
+}
+
+void PipelineStateCompiler::WaitForAll()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdleCondition.wait(lock, [this]() { return mPending.empty(); });
+}
+
+PipelineStateCompiler::Stats PipelineStateCompiler::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	Stats stats = mStats;
+	stats.AverageLatency = stats.Completed > 0 ? mTotalLatency / stats.Completed : 0.0;
+	return stats;
+}
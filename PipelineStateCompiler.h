@@ -0,0 +1,124 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "PipelineStateCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class ThreadPool;
+
+// A pipeline state object that may still be compiling.
+class AsyncPipelineState
+{
+public:
+	enum class Status
+	{
+		Pending,
+		Ready,
+		Failed,
+	};
+
+	Status GetStatus() const;
+	bool IsReady() const;
+
+	// The compiled PSO once it is ready, otherwise the fallback, which may be
+	// null. Draws that get null should be skipped.
+	ID3D12PipelineState* Get() const;
+
+	uint64_t GetKey() const;
+
+private:
+	friend class PipelineStateCompiler;
+
+	AsyncPipelineState(uint64_t key, ComPtr<ID3D12PipelineState> fallback);
+
+	uint64_t mKey;
+	// Written before mStatus becomes Ready and never changed afterwards.
+	ComPtr<ID3D12PipelineState> mPipelineState;
+	ComPtr<ID3D12PipelineState> mFallback;
+	std::atomic<Status> mStatus;
+};
+
+// Compiles pipeline state objects through a PipelineStateCache on a thread
+// pool, so creating a PSO never blocks the calling thread.
+// Requests for a PSO that is already cached are ready immediately, and
+// requests for a PSO that is already compiling share the same compile. Each
+// request keeps its own fallback.
+class PipelineStateCompiler
+{
+public:
+	PipelineStateCompiler(PipelineStateCache& pipelineStateCache, std::shared_ptr<ThreadPool> threadPool);
+	// Waits for the compiles that are still running.
+	virtual ~PipelineStateCompiler();
+
+	// Start compiling the stream and return right away. The stream itself is
+	// copied, but everything it points to (shader bytecode, input layout,
+	// root signature) must stay valid until the PSO is no longer pending.
+	// Objects in keepAlive are held until then.
+	std::shared_ptr<AsyncPipelineState> Compile(const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+		std::vector<ComPtr<IUnknown>> keepAlive = {}, ComPtr<ID3D12PipelineState> fallback = nullptr);
+	// The same for a PipelineStateStream, whose layout hash is known at
+	// compile time.
+	template<typename... Subobjects>
+	std::shared_ptr<AsyncPipelineState> Compile(const PipelineStateStream<Subobjects...>& stream,
+		std::vector<ComPtr<IUnknown>> keepAlive = {}, ComPtr<ID3D12PipelineState> fallback = nullptr)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		bool persistent = true;
+		uint64_t key = PipelineStateCache::HashPipelineStateStream(stream, &persistent);
+		return Compile(key, persistent, stream.GetDesc(), startTime, std::move(keepAlive), fallback);
+	}
+
+	// Block until every compile has finished.
+	void WaitForAll();
+
+	struct Stats
+	{
+		uint64_t QueueDepth;		// Compiles queued or running.
+		uint64_t MaxQueueDepth;
+		uint64_t Requests;
+		uint64_t ImmediateHits;		// Requests that were already in the cache.
+		uint64_t Completed;
+		uint64_t Failed;
+		// Time from Compile to the PSO being ready, in milliseconds.
+		double AverageLatency;
+		double MaxLatency;
+	};
+	Stats GetStats() const;
+
+private:
+	PipelineStateCompiler(const PipelineStateCompiler& copy) = delete;
+	PipelineStateCompiler& operator=(const PipelineStateCompiler& other) = delete;
+
+	std::shared_ptr<AsyncPipelineState> Compile(uint64_t key, bool persistent, const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+		std::chrono::steady_clock::time_point startTime, std::vector<ComPtr<IUnknown>> keepAlive, ComPtr<ID3D12PipelineState> fallback);
+	void OnCompiled(uint64_t key, ComPtr<ID3D12PipelineState> compiled, std::chrono::steady_clock::time_point startTime, bool succeeded);
+
+	PipelineStateCache& mPipelineStateCache;
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mIdleCondition;
+
+	struct PendingCompile
+	{
+		// Every request for the PSO while it compiles.
+		std::vector<std::shared_ptr<AsyncPipelineState>> requests;
+		// The keepAlive objects of all of those requests.
+		std::vector<ComPtr<IUnknown>> keepAlive;
+	};
+	std::unordered_map<uint64_t, PendingCompile> mPending;
+	Stats mStats;
+	double mTotalLatency;
+};
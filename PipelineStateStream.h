@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Hash.h"
+#include "d3dx12.h"
+
+#include <cstdint>
+#include <type_traits>
+
+// Compile-time information about a CD3DX12_PIPELINE_STATE_STREAM_* subobject type.
+template<typename Subobject>
+struct PipelineStateSubobjectTraits;
+
+template<typename InnerStructType, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType, typename DefaultArg>
+struct PipelineStateSubobjectTraits<CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT<InnerStructType, SubobjectType, DefaultArg>>
+{
+	using InnerType = InnerStructType;
+	static constexpr D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type = SubobjectType;
+	// DEPTH_STENCIL1 replaces DEPTH_STENCIL; a stream can only have one of them.
+	static constexpr D3D12_PIPELINE_STATE_SUBOBJECT_TYPE BaseType =
+		SubobjectType == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1 ?
+		D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL : SubobjectType;
+};
+
+// A CD3DX12_PIPELINE_STATE_STREAM_* subobject type.
+template<typename Subobject>
+concept PipelineStateSubobject = requires { PipelineStateSubobjectTraits<Subobject>::Type; };
+
+template<typename... Subobjects>
+constexpr bool HasDuplicatePipelineStateSubobjects()
+{
+	// The extra element keeps the array from being empty.
+	constexpr D3D12_PIPELINE_STATE_SUBOBJECT_TYPE types[] =
+	{
+		PipelineStateSubobjectTraits<Subobjects>::BaseType...,
+		D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID
+	};
+
+	for (size_t i = 0; i < sizeof...(Subobjects); ++i)
+	{
+		for (size_t j = i + 1; j < sizeof...(Subobjects); ++j)
+		{
+			if (types[i] == types[j])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// At least one subobject, and no subobject type more than once.
+template<typename... Subobjects>
+concept UniquePipelineStateSubobjects = (PipelineStateSubobject<Subobjects> && ...) &&
+	sizeof...(Subobjects) > 0 && !HasDuplicatePipelineStateSubobjects<Subobjects...>();
+
+// A pipeline state stream made of exactly the given subobjects, e.g.
+//
+//   PipelineStateStream<
+//       CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE,
+//       CD3DX12_PIPELINE_STATE_STREAM_VS,
+//       CD3DX12_PIPELINE_STATE_STREAM_PS> stream(rootSignature, vs, ps);
+//
+// The subobjects are laid out back to back with nothing in between, as
+// CreatePipelineState expects, and the stream lives wherever it is declared.
+// Listing no subobjects, or a subobject type twice, fails to compile instead
+// of failing in the driver. Subobjects that aren't given a value keep the
+// d3dx12.h defaults.
+template<typename... Subobjects>
+	requires UniquePipelineStateSubobjects<Subobjects...>
+class PipelineStateStream : public Subobjects...
+{
+public:
+	// A hash of the subobject types in stream order. Streams with the same
+	// layout have the same LayoutHash, whatever their values.
+	static constexpr uint64_t LayoutHash = []()
+	{
+		uint64_t hash = HashOffsetBasis;
+		((hash = HashCombine(hash, PipelineStateSubobjectTraits<Subobjects>::Type)), ...);
+		return hash;
+	}();
+
+	// The offset of a subobject from the start of the stream.
+	template<typename Subobject>
+	static constexpr size_t OffsetOf = []()
+	{
+		static_assert((std::is_same<Subobject, Subobjects>::value || ...), "The stream does not have this subobject.");
+		size_t offset = 0;
+		bool found = false;
+		((found = found || std::is_same<Subobject, Subobjects>::value, offset += found ? 0 : sizeof(Subobjects)), ...);
+		return offset;
+	}();
+
+	PipelineStateStream() = default;
+
+	// Initialize every subobject, in the order they are listed.
+	PipelineStateStream(const typename PipelineStateSubobjectTraits<Subobjects>::InnerType&... values)
+		: Subobjects(values)...
+	{
+	}
+
+	template<typename Subobject>
+	Subobject& Get()
+	{
+		static_assert((std::is_same<Subobject, Subobjects>::value || ...), "The stream does not have this subobject.");
+		return *this;
+	}
+
+	template<typename Subobject>
+	const Subobject& Get() const
+	{
+		static_assert((std::is_same<Subobject, Subobjects>::value || ...), "The stream does not have this subobject.");
+		return *this;
+	}
+
+	template<typename Subobject>
+	void Set(const typename PipelineStateSubobjectTraits<Subobject>::InnerType& value)
+	{
+		Get<Subobject>() = value;
+	}
+
+	D3D12_PIPELINE_STATE_STREAM_DESC GetDesc() const
+	{
+		static_assert(sizeof(PipelineStateStream) == (sizeof(Subobjects) + ...),
+			"Pipeline state subobjects must be tightly packed.");
+
+		return D3D12_PIPELINE_STATE_STREAM_DESC{ sizeof(PipelineStateStream),
+			const_cast<PipelineStateStream*>(this) };
+	}
+};
@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+struct ZoneEvent
+{
+	const char* Name;
+	uint64_t Begin;
+	uint64_t End;
+	uint32_t Depth;
+};
+
+// The zones of one thread. The thread is the only writer and EndFrame
+// the only reader, so a ring with two indices needs no locks.
+struct ThreadBuffer
+{
+	static const uint64_t Capacity = 64 * 1024;
+
+	ThreadBuffer()
+		: Events(std::make_unique<ZoneEvent[]>(Capacity))
+		, WriteIndex(0)
+		, ReadIndex(0)
+		, DroppedZones(0)
+		, Depth(0)
+	{}
+
+	std::unique_ptr<ZoneEvent[]> Events;
+	std::atomic<uint64_t> WriteIndex;
+	std::atomic<uint64_t> ReadIndex;
+	std::atomic<uint64_t> DroppedZones;
+
+	// Only used by the thread.
+	uint32_t Depth;
+
+	// Only used by EndFrame, under the registry lock.
+	std::string Name;
+	// Zones that ended, by depth, whose parents haven't ended yet.
+	std::vector<std::vector<Profiler::Node>> Pending;
+};
+
+static std::mutex gMutex;
+// Kept until the process ends, so zones of threads that have exited can
+// still be collected.
+static std::vector<std::unique_ptr<ThreadBuffer>> gThreadBuffers;
+static Profiler::Frame gLastFrame = {};
+static uint64_t gFrameNumber = 0;
+
+static thread_local ThreadBuffer* tThreadBuffer = nullptr;
+
+static ThreadBuffer& GetThreadBuffer()
+{
+	if (!tThreadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(gMutex);
+		gThreadBuffers.push_back(std::make_unique<ThreadBuffer>());
+		tThreadBuffer = gThreadBuffers.back().get();
+		tThreadBuffer->Name = "Thread " + std::to_string(gThreadBuffers.size() - 1);
+	}
+
+	return *tThreadBuffer;
+}
+
+// Add a zone to its siblings, counting it together with one of the same name.
+static void MergeNode(std::vector<Profiler::Node>& nodes, Profiler::Node&& node)
+{
+	for (Profiler::Node& sibling : nodes)
+	{
+		if (sibling.Name == node.Name)
+		{
+			sibling.Calls += node.Calls;
+			sibling.Time += node.Time;
+			sibling.SelfTime += node.SelfTime;
+			for (Profiler::Node& child : node.Children)
+			{
+				MergeNode(sibling.Children, std::move(child));
+			}
+			return;
+		}
+	}
+
+	nodes.push_back(std::move(node));
+}
+
+static void WriteNodes(std::ostream& stream, const std::vector<Profiler::Node>& nodes, int indent)
+{
+	for (const Profiler::Node& node : nodes)
+	{
+		stream << std::string(indent * 2, ' ') << node.Name
+			<< ": " << node.Time << " ms, self " << node.SelfTime << " ms, " << node.Calls << " calls\n";
+		WriteNodes(stream, node.Children, indent + 1);
+	}
+}
+
+Profiler::Scope::Scope(const char* name)
+	: mName(name)
+{
+	++GetThreadBuffer().Depth;
+	mBegin = Now();
+}
+
+Profiler::Scope::~Scope()
+{
+	uint64_t end = Now();
+
+	ThreadBuffer& buffer = *tThreadBuffer;
+	uint32_t depth = --buffer.Depth;
+
+	uint64_t writeIndex = buffer.WriteIndex.load(std::memory_order_relaxed);
+	if (writeIndex - buffer.ReadIndex.load(std::memory_order_acquire) >= ThreadBuffer::Capacity)
+	{
+		buffer.DroppedZones.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer.Events[writeIndex % ThreadBuffer::Capacity] = ZoneEvent{ mName, mBegin, end, depth };
+	buffer.WriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(gMutex);
+	buffer.Name = name;
+}
+
+void Profiler::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+
+	Frame frame = {};
+	frame.Number = gFrameNumber++;
+
+	for (auto& buffer : gThreadBuffers)
+	{
+		uint64_t readIndex = buffer->ReadIndex.load(std::memory_order_relaxed);
+		uint64_t writeIndex = buffer->WriteIndex.load(std::memory_order_acquire);
+
+		// Zones end after the zones in them, so a zone's children are the
+		// zones one level deeper that ended since its last sibling did.
+		for (uint64_t i = readIndex; i < writeIndex; ++i)
+		{
+			const ZoneEvent& event = buffer->Events[i % ThreadBuffer::Capacity];
+			if (buffer->Pending.size() < event.Depth + 2)
+			{
+				buffer->Pending.resize(event.Depth + 2);
+			}
+
+			Node node = {};
+			node.Name = event.Name;
+			node.Calls = 1;
+			node.Time = (event.End - event.Begin) * 1e-6;
+			node.SelfTime = node.Time;
+			for (Node& child : buffer->Pending[event.Depth + 1])
+			{
+				node.SelfTime -= child.Time;
+				MergeNode(node.Children, std::move(child));
+			}
+			buffer->Pending[event.Depth + 1].clear();
+
+			MergeNode(buffer->Pending[event.Depth], std::move(node));
+		}
+		buffer->ReadIndex.store(writeIndex, std::memory_order_release);
+
+		Thread thread = {};
+		thread.Name = buffer->Name;
+		thread.DroppedZones = buffer->DroppedZones.exchange(0, std::memory_order_relaxed);
+		// Only the top level is complete. Deeper zones wait for their
+		// parent, which may end in a later frame.
+		if (!buffer->Pending.empty())
+		{
+			thread.Zones = std::move(buffer->Pending[0]);
+			buffer->Pending[0].clear();
+		}
+
+		if (!thread.Zones.empty() || thread.DroppedZones > 0)
+		{
+			frame.Threads.push_back(std::move(thread));
+		}
+	}
+
+	gLastFrame = std::move(frame);
+}
+
+Profiler::Frame Profiler::GetLastFrame()
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+	return gLastFrame;
+}
+
+void Profiler::WriteReport(std::ostream& stream, const Frame& frame)
+{
+	std::ios_base::fmtflags flags = stream.flags();
+	std::streamsize precision = stream.precision();
+
+	stream << "Frame " << frame.Number << "\n" << std::fixed << std::setprecision(3);
+	for (const Thread& thread : frame.Threads)
+	{
+		stream << thread.Name;
+		if (thread.DroppedZones > 0)
+		{
+			stream << " (" << thread.DroppedZones << " zones dropped)";
+		}
+		stream << "\n";
+		WriteNodes(stream, thread.Zones, 1);
+	}
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+uint64_t Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile the profile zones out.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Measures where the CPU time of a frame goes.
+//
+// Code is instrumented with PROFILE_SCOPE, which times the rest of the
+// enclosing block as a zone. Every thread records its zones into its own
+// buffer without locks. EndFrame collects the zones of all threads since
+// the last call and merges them into a call tree per thread, with zones of
+// the same name under the same parent counted together.
+//
+// Times are taken from std::chrono::steady_clock. Zone names must be
+// string literals or otherwise outlive the profiler. A zone that is still
+// open at the end of a frame is counted in the frame it ends in, together
+// with the zones in it that ended in earlier frames.
+class Profiler
+{
+public:
+	struct Node
+	{
+		std::string Name;
+		uint32_t Calls;
+		// In milliseconds. The self time leaves out the children.
+		double Time;
+		double SelfTime;
+		std::vector<Node> Children;
+	};
+
+	struct Thread
+	{
+		std::string Name;
+		std::vector<Node> Zones;
+		// Zones that didn't fit into the buffer of the thread.
+		uint64_t DroppedZones;
+	};
+
+	struct Frame
+	{
+		uint64_t Number;
+		std::vector<Thread> Threads;
+	};
+
+	// Times a zone from construction to destruction. Use PROFILE_SCOPE.
+	class Scope
+	{
+	public:
+		Scope(const char* name);
+		~Scope();
+
+	private:
+		Scope(const Scope& copy) = delete;
+		Scope& operator=(const Scope& other) = delete;
+
+		const char* mName;
+		uint64_t mBegin;
+	};
+
+	// The name of the calling thread in the call tree.
+	static void SetThreadName(const std::string& name);
+
+	// Collect the zones that ended since the last call.
+	static void EndFrame();
+	// The call tree of the last frame.
+	static Frame GetLastFrame();
+
+	// The call tree as indented text.
+	static void WriteReport(std::ostream& stream, const Frame& frame);
+
+	// Nanoseconds since a fixed point, from a monotonic clock.
+	static uint64_t Now();
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// Time the rest of the block.
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "QueueDependencyTracker.h"
+
+static bool IsPending(const FenceValue& fenceValue)
+{
+	return fenceValue.GetCommandQueue() && !fenceValue.GetCommandQueue()->IsFenceComplete(fenceValue);
+}
+
+void QueueDependencyTracker::WaitForAccess(CommandQueue& queue, ID3D12Resource* resource, Access access)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto iter = mResources.find(resource);
+	if (iter == mResources.end())
+	{
+		return;
+	}
+
+	ResourceAccesses& accesses = iter->second;
+	if (IsPending(accesses.lastWrite))
+	{
+		queue.Wait(accesses.lastWrite);
+	}
+
+	if (access == Access::Write)
+	{
+		for (auto& read : accesses.reads)
+		{
+			if (IsPending(read))
+			{
+				queue.Wait(read);
+			}
+		}
+	}
+}
+
+void QueueDependencyTracker::RecordAccess(ID3D12Resource* resource, Access access, const FenceValue& fenceValue)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ResourceAccesses& accesses = mResources[resource];
+	if (access == Access::Write)
+	{
+		accesses.lastWrite = fenceValue;
+		accesses.reads.clear();
+	}
+	else
+	{
+		auto iter = std::find_if(accesses.reads.begin(), accesses.reads.end(),
+			[&fenceValue](const FenceValue& read) { return read.GetCommandQueue() == fenceValue.GetCommandQueue(); });
+		if (iter != accesses.reads.end())
+		{
+			*iter = fenceValue;
+		}
+		else
+		{
+			accesses.reads.push_back(fenceValue);
+		}
+	}
+
+	if (mResources.size() > mPruneThreshold)
+	{
+		PruneCompleted();
+		mPruneThreshold = std::max<size_t>(64, mResources.size() * 2);
+	}
+}
+
+void QueueDependencyTracker::Forget(ID3D12Resource* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mResources.erase(resource);
+}
+
+void QueueDependencyTracker::PruneCompleted()
+{
+	for (auto iter = mResources.begin(); iter != mResources.end();)
+	{
+		const ResourceAccesses& accesses = iter->second;
+		bool pending = IsPending(accesses.lastWrite) ||
+			std::any_of(accesses.reads.begin(), accesses.reads.end(), IsPending);
+
+		if (pending)
+		{
+			++iter;
+		}
+		else
+		{
+			iter = mResources.erase(iter);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CommandQueue.h"
+
+#include <d3d12.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Tracks which queue last wrote or read a resource so work on another
+// queue can be made to wait for it on the GPU instead of on the CPU.
+//
+// Before submitting work that touches a resource call WaitForAccess on the
+// queue that will execute it, and after submitting call RecordAccess with
+// the returned fence value.
+class QueueDependencyTracker
+{
+public:
+	enum class Access
+	{
+		Read,
+		Write
+	};
+
+	// Insert GPU waits on queue for any conflicting access by another queue.
+	// Reads wait for the last write. Writes wait for the last write and for
+	// all reads since then.
+	void WaitForAccess(CommandQueue& queue, ID3D12Resource* resource, Access access);
+
+	// Record that the work signaled by fenceValue accesses the resource.
+	void RecordAccess(ID3D12Resource* resource, Access access, const FenceValue& fenceValue);
+
+	// Stop tracking a resource, e.g. because it is being released.
+	void Forget(ID3D12Resource* resource);
+
+private:
+	struct ResourceAccesses
+	{
+		// Only valid if its queue is not null.
+		FenceValue lastWrite{ nullptr, 0 };
+		// The latest read on each queue since the last write.
+		std::vector<FenceValue> reads;
+	};
+
+	// Drop resources whose accesses have all completed.
+	void PruneCompleted();
+
+	std::mutex mMutex;
+	std::unordered_map<ID3D12Resource*, ResourceAccesses> mResources;
+	// Pruning happens whenever the map grows past this size.
+	size_t mPruneThreshold = 64;
+};
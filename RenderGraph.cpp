@@ -0,0 +1,925 @@
+#include "pch.h"
+#include "RenderGraph.h"
+
+#include "CommandQueue.h"
+#include "ResourceStateTracker.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// The states a compute command list can transition resources to and from.
+static const D3D12_RESOURCE_STATES ComputeQueueStates =
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER |
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT |
+	D3D12_RESOURCE_STATE_COPY_DEST |
+	D3D12_RESOURCE_STATE_COPY_SOURCE;
+
+static bool IsSameDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b)
+{
+	// Compared field by field, the struct has padding.
+	return a.Dimension == b.Dimension &&
+		a.Alignment == b.Alignment &&
+		a.Width == b.Width &&
+		a.Height == b.Height &&
+		a.DepthOrArraySize == b.DepthOrArraySize &&
+		a.MipLevels == b.MipLevels &&
+		a.Format == b.Format &&
+		a.SampleDesc.Count == b.SampleDesc.Count &&
+		a.SampleDesc.Quality == b.SampleDesc.Quality &&
+		a.Layout == b.Layout &&
+		a.Flags == b.Flags;
+}
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph& renderGraph, uint32_t pass)
+	: mRenderGraph(renderGraph)
+	, mPass(pass)
+{
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(uint32_t resource, D3D12_RESOURCE_STATES state)
+{
+	mRenderGraph.AddAccess(mPass, resource, state, false);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(uint32_t resource, D3D12_RESOURCE_STATES state)
+{
+	mRenderGraph.AddAccess(mPass, resource, state, true);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SetSideEffects()
+{
+	mRenderGraph.mPasses[mPass].SideEffects = true;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SetAsyncCompute()
+{
+	mRenderGraph.mPasses[mPass].AsyncCompute = true;
+	return *this;
+}
+
+RenderGraph::RenderGraph(ComPtr<ID3D12Device2> device)
+	: mDevice(device)
+	, mCompiled(false)
+	, mHeapSizes{}
+	, mStats{}
+	, mHeaps{}
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+void RenderGraph::Reset()
+{
+	mPasses.clear();
+	mResources.clear();
+	mCompiled = false;
+	mCompiledPasses.clear();
+	mSubmissions.clear();
+	mTransientPlacements.clear();
+	std::fill(std::begin(mHeapSizes), std::end(mHeapSizes), 0);
+	mStats = {};
+}
+
+uint32_t RenderGraph::ImportResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES finalState)
+{
+	assert(resource);
+
+	Resource imported = {};
+	imported.Name = name;
+	imported.ImportedResource = resource;
+	imported.FinalState = finalState;
+	mResources.push_back(imported);
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
+
+uint32_t RenderGraph::CreateTexture(const std::string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue)
+{
+	assert(desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && "Only textures can be transient.");
+
+	Resource texture = {};
+	texture.Name = name;
+	texture.Desc = desc;
+	if (clearValue)
+	{
+		texture.ClearValue = *clearValue;
+		texture.HasClearValue = true;
+	}
+	mResources.push_back(texture);
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
+
+void RenderGraph::MarkOutput(uint32_t resource)
+{
+	assert(resource < mResources.size());
+	mResources[resource].Output = true;
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name, ExecuteFunction execute)
+{
+	Pass pass = {};
+	pass.Name = name;
+	pass.Execute = execute;
+	mPasses.push_back(pass);
+	mCompiled = false;
+	return PassBuilder(*this, static_cast<uint32_t>(mPasses.size() - 1));
+}
+
+void RenderGraph::AddAccess(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state, bool write)
+{
+	assert(resource < mResources.size() && "Invalid render graph resource.");
+
+	std::vector<Access>& accesses = mPasses[pass].Accesses;
+	for (Access& access : accesses)
+	{
+		if (access.Resource == resource)
+		{
+			// A resource is in one state for the whole pass. Reads can share
+			// it, a write can't.
+			assert(!write && !access.Write && "A pass can't access a resource it writes in another way.");
+			access.State |= state;
+			return;
+		}
+	}
+	accesses.push_back(Access{ resource, state, write });
+}
+
+void RenderGraph::Compile(const AllocationInfoFunction& getAllocationInfo)
+{
+	mStats = {};
+	mStats.Passes = static_cast<uint32_t>(mPasses.size());
+
+	CullPasses();
+	ScheduleSubmissions();
+	ComputeBarriers();
+	PlaceTransientResources(getAllocationInfo);
+
+	mCompiled = true;
+}
+
+void RenderGraph::Compile()
+{
+	ComPtr<ID3D12Device2> device = mDevice;
+	Compile([device](const D3D12_RESOURCE_DESC& desc)
+	{
+		return device->GetResourceAllocationInfo(0, 1, &desc);
+	});
+}
+
+void RenderGraph::CullPasses()
+{
+	// Count how often each resource is read and how many resources each
+	// pass writes. Passes that end up writing only resources nobody reads
+	// are culled, which in turn may leave the resources they read unused.
+	std::vector<uint32_t> passReferences(mPasses.size(), 0);
+	std::vector<uint32_t> resourceReferences(mResources.size(), 0);
+	std::vector<std::vector<uint32_t>> writers(mResources.size());
+
+	for (uint32_t i = 0; i < mPasses.size(); ++i)
+	{
+		mPasses[i].Culled = false;
+		for (const Access& access : mPasses[i].Accesses)
+		{
+			if (access.Write)
+			{
+				++passReferences[i];
+				writers[access.Resource].push_back(i);
+			}
+			else
+			{
+				++resourceReferences[access.Resource];
+			}
+		}
+	}
+
+	// Imported and output resources are used after the frame.
+	for (uint32_t i = 0; i < mResources.size(); ++i)
+	{
+		if (mResources[i].ImportedResource || mResources[i].Output)
+		{
+			++resourceReferences[i];
+		}
+	}
+
+	std::vector<uint32_t> unusedResources;
+	auto cullPass = [&](uint32_t pass)
+	{
+		mPasses[pass].Culled = true;
+		++mStats.CulledPasses;
+		for (const Access& access : mPasses[pass].Accesses)
+		{
+			if (!access.Write && --resourceReferences[access.Resource] == 0)
+			{
+				unusedResources.push_back(access.Resource);
+			}
+		}
+	};
+
+	for (uint32_t i = 0; i < mPasses.size(); ++i)
+	{
+		if (passReferences[i] == 0 && !mPasses[i].SideEffects)
+		{
+			cullPass(i);
+		}
+	}
+	for (uint32_t i = 0; i < mResources.size(); ++i)
+	{
+		if (resourceReferences[i] == 0)
+		{
+			unusedResources.push_back(i);
+		}
+	}
+
+	while (!unusedResources.empty())
+	{
+		uint32_t resource = unusedResources.back();
+		unusedResources.pop_back();
+
+		for (uint32_t writer : writers[resource])
+		{
+			if (!mPasses[writer].Culled && --passReferences[writer] == 0 && !mPasses[writer].SideEffects)
+			{
+				cullPass(writer);
+			}
+		}
+	}
+}
+
+void RenderGraph::ScheduleSubmissions()
+{
+	mCompiledPasses.clear();
+	mSubmissions.clear();
+
+	// The submissions that last accessed each resource. Reads on both queues
+	// can run at the same time; writes and state changes wait for all
+	// earlier accesses.
+	struct ResourceUse
+	{
+		bool Used;
+		D3D12_RESOURCE_STATES State;
+		uint32_t LastWrite;
+		uint32_t LastRead[2];	// Since the last write, on the graphics and the compute queue.
+	};
+	std::vector<ResourceUse> uses(mResources.size(),
+		ResourceUse{ false, D3D12_RESOURCE_STATE_COMMON, InvalidSubmission, { InvalidSubmission, InvalidSubmission } });
+
+	for (uint32_t i = 0; i < mPasses.size(); ++i)
+	{
+		const Pass& pass = mPasses[i];
+		if (pass.Culled)
+		{
+			continue;
+		}
+
+		uint32_t compiledPass = static_cast<uint32_t>(mCompiledPasses.size());
+		if (pass.AsyncCompute)
+		{
+			++mStats.AsyncComputePasses;
+		}
+
+		uint32_t wait = InvalidSubmission;
+		auto waitFor = [&](uint32_t submission)
+		{
+			// Work on the same queue is already ordered.
+			if (submission != InvalidSubmission && mSubmissions[submission].AsyncCompute != pass.AsyncCompute &&
+				(wait == InvalidSubmission || submission > wait))
+			{
+				wait = submission;
+			}
+		};
+
+		for (const Access& access : pass.Accesses)
+		{
+			assert((!pass.AsyncCompute || (access.State & ~ComputeQueueStates) == 0) &&
+				"Async compute passes can only use states the compute queue supports.");
+
+			const ResourceUse& use = uses[access.Resource];
+			if (use.Used)
+			{
+				waitFor(use.LastWrite);
+				if (access.Write || access.State != use.State)
+				{
+					waitFor(use.LastRead[0]);
+					waitFor(use.LastRead[1]);
+				}
+			}
+		}
+
+		// Start a new submission when the queue changes, or when the pass
+		// waits for work the passes before it don't need.
+		if (mSubmissions.empty() || mSubmissions.back().AsyncCompute != pass.AsyncCompute ||
+			(wait != InvalidSubmission && (mSubmissions.back().Wait == InvalidSubmission || mSubmissions.back().Wait < wait)))
+		{
+			mSubmissions.push_back(Submission{ pass.AsyncCompute, compiledPass, compiledPass, wait });
+			if (wait != InvalidSubmission)
+			{
+				++mStats.QueueWaits;
+			}
+		}
+		else
+		{
+			mSubmissions.back().LastPass = compiledPass;
+		}
+
+		uint32_t submission = static_cast<uint32_t>(mSubmissions.size() - 1);
+		mCompiledPasses.push_back(CompiledPass{ i, submission, {}, {} });
+
+		for (const Access& access : pass.Accesses)
+		{
+			ResourceUse& use = uses[access.Resource];
+			if (!use.Used || access.Write || access.State != use.State)
+			{
+				use.LastWrite = submission;
+				use.LastRead[0] = InvalidSubmission;
+				use.LastRead[1] = InvalidSubmission;
+			}
+			else
+			{
+				use.LastRead[pass.AsyncCompute ? 1 : 0] = submission;
+			}
+			use.Used = true;
+			use.State = access.State;
+		}
+	}
+
+	mStats.Submissions = static_cast<uint32_t>(mSubmissions.size());
+}
+
+void RenderGraph::ComputeBarriers()
+{
+	struct ResourceUse
+	{
+		bool Used;
+		D3D12_RESOURCE_STATES State;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+	};
+	std::vector<ResourceUse> uses(mResources.size(), ResourceUse{ false, D3D12_RESOURCE_STATE_COMMON, 0, 0 });
+	std::vector<bool> asyncComputeUses(mResources.size(), false);
+
+	auto isAsyncCompute = [this](uint32_t compiledPass)
+	{
+		return mPasses[mCompiledPasses[compiledPass].Pass].AsyncCompute;
+	};
+
+	for (uint32_t i = 0; i < mCompiledPasses.size(); ++i)
+	{
+		CompiledPass& compiledPass = mCompiledPasses[i];
+		for (const Access& access : mPasses[compiledPass.Pass].Accesses)
+		{
+			Resource& resource = mResources[access.Resource];
+			ResourceUse& use = uses[access.Resource];
+
+			if (!use.Used)
+			{
+				// Transient textures are created in the state of their first access.
+				assert((resource.ImportedResource || access.Write) && "Transient texture is read before it is written.");
+				use = ResourceUse{ true, access.State, i, i };
+				resource.InitialState = access.State;
+				resource.LastState = access.State;
+				asyncComputeUses[access.Resource] = isAsyncCompute(i);
+				continue;
+			}
+
+			if (access.State == use.State)
+			{
+				if (access.State == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+				{
+					compiledPass.BarriersBefore.push_back(Barrier{ BarrierType::UAV, access.Resource,
+						D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_BARRIER_FLAG_NONE });
+					++mStats.Barriers;
+				}
+			}
+			else if (isAsyncCompute(i) && !isAsyncCompute(use.LastPass))
+			{
+				// The compute queue can't leave graphics states, so the graphics
+				// queue hands the resource over in the state the pass needs.
+				mCompiledPasses[use.LastPass].BarriersAfter.push_back(Barrier{ BarrierType::Transition, access.Resource,
+					use.State, access.State, D3D12_RESOURCE_BARRIER_FLAG_NONE });
+				++mStats.Barriers;
+			}
+			else if (!resource.ImportedResource)
+			{
+				// Imported resources are transitioned by the tracker.
+				Barrier transition = { BarrierType::Transition, access.Resource, use.State, access.State,
+					D3D12_RESOURCE_BARRIER_FLAG_NONE };
+				// Split barriers can't span command lists.
+				if (i - use.LastPass > 1 && mCompiledPasses[use.LastPass].Submission == compiledPass.Submission)
+				{
+					// Start the transition when the last pass that used the old
+					// state is done, and only wait for it here.
+					transition.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+					mCompiledPasses[use.LastPass].BarriersAfter.push_back(transition);
+					transition.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+					++mStats.SplitBarriers;
+					++mStats.Barriers;
+				}
+				compiledPass.BarriersBefore.push_back(transition);
+				++mStats.Barriers;
+			}
+
+			use.State = access.State;
+			use.LastPass = i;
+			resource.LastState = access.State;
+			asyncComputeUses[access.Resource] = asyncComputeUses[access.Resource] || isAsyncCompute(i);
+		}
+	}
+
+	// Placement needs the lifetimes.
+	mTransientPlacements.clear();
+	for (uint32_t i = 0; i < mResources.size(); ++i)
+	{
+		if (!mResources[i].ImportedResource && uses[i].Used)
+		{
+			Resource& resource = mResources[i];
+			if (isAsyncCompute(uses[i].FirstPass) && !isAsyncCompute(uses[i].LastPass) &&
+				resource.LastState != resource.InitialState)
+			{
+				// The next frame starts using the texture on the compute queue,
+				// which can't leave the state the graphics queue left it in.
+				mCompiledPasses[uses[i].LastPass].BarriersAfter.push_back(Barrier{ BarrierType::Transition, i,
+					resource.LastState, resource.InitialState, D3D12_RESOURCE_BARRIER_FLAG_NONE });
+				resource.LastState = resource.InitialState;
+				++mStats.Barriers;
+			}
+
+			TransientPlacement placement = {};
+			placement.Resource = i;
+			placement.HeapCategory = (mResources[i].Desc.Flags &
+				(D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ?
+				RenderTargetTextures : OtherTextures;
+			placement.FirstPass = uses[i].FirstPass;
+			placement.LastPass = uses[i].LastPass;
+			placement.AsyncCompute = asyncComputeUses[i];
+			mTransientPlacements.push_back(placement);
+		}
+	}
+}
+
+void RenderGraph::PlaceTransientResources(const AllocationInfoFunction& getAllocationInfo)
+{
+	// The graph may be compiled again after adding passes.
+	std::fill(std::begin(mHeapSizes), std::end(mHeapSizes), 0);
+
+	std::vector<uint64_t> alignments(mTransientPlacements.size());
+	for (size_t i = 0; i < mTransientPlacements.size(); ++i)
+	{
+		D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = getAllocationInfo(mResources[mTransientPlacements[i].Resource].Desc);
+		mTransientPlacements[i].Size = allocationInfo.SizeInBytes;
+		alignments[i] = allocationInfo.Alignment;
+		mStats.TransientSize += allocationInfo.SizeInBytes;
+	}
+
+	// Place the largest textures first, each at the lowest offset where it
+	// doesn't overlap a texture that is alive at the same time.
+	std::vector<size_t> order(mTransientPlacements.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		return mTransientPlacements[a].Size > mTransientPlacements[b].Size;
+	});
+
+	auto livesOverlap = [](const TransientPlacement& a, const TransientPlacement& b)
+	{
+		// Pass order says nothing about when work on the other queue runs.
+		return a.AsyncCompute || b.AsyncCompute || (a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass);
+	};
+	auto memoryOverlaps = [](const TransientPlacement& a, const TransientPlacement& b)
+	{
+		return a.HeapCategory == b.HeapCategory && a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+	};
+
+	std::vector<size_t> placed;
+	for (size_t i : order)
+	{
+		TransientPlacement& placement = mTransientPlacements[i];
+		placement.Offset = 0;
+
+		bool moved = true;
+		while (moved)
+		{
+			moved = false;
+			for (size_t j : placed)
+			{
+				const TransientPlacement& other = mTransientPlacements[j];
+				if (livesOverlap(placement, other) && memoryOverlaps(placement, other))
+				{
+					placement.Offset = AlignUp(other.Offset + other.Size, alignments[i]);
+					moved = true;
+				}
+			}
+		}
+		placed.push_back(i);
+
+		mHeapSizes[placement.HeapCategory] = std::max(mHeapSizes[placement.HeapCategory], placement.Offset + placement.Size);
+	}
+
+	for (TransientPlacement& placement : mTransientPlacements)
+	{
+		for (const TransientPlacement& other : mTransientPlacements)
+		{
+			if (other.LastPass < placement.FirstPass && memoryOverlaps(placement, other))
+			{
+				placement.Aliased = true;
+			}
+		}
+
+		if (placement.Aliased)
+		{
+			// The texture takes over the memory before its first pass.
+			std::vector<Barrier>& barriers = mCompiledPasses[placement.FirstPass].BarriersBefore;
+			barriers.insert(barriers.begin(), Barrier{ BarrierType::Aliasing, placement.Resource,
+				D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_BARRIER_FLAG_NONE });
+			++mStats.AliasingBarriers;
+			++mStats.Barriers;
+		}
+	}
+
+	for (uint64_t heapSize : mHeapSizes)
+	{
+		mStats.TransientHeapSize += heapSize;
+	}
+}
+
+void RenderGraph::CreateTransientResources(CommandQueue& commandQueue)
+{
+	static const D3D12_HEAP_FLAGS heapFlags[NumHeapCategories] =
+	{
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+	};
+
+	for (uint32_t category = 0; category < NumHeapCategories; ++category)
+	{
+		if (mHeapSizes[category] <= mHeaps[category].Size)
+		{
+			continue;
+		}
+
+		// Grow the heap. Textures in the old one go away with it.
+		if (mHeaps[category].Heap)
+		{
+			commandQueue.ReleaseWhenComplete(mHeaps[category].Heap);
+		}
+		for (auto iter = mPlacedResources.begin(); iter != mPlacedResources.end();)
+		{
+			if (iter->HeapCategory == category)
+			{
+				commandQueue.ReleaseWhenComplete(iter->Resource);
+				iter = mPlacedResources.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = AlignUp(mHeapSizes[category], D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+		heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = heapFlags[category];
+
+		ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&mHeaps[category].Heap)));
+		mHeaps[category].Size = heapDesc.SizeInBytes;
+	}
+
+	for (PlacedResource& placedResource : mPlacedResources)
+	{
+		placedResource.Used = false;
+	}
+
+	for (const TransientPlacement& placement : mTransientPlacements)
+	{
+		Resource& resource = mResources[placement.Resource];
+
+		auto iter = std::find_if(mPlacedResources.begin(), mPlacedResources.end(), [&](const PlacedResource& placedResource)
+		{
+			// The clear value is ignored; a different one only makes clears slower.
+			return !placedResource.Used && placedResource.HeapCategory == placement.HeapCategory &&
+				placedResource.Offset == placement.Offset && IsSameDesc(placedResource.Desc, resource.Desc);
+		});
+
+		if (iter == mPlacedResources.end())
+		{
+			PlacedResource placedResource = {};
+			placedResource.HeapCategory = placement.HeapCategory;
+			placedResource.Offset = placement.Offset;
+			placedResource.Desc = resource.Desc;
+			placedResource.State = resource.InitialState;
+			placedResource.Created = true;
+
+			ThrowIfFailed(mDevice->CreatePlacedResource(mHeaps[placement.HeapCategory].Heap.Get(), placement.Offset,
+				&resource.Desc, resource.InitialState, resource.HasClearValue ? &resource.ClearValue : nullptr,
+				IID_PPV_ARGS(&placedResource.Resource)));
+
+			std::wstring name(resource.Name.begin(), resource.Name.end());
+			placedResource.Resource->SetName(name.c_str());
+
+			iter = mPlacedResources.insert(mPlacedResources.end(), placedResource);
+		}
+
+		iter->Used = true;
+		resource.PlacedResource = iter->Resource.Get();
+	}
+
+	// Textures of earlier frames that weren't needed this time.
+	for (auto iter = mPlacedResources.begin(); iter != mPlacedResources.end();)
+	{
+		if (!iter->Used)
+		{
+			commandQueue.ReleaseWhenComplete(iter->Resource);
+			iter = mPlacedResources.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+void RenderGraph::AppendBarriers(std::vector<D3D12_RESOURCE_BARRIER>& d3d12Barriers, const std::vector<Barrier>& barriers,
+	ResourceStateTracker& resourceStateTracker) const
+{
+	for (const Barrier& barrier : barriers)
+	{
+		const Resource& resource = mResources[barrier.Resource];
+		switch (barrier.Type)
+		{
+		case BarrierType::Transition:
+			if (resource.ImportedResource)
+			{
+				resourceStateTracker.TransitionResource(resource.ImportedResource, barrier.StateAfter);
+			}
+			else
+			{
+				d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource.PlacedResource,
+					barrier.StateBefore, barrier.StateAfter, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, barrier.Flags));
+			}
+			break;
+		case BarrierType::Aliasing:
+			d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource.PlacedResource));
+			break;
+		case BarrierType::UAV:
+			if (resource.ImportedResource)
+			{
+				resourceStateTracker.UAVBarrier(resource.ImportedResource);
+			}
+			else
+			{
+				d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource.PlacedResource));
+			}
+			break;
+		}
+	}
+}
+
+void RenderGraph::RecordPass(uint32_t compiledPassIndex, ID3D12GraphicsCommandList2* commandList, ResourceStateTracker& resourceStateTracker)
+{
+	const CompiledPass& compiledPass = mCompiledPasses[compiledPassIndex];
+	Pass& pass = mPasses[compiledPass.Pass];
+
+	std::vector<D3D12_RESOURCE_BARRIER> d3d12Barriers;
+	std::vector<ID3D12Resource*> discards;
+	AppendBarriers(d3d12Barriers, compiledPass.BarriersBefore, resourceStateTracker);
+
+	for (const TransientPlacement& placement : mTransientPlacements)
+	{
+		if (placement.FirstPass != compiledPassIndex)
+		{
+			continue;
+		}
+
+		const Resource& resource = mResources[placement.Resource];
+		auto iter = std::find_if(mPlacedResources.begin(), mPlacedResources.end(), [&](const PlacedResource& placedResource)
+		{
+			return placedResource.Resource.Get() == resource.PlacedResource;
+		});
+
+		// Aliased textures got their aliasing barrier from Compile. New
+		// ones may sit on memory a released texture used.
+		if (iter->Created && !placement.Aliased)
+		{
+			d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource.PlacedResource));
+		}
+		// The texture is still in the state the last frame left it in.
+		if (iter->State != resource.InitialState)
+		{
+			d3d12Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource.PlacedResource,
+				iter->State, resource.InitialState));
+		}
+		// Textures that take over memory must be initialized first.
+		if ((iter->Created || placement.Aliased) &&
+			(resource.InitialState == D3D12_RESOURCE_STATE_RENDER_TARGET ||
+			resource.InitialState == D3D12_RESOURCE_STATE_DEPTH_WRITE ||
+			resource.InitialState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS))
+		{
+			discards.push_back(resource.PlacedResource);
+		}
+	}
+
+	for (const Access& access : pass.Accesses)
+	{
+		if (ID3D12Resource* imported = mResources[access.Resource].ImportedResource)
+		{
+			resourceStateTracker.TransitionResource(imported, access.State);
+		}
+	}
+	resourceStateTracker.FlushResourceBarriers(commandList);
+
+	if (!d3d12Barriers.empty())
+	{
+		commandList->ResourceBarrier(static_cast<UINT>(d3d12Barriers.size()), d3d12Barriers.data());
+	}
+	for (ID3D12Resource* discard : discards)
+	{
+		commandList->DiscardResource(discard, nullptr);
+	}
+
+	pass.Execute(*this, commandList);
+
+	d3d12Barriers.clear();
+	AppendBarriers(d3d12Barriers, compiledPass.BarriersAfter, resourceStateTracker);
+	resourceStateTracker.FlushResourceBarriers(commandList);
+	if (!d3d12Barriers.empty())
+	{
+		commandList->ResourceBarrier(static_cast<UINT>(d3d12Barriers.size()), d3d12Barriers.data());
+	}
+}
+
+void RenderGraph::FinishExecute(ResourceStateTracker& resourceStateTracker)
+{
+	for (const Resource& resource : mResources)
+	{
+		if (resource.ImportedResource)
+		{
+			resourceStateTracker.TransitionResource(resource.ImportedResource, resource.FinalState);
+		}
+	}
+
+	for (PlacedResource& placedResource : mPlacedResources)
+	{
+		placedResource.Created = false;
+	}
+	for (const TransientPlacement& placement : mTransientPlacements)
+	{
+		const Resource& resource = mResources[placement.Resource];
+		for (PlacedResource& placedResource : mPlacedResources)
+		{
+			if (placedResource.Resource.Get() == resource.PlacedResource)
+			{
+				placedResource.State = resource.LastState;
+			}
+		}
+	}
+}
+
+void RenderGraph::Execute(CommandQueue& commandQueue, ID3D12GraphicsCommandList2* commandList, ResourceStateTracker& resourceStateTracker)
+{
+	assert(mCompiled && "Compile the render graph before executing it.");
+
+	CreateTransientResources(commandQueue);
+
+	for (uint32_t i = 0; i < mCompiledPasses.size(); ++i)
+	{
+		RecordPass(i, commandList, resourceStateTracker);
+	}
+
+	FinishExecute(resourceStateTracker);
+}
+
+ComPtr<ID3D12GraphicsCommandList2> RenderGraph::Execute(CommandQueue& commandQueue, ComPtr<ID3D12GraphicsCommandList2> commandList,
+	ResourceStateTracker& resourceStateTracker, CommandQueue& computeQueue)
+{
+	assert(mCompiled && "Compile the render graph before executing it.");
+	assert(computeQueue.GetCommandListType() == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+
+	CreateTransientResources(commandQueue);
+
+	// The fence value of each submission once it has been submitted.
+	std::vector<uint64_t> fenceValues(mSubmissions.size(), 0);
+	// Graphics submissions recorded into commandList but not submitted yet.
+	std::vector<uint32_t> recordedSubmissions;
+
+	auto submitGraphics = [&]()
+	{
+		uint64_t fenceValue = commandQueue.ExecuteCommandList(commandList, resourceStateTracker);
+		for (uint32_t submission : recordedSubmissions)
+		{
+			fenceValues[submission] = fenceValue;
+		}
+		recordedSubmissions.clear();
+		commandList = commandQueue.GetCommandList();
+	};
+
+	uint32_t lastComputeSubmission = InvalidSubmission;
+	// The latest compute submission the graphics queue waits for.
+	uint32_t joinedComputeSubmission = InvalidSubmission;
+	for (uint32_t i = 0; i < mSubmissions.size(); ++i)
+	{
+		const Submission& submission = mSubmissions[i];
+		if (submission.AsyncCompute)
+		{
+			if (submission.Wait != InvalidSubmission && fenceValues[submission.Wait] == 0)
+			{
+				submitGraphics();
+			}
+
+			uint64_t waitFenceValue = submission.Wait != InvalidSubmission ? fenceValues[submission.Wait] : 0;
+			if (lastComputeSubmission == InvalidSubmission)
+			{
+				// The first compute work of the frame also waits for the graphics
+				// work of earlier frames, which used the same memory.
+				waitFenceValue = commandQueue.GetLastSignaledFenceValue();
+			}
+			computeQueue.Wait(commandQueue, waitFenceValue);
+
+			ComPtr<ID3D12GraphicsCommandList2> computeCommandList = computeQueue.GetCommandList();
+			ResourceStateTracker computeStateTracker;
+			for (uint32_t pass = submission.FirstPass; pass <= submission.LastPass; ++pass)
+			{
+				RecordPass(pass, computeCommandList.Get(), computeStateTracker);
+			}
+			fenceValues[i] = computeQueue.ExecuteCommandList(computeCommandList, computeStateTracker);
+			lastComputeSubmission = i;
+		}
+		else
+		{
+			if (submission.Wait != InvalidSubmission)
+			{
+				// Only the passes from here on wait.
+				if (!recordedSubmissions.empty())
+				{
+					submitGraphics();
+				}
+				commandQueue.Wait(computeQueue, fenceValues[submission.Wait]);
+				joinedComputeSubmission = submission.Wait;
+			}
+
+			for (uint32_t pass = submission.FirstPass; pass <= submission.LastPass; ++pass)
+			{
+				RecordPass(pass, commandList.Get(), resourceStateTracker);
+			}
+			recordedSubmissions.push_back(i);
+		}
+	}
+
+	// Join the compute work back into the graphics queue, so the end of the
+	// frame and the next frame can rely on it.
+	if (lastComputeSubmission != joinedComputeSubmission)
+	{
+		if (!recordedSubmissions.empty())
+		{
+			submitGraphics();
+		}
+		commandQueue.Wait(computeQueue, fenceValues[lastComputeSubmission]);
+	}
+
+	FinishExecute(resourceStateTracker);
+
+	return commandList;
+}
+
+ID3D12Resource* RenderGraph::GetResource(uint32_t resource) const
+{
+	assert(resource < mResources.size());
+	const Resource& graphResource = mResources[resource];
+	return graphResource.ImportedResource ? graphResource.ImportedResource : graphResource.PlacedResource;
+}
+
+const std::vector<RenderGraph::CompiledPass>& RenderGraph::GetCompiledPasses() const
+{
+	return mCompiledPasses;
+}
+
+const std::vector<RenderGraph::Submission>& RenderGraph::GetSubmissions() const
+{
+	return mSubmissions;
+}
+
+const std::vector<RenderGraph::TransientPlacement>& RenderGraph::GetTransientPlacements() const
+{
+	return mTransientPlacements;
+}
+
+bool RenderGraph::IsPassCulled(uint32_t pass) const
+{
+	assert(pass < mPasses.size());
+	return mPasses[pass].Culled;
+}
+
+RenderGraph::Stats RenderGraph::GetStats() const
+{
+	return mStats;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class CommandQueue;
+class ResourceStateTracker;
+
+// Describes a frame as a list of passes and the resources they read and
+// write, and records it with the barriers it needs.
+//
+// The graph is built again every frame: Reset, import the resources that
+// live outside the frame, create transient textures, add passes, Compile
+// and Execute. Compiling is pure bookkeeping and doesn't need a GPU:
+//   - Passes whose results are never used are culled. Passes that write an
+//     imported or output resource, or that have side effects, are kept.
+//   - Passes run in the order they were added, which always satisfies the
+//     dependencies between them.
+//   - Transitions of transient textures are split when other passes run in
+//     between, so the GPU can start them early.
+//   - Transient textures whose lifetimes don't overlap share heap memory.
+//   - Passes marked as async compute are grouped into submissions on the
+//     compute queue. They overlap the graphics work around them and only
+//     wait for it, on the GPU, where they use its results, and the other way
+//     round.
+//
+// Imported resources are transitioned through the ResourceStateTracker of
+// the command list, so their states stay known outside the graph.
+// Transient textures are owned by the graph and reused across frames while
+// their descriptions stay the same.
+//
+// Async compute passes may only use states a compute command list supports.
+// Resources are handed over between the queues in the state the compute
+// pass needs by the graphics queue. An imported resource that is first used
+// by an async compute pass must already be in such a state.
+class RenderGraph
+{
+public:
+	static const uint32_t InvalidResource = ~0u;
+	static const uint32_t InvalidSubmission = ~0u;
+
+	using ExecuteFunction = std::function<void(RenderGraph& renderGraph, ID3D12GraphicsCommandList2* commandList)>;
+	// Returns the size and alignment of a resource, e.g. from
+	// ID3D12Device::GetResourceAllocationInfo.
+	using AllocationInfoFunction = std::function<D3D12_RESOURCE_ALLOCATION_INFO(const D3D12_RESOURCE_DESC& desc)>;
+
+	// Declares what a pass reads and writes.
+	class PassBuilder
+	{
+	public:
+		PassBuilder& Read(uint32_t resource,
+			D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		PassBuilder& Write(uint32_t resource, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_RENDER_TARGET);
+		// Never cull the pass, e.g. because it reads back data on the CPU.
+		PassBuilder& SetSideEffects();
+		// Run the pass on the compute queue, next to the graphics work.
+		PassBuilder& SetAsyncCompute();
+
+	private:
+		friend class RenderGraph;
+
+		PassBuilder(RenderGraph& renderGraph, uint32_t pass);
+
+		RenderGraph& mRenderGraph;
+		uint32_t mPass;
+	};
+
+	// The device is only needed to Execute.
+	RenderGraph(ComPtr<ID3D12Device2> device = nullptr);
+	virtual ~RenderGraph();
+
+	// Remove all passes and resources. Transient memory is kept for the next frame.
+	void Reset();
+
+	// A resource that lives outside the graph. It is left in finalState.
+	uint32_t ImportResource(const std::string& name, ID3D12Resource* resource, D3D12_RESOURCE_STATES finalState);
+	// A texture that only lives during the frame. Its first access must be
+	// a write; for render targets and depth buffers that write must
+	// initialize it, e.g. with a clear.
+	uint32_t CreateTexture(const std::string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+	// Keep the passes that write the resource even if nothing reads it.
+	void MarkOutput(uint32_t resource);
+
+	PassBuilder AddPass(const std::string& name, ExecuteFunction execute);
+
+	void Compile(const AllocationInfoFunction& getAllocationInfo);
+	// Compile with the allocation info of the device.
+	void Compile();
+
+	// Record the compiled passes into the command list. commandQueue must be
+	// the queue the command list is submitted to. Async compute passes are
+	// recorded into the command list as well.
+	void Execute(CommandQueue& commandQueue, ID3D12GraphicsCommandList2* commandList, ResourceStateTracker& resourceStateTracker);
+	// Record the compiled passes and run the async compute passes on
+	// computeQueue. Graphics work that async compute passes wait for is
+	// submitted to commandQueue along the way, so GPU waits that the frame
+	// needs must be issued before. Returns the command list the rest of the
+	// frame was recorded into, which the caller submits with the tracker
+	// instead of commandList.
+	ComPtr<ID3D12GraphicsCommandList2> Execute(CommandQueue& commandQueue, ComPtr<ID3D12GraphicsCommandList2> commandList,
+		ResourceStateTracker& resourceStateTracker, CommandQueue& computeQueue);
+
+	// The D3D12 resource. Only valid for transient textures while executing.
+	ID3D12Resource* GetResource(uint32_t resource) const;
+
+	// The result of Compile.
+	enum class BarrierType
+	{
+		Transition,
+		Aliasing,
+		UAV,
+	};
+
+	struct Barrier
+	{
+		BarrierType Type;
+		uint32_t Resource;
+		D3D12_RESOURCE_STATES StateBefore;
+		D3D12_RESOURCE_STATES StateAfter;
+		// BEGIN_ONLY or END_ONLY for split transitions.
+		D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	};
+
+	struct CompiledPass
+	{
+		uint32_t Pass;	// The index of the pass in the order it was added.
+		uint32_t Submission;
+		std::vector<Barrier> BarriersBefore;
+		std::vector<Barrier> BarriersAfter;
+	};
+
+	// Compiled passes that are submitted together to one queue.
+	struct Submission
+	{
+		bool AsyncCompute;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		// The latest submission on the other queue this one waits for on the
+		// GPU, or InvalidSubmission.
+		uint32_t Wait;
+	};
+
+	struct TransientPlacement
+	{
+		uint32_t Resource;
+		uint32_t HeapCategory;
+		uint64_t Offset;
+		uint64_t Size;
+		// The first and last compiled pass that use the texture.
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		// Another texture used the memory earlier in the frame.
+		bool Aliased;
+		// Used by an async compute pass, so it may be alive at any time and
+		// never shares memory.
+		bool AsyncCompute;
+	};
+
+	const std::vector<CompiledPass>& GetCompiledPasses() const;
+	const std::vector<Submission>& GetSubmissions() const;
+	const std::vector<TransientPlacement>& GetTransientPlacements() const;
+	bool IsPassCulled(uint32_t pass) const;
+
+	struct Stats
+	{
+		uint32_t Passes;
+		uint32_t CulledPasses;
+		uint32_t Barriers;
+		uint32_t SplitBarriers;		// Counted once for each begin and end pair.
+		uint32_t AliasingBarriers;
+		uint32_t AsyncComputePasses;
+		uint32_t Submissions;
+		uint32_t QueueWaits;		// GPU waits between the graphics and compute queue.
+		uint64_t TransientSize;		// Memory the transient textures would need without aliasing.
+		uint64_t TransientHeapSize;	// Memory they need with aliasing.
+	};
+	Stats GetStats() const;
+
+private:
+	RenderGraph(const RenderGraph& copy) = delete;
+	RenderGraph& operator=(const RenderGraph& other) = delete;
+
+	// Textures that can share a heap on every resource heap tier.
+	enum HeapCategory
+	{
+		RenderTargetTextures,
+		OtherTextures,
+		NumHeapCategories
+	};
+
+	struct Access
+	{
+		uint32_t Resource;
+		D3D12_RESOURCE_STATES State;
+		bool Write;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		ExecuteFunction Execute;
+		std::vector<Access> Accesses;
+		bool SideEffects;
+		bool AsyncCompute;
+		bool Culled;
+	};
+
+	struct Resource
+	{
+		std::string Name;
+		// Null for transient textures.
+		ID3D12Resource* ImportedResource;
+		// The state an imported resource is left in.
+		D3D12_RESOURCE_STATES FinalState;
+		D3D12_RESOURCE_DESC Desc;
+		D3D12_CLEAR_VALUE ClearValue;
+		bool HasClearValue;
+		bool Output;
+		// The states of a transient texture at its first and last access.
+		D3D12_RESOURCE_STATES InitialState;
+		D3D12_RESOURCE_STATES LastState;
+		// Set while executing.
+		ID3D12Resource* PlacedResource;
+	};
+
+	void AddAccess(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state, bool write);
+
+	void CullPasses();
+	void ScheduleSubmissions();
+	void ComputeBarriers();
+	void PlaceTransientResources(const AllocationInfoFunction& getAllocationInfo);
+
+	void CreateTransientResources(CommandQueue& commandQueue);
+	void RecordPass(uint32_t compiledPassIndex, ID3D12GraphicsCommandList2* commandList, ResourceStateTracker& resourceStateTracker);
+	// Leave imported resources in their final states and remember the states
+	// of the transient textures for the next frame.
+	void FinishExecute(ResourceStateTracker& resourceStateTracker);
+	// Barriers of transient textures are appended to d3d12Barriers. Those of
+	// imported resources go through the tracker.
+	void AppendBarriers(std::vector<D3D12_RESOURCE_BARRIER>& d3d12Barriers, const std::vector<Barrier>& barriers,
+		ResourceStateTracker& resourceStateTracker) const;
+
+	ComPtr<ID3D12Device2> mDevice;
+
+	std::vector<Pass> mPasses;
+	std::vector<Resource> mResources;
+
+	bool mCompiled;
+	std::vector<CompiledPass> mCompiledPasses;
+	std::vector<Submission> mSubmissions;
+	std::vector<TransientPlacement> mTransientPlacements;
+	uint64_t mHeapSizes[NumHeapCategories];
+	Stats mStats;
+
+	// Transient memory, kept across frames.
+	struct TransientHeap
+	{
+		ComPtr<ID3D12Heap> Heap;
+		uint64_t Size;
+	};
+	TransientHeap mHeaps[NumHeapCategories];
+
+	struct PlacedResource
+	{
+		uint32_t HeapCategory;
+		uint64_t Offset;
+		D3D12_RESOURCE_DESC Desc;
+		ComPtr<ID3D12Resource> Resource;
+		// The state the texture was left in by the last frame.
+		D3D12_RESOURCE_STATES State;
+		bool Used;
+		// Created this frame, so its memory may still hold another texture.
+		bool Created;
+	};
+	std::vector<PlacedResource> mPlacedResources;
+};
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "ResourceHeapAllocator.h"
+
+#include "CommandQueue.h"
+
+ResourceHeapAllocator::ResourceHeapAllocator(ComPtr<ID3D12Device2> device, uint64_t heapSize)
+	: mDevice(device)
+	, mHeapSize(heapSize)
+	, mResourceHeapTier(D3D12_RESOURCE_HEAP_TIER_1)
+	, mCommittedCount(0)
+{
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	if (SUCCEEDED(mDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+	{
+		mResourceHeapTier = options.ResourceHeapTier;
+	}
+}
+
+ResourceHeapAllocator::~ResourceHeapAllocator()
+{
+}
+
+ResourceHeapAllocator::HeapCategory ResourceHeapAllocator::GetHeapCategory(const D3D12_RESOURCE_DESC& resourceDesc) const
+{
+	if (mResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2)
+	{
+		return AllResources;
+	}
+
+	if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		return Buffers;
+	}
+
+	if (resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		return RenderTargetTextures;
+	}
+
+	return OtherTextures;
+}
+
+ComPtr<ID3D12Resource> ResourceHeapAllocator::CreateResource(const D3D12_RESOURCE_DESC& resourceDesc,
+	D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue)
+{
+	ComPtr<ID3D12Resource> resource;
+
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = mDevice->GetResourceAllocationInfo(0, 1, &resourceDesc);
+	if (allocationInfo.SizeInBytes == UINT64_MAX)
+	{
+		throw std::exception();
+	}
+
+	if (allocationInfo.SizeInBytes > mHeapSize)
+	{
+		auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		ThrowIfFailed(mDevice->CreateCommittedResource(
+			&heapProp,
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			initialState,
+			clearValue,
+			IID_PPV_ARGS(&resource)));
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPlacements[resource.Get()] = Placement{ nullptr, 0 };
+		++mCommittedCount;
+
+		return resource;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	HeapCategory category = GetHeapCategory(resourceDesc);
+
+	Heap* heap = nullptr;
+	uint64_t offset = BuddyAllocator::InvalidOffset;
+	for (auto& candidate : mHeaps)
+	{
+		if (candidate->category == category)
+		{
+			offset = candidate->allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+			if (offset != BuddyAllocator::InvalidOffset)
+			{
+				heap = candidate.get();
+				break;
+			}
+		}
+	}
+
+	if (!heap)
+	{
+		static const D3D12_HEAP_FLAGS heapFlags[NumHeapCategories] =
+		{
+			D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		};
+
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = mHeapSize;
+		heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		// Large enough for MSAA textures as well.
+		heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = heapFlags[category];
+
+		ComPtr<ID3D12Heap> d3d12Heap;
+		ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&d3d12Heap)));
+
+		mHeaps.push_back(std::unique_ptr<Heap>(new Heap{ d3d12Heap, category,
+			BuddyAllocator(mHeapSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) }));
+		heap = mHeaps.back().get();
+
+		offset = heap->allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+		assert(offset != BuddyAllocator::InvalidOffset);
+	}
+
+	HRESULT hr = mDevice->CreatePlacedResource(heap->heap.Get(), offset,
+		&resourceDesc, initialState, clearValue, IID_PPV_ARGS(&resource));
+	if (FAILED(hr))
+	{
+		heap->allocator.Free(offset);
+		ThrowIfFailed(hr);
+	}
+
+	mPlacements[resource.Get()] = Placement{ heap, offset };
+
+	return resource;
+}
+
+void ResourceHeapAllocator::ReleaseResource(ComPtr<ID3D12Resource> resource, CommandQueue& commandQueue)
+{
+	commandQueue.AddFenceCallback(commandQueue.GetLastSignaledFenceValue(), [this, resource]()
+	{
+		ReleaseResource(resource);
+	});
+}
+
+void ResourceHeapAllocator::ReleaseResource(ComPtr<ID3D12Resource> resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto iter = mPlacements.find(resource.Get());
+	assert(iter != mPlacements.end() && "Resource was not created by this allocator.");
+	if (iter == mPlacements.end())
+	{
+		return;
+	}
+
+	if (iter->second.heap)
+	{
+		iter->second.heap->allocator.Free(iter->second.offset);
+	}
+	else
+	{
+		--mCommittedCount;
+	}
+	mPlacements.erase(iter);
+}
+
+ResourceHeapAllocator::Stats ResourceHeapAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	Stats stats = {};
+	stats.HeapCount = mHeaps.size();
+	stats.CommittedCount = mCommittedCount;
+	stats.PlacedCount = mPlacements.size() - mCommittedCount;
+
+	double weightedFragmentation = 0.0;
+	uint64_t totalFree = 0;
+	for (auto& heap : mHeaps)
+	{
+		BuddyAllocator::Stats heapStats = heap->allocator.GetStats();
+		stats.HeapSize += heapStats.Size;
+		stats.AllocatedSize += heapStats.AllocatedSize;
+		stats.RequestedSize += heapStats.RequestedSize;
+		stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, heapStats.LargestFreeBlock);
+
+		uint64_t heapFree = heapStats.Size - heapStats.AllocatedSize;
+		weightedFragmentation += heapStats.Fragmentation * heapFree;
+		totalFree += heapFree;
+	}
+	stats.Fragmentation = totalFree > 0 ? weightedFragmentation / totalFree : 0.0;
+
+	return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "BuddyAllocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+class CommandQueue;
+
+// Creates default heap resources as placed resources inside large
+// ID3D12Heaps instead of giving every resource its own committed allocation.
+// Each heap is suballocated with a buddy allocator. On resource heap tier 1
+// hardware, buffers, render target/depth textures and other textures are
+// kept in separate heaps, as the tier requires.
+class ResourceHeapAllocator
+{
+public:
+	ResourceHeapAllocator(ComPtr<ID3D12Device2> device, uint64_t heapSize = 64 * 1024 * 1024);
+	virtual ~ResourceHeapAllocator();
+
+	// Create a resource in a default heap. Resources larger than a heap get
+	// a committed allocation of their own.
+	ComPtr<ID3D12Resource> CreateResource(const D3D12_RESOURCE_DESC& resourceDesc,
+		D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+	// Release the resource and give its memory back once all work submitted
+	// to the queue so far has completed.
+	void ReleaseResource(ComPtr<ID3D12Resource> resource, CommandQueue& commandQueue);
+	// Release the resource and give its memory back immediately. The GPU
+	// must not be using it anymore.
+	void ReleaseResource(ComPtr<ID3D12Resource> resource);
+
+	struct Stats
+	{
+		uint64_t HeapCount;
+		uint64_t HeapSize;			// Memory reserved by all heaps.
+		uint64_t AllocatedSize;		// Memory handed out to placed resources, including padding.
+		uint64_t RequestedSize;		// Memory the placed resources asked for.
+		uint64_t PlacedCount;
+		uint64_t CommittedCount;	// Resources too large for a heap.
+		uint64_t LargestFreeBlock;
+		// Average fragmentation of the heaps, weighted by free memory.
+		double Fragmentation;
+	};
+	Stats GetStats() const;
+
+private:
+	ResourceHeapAllocator(const ResourceHeapAllocator& copy) = delete;
+	ResourceHeapAllocator& operator=(const ResourceHeapAllocator& other) = delete;
+
+	enum HeapCategory
+	{
+		// Used for everything on resource heap tier 2.
+		AllResources = 0,
+		Buffers,
+		RenderTargetTextures,
+		OtherTextures,
+		NumHeapCategories
+	};
+
+	HeapCategory GetHeapCategory(const D3D12_RESOURCE_DESC& resourceDesc) const;
+
+	struct Heap
+	{
+		ComPtr<ID3D12Heap> heap;
+		HeapCategory category;
+		BuddyAllocator allocator;
+	};
+
+	struct Placement
+	{
+		Heap* heap;
+		uint64_t offset;
+	};
+
+	ComPtr<ID3D12Device2> mDevice;
+	uint64_t mHeapSize;
+	D3D12_RESOURCE_HEAP_TIER mResourceHeapTier;
+
+	mutable std::mutex mMutex;
+	std::vector<std::unique_ptr<Heap>> mHeaps;
+	// Where each placed resource lives. Committed resources are not in here.
+	std::unordered_map<ID3D12Resource*, Placement> mPlacements;
+	uint64_t mCommittedCount;
+};
@@ -0,0 +1,187 @@
+#include "pch.h"
+#include "ResourceStateTracker.h"
+
+// The state of the rest of a resource whose first transition in a command
+// list was for single subresources.
+static const D3D12_RESOURCE_STATES UnknownState = static_cast<D3D12_RESOURCE_STATES>(-1);
+
+std::mutex ResourceStateTracker::sGlobalMutex;
+std::unordered_map<ID3D12Resource*, ResourceStateTracker::ResourceState> ResourceStateTracker::sGlobalResourceState;
+
+void ResourceStateTracker::ResourceState::SetSubresourceState(UINT subresource, D3D12_RESOURCE_STATES state)
+{
+	if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		State = state;
+		SubresourceState.clear();
+	}
+	else
+	{
+		SubresourceState[subresource] = state;
+	}
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::ResourceState::GetSubresourceState(UINT subresource) const
+{
+	auto iter = SubresourceState.find(subresource);
+	return iter != SubresourceState.end() ? iter->second : State;
+}
+
+ResourceStateTracker::ResourceStateTracker()
+	: mStats{}
+{
+}
+
+ResourceStateTracker::~ResourceStateTracker()
+{
+	assert(mResourceBarriers.empty() && "Resource barriers were never flushed.");
+}
+
+void ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, UINT subresource)
+{
+	assert(resource);
+
+	auto iter = mFinalResourceState.find(resource);
+	if (iter == mFinalResourceState.end())
+	{
+		// The first use in this command list. The state before is only known
+		// once the list is submitted.
+		mPendingTransitions.push_back(PendingTransition{ resource, subresource, stateAfter });
+
+		ResourceState& finalState = mFinalResourceState.emplace(resource, ResourceState(UnknownState)).first->second;
+		finalState.SetSubresourceState(subresource, stateAfter);
+		return;
+	}
+
+	ResourceState& finalState = iter->second;
+	if (finalState.GetSubresourceState(subresource) == UnknownState)
+	{
+		assert(subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES &&
+			"A resource that was first transitioned per subresource can't be transitioned as a whole.");
+
+		// The first use of this subresource.
+		mPendingTransitions.push_back(PendingTransition{ resource, subresource, stateAfter });
+		finalState.SetSubresourceState(subresource, stateAfter);
+		return;
+	}
+
+	AppendTransition(mResourceBarriers, resource, finalState, subresource, stateAfter);
+	finalState.SetSubresourceState(subresource, stateAfter);
+}
+
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* resource)
+{
+	mResourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+}
+
+void ResourceStateTracker::AliasBarrier(ID3D12Resource* resourceBefore, ID3D12Resource* resourceAfter)
+{
+	mResourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(resourceBefore, resourceAfter));
+}
+
+void ResourceStateTracker::AppendTransition(std::vector<D3D12_RESOURCE_BARRIER>& barriers, ID3D12Resource* resource,
+	const ResourceState& stateBefore, UINT subresource, D3D12_RESOURCE_STATES stateAfter)
+{
+	if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !stateBefore.SubresourceState.empty())
+	{
+		// A barrier for all subresources needs them all in the same state, so
+		// move the ones that differ back to the state of the rest first.
+		for (const auto& subresourceState : stateBefore.SubresourceState)
+		{
+			if (subresourceState.second != stateBefore.State)
+			{
+				barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+					subresourceState.second, stateBefore.State, subresourceState.first));
+			}
+		}
+	}
+
+	D3D12_RESOURCE_STATES before = stateBefore.GetSubresourceState(subresource);
+	if (before != stateAfter)
+	{
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, before, stateAfter, subresource));
+	}
+}
+
+void ResourceStateTracker::FlushResourceBarriers(ID3D12GraphicsCommandList* commandList)
+{
+	if (!mResourceBarriers.empty())
+	{
+		commandList->ResourceBarrier(static_cast<UINT>(mResourceBarriers.size()), mResourceBarriers.data());
+
+		mStats.Barriers += static_cast<uint32_t>(mResourceBarriers.size());
+		++mStats.Flushes;
+		mResourceBarriers.clear();
+	}
+}
+
+std::vector<D3D12_RESOURCE_BARRIER> ResourceStateTracker::ResolvePendingResourceBarriers()
+{
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	for (const PendingTransition& pending : mPendingTransitions)
+	{
+		auto iter = sGlobalResourceState.find(pending.Resource);
+		assert(iter != sGlobalResourceState.end() && "Resource has no global state. Use AddGlobalResourceState.");
+		if (iter != sGlobalResourceState.end())
+		{
+			AppendTransition(barriers, pending.Resource, iter->second, pending.Subresource, pending.StateAfter);
+		}
+	}
+	mPendingTransitions.clear();
+
+	mStats.PendingBarriers += static_cast<uint32_t>(barriers.size());
+	return barriers;
+}
+
+void ResourceStateTracker::CommitFinalResourceStates()
+{
+	assert(mResourceBarriers.empty() && "Resource barriers must be flushed before the command list is submitted.");
+
+	for (const auto& finalState : mFinalResourceState)
+	{
+		ResourceState& globalState = sGlobalResourceState[finalState.first];
+		if (finalState.second.State != UnknownState)
+		{
+			globalState = finalState.second;
+		}
+		else
+		{
+			// Only these subresources were used.
+			for (const auto& subresourceState : finalState.second.SubresourceState)
+			{
+				globalState.SetSubresourceState(subresourceState.first, subresourceState.second);
+			}
+		}
+	}
+	mFinalResourceState.clear();
+}
+
+void ResourceStateTracker::Reset()
+{
+	mPendingTransitions.clear();
+	mResourceBarriers.clear();
+	mFinalResourceState.clear();
+	mStats = {};
+}
+
+ResourceStateTracker::Stats ResourceStateTracker::GetStats() const
+{
+	return mStats;
+}
+
+std::unique_lock<std::mutex> ResourceStateTracker::LockGlobalState()
+{
+	return std::unique_lock<std::mutex>(sGlobalMutex);
+}
+
+void ResourceStateTracker::AddGlobalResourceState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	std::lock_guard<std::mutex> lock(sGlobalMutex);
+	sGlobalResourceState[resource] = ResourceState(state);
+}
+
+void ResourceStateTracker::RemoveGlobalResourceState(ID3D12Resource* resource)
+{
+	std::lock_guard<std::mutex> lock(sGlobalMutex);
+	sGlobalResourceState.erase(resource);
+}
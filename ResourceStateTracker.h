@@ -0,0 +1,111 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Tracks the state of resources while a command list is recorded, so
+// callers only say which state they need next instead of passing exact
+// before and after states.
+//
+// Each command list gets its own tracker. Transitions are collected and
+// only recorded, as one ResourceBarrier call, by FlushResourceBarriers right
+// before the draw, dispatch or copy that needs them. The first transition of
+// a resource in a command list can't know the state the resource will be in
+// when the list executes, so it stays pending until the list is submitted
+// (CommandQueue::ExecuteCommandList with a tracker). Pending transitions are
+// then resolved against the global states and recorded in a small command
+// list that runs just before.
+//
+// Resources must be registered with AddGlobalResourceState before they are
+// tracked, and removed with RemoveGlobalResourceState before they are released.
+//
+// Within one command list, a resource whose first transition was for single
+// subresources can't later be transitioned as a whole.
+class ResourceStateTracker
+{
+public:
+	ResourceStateTracker();
+	virtual ~ResourceStateTracker();
+
+	// Transition a subresource, or the whole resource, to stateAfter.
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter,
+		UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+	// Wait for UAV writes to finish. Null waits for all of them.
+	void UAVBarrier(ID3D12Resource* resource = nullptr);
+	void AliasBarrier(ID3D12Resource* resourceBefore = nullptr, ID3D12Resource* resourceAfter = nullptr);
+
+	// Record the transitions collected so far in one ResourceBarrier call.
+	void FlushResourceBarriers(ID3D12GraphicsCommandList* commandList);
+
+	// Resolve the pending transitions against the global states. The global
+	// state lock must be held until the command list has been submitted.
+	std::vector<D3D12_RESOURCE_BARRIER> ResolvePendingResourceBarriers();
+	// Make the states at the end of the command list the global states. The
+	// global state lock must be held.
+	void CommitFinalResourceStates();
+
+	// Forget everything for the next command list.
+	void Reset();
+
+	// Counts since the last Reset.
+	struct Stats
+	{
+		uint32_t Barriers;			// Recorded by FlushResourceBarriers.
+		uint32_t Flushes;			// ResourceBarrier calls the barriers were batched into.
+		uint32_t PendingBarriers;	// Resolved at submit time.
+	};
+	Stats GetStats() const;
+
+	// Lock the global states, from resolving the pending transitions of a
+	// command list until it has been submitted.
+	static std::unique_lock<std::mutex> LockGlobalState();
+
+	static void AddGlobalResourceState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+	static void RemoveGlobalResourceState(ID3D12Resource* resource);
+
+private:
+	ResourceStateTracker(const ResourceStateTracker& copy) = delete;
+	ResourceStateTracker& operator=(const ResourceStateTracker& other) = delete;
+
+	// The state of a resource, with the subresources that differ from the
+	// rest listed separately.
+	struct ResourceState
+	{
+		explicit ResourceState(D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON)
+			: State(state)
+		{}
+
+		void SetSubresourceState(UINT subresource, D3D12_RESOURCE_STATES state);
+		D3D12_RESOURCE_STATES GetSubresourceState(UINT subresource) const;
+
+		D3D12_RESOURCE_STATES State;
+		std::map<UINT, D3D12_RESOURCE_STATES> SubresourceState;
+	};
+
+	// Append the barriers that move subresource (or all of them) from
+	// stateBefore to stateAfter.
+	static void AppendTransition(std::vector<D3D12_RESOURCE_BARRIER>& barriers, ID3D12Resource* resource,
+		const ResourceState& stateBefore, UINT subresource, D3D12_RESOURCE_STATES stateAfter);
+
+	struct PendingTransition
+	{
+		ID3D12Resource* Resource;
+		UINT Subresource;
+		D3D12_RESOURCE_STATES StateAfter;
+	};
+
+	std::vector<PendingTransition> mPendingTransitions;
+	// Barriers that have been collected but not flushed yet.
+	std::vector<D3D12_RESOURCE_BARRIER> mResourceBarriers;
+	// The state of each resource at the end of the command list so far.
+	std::unordered_map<ID3D12Resource*, ResourceState> mFinalResourceState;
+	Stats mStats;
+
+	static std::mutex sGlobalMutex;
+	static std::unordered_map<ID3D12Resource*, ResourceState> sGlobalResourceState;
+};
@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "RingAllocator.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+RingAllocator::RingAllocator(uint64_t capacity)
+	: mCapacity(capacity)
+	, mHead(0)
+	, mTail(0)
+	, mRetryCount(0)
+{
+	assert(capacity > 0 && "Ring capacity must not be zero.");
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+	assert(mCapacity % alignment == 0 && "Alignment must divide the ring capacity.");
+
+	if (size > mCapacity)
+	{
+		return InvalidOffset;
+	}
+
+	uint64_t head = mHead.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		uint64_t offset = AlignUp(head, alignment);
+
+		// Allocations never straddle the end of the ring; skip to the start instead.
+		uint64_t ringOffset = offset % mCapacity;
+		if (ringOffset + size > mCapacity)
+		{
+			offset += mCapacity - ringOffset;
+		}
+
+		uint64_t newHead = offset + size;
+		if (newHead - mTail.load(std::memory_order_acquire) > mCapacity)
+		{
+			return InvalidOffset;
+		}
+
+		if (mHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return offset % mCapacity;
+		}
+		mRetryCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void RingAllocator::Retire(uint64_t fenceValue)
+{
+	std::lock_guard<std::mutex> lock(mRetireMutex);
+
+	uint64_t head = mHead.load(std::memory_order_acquire);
+	uint64_t lastRetiredHead = mRetirements.empty() ? mTail.load(std::memory_order_relaxed) : mRetirements.back().head;
+	if (head != lastRetiredHead)
+	{
+		mRetirements.push_back(Retirement{ fenceValue, head });
+	}
+}
+
+void RingAllocator::Reclaim(uint64_t completedFenceValue)
+{
+	std::lock_guard<std::mutex> lock(mRetireMutex);
+
+	uint64_t tail = mTail.load(std::memory_order_relaxed);
+	while (!mRetirements.empty() && mRetirements.front().fenceValue <= completedFenceValue)
+	{
+		tail = mRetirements.front().head;
+		mRetirements.pop_front();
+	}
+	mTail.store(tail, std::memory_order_release);
+}
+
+uint64_t RingAllocator::GetCapacity() const
+{
+	return mCapacity;
+}
+
+uint64_t RingAllocator::GetUsedSize() const
+{
+	return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+}
+
+uint64_t RingAllocator::GetRetryCount() const
+{
+	return mRetryCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// Suballocates aligned ranges from a fixed size ring.
+// Allocations are made lock-free from any number of threads. Space is
+// given back in bulk: Retire marks everything allocated so far as owned by
+// a fence value, and Reclaim frees it once that fence value has completed.
+//
+// Retire must only be called once every command list that references an
+// allocation made before the call has been submitted.
+class RingAllocator
+{
+public:
+	static const uint64_t InvalidOffset = ~0ull;
+
+	RingAllocator(uint64_t capacity);
+
+	// Returns the offset of the allocation in the ring, or InvalidOffset if
+	// there is not enough free space. alignment must be a power of two that
+	// divides the capacity.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	// Everything allocated before this call stays in use until fenceValue completes.
+	void Retire(uint64_t fenceValue);
+
+	// Free the space of every retirement with a fence value less than or equal
+	// to completedFenceValue.
+	void Reclaim(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const;
+	// The number of bytes allocated and not yet reclaimed, including padding.
+	uint64_t GetUsedSize() const;
+	// How often Allocate had to try again because another thread moved the
+	// head first. Shows how contended the ring is.
+	uint64_t GetRetryCount() const;
+
+private:
+	RingAllocator(const RingAllocator& copy) = delete;
+	RingAllocator& operator=(const RingAllocator& other) = delete;
+
+	const uint64_t mCapacity;
+
+	// Head and tail are absolute byte positions that only ever grow.
+	// The ring offset of a position is position % capacity.
+	std::atomic<uint64_t> mHead;
+	std::atomic<uint64_t> mTail;
+	std::atomic<uint64_t> mRetryCount;
+
+	struct Retirement
+	{
+		uint64_t fenceValue;
+		uint64_t head;
+	};
+
+	std::mutex mRetireMutex;
+	std::deque<Retirement> mRetirements;
+};
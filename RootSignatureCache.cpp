@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "RootSignatureCache.h"
+
+#include "D3D12Hash.h"
+#include "Hash.h"
+#include "PipelineStateCache.h"
+
+// Root signature 1.0 ranges and descriptors have no flags.
+static D3D12_DESCRIPTOR_RANGE_FLAGS GetRangeFlags(const D3D12_DESCRIPTOR_RANGE&) { return D3D12_DESCRIPTOR_RANGE_FLAG_NONE; }
+static D3D12_DESCRIPTOR_RANGE_FLAGS GetRangeFlags(const D3D12_DESCRIPTOR_RANGE1& range) { return range.Flags; }
+static D3D12_ROOT_DESCRIPTOR_FLAGS GetDescriptorFlags(const D3D12_ROOT_DESCRIPTOR&) { return D3D12_ROOT_DESCRIPTOR_FLAG_NONE; }
+static D3D12_ROOT_DESCRIPTOR_FLAGS GetDescriptorFlags(const D3D12_ROOT_DESCRIPTOR1& descriptor) { return descriptor.Flags; }
+
+// Root parameters hold a union with pointers, so they are hashed field by
+// field instead of as bytes.
+template<typename RootSignatureDesc>
+static uint64_t HashDesc(const RootSignatureDesc& desc, uint64_t hash)
+{
+	hash = HashCombine(hash, desc.NumParameters);
+	for (UINT i = 0; i < desc.NumParameters; ++i)
+	{
+		const auto& parameter = desc.pParameters[i];
+		hash = HashCombine(hash, parameter.ParameterType);
+		hash = HashCombine(hash, parameter.ShaderVisibility);
+
+		switch (parameter.ParameterType)
+		{
+		case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+			hash = HashCombine(hash, parameter.DescriptorTable.NumDescriptorRanges);
+			for (UINT j = 0; j < parameter.DescriptorTable.NumDescriptorRanges; ++j)
+			{
+				const auto& range = parameter.DescriptorTable.pDescriptorRanges[j];
+				hash = HashCombine(hash, range.RangeType);
+				hash = HashCombine(hash, range.NumDescriptors);
+				hash = HashCombine(hash, range.BaseShaderRegister);
+				hash = HashCombine(hash, range.RegisterSpace);
+				hash = HashCombine(hash, GetRangeFlags(range));
+				hash = HashCombine(hash, range.OffsetInDescriptorsFromTableStart);
+			}
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+			hash = HashCombine(hash, parameter.Constants.ShaderRegister);
+			hash = HashCombine(hash, parameter.Constants.RegisterSpace);
+			hash = HashCombine(hash, parameter.Constants.Num32BitValues);
+			break;
+		default:
+			hash = HashCombine(hash, parameter.Descriptor.ShaderRegister);
+			hash = HashCombine(hash, parameter.Descriptor.RegisterSpace);
+			hash = HashCombine(hash, GetDescriptorFlags(parameter.Descriptor));
+			break;
+		}
+	}
+
+	// A static sampler is 13 four-byte fields without padding, but its LOD
+	// bias and clamps are floats, and -0.0f must hash like 0.0f.
+	hash = HashCombine(hash, desc.NumStaticSamplers);
+	for (UINT i = 0; i < desc.NumStaticSamplers; ++i)
+	{
+		hash = HashStaticSamplerDesc(desc.pStaticSamplers[i], hash);
+	}
+
+	return HashCombine(hash, desc.Flags);
+}
+
+RootSignatureCache::RootSignatureCache(ComPtr<ID3D12Device2> device, const std::filesystem::path& path, uint64_t version)
+	: mDevice(device)
+	, mPath(path)
+	, mArchive(version)
+	, mDirty(false)
+	, mStats{}
+{
+	D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+	featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+	if (FAILED(mDevice->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+	{
+		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+	}
+	mHighestVersion = featureData.HighestVersion;
+
+	mArchive.Load(mPath);
+}
+
+RootSignatureCache::~RootSignatureCache()
+{
+	Save();
+}
+
+uint64_t RootSignatureCache::HashRootSignatureDesc(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+	uint64_t hash = HashCombine(HashOffsetBasis, desc.Version);
+	switch (desc.Version)
+	{
+	case D3D_ROOT_SIGNATURE_VERSION_1_0:
+		return HashDesc(desc.Desc_1_0, hash);
+	case D3D_ROOT_SIGNATURE_VERSION_1_1:
+		return HashDesc(desc.Desc_1_1, hash);
+	default:
+		throw std::exception();
+	}
+}
+
+ComPtr<ID3D12RootSignature> RootSignatureCache::GetRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+	// The serialized blob depends on the version it is serialized with too.
+	uint64_t key = HashCombine(HashRootSignatureDesc(desc), mHighestVersion);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto iter = mRootSignatures.find(key);
+		if (iter != mRootSignatures.end())
+		{
+			++mStats.MemoryHits;
+			return iter->second;
+		}
+	}
+
+	// Create without holding the lock. If two threads create the same root
+	// signature, the first one wins.
+	ComPtr<ID3D12RootSignature> rootSignature = CreateFromArchive(key);
+	if (!rootSignature)
+	{
+		rootSignature = CreateRootSignature(key, desc);
+	}
+	PipelineStateCache::SetRootSignatureHash(rootSignature.Get(), key);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRootSignatures.emplace(key, rootSignature).first->second;
+}
+
+ComPtr<ID3D12RootSignature> RootSignatureCache::CreateRootSignature(uint64_t key, const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+	ComPtr<ID3DBlob> rootSignatureBlob;
+	ComPtr<ID3DBlob> errorBlob;
+	HRESULT hr = D3DX12SerializeVersionedRootSignature(&desc, mHighestVersion, &rootSignatureBlob, &errorBlob);
+	if (FAILED(hr) && errorBlob)
+	{
+		OutputDebugStringA(static_cast<const char*>(errorBlob->GetBufferPointer()));
+	}
+	ThrowIfFailed(hr);
+
+	ComPtr<ID3D12RootSignature> rootSignature;
+	ThrowIfFailed(mDevice->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(),
+		rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mStats.Serializations;
+	mArchive.Add(key, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize());
+	mDirty = true;
+	return rootSignature;
+}
+
+ComPtr<ID3D12RootSignature> RootSignatureCache::CreateFromArchive(uint64_t key)
+{
+	std::vector<uint8_t> blob;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const std::vector<uint8_t>* entry = mArchive.Find(key);
+		if (!entry)
+		{
+			return nullptr;
+		}
+		blob = *entry;
+	}
+
+	ComPtr<ID3D12RootSignature> rootSignature;
+	HRESULT hr = mDevice->CreateRootSignature(0, blob.data(), blob.size(), IID_PPV_ARGS(&rootSignature));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (FAILED(hr))
+	{
+		// Serialize it again and replace the blob.
+		mArchive.Remove(key);
+		mDirty = true;
+		++mStats.DiskRejects;
+		return nullptr;
+	}
+
+	++mStats.DiskHits;
+	return rootSignature;
+}
+
+D3D_ROOT_SIGNATURE_VERSION RootSignatureCache::GetHighestVersion() const
+{
+	return mHighestVersion;
+}
+
+bool RootSignatureCache::Save()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!mDirty)
+	{
+		return true;
+	}
+
+	mDirty = !mArchive.Save(mPath);
+	return !mDirty;
+}
+
+RootSignatureCache::Stats RootSignatureCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+size_t RootSignatureCache::GetRootSignatureCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRootSignatures.size();
+}
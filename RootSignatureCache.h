@@ -0,0 +1,77 @@
+#pragma once
+
+#include "PipelineStateArchive.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+using Microsoft::WRL::ComPtr;
+
+// Creates root signatures from versioned root signature descriptions, keyed
+// by a stable hash of the description.
+// Identical descriptions share one root signature, so passes and materials
+// that agree on a layout don't cause root signature switches. Serialized
+// root signatures are persisted to disk in a PipelineStateArchive, so the
+// next run doesn't have to serialize them again.
+//
+// Every root signature created here has its key stored with
+// PipelineStateCache::SetRootSignatureHash, so PSOs that use it can be
+// cached on disk too.
+class RootSignatureCache
+{
+public:
+	// version identifies the GPU and driver. Archives written with a
+	// different version are ignored.
+	RootSignatureCache(ComPtr<ID3D12Device2> device, const std::filesystem::path& path, uint64_t version);
+	// Saves the archive if anything was added.
+	virtual ~RootSignatureCache();
+
+	// Return the root signature for the description, creating it if it isn't
+	// cached. 1.1 descriptions are converted to 1.0 if the device doesn't
+	// support root signature 1.1.
+	ComPtr<ID3D12RootSignature> GetRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+
+	// The root signature version descriptions are serialized with.
+	D3D_ROOT_SIGNATURE_VERSION GetHighestVersion() const;
+
+	// Write the serialized root signatures to disk.
+	bool Save();
+
+	// Hash the contents of a root signature description. Pointers are
+	// followed, so the hash is the same across runs for the same layout.
+	static uint64_t HashRootSignatureDesc(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+
+	struct Stats
+	{
+		uint64_t MemoryHits;		// Returned a root signature that was already created.
+		uint64_t DiskHits;			// Created a root signature from the archive.
+		uint64_t Serializations;	// Serialized a description from scratch.
+		uint64_t DiskRejects;		// Archived blobs the device refused.
+	};
+	Stats GetStats() const;
+
+	// The number of distinct root signatures created so far.
+	size_t GetRootSignatureCount() const;
+
+private:
+	RootSignatureCache(const RootSignatureCache& copy) = delete;
+	RootSignatureCache& operator=(const RootSignatureCache& other) = delete;
+
+	ComPtr<ID3D12RootSignature> CreateRootSignature(uint64_t key, const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+	ComPtr<ID3D12RootSignature> CreateFromArchive(uint64_t key);
+
+	ComPtr<ID3D12Device2> mDevice;
+	std::filesystem::path mPath;
+	D3D_ROOT_SIGNATURE_VERSION mHighestVersion;
+
+	mutable std::mutex mMutex;
+	PipelineStateArchive mArchive;
+	std::unordered_map<uint64_t, ComPtr<ID3D12RootSignature>> mRootSignatures;
+	bool mDirty;
+	Stats mStats;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+// A coroutine that starts running as soon as it is called.
+// The Task may be discarded (fire and forget), co_awaited from another
+// coroutine, or waited on from a regular thread with Wait().
+//
+// Task LoadMesh(CommandQueue& queue)
+// {
+//     auto commandList = queue.GetCommandList();
+//     ...
+//     co_await queue.ExecuteCommandList(commandList);
+//     // The upload is complete, the intermediate buffers can be released.
+// }
+class Task
+{
+private:
+	// Shared between the coroutine frame and the Task so either may go away first.
+	struct State
+	{
+		std::mutex				mutex;
+		std::condition_variable	condition;
+		bool					done = false;
+		std::exception_ptr		exception;
+		std::coroutine_handle<>	continuation;
+	};
+
+public:
+	struct promise_type
+	{
+		std::shared_ptr<State> state = std::make_shared<State>();
+
+		Task get_return_object() { return Task(state); }
+
+		std::suspend_never initial_suspend() noexcept { return {}; }
+
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				std::shared_ptr<State> state = handle.promise().state;
+				// The frame is no longer needed once the coroutine has finished.
+				handle.destroy();
+
+				std::coroutine_handle<> continuation;
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->done = true;
+					continuation = state->continuation;
+				}
+				state->condition.notify_all();
+
+				if (continuation)
+				{
+					continuation.resume();
+				}
+			}
+			void await_resume() const noexcept {}
+		};
+		FinalAwaiter final_suspend() noexcept { return {}; }
+
+		void return_void() {}
+		void unhandled_exception() { state->exception = std::current_exception(); }
+	};
+
+	// A Task that has already finished, e.g. to return when there is nothing to do.
+	Task()
+		: mState(std::make_shared<State>())
+	{
+		mState->done = true;
+	}
+
+	bool IsDone() const
+	{
+		std::lock_guard<std::mutex> lock(mState->mutex);
+		return mState->done;
+	}
+
+	// Block the calling thread until the coroutine has finished.
+	// Rethrows any exception that escaped the coroutine.
+	void Wait() const
+	{
+		std::unique_lock<std::mutex> lock(mState->mutex);
+		mState->condition.wait(lock, [this]() { return mState->done; });
+		if (mState->exception)
+		{
+			std::rethrow_exception(mState->exception);
+		}
+	}
+
+	// Awaiting a Task from another coroutine resumes it when the Task has finished.
+	struct Awaiter
+	{
+		std::shared_ptr<State> state;
+
+		bool await_ready() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->done;
+		}
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (state->done)
+			{
+				return false;
+			}
+			state->continuation = handle;
+			return true;
+		}
+		void await_resume() const
+		{
+			if (state->exception)
+			{
+				std::rethrow_exception(state->exception);
+			}
+		}
+	};
+	Awaiter operator co_await() const { return Awaiter{ mState }; }
+
+private:
+	explicit Task(std::shared_ptr<State> state)
+		: mState(std::move(state))
+	{}
+
+	std::shared_ptr<State> mState;
+};
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t numThreads)
+	: mStop(false)
+{
+	if (numThreads == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mThreads.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		mThreads.emplace_back(&ThreadPool::WorkerThread, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Enqueue(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mCondition.notify_one();
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+	return mThreads.size();
+}
+
+size_t ThreadPool::GetQueueDepth() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mJobs.size();
+}
+
+void ThreadPool::WorkerThread()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStop || !mJobs.empty(); });
+
+			// Finish the queued jobs before shutting down.
+			if (mJobs.empty())
+			{
+				return;
+			}
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		job();
+	}
+}
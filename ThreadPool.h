@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run queued jobs in FIFO order.
+class ThreadPool
+{
+public:
+	using Job = std::function<void()>;
+
+	// If numThreads is 0, one thread per hardware thread (minus the main thread) is created.
+	ThreadPool(size_t numThreads = 0);
+	virtual ~ThreadPool();
+
+	void Enqueue(Job job);
+
+	size_t GetThreadCount() const;
+	// The number of jobs waiting for a worker.
+	size_t GetQueueDepth() const;
+
+	// co_await pool.Schedule() continues the calling coroutine on a worker thread.
+	struct ScheduleAwaiter
+	{
+		ThreadPool* pool;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle) { pool->Enqueue([handle]() { handle.resume(); }); }
+		void await_resume() const noexcept {}
+	};
+	ScheduleAwaiter Schedule() { return ScheduleAwaiter{ this }; }
+
+private:
+	ThreadPool(const ThreadPool& copy) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	void WorkerThread();
+
+	mutable std::mutex		mMutex;
+	std::condition_variable	mCondition;
+	std::deque<Job>			mJobs;
+	bool					mStop;
+
+	std::vector<std::thread> mThreads;
+};
@@ -1,8 +1,23 @@
 #include "Tutorial2.h"
 #include "Application.h"
 #include "CommandQueue.h"
+#include "DescriptorAllocator.h"
+#include "FrameContext.h"
+#include "FrameStatistics.h"
+#include "PipelineStateCompiler.h"
+#include "PipelineStateStream.h"
+#include "Profiler.h"
+#include "QueueDependencyTracker.h"
+#include "RenderGraph.h"
+#include "RootSignatureCache.h"
+#include "ResourceHeapAllocator.h"
+#include "ResourceStateTracker.h"
+#include "UploadBuffer.h"
 #include "pch.h"
 
+#include <fstream>
+#include <sstream>
+
 #pragma comment(lib, "dxgi")
 #pragma comment(lib, "d3d12")
 #pragma comment(lib, "shlwapi")
@@ -32,6 +47,11 @@ static VertexPosColor gVertices[8] = {
 	{ XMFLOAT3(1.0f,  1.0f,  1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) }, // 6
 	{ XMFLOAT3(1.0f, -1.0f,  1.0f), XMFLOAT3(1.0f, 0.0f, 1.0f) }  // 7
 };
+// The vertex input layout. It is read while the pipeline compiles in the background.
+static const D3D12_INPUT_ELEMENT_DESC gInputLayout[] = {
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
 static WORD gIndicies[36] =
 {
 	0, 1, 2, 0, 2, 3,
@@ -47,61 +67,43 @@ Tutorial2::Tutorial2(const std::wstring& name, int width, int height, bool vSync
 	, mScissorRect(CD3DX12_RECT(0, 0, LONG_MAX, LONG_MAX))
 	, mViewport(CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)))
 	, mFoV(45.0)
+	, mPreviousAngle(0.0)
+	, mAngle(0.0)
+	, mFrameSnapshots(Application::Get().GetFramePipeline().GetDepth(), FrameSnapshot{})
 	, mContentLoaded(false)
 {
 }
 void Tutorial2::UpdateBufferResource(
 	ComPtr<ID3D12GraphicsCommandList2> commandList,
 	ID3D12Resource** pDestinationResource,
-	ID3D12Resource** pIntermediateResource,
 	size_t numElements, size_t elementSize, const void* bufferData,
 	D3D12_RESOURCE_FLAGS flags)
 {
-	auto device = Application::Get().GetDevice();
-
 	size_t bufferSize = numElements * elementSize;
-	// Create a committed resource for the GPU resource in a default heap.
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	// Place the GPU resource in one of the shared default heaps.
 	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize, flags);
-	ThrowIfFailed(device->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resourceDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		nullptr,
-		IID_PPV_ARGS(pDestinationResource)));
-	// Create a committed resource for the upload.
+	*pDestinationResource = Application::Get().GetResourceAllocator().CreateResource(
+		resourceDesc, D3D12_RESOURCE_STATE_COPY_DEST).Detach();
+	// Stage the data in the shared upload buffer.
 	if (bufferData)
 	{
-		heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
-		ThrowIfFailed(device->CreateCommittedResource(
-			&heapProp,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(pIntermediateResource)));
-		D3D12_SUBRESOURCE_DATA subresourceData = {};
-		subresourceData.pData = bufferData;
-		subresourceData.RowPitch = bufferSize;
-		subresourceData.SlicePitch = subresourceData.RowPitch;
-
-		UpdateSubresources(commandList.Get(),
-			*pDestinationResource, *pIntermediateResource,
-			0, 0, 1, &subresourceData);
+		auto upload = Application::Get().GetUploadBuffer().Allocate(bufferSize);
+		memcpy(upload.CPU, bufferData, bufferSize);
+
+		commandList->CopyBufferRegion(*pDestinationResource, 0,
+			upload.Resource, upload.Offset, bufferSize);
 	}
 }
 bool Tutorial2::LoadContent()
 {
-	auto device = Application::Get().GetDevice();
+	PROFILE_FUNCTION();
+
 	auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
 	auto commandList = commandQueue->GetCommandList();
 
 	// Upload vertex buffer data.
-	ComPtr<ID3D12Resource> intermediateVertexBuffer;
 	UpdateBufferResource(commandList.Get(),
-		&mVertexBuffer, &intermediateVertexBuffer,
+		&mVertexBuffer,
 		_countof(gVertices), sizeof(VertexPosColor), gVertices);
 
 	// Create the vertex buffer view.
@@ -110,9 +112,8 @@ bool Tutorial2::LoadContent()
 	mVertexBufferView.StrideInBytes = sizeof(VertexPosColor);
 
 	// Upload index buffer data.
-	ComPtr<ID3D12Resource> intermediateIndexBuffer;
 	UpdateBufferResource(commandList.Get(),
-		&mIndexBuffer, &intermediateIndexBuffer,
+		&mIndexBuffer,
 		_countof(gIndicies), sizeof(WORD), gIndicies);
 
 	// Create index buffer view.
@@ -120,12 +121,8 @@ bool Tutorial2::LoadContent()
 	mIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
 	mIndexBufferView.SizeInBytes = sizeof(gIndicies);
 
-	// Create the descriptor heap for the depth-stencil view.
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-	dsvHeapDesc.NumDescriptors = 1;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	ThrowIfFailed(device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&mDSVHeap)));
+	// Allocate the descriptor for the depth-stencil view.
+	mDSV = Application::Get().GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).Allocate();
 
 	// Load the vertex shader.
 	ComPtr<ID3DBlob> vertexShaderBlob;
@@ -135,20 +132,6 @@ bool Tutorial2::LoadContent()
 	ComPtr<ID3DBlob> pixelShaderBlob;
 	ThrowIfFailed(D3DReadFileToBlob(L"PixelShader.cso", &pixelShaderBlob));
 
-	// Create the vertex input layout
-	D3D12_INPUT_ELEMENT_DESC inputLayout[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	// Create a root signature.
-	D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
-	featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-	if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
-	{
-		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-	}
-
 	// Allow input layout and deny unnecessary access to certain pipeline stages.
 	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
@@ -157,49 +140,58 @@ bool Tutorial2::LoadContent()
 		D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
 		D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
 
-	// A single 32-bit constant root parameter that is used by the vertex shader.
+	// A constant buffer with the MVP matrix, used by the vertex shader. It is
+	// written to the frame's upload memory and not changed until the GPU has
+	// finished the frame.
 	CD3DX12_ROOT_PARAMETER1 rootParameters[1];
-	rootParameters[0].InitAsConstants(sizeof(XMMATRIX) / 4, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
 
 	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription;
 	rootSignatureDescription.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
 
-	// Serialize the root signature.
-	ComPtr<ID3DBlob> rootSignatureBlob;
-	ComPtr<ID3DBlob> errorBlob;
-	ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDescription,
-		featureData.HighestVersion, &rootSignatureBlob, &errorBlob));
-	// Create the root signature.
-	ThrowIfFailed(device->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(),
-		rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
+	// Root signatures with the same layout are shared, and their serialized
+	// blobs are cached on disk.
+	mRootSignature = Application::Get().GetRootSignatureCache().GetRootSignature(rootSignatureDescription);
+
+	mRenderGraph = std::make_unique<RenderGraph>(Application::Get().GetDevice());
+
+	mDynamicDescriptorHeap = std::make_unique<DynamicDescriptorHeap>(
+		Application::Get().GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+	mDynamicDescriptorHeap->ParseRootSignature(rootSignatureDescription.Desc_1_1);
 
-	struct PipelineStateStream
-	{
-		CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
-		CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
-		CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
-		CD3DX12_PIPELINE_STATE_STREAM_VS VS;
-		CD3DX12_PIPELINE_STATE_STREAM_PS PS;
-		CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
-		CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
-	} pipelineStateStream;
 	D3D12_RT_FORMAT_ARRAY rtvFormats = {};
 	rtvFormats.NumRenderTargets = 1;
 	rtvFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-	pipelineStateStream.pRootSignature = mRootSignature.Get();
-	pipelineStateStream.InputLayout = { inputLayout, _countof(inputLayout) };
-	pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShaderBlob.Get());
-	pipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlob.Get());
-	pipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-	pipelineStateStream.RTVFormats = rtvFormats;
-	D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
-	sizeof(PipelineStateStream), &pipelineStateStream
-	};
-	ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&mPipelineState)));
+
+	PipelineStateStream<
+		CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE,
+		CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT,
+		CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY,
+		CD3DX12_PIPELINE_STATE_STREAM_VS,
+		CD3DX12_PIPELINE_STATE_STREAM_PS,
+		CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT,
+		CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS> pipelineStateStream(
+			mRootSignature.Get(),
+			{ gInputLayout, _countof(gInputLayout) },
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+			CD3DX12_SHADER_BYTECODE(vertexShaderBlob.Get()),
+			CD3DX12_SHADER_BYTECODE(pixelShaderBlob.Get()),
+			DXGI_FORMAT_D32_FLOAT,
+			rtvFormats);
+	// The shaders and root signature are held until the pipeline is compiled.
+	mPipelineState = Application::Get().GetPipelineStateCompiler().Compile(pipelineStateStream,
+		{ vertexShaderBlob, pixelShaderBlob, mRootSignature });
 
 	auto fenceValue = commandQueue->ExecuteCommandList(commandList);
-	commandQueue->WaitForFenceValue(fenceValue);
+
+	// The direct queue waits for the uploads on the GPU the first time it
+	// reads the buffers, so there is no need to block here.
+	auto& dependencyTracker = Application::Get().GetDependencyTracker();
+	dependencyTracker.RecordAccess(mVertexBuffer.Get(), QueueDependencyTracker::Access::Write, fenceValue);
+	dependencyTracker.RecordAccess(mIndexBuffer.Get(), QueueDependencyTracker::Access::Write, fenceValue);
+
+	// The staged data stays in the upload buffer until the copy queue is done with it.
+	Application::Get().GetUploadBuffer().Retire(fenceValue);
 
 	mContentLoaded = true;
 
@@ -211,6 +203,34 @@ bool Tutorial2::LoadContent()
 
 void Tutorial2::UnloadContent()
 {
+	Application& app = Application::Get();
+	auto commandQueue = app.GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	app.GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).Free(std::move(mDSV), *commandQueue);
+
+	// The buffers and the depth buffer are suballocated from shared heaps, so
+	// their memory has to be given back explicitly. The direct queue is the
+	// last to use them; draws wait for the copies that wrote the buffers.
+	auto& resourceAllocator = app.GetResourceAllocator();
+	auto& dependencyTracker = app.GetDependencyTracker();
+	if (mVertexBuffer)
+	{
+		dependencyTracker.Forget(mVertexBuffer.Get());
+		resourceAllocator.ReleaseResource(mVertexBuffer, *commandQueue);
+		mVertexBuffer.Reset();
+	}
+	if (mIndexBuffer)
+	{
+		dependencyTracker.Forget(mIndexBuffer.Get());
+		resourceAllocator.ReleaseResource(mIndexBuffer, *commandQueue);
+		mIndexBuffer.Reset();
+	}
+	if (mDepthBuffer)
+	{
+		ResourceStateTracker::RemoveGlobalResourceState(mDepthBuffer.Get());
+		resourceAllocator.ReleaseResource(mDepthBuffer, *commandQueue);
+		mDepthBuffer.Reset();
+	}
+
 	mContentLoaded = false;
 }
 
@@ -218,8 +238,16 @@ void Tutorial2::ResizeDepthBuffer(int width, int height)
 {
 	if (mContentLoaded)
 	{
-		// Flush any GPU commands that might be referencing the depth buffer.
-		Application::Get().Flush();
+		// The GPU may still be using the old depth buffer, so its memory is
+		// only given back once the direct queue has finished the work
+		// submitted so far.
+		auto& resourceAllocator = Application::Get().GetResourceAllocator();
+		if (mDepthBuffer)
+		{
+			ResourceStateTracker::RemoveGlobalResourceState(mDepthBuffer.Get());
+			resourceAllocator.ReleaseResource(mDepthBuffer, *Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT));
+			mDepthBuffer.Reset();
+		}
 
 		width = std::max(1, width);
 		height = std::max(1, height);
@@ -232,16 +260,10 @@ void Tutorial2::ResizeDepthBuffer(int width, int height)
 		optimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
 		optimizedClearValue.DepthStencil = { 1.0f, 0 };
 
-		auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 		auto resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, width, height, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-		ThrowIfFailed(device->CreateCommittedResource(
-			&heapProp,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_DEPTH_WRITE,
-			&optimizedClearValue,
-			IID_PPV_ARGS(&mDepthBuffer)
-		));
+		mDepthBuffer = resourceAllocator.CreateResource(resourceDesc,
+			D3D12_RESOURCE_STATE_DEPTH_WRITE, &optimizedClearValue);
+		ResourceStateTracker::AddGlobalResourceState(mDepthBuffer.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
 		// Update the depth-stencil view.
 		D3D12_DEPTH_STENCIL_VIEW_DESC dsv = {};
@@ -251,7 +273,7 @@ void Tutorial2::ResizeDepthBuffer(int width, int height)
 		dsv.Flags = D3D12_DSV_FLAG_NONE;
 
 		device->CreateDepthStencilView(mDepthBuffer.Get(), &dsv,
-			mDSVHeap->GetCPUDescriptorHandleForHeapStart());
+			mDSV.GetDescriptorHandle());
 	}
 }
 
@@ -268,50 +290,42 @@ void Tutorial2::OnResize(ResizeEventArgs& e)
 	}
 }
 
-void Tutorial2::OnUpdate(UpdateEventArgs& e)
+void Tutorial2::OnFixedUpdate(UpdateEventArgs& e)
 {
-	static uint64_t frameCount = 0;
-	static double totalTime = 0.0;
+	super::OnFixedUpdate(e);
 
-	super::OnUpdate(e);
-
-	totalTime += e.ElapsedTime;
-	frameCount++;
-
-	if (totalTime > 1.0)
+	// Only depends on the number of ticks, not on the frame rate.
+	mPreviousAngle = mAngle;
+	mAngle += e.ElapsedTime * 90.0;
+	if (mAngle >= 360.0)
 	{
-		double fps = frameCount / totalTime;
+		// Keep the angles small without changing the blend between them.
+		mAngle -= 360.0;
+		mPreviousAngle -= 360.0;
+	}
+}
 
-		char buffer[512];
-		sprintf_s(buffer, "FPS: %f\n", fps);
-		OutputDebugStringA(buffer);
+void Tutorial2::OnUpdate(UpdateEventArgs& e)
+{
+	PROFILE_FUNCTION();
 
-		frameCount = 0;
-		totalTime = 0.0;
-	}
+	super::OnUpdate(e);
+
+	FrameSnapshot& snapshot = mFrameSnapshots[e.FrameSlot];
 
-	// Update the model matrix.
-	float angle = static_cast<float>(e.TotalTime * 90.0);
-	const XMVECTOR rotationAxis = XMVectorSet(0, 1, 1, 0);
-	mModelMatrix = XMMatrixRotationAxis(rotationAxis, XMConvertToRadians(angle));
+	snapshot.PreviousAngle = static_cast<float>(mPreviousAngle);
+	snapshot.Angle = static_cast<float>(mAngle);
+	snapshot.Alpha = static_cast<float>(e.Alpha);
 
 	// Update the view matrix.
 	const XMVECTOR eyePosition = XMVectorSet(0, 0, -10, 1);
 	const XMVECTOR focusPoint = XMVectorSet(0, 0, 0, 1);
 	const XMVECTOR upDirection = XMVectorSet(0, 1, 0, 0);
-	mViewMatrix = XMMatrixLookAtLH(eyePosition, focusPoint, upDirection);
+	snapshot.ViewMatrix = XMMatrixLookAtLH(eyePosition, focusPoint, upDirection);
 
 	// Update the projection matrix.
 	float aspectRatio = mWindow->GetClientWidth() / static_cast<float>(mWindow->GetClientHeight());
-	mProjectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(mFoV), aspectRatio, 0.1f, 100.0f);
-}
-
-// Transition a resource
-void Tutorial2::TransitionResource(ComPtr<ID3D12GraphicsCommandList2> commandList, ComPtr<ID3D12Resource> resource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
-{
-	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), beforeState, afterState);
-
-	commandList->ResourceBarrier(1, &barrier);
+	snapshot.ProjectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(mFoV), aspectRatio, 0.1f, 100.0f);
 }
 
 // Clear a render target.
@@ -327,56 +341,129 @@ void Tutorial2::ClearDepth(ComPtr<ID3D12GraphicsCommandList2> commandList, D3D12
 
 void Tutorial2::OnRender(RenderEventArgs& e)
 {
-	super::OnRender(e);
+	PROFILE_FUNCTION();
 
-	auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
-	auto commandList = commandQueue->GetCommandList();
+	static double totalTime = 0.0;
 
-	UINT currentBackBufferIndex = mWindow->GetCurrentBackBufferIndex();
-	auto backBuffer = mWindow->GetCurrentBackBuffer();
-	auto rtv = mWindow->GetCurrentRenderTargetView();
-	auto dsv = mDSVHeap->GetCPUDescriptorHandleForHeapStart();
+	super::OnRender(e);
+
+	auto& frameContextManager = Application::Get().GetFrameContextManager();
 
-	// Clear the render targets.
+	totalTime += e.ElapsedTime;
+	if (totalTime > 1.0)
 	{
-		TransitionResource(commandList, backBuffer,
-			D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		FrameStatistics::Report report = frameContextManager.GetStatistics().GetReport();
 
-		FLOAT clearColor[] = { 0.4f, 0.6f, 0.9f, 1.0f };
+		char buffer[512];
+		sprintf_s(buffer, "CPU ms p50 %.2f p95 %.2f p99 %.2f max %.2f, GPU ms p50 %.2f p95 %.2f p99 %.2f max %.2f, "
+			"%zu hitches in %u frames, state calls per frame: %u issued, %u elided\n",
+			report.CPU.P50, report.CPU.P95, report.CPU.P99, report.CPU.Max,
+			report.GPU.P50, report.GPU.P95, report.GPU.P99, report.GPU.Max,
+			report.Hitches.size(), report.NumFrames, mCommandListStats.Issued, mCommandListStats.Elided);
+		OutputDebugStringA(buffer);
 
-		ClearRTV(commandList, rtv, clearColor);
-		ClearDepth(commandList, dsv);
+		// Where the last frame went.
+		std::ostringstream profile;
+		Profiler::WriteReport(profile, Profiler::GetLastFrame());
+		OutputDebugStringA(profile.str().c_str());
+
+		totalTime = 0.0;
 	}
 
-	commandList->SetPipelineState(mPipelineState.Get());
-	commandList->SetGraphicsRootSignature(mRootSignature.Get());
+	const FrameSnapshot& snapshot = mFrameSnapshots[e.FrameSlot];
+
+	// Waits until the GPU is no more than the frame count behind.
+	FrameContext& frameContext = frameContextManager.BeginFrame();
 
-	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	commandList->IASetVertexBuffers(0, 1, &mVertexBufferView);
-	commandList->IASetIndexBuffer(&mIndexBufferView);
+	auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	auto commandList = commandQueue->GetCommandList();
+	frameContext.BeginGPUTimer(commandList.Get());
 
-	commandList->RSSetViewports(1, &mViewport);
-	commandList->RSSetScissorRects(1, &mScissorRect);
+	auto backBuffer = mWindow->GetCurrentBackBuffer();
+	auto rtv = mWindow->GetCurrentRenderTargetView();
+	auto dsv = mDSV.GetDescriptorHandle();
+
+	{
+		PROFILE_SCOPE("BuildRenderGraph");
+		mRenderGraph->Reset();
+		uint32_t backBufferResource = mRenderGraph->ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		uint32_t depthBufferResource = mRenderGraph->ImportResource("DepthBuffer", mDepthBuffer.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
-	commandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+		mRenderGraph->AddPass("Scene", [&](RenderGraph&, ID3D12GraphicsCommandList2* graphicsCommandList)
+		{
+			// Clear the render targets.
+			FLOAT clearColor[] = { 0.4f, 0.6f, 0.9f, 1.0f };
+
+			ClearRTV(graphicsCommandList, rtv, clearColor);
+			ClearDepth(graphicsCommandList, dsv);
+
+			// The pipeline compiles in the background. Skip the cube until it is ready.
+			ID3D12PipelineState* pipelineState = mPipelineState ? mPipelineState->Get() : nullptr;
+			if (!pipelineState)
+			{
+				return;
+			}
+
+			mGraphicsCommandList.Reset(graphicsCommandList);
+
+			mGraphicsCommandList.SetPipelineState(pipelineState);
+			mGraphicsCommandList.SetGraphicsRootSignature(mRootSignature.Get());
+
+			// Descriptor tables are copied into the frame's descriptors, which
+			// are freed with the frame.
+			ID3D12DescriptorHeap* descriptorHeaps[] = { frameContext.GetDescriptorHeap() };
+			mGraphicsCommandList.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+			mDynamicDescriptorHeap->Reset(frameContext);
+
+			mGraphicsCommandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			mGraphicsCommandList.IASetVertexBuffers(0, 1, &mVertexBufferView);
+			mGraphicsCommandList.IASetIndexBuffer(&mIndexBufferView);
+
+			mGraphicsCommandList.RSSetViewports(1, &mViewport);
+			mGraphicsCommandList.RSSetScissorRects(1, &mScissorRect);
+
+			mGraphicsCommandList.OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+
+			// Update the MVP matrix
+			float angle = snapshot.PreviousAngle + (snapshot.Angle - snapshot.PreviousAngle) * snapshot.Alpha;
+			const XMVECTOR rotationAxis = XMVectorSet(0, 1, 1, 0);
+			XMMATRIX modelMatrix = XMMatrixRotationAxis(rotationAxis, XMConvertToRadians(angle));
+			XMMATRIX mvpMatrix = XMMatrixMultiply(modelMatrix, snapshot.ViewMatrix);
+			mvpMatrix = XMMatrixMultiply(mvpMatrix, snapshot.ProjectionMatrix);
+			UploadBuffer::Allocation constantBuffer = frameContext.AllocateUpload(sizeof(XMMATRIX));
+			memcpy(constantBuffer.CPU, &mvpMatrix, sizeof(XMMATRIX));
+			mGraphicsCommandList.SetGraphicsRootConstantBufferView(0, constantBuffer.GPU);
+
+			mDynamicDescriptorHeap->CommitStagedDescriptorsForDraw(mGraphicsCommandList);
+			mGraphicsCommandList.DrawIndexedInstanced(_countof(gIndicies), 1, 0, 0, 0);
+
+			mCommandListStats = mGraphicsCommandList.GetStats();
+		})
+		.Write(backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET)
+		.Write(depthBufferResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	}
 
-	// Update the MVP matrix
-	XMMATRIX mvpMatrix = XMMatrixMultiply(mModelMatrix, mViewMatrix);
-	mvpMatrix = XMMatrixMultiply(mvpMatrix, mProjectionMatrix);
-	commandList->SetGraphicsRoot32BitConstants(0, sizeof(XMMATRIX) / 4, &mvpMatrix, 0);
+	// The graph may submit part of the frame before it returns.
+	auto& dependencyTracker = Application::Get().GetDependencyTracker();
+	dependencyTracker.WaitForAccess(*commandQueue, mVertexBuffer.Get(), QueueDependencyTracker::Access::Read);
+	dependencyTracker.WaitForAccess(*commandQueue, mIndexBuffer.Get(), QueueDependencyTracker::Access::Read);
 
-	commandList->DrawIndexedInstanced(_countof(gIndicies), 1, 0, 0, 0);
+	// Leaves the back buffer ready to present.
+	{
+		PROFILE_SCOPE("ExecuteRenderGraph");
+		mRenderGraph->Compile();
+		commandList = mRenderGraph->Execute(*commandQueue, commandList, mResourceStateTracker,
+			*Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE));
+	}
 
 	// Present
 	{
-		TransitionResource(commandList, backBuffer,
-			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-
-		mFenceValues[currentBackBufferIndex] = commandQueue->ExecuteCommandList(commandList);
+		PROFILE_SCOPE("Present");
+		frameContext.EndGPUTimer(commandList.Get());
+		uint64_t fenceValue = commandQueue->ExecuteCommandList(commandList, mResourceStateTracker);
+		frameContextManager.EndFrame(fenceValue);
 
-		currentBackBufferIndex = mWindow->Present();
-
-		commandQueue->WaitForFenceValue(mFenceValues[currentBackBufferIndex]);
+		mWindow->Present();
 	}
 }
 
@@ -399,6 +486,18 @@ void Tutorial2::OnKeyPressed(KeyEventArgs& e)
 	case KeyCode::V:
 		mWindow->ToggleVSync();
 		break;
+	case KeyCode::P:
+	{
+		// Dump the frame times next to the executable.
+		const FrameStatistics& statistics = Application::Get().GetFrameContextManager().GetStatistics();
+		std::vector<FrameStatistics::FrameTime> frames = statistics.GetFrames();
+
+		std::ofstream csv("FrameStatistics.csv");
+		FrameStatistics::WriteCSV(csv, frames);
+		std::ofstream json("FrameStatistics.json");
+		FrameStatistics::WriteJSON(json, FrameStatistics::ComputeReport(frames));
+		break;
+	}
 	}
 }
 
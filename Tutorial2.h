@@ -1,10 +1,19 @@
 #pragma once
 
+#include "DescriptorAllocator.h"
+#include "DynamicDescriptorHeap.h"
 #include "Game.h"
+#include "GraphicsCommandList.h"
+#include "PipelineStateCompiler.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
 #include "Window.h"
 
 #include <DirectXMath.h>
 
+#include <memory>
+#include <vector>
+
 class Tutorial2 : public Game
 {
 public:
@@ -15,6 +24,7 @@ public:
 	virtual void UnloadContent() override;
 
 protected:
+	virtual void OnFixedUpdate(UpdateEventArgs& e) override;
 	virtual void OnUpdate(UpdateEventArgs& e) override;
 	virtual void OnRender(RenderEventArgs& e) override;
 
@@ -25,10 +35,6 @@ protected:
 	virtual void OnResize(ResizeEventArgs& e) override;
 
 private:
-	void TransitionResource(ComPtr<ID3D12GraphicsCommandList2> commandList,
-		ComPtr<ID3D12Resource> resource,
-		D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
-
 	void ClearRTV(ComPtr<ID3D12GraphicsCommandList2> commandList,
 		D3D12_CPU_DESCRIPTOR_HANDLE rtv, FLOAT* clearColor);
 
@@ -36,14 +42,12 @@ private:
 		D3D12_CPU_DESCRIPTOR_HANDLE dsv, FLOAT depth = 1.0f);
 
 	void UpdateBufferResource(ComPtr<ID3D12GraphicsCommandList2> commandList,
-		ID3D12Resource** pDestinationResource, ID3D12Resource** pIntermediateResource,
+		ID3D12Resource** pDestinationResource,
 		size_t numElements, size_t elementSize, const void* bufferData,
 		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
 
 	void ResizeDepthBuffer(int width, int height);
 
-	uint64_t mFenceValues[Window::BufferCount] = {};
-
 	// Vertex buffer for the cube.
 	ComPtr<ID3D12Resource> mVertexBuffer;
 	D3D12_VERTEX_BUFFER_VIEW mVertexBufferView{};
@@ -53,23 +57,46 @@ private:
 
 	// Depth buffer.
 	ComPtr<ID3D12Resource> mDepthBuffer;
-	// Descriptor heap for depth buffer.
-	ComPtr<ID3D12DescriptorHeap> mDSVHeap;
+	// Depth-stencil view for the depth buffer.
+	DescriptorAllocation mDSV;
 
 	// Root signature
 	ComPtr<ID3D12RootSignature> mRootSignature;
+	// Descriptor tables of the root signature, copied to the GPU per draw.
+	std::unique_ptr<DynamicDescriptorHeap> mDynamicDescriptorHeap;
 
 	// Pipeline state object.
-	ComPtr<ID3D12PipelineState> mPipelineState;
+	std::shared_ptr<AsyncPipelineState> mPipelineState;
+
+	// The passes of a frame, built again every frame.
+	std::unique_ptr<RenderGraph> mRenderGraph;
+	// Resource states of the frame being recorded.
+	ResourceStateTracker mResourceStateTracker;
+	// Drops redundant state changes while recording a frame.
+	GraphicsCommandList mGraphicsCommandList;
+	// Counters of the last frame that was recorded.
+	GraphicsCommandList::Stats mCommandListStats{};
 
 	D3D12_VIEWPORT mViewport;
 	D3D12_RECT mScissorRect;
 
 	float mFoV;
 
-	DirectX::XMMATRIX mModelMatrix{};
-	DirectX::XMMATRIX mViewMatrix{};
-	DirectX::XMMATRIX mProjectionMatrix{};
+	// The rotation of the cube in degrees, after the last two fixed updates.
+	double mPreviousAngle;
+	double mAngle;
+
+	// What OnRender needs from OnUpdate, one for each slot of the frame
+	// pipeline. The cube is rotated by the blend of the last two angles.
+	struct FrameSnapshot
+	{
+		float PreviousAngle;
+		float Angle;
+		float Alpha;
+		DirectX::XMMATRIX ViewMatrix;
+		DirectX::XMMATRIX ProjectionMatrix;
+	};
+	std::vector<FrameSnapshot> mFrameSnapshots;
 
 	bool mContentLoaded;
 };
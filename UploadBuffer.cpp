@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "UploadBuffer.h"
+
+UploadBuffer::UploadBuffer(ComPtr<ID3D12Device2> device, ComPtr<ID3D12Fence> fence, uint64_t capacity)
+	: mDevice(device)
+	, mFence(fence)
+	, mRing(capacity)
+	, mFallbackCount(0)
+{
+	mResource = CreateUploadResource(capacity);
+
+	// Upload heaps can stay mapped for their whole lifetime.
+	CD3DX12_RANGE readRange(0, 0);
+	void* cpuBase = nullptr;
+	ThrowIfFailed(mResource->Map(0, &readRange, &cpuBase));
+	mCPUBase = static_cast<uint8_t*>(cpuBase);
+	mGPUBase = mResource->GetGPUVirtualAddress();
+}
+
+UploadBuffer::~UploadBuffer()
+{
+	mResource->Unmap(0, nullptr);
+}
+
+ComPtr<ID3D12Resource> UploadBuffer::CreateUploadResource(uint64_t size)
+{
+	ComPtr<ID3D12Resource> resource;
+
+	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&heapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&resource)));
+
+	return resource;
+}
+
+UploadBuffer::Allocation UploadBuffer::Allocate(uint64_t size, uint64_t alignment)
+{
+	uint64_t offset = mRing.Allocate(size, alignment);
+	if (offset == RingAllocator::InvalidOffset)
+	{
+		// Give back whatever the GPU has finished with and try again.
+		Reclaim();
+		offset = mRing.Allocate(size, alignment);
+	}
+
+	if (offset != RingAllocator::InvalidOffset)
+	{
+		return Allocation{ mCPUBase + offset, mGPUBase + offset, mResource.Get(), offset };
+	}
+
+	// The ring is full (or the request is larger than the ring).
+	ComPtr<ID3D12Resource> resource = CreateUploadResource(size);
+
+	CD3DX12_RANGE readRange(0, 0);
+	void* cpu = nullptr;
+	ThrowIfFailed(resource->Map(0, &readRange, &cpu));
+
+	Allocation allocation{ cpu, resource->GetGPUVirtualAddress(), resource.Get(), 0 };
+
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	mFallbackResources.push_back(FallbackResource{ 0, resource });
+	++mFallbackCount;
+
+	return allocation;
+}
+
+void UploadBuffer::Retire(uint64_t fenceValue)
+{
+	mRing.Retire(fenceValue);
+
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	for (auto& fallback : mFallbackResources)
+	{
+		if (fallback.fenceValue == 0)
+		{
+			fallback.fenceValue = fenceValue;
+		}
+	}
+}
+
+void UploadBuffer::Reclaim()
+{
+	uint64_t completedValue = mFence->GetCompletedValue();
+	mRing.Reclaim(completedValue);
+
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	mFallbackResources.erase(std::remove_if(mFallbackResources.begin(), mFallbackResources.end(),
+		[completedValue](const FallbackResource& fallback)
+		{
+			return fallback.fenceValue != 0 && fallback.fenceValue <= completedValue;
+		}), mFallbackResources.end());
+}
+
+uint64_t UploadBuffer::GetCapacity() const
+{
+	return mRing.GetCapacity();
+}
+
+uint64_t UploadBuffer::GetUsedSize() const
+{
+	return mRing.GetUsedSize();
+}
+
+uint64_t UploadBuffer::GetFallbackCount() const
+{
+	std::lock_guard<std::mutex> lock(mFallbackMutex);
+	return mFallbackCount;
+}
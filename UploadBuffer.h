@@ -0,0 +1,76 @@
+#pragma once
+
+#include "RingAllocator.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// A persistently mapped upload heap that hands out aligned, CPU writable
+// ranges for copying data to the GPU.
+// Ranges are retired against the fence of the queue that consumes them.
+// Requests that do not fit in the ring fall back to a dedicated upload
+// resource, which is retired the same way.
+class UploadBuffer
+{
+public:
+	struct Allocation
+	{
+		void* CPU;
+		D3D12_GPU_VIRTUAL_ADDRESS GPU;
+		// The upload resource and the offset of the allocation within it,
+		// for use with CopyBufferRegion/CopyTextureRegion.
+		ID3D12Resource* Resource;
+		uint64_t Offset;
+	};
+
+	// fence is the fence of the queue that executes the copies.
+	UploadBuffer(ComPtr<ID3D12Device2> device, ComPtr<ID3D12Fence> fence, uint64_t capacity = 64 * 1024 * 1024);
+	virtual ~UploadBuffer();
+
+	// Allocate size bytes. Thread-safe, and lock-free unless the ring is full.
+	Allocation Allocate(uint64_t size, uint64_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	// Everything allocated so far stays alive until the fence reaches fenceValue.
+	// Call this after the command lists that use the allocations are submitted.
+	void Retire(uint64_t fenceValue);
+
+	// Free everything retired with a fence value the GPU has passed.
+	void Reclaim();
+
+	uint64_t GetCapacity() const;
+	uint64_t GetUsedSize() const;
+	// The number of dedicated upload resources created because the ring was full.
+	uint64_t GetFallbackCount() const;
+
+private:
+	UploadBuffer(const UploadBuffer& copy) = delete;
+	UploadBuffer& operator=(const UploadBuffer& other) = delete;
+
+	ComPtr<ID3D12Resource> CreateUploadResource(uint64_t size);
+
+	ComPtr<ID3D12Device2>	mDevice;
+	ComPtr<ID3D12Fence>		mFence;
+
+	ComPtr<ID3D12Resource>	mResource;
+	uint8_t*				mCPUBase;
+	D3D12_GPU_VIRTUAL_ADDRESS mGPUBase;
+
+	RingAllocator			mRing;
+
+	struct FallbackResource
+	{
+		uint64_t fenceValue;
+		ComPtr<ID3D12Resource> resource;
+	};
+
+	// Fallback resources that have not been retired yet have a fence value of 0.
+	mutable std::mutex		mFallbackMutex;
+	std::vector<FallbackResource> mFallbackResources;
+	uint64_t				mFallbackCount;
+};
@@ -3,23 +3,30 @@
 #include "CommandQueue.h"
 #include "Window.h"
 #include "Game.h"
+#include "Profiler.h"
+#include "ResourceStateTracker.h"
 
-Window::Window(HWND hWnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync)
+Window::Window(HWND hWnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync, UINT bufferCount)
 	: mHwnd(hWnd)
 	, mWindowName(windowName)
 	, mClientWidth(clientWidth)
 	, mClientHeight(clientHeight)
 	, mVSync(vSync)
 	, mFullscreen(false)
+	, mOccluded(false)
+	, mResizePending(false)
+	, mPendingResize(clientWidth, clientHeight)
+	, mRenderingStopped(false)
 	, mFrameCounter(0)
+	, mBufferCount(bufferCount)
+	, mBackBuffers(bufferCount)
 {
 	Application& app = Application::Get();
 
 	mIsTearingSupported = app.IsTearingSupported();
 
 	mSwapChain = CreateSwapChain();
-	mRTVDescriptorHeap = app.CreateDescriptorHeap(BufferCount, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	mRTVDescriptorSize = app.GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	mRenderTargetViews = app.GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV).Allocate(mBufferCount);
 
 	UpdateRenderTargetViews();
 }
@@ -63,6 +70,13 @@ void Window::Destroy()
 	}
 	if (mHwnd)
 	{
+		Application& app = Application::Get();
+		app.GetDescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV).Free(std::move(mRenderTargetViews), *app.GetCommandQueue());
+		for (UINT i = 0; i < mBufferCount; ++i)
+		{
+			ResourceStateTracker::RemoveGlobalResourceState(mBackBuffers[i].Get());
+		}
+
 		DestroyWindow(mHwnd);
 		mHwnd = nullptr;
 	}
@@ -90,7 +104,7 @@ void Window::SetVSync(bool vSync)
 
 void Window::ToggleVSync()
 {
-	SetVSync(!mVSync);
+	SetVSync(!mVSync.load());
 }
 
 bool Window::IsFullScreen() const
@@ -98,6 +112,21 @@ bool Window::IsFullScreen() const
 	return mFullscreen;
 }
 
+FixedTimestep& Window::GetFixedTimestep()
+{
+	return mFixedTimestep;
+}
+
+bool Window::IsMinimized() const
+{
+	return ::IsIconic(mHwnd) != FALSE;
+}
+
+bool Window::IsOccluded() const
+{
+	return mOccluded;
+}
+
 // Set the fullscreen state of the window.
 void Window::SetFullscreen(bool fullscreen)
 {
@@ -157,30 +186,67 @@ void Window::RegisterCallbacks(std::shared_ptr<Game> pGame)
 	return;
 }
 
-void Window::OnUpdate(UpdateEventArgs&)
+void Window::OnUpdate(UpdateEventArgs& e)
 {
+	PROFILE_FUNCTION();
+
 	mUpdateClock.Tick();
 
 	if (auto pGame = mpGame.lock())
 	{
 		mFrameCounter++;
 
-		UpdateEventArgs updateEventArgs(mUpdateClock.GetDeltaSeconds(), mUpdateClock.GetTotalSeconds());
+		mFixedTimestep.Advance(FixedTimestep::Duration(static_cast<int64_t>(mUpdateClock.GetDeltaNanoseconds())));
+		while (mFixedTimestep.Step())
+		{
+			PROFILE_SCOPE("FixedUpdate");
+			UpdateEventArgs fixedUpdateEventArgs(mFixedTimestep.GetTickSeconds(), mFixedTimestep.GetTotalSeconds(), e.FrameSlot);
+			pGame->OnFixedUpdate(fixedUpdateEventArgs);
+		}
+
+		UpdateEventArgs updateEventArgs(mUpdateClock.GetDeltaSeconds(), mUpdateClock.GetTotalSeconds(), e.FrameSlot,
+			mFixedTimestep.GetAlpha());
 		pGame->OnUpdate(updateEventArgs);
 	}
 }
 
-void Window::OnRender(RenderEventArgs&)
+void Window::OnRender(RenderEventArgs& e)
 {
+	PROFILE_FUNCTION();
+
+	std::lock_guard<std::mutex> lock(mRenderMutex);
+	if (mRenderingStopped)
+	{
+		return;
+	}
+
+	ApplyPendingResize();
+
+	if (mOccluded)
+	{
+		// Don't draw until the window can be seen again.
+		mOccluded = mSwapChain->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED;
+		if (mOccluded)
+		{
+			return;
+		}
+	}
+
 	mRenderClock.Tick();
 
 	if (auto pGame = mpGame.lock())
 	{
-		RenderEventArgs renderEventArgs(mRenderClock.GetDeltaSeconds(), mRenderClock.GetTotalSeconds());
+		RenderEventArgs renderEventArgs(mRenderClock.GetDeltaSeconds(), mRenderClock.GetTotalSeconds(), e.FrameSlot);
 		pGame->OnRender(renderEventArgs);
 	}
 }
 
+void Window::StopRendering()
+{
+	std::lock_guard<std::mutex> lock(mRenderMutex);
+	mRenderingStopped = true;
+}
+
 void Window::OnKeyPressed(KeyEventArgs& e)
 {
 	if (auto pGame = mpGame.lock())
@@ -235,22 +301,48 @@ void Window::OnMouseWheel(MouseWheelEventArgs& e)
 
 void Window::OnResize(ResizeEventArgs& e)
 {
+	// The swap chain belongs to the render thread, which may be drawing right
+	// now. Only the last size matters once it gets to it.
+	std::lock_guard<std::mutex> lock(mResizeMutex);
+	mPendingResize = e;
+	mResizePending = true;
+}
+
+void Window::ApplyPendingResize()
+{
+	ResizeEventArgs e(0, 0);
+	{
+		std::lock_guard<std::mutex> lock(mResizeMutex);
+		if (!mResizePending)
+		{
+			return;
+		}
+		e = mPendingResize;
+		mResizePending = false;
+	}
+
 	// Update the client size.
 	if (mClientWidth != e.Width || mClientHeight != e.Height)
 	{
+		PROFILE_SCOPE("ResizeSwapChain");
+
 		mClientWidth = std::max(1, e.Width);
 		mClientHeight = std::max(1, e.Height);
 
-		Application::Get().Flush();
+		// The swap chain buffers can only be resized once every reference to
+		// them is gone, including the ones held by in-flight work. Only the
+		// direct queue renders to and presents them, so only it needs to drain.
+		Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->Flush();
 
-		for (int i = 0; i < BufferCount; ++i)
+		for (UINT i = 0; i < mBufferCount; ++i)
 		{
+			ResourceStateTracker::RemoveGlobalResourceState(mBackBuffers[i].Get());
 			mBackBuffers[i].Reset();
 		}
 
 		DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
 		ThrowIfFailed(mSwapChain->GetDesc(&swapChainDesc));
-		ThrowIfFailed(mSwapChain->ResizeBuffers(BufferCount, mClientWidth,
+		ThrowIfFailed(mSwapChain->ResizeBuffers(mBufferCount, mClientWidth,
 			mClientHeight, swapChainDesc.BufferDesc.Format, swapChainDesc.Flags));
 
 		mCurrentBackBufferIndex = mSwapChain->GetCurrentBackBufferIndex();
@@ -284,7 +376,7 @@ ComPtr<IDXGISwapChain4> Window::CreateSwapChain()
 	swapChainDesc.Stereo = FALSE;
 	swapChainDesc.SampleDesc = { 1, 0 };
 	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapChainDesc.BufferCount = BufferCount;
+	swapChainDesc.BufferCount = mBufferCount;
 	swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
 	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
 	swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
@@ -317,25 +409,21 @@ void Window::UpdateRenderTargetViews()
 {
 	auto device = Application::Get().GetDevice();
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	for (int i = 0; i < BufferCount; ++i)
+	for (UINT i = 0; i < mBufferCount; ++i)
 	{
 		ComPtr<ID3D12Resource> backBuffer;
 		ThrowIfFailed(mSwapChain->GetBuffer(i, IID_PPV_ARGS(&backBuffer)));
 
-		device->CreateRenderTargetView(backBuffer.Get(), nullptr, rtvHandle);
+		device->CreateRenderTargetView(backBuffer.Get(), nullptr, mRenderTargetViews.GetDescriptorHandle(i));
+		ResourceStateTracker::AddGlobalResourceState(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
 
 		mBackBuffers[i] = backBuffer;
-
-		rtvHandle.Offset(mRTVDescriptorSize);
 	}
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE Window::GetCurrentRenderTargetView() const
 {
-	return CD3DX12_CPU_DESCRIPTOR_HANDLE(mRTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-		mCurrentBackBufferIndex, mRTVDescriptorSize);
+	return mRenderTargetViews.GetDescriptorHandle(mCurrentBackBufferIndex);
 }
 
 ComPtr<ID3D12Resource> Window::GetCurrentBackBuffer() const
@@ -343,6 +431,11 @@ ComPtr<ID3D12Resource> Window::GetCurrentBackBuffer() const
 	return mBackBuffers[mCurrentBackBufferIndex];
 }
 
+UINT Window::GetBufferCount() const
+{
+	return mBufferCount;
+}
+
 UINT Window::GetCurrentBackBufferIndex() const
 {
 	return mCurrentBackBufferIndex;
@@ -352,7 +445,9 @@ UINT Window::Present()
 {
 	UINT syncInterval = mVSync ? 1 : 0;
 	UINT presentFlags = mIsTearingSupported && !mVSync ? DXGI_PRESENT_ALLOW_TEARING : 0;
-	ThrowIfFailed(mSwapChain->Present(syncInterval, presentFlags));
+	HRESULT hr = mSwapChain->Present(syncInterval, presentFlags);
+	ThrowIfFailed(hr);
+	mOccluded = hr == DXGI_STATUS_OCCLUDED;
 	mCurrentBackBufferIndex = mSwapChain->GetCurrentBackBufferIndex();
 
 	return mCurrentBackBufferIndex;
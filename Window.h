@@ -6,21 +6,27 @@
 #include <wrl.h>
 #include <d3d12.h>
 #include <dxgi1_6.h>
+#include <atomic>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
 
+#include "DescriptorAllocator.h"
 #include "Events.h"
+#include "FixedTimestep.h"
 #include "HighResolutionClock.h"
 
 using Microsoft::WRL::ComPtr;
 
 class Game;
 
+// Window messages and updates are handled on the thread that created the
+// window, rendering on the render thread of the Application. Resizes are
+// applied by the render thread before it draws the next frame.
 class Window
 {
 public:
-	static const UINT BufferCount = 3;
-
 	HWND GetWindowHandle() const;
 
 	void Destroy();
@@ -36,12 +42,21 @@ public:
 
 	bool IsFullScreen() const;
 
+	// Paces the simulation of the game. Only use it on the message thread.
+	FixedTimestep& GetFixedTimestep();
+
+	bool IsMinimized() const;
+	// Whether the last present found the window hidden. Once it is, the
+	// render thread only checks again, without drawing, for every frame.
+	bool IsOccluded() const;
+
 	void SetFullscreen(bool fullscreen);
 	void ToggleFullscreen();
 
 	void Show();
 	void Hide();
 
+	UINT GetBufferCount() const;
 	UINT GetCurrentBackBufferIndex() const;
 
 	UINT Present();
@@ -57,7 +72,7 @@ protected:
 	friend class Game;
 
 	Window() = delete;
-	Window(HWND hwnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync);
+	Window(HWND hwnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync, UINT bufferCount);
 	virtual ~Window();
 
 	void RegisterCallbacks(std::shared_ptr<Game> pGame);
@@ -75,10 +90,18 @@ protected:
 
 	virtual void OnResize(ResizeEventArgs& e);
 
+	// Windows is destroying the window. Frames for it that are still queued
+	// are not drawn.
+	void StopRendering();
+
 	ComPtr<IDXGISwapChain4> CreateSwapChain();
 
 	void UpdateRenderTargetViews();
 
+	// Resize the swap chain to the size of the last resize event. Called by
+	// the render thread.
+	void ApplyPendingResize();
+
 private:
 	// Windows should not be copied.
 	Window(const Window& copy) = delete;
@@ -88,22 +111,34 @@ private:
 
 	std::wstring mWindowName;
 
-	int mClientWidth;
-	int mClientHeight;
-	bool mVSync;
+	// The size of the swap chain buffers.
+	std::atomic<int> mClientWidth;
+	std::atomic<int> mClientHeight;
+	std::atomic<bool> mVSync;
 	bool mFullscreen;
+	std::atomic<bool> mOccluded;
+
+	// Resizes waiting for the render thread.
+	std::mutex mResizeMutex;
+	bool mResizePending;
+	ResizeEventArgs mPendingResize;
+
+	// Held by the render thread while it draws the window.
+	std::mutex mRenderMutex;
+	bool mRenderingStopped;
 
 	HighResolutionClock mUpdateClock;
+	FixedTimestep mFixedTimestep;
 	HighResolutionClock mRenderClock;
 	uint64_t mFrameCounter;
 
 	std::weak_ptr<Game> mpGame;
 
 	ComPtr<IDXGISwapChain4> mSwapChain;
-	ComPtr<ID3D12DescriptorHeap> mRTVDescriptorHeap;
-	ComPtr<ID3D12Resource> mBackBuffers[BufferCount];
+	DescriptorAllocation mRenderTargetViews;
+	UINT mBufferCount;
+	std::vector<ComPtr<ID3D12Resource>> mBackBuffers;
 
-	UINT mRTVDescriptorSize;
 	UINT mCurrentBackBufferIndex;
 
 	RECT mWindowRect;
@@ -29,7 +29,27 @@ int CALLBACK wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 		SetCurrentDirectoryW(path);
 	}
 
-	Application::Create(hInstance);
+	// The number of frames the CPU may run ahead of the GPU, e.g. -frames 2,
+	// and the frame rate to aim for, e.g. -fps 60. 0 is unlimited.
+	uint32_t frameCount = 3;
+	double targetFrameRate = 0.0;
+	int argc = 0;
+	wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (::wcscmp(argv[i], L"-frames") == 0)
+		{
+			frameCount = static_cast<uint32_t>(std::max(_wtoi(argv[i + 1]), 1));
+		}
+		else if (::wcscmp(argv[i], L"-fps") == 0)
+		{
+			targetFrameRate = std::max(_wtof(argv[i + 1]), 0.0);
+		}
+	}
+	LocalFree(argv);
+
+	Application::Create(hInstance, frameCount);
+	Application::Get().GetFrameScheduler().SetTargetFrameRate(targetFrameRate);
 	{
 		std::shared_ptr<Tutorial2> demo = std::make_shared<Tutorial2>(L"Learning DirectX 12 - Lesson 2", 1280, 720);
 		retCode = Application::Get().Run(demo);
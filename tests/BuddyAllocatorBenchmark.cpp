@@ -0,0 +1,119 @@
+// Runs a random allocate and free workload against BuddyAllocator and
+// reports how fragmented the free memory gets over time. Built with the
+// tests but not run by ctest:
+//
+//   BuddyAllocatorBenchmark [steps] [seed]
+
+#include "BuddyAllocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static const uint64_t KiB = 1024;
+static const uint64_t MiB = 1024 * KiB;
+
+// A heap the size of the ones ResourceHeapAllocator creates by default,
+// with D3D12's 64 KiB resource placement alignment as the smallest block.
+static const uint64_t HeapSize = 64 * MiB;
+static const uint64_t MinBlockSize = 64 * KiB;
+// The workload frees memory once this much of the heap is requested.
+static const double TargetUsage = 0.5;
+static const uint32_t ReportCount = 20;
+
+// Mostly small buffers, some textures, and a few MSAA targets that need
+// 4 MiB alignment.
+static void GetRandomAllocation(std::mt19937& random, uint64_t& size, uint64_t& alignment)
+{
+	uint32_t kind = std::uniform_int_distribution<uint32_t>(0, 99)(random);
+	if (kind < 70)
+	{
+		size = std::uniform_int_distribution<uint64_t>(1 * KiB, 1 * MiB)(random);
+		alignment = 64 * KiB;
+	}
+	else if (kind < 95)
+	{
+		size = std::uniform_int_distribution<uint64_t>(1 * MiB, 8 * MiB)(random);
+		alignment = 64 * KiB;
+	}
+	else
+	{
+		size = std::uniform_int_distribution<uint64_t>(4 * MiB, 8 * MiB)(random);
+		alignment = 4 * MiB;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t numSteps = argc > 1 ? std::atoi(argv[1]) : 100000;
+	uint32_t seed = argc > 2 ? std::atoi(argv[2]) : 1;
+	if (numSteps < ReportCount)
+	{
+		std::fprintf(stderr, "Usage: %s [steps >= %u] [seed]\n", argv[0], ReportCount);
+		return 1;
+	}
+
+	BuddyAllocator allocator(HeapSize, MinBlockSize);
+	std::mt19937 random(seed);
+	std::vector<uint64_t> allocations;
+	uint64_t failedAllocations = 0;
+
+	std::printf("%u steps on a %llu MiB heap, seed %u\n", numSteps,
+		static_cast<unsigned long long>(HeapSize / MiB), seed);
+	std::printf("%8s %6s %8s %8s %13s %15s %7s\n",
+		"step", "live", "used", "overhead", "fragmentation", "largest free", "failed");
+
+	for (uint32_t step = 1; step <= numSteps; ++step)
+	{
+		// Allocate while below the target usage, and otherwise free a
+		// random allocation, so the heap churns around the target.
+		BuddyAllocator::Stats stats = allocator.GetStats();
+		bool allocate = stats.RequestedSize < TargetUsage * HeapSize
+			? std::bernoulli_distribution(0.8)(random)
+			: std::bernoulli_distribution(0.2)(random);
+
+		if (allocate || allocations.empty())
+		{
+			uint64_t size;
+			uint64_t alignment;
+			GetRandomAllocation(random, size, alignment);
+
+			uint64_t offset = allocator.Allocate(size, alignment);
+			if (offset == BuddyAllocator::InvalidOffset)
+			{
+				++failedAllocations;
+			}
+			else
+			{
+				allocations.push_back(offset);
+			}
+		}
+		else
+		{
+			size_t index = std::uniform_int_distribution<size_t>(0, allocations.size() - 1)(random);
+			allocator.Free(allocations[index]);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+
+		if (step % (numSteps / ReportCount) == 0)
+		{
+			stats = allocator.GetStats();
+			std::printf("%8u %6llu %7.1f%% %8.3f %13.3f %11.1f MiB %7llu\n", step,
+				static_cast<unsigned long long>(stats.AllocationCount),
+				100.0 * stats.AllocatedSize / stats.Size,
+				stats.RequestedSize > 0 ? static_cast<double>(stats.AllocatedSize) / stats.RequestedSize : 1.0,
+				stats.Fragmentation,
+				static_cast<double>(stats.LargestFreeBlock) / MiB,
+				static_cast<unsigned long long>(failedAllocations));
+			failedAllocations = 0;
+		}
+	}
+
+	for (uint64_t offset : allocations)
+	{
+		allocator.Free(offset);
+	}
+	return allocator.IsEmpty() ? 0 : 1;
+}
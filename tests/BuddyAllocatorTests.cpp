@@ -0,0 +1,122 @@
+#include "BuddyAllocator.h"
+#include "Test.h"
+
+#include <vector>
+
+TEST(BlocksAreSplitDownToTheRequestedSize)
+{
+	BuddyAllocator allocator(1024, 64);
+	CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+
+	// 1024 was split into 64 + 64 + 128 + 256 + 512.
+	BuddyAllocator::Stats stats = allocator.GetStats();
+	CHECK_EQUAL(4u, stats.FreeBlockCount);
+	CHECK_EQUAL(512u, stats.LargestFreeBlock);
+	CHECK_EQUAL(64u, stats.AllocatedSize);
+	CHECK_EQUAL(1u, stats.AllocationCount);
+
+	// The free halves are used before larger blocks are split.
+	CHECK_EQUAL(64u, allocator.Allocate(64, 1));
+	CHECK_EQUAL(128u, allocator.Allocate(128, 1));
+	CHECK_EQUAL(256u, allocator.Allocate(200, 1));
+	CHECK_EQUAL(1u, allocator.GetStats().FreeBlockCount);
+}
+
+TEST(FreedBuddiesAreMerged)
+{
+	BuddyAllocator allocator(1024, 64);
+	std::vector<uint64_t> offsets;
+	for (int i = 0; i < 4; ++i)
+	{
+		offsets.push_back(allocator.Allocate(64, 1));
+	}
+	CHECK(offsets == std::vector<uint64_t>({ 0, 64, 128, 192 }));
+
+	// 64 and 192 have no free buddy.
+	allocator.Free(64);
+	allocator.Free(192);
+	CHECK_EQUAL(4u, allocator.GetStats().FreeBlockCount);
+
+	// 128 merges with 192, then 0 merges with 64 and everything with 256 and 512.
+	allocator.Free(128);
+	CHECK_EQUAL(4u, allocator.GetStats().FreeBlockCount);
+	allocator.Free(0);
+
+	BuddyAllocator::Stats stats = allocator.GetStats();
+	CHECK(allocator.IsEmpty());
+	CHECK_EQUAL(1u, stats.FreeBlockCount);
+	CHECK_EQUAL(1024u, stats.LargestFreeBlock);
+	CHECK_EQUAL(0u, stats.AllocatedSize);
+	CHECK_EQUAL(0u, stats.RequestedSize);
+	CHECK_EQUAL(0.0, stats.Fragmentation);
+
+	CHECK_EQUAL(0u, allocator.Allocate(1024, 1));
+}
+
+TEST(AllocationsAreAlignedToTheirBlockSize)
+{
+	BuddyAllocator allocator(1024, 64);
+	CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+
+	// A 64 byte allocation with 256 byte alignment takes a 256 byte block.
+	uint64_t offset = allocator.Allocate(64, 256);
+	CHECK_EQUAL(256u, offset);
+	CHECK_EQUAL(0u, offset % 256);
+
+	// Sizes are rounded up to a power of two and to the minimum block size.
+	CHECK_EQUAL(128u, allocator.Allocate(100, 1));
+	CHECK_EQUAL(64u, allocator.Allocate(1, 1));
+
+	BuddyAllocator::Stats stats = allocator.GetStats();
+	CHECK_EQUAL(64u + 256u + 128u + 64u, stats.AllocatedSize);
+	CHECK_EQUAL(64u + 64u + 100u + 1u, stats.RequestedSize);
+}
+
+TEST(AllocationFailsWhenNoBlockIsLargeEnough)
+{
+	BuddyAllocator allocator(1024, 64);
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(0, 1));
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(1025, 1));
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(64, 2048));
+
+	for (uint64_t i = 0; i < 16; ++i)
+	{
+		CHECK_EQUAL(i * 64, allocator.Allocate(64, 1));
+	}
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(64, 1));
+	CHECK_EQUAL(0u, allocator.GetStats().FreeBlockCount);
+
+	allocator.Free(320);
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(128, 1));
+	CHECK_EQUAL(320u, allocator.Allocate(64, 1));
+}
+
+TEST(FragmentationOfFreeMemory)
+{
+	BuddyAllocator allocator(1024, 64);
+	for (int i = 0; i < 16; ++i)
+	{
+		allocator.Allocate(64, 1);
+	}
+
+	// Free every other block: half of the memory is free, but none of it merges.
+	for (uint64_t offset = 0; offset < 1024; offset += 128)
+	{
+		allocator.Free(offset);
+	}
+
+	BuddyAllocator::Stats stats = allocator.GetStats();
+	CHECK_EQUAL(8u, stats.FreeBlockCount);
+	CHECK_EQUAL(64u, stats.LargestFreeBlock);
+	CHECK_EQUAL(1.0 - 64.0 / 512.0, stats.Fragmentation);
+	CHECK_EQUAL(BuddyAllocator::InvalidOffset, allocator.Allocate(128, 1));
+
+	// Freeing the other halves merges everything back into one block.
+	for (uint64_t offset = 64; offset < 1024; offset += 128)
+	{
+		allocator.Free(offset);
+	}
+	stats = allocator.GetStats();
+	CHECK_EQUAL(1u, stats.FreeBlockCount);
+	CHECK_EQUAL(0.0, stats.Fragmentation);
+}
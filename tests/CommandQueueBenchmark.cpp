@@ -0,0 +1,96 @@
+// Compares submitting the command lists of a frame one at a time with
+// submitting them as one batch, on the fake D3D12 queue. Built with the
+// tests but not run by ctest:
+//
+//   CommandQueueBenchmark [frames] [command lists per frame]
+
+#include "CommandQueue.h"
+#include "FakeD3D12.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct Result
+{
+	CommandQueue::SubmissionStats Stats;
+	uint32_t CommandAllocators;
+	double Time;
+};
+
+// Record numLists command lists per frame and submit them each on their
+// own, or all together.
+static Result Run(uint32_t numFrames, uint32_t numLists, bool batch)
+{
+	ComPtr<FakeDevice> device;
+	device.Attach(new FakeDevice());
+
+	Result result = {};
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+		std::vector<ComPtr<ID3D12GraphicsCommandList2>> commandLists;
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < numFrames; ++frame)
+		{
+			for (uint32_t i = 0; i < numLists; ++i)
+			{
+				auto commandList = commandQueue.GetCommandList();
+				if (batch)
+				{
+					commandLists.push_back(commandList);
+				}
+				else
+				{
+					commandQueue.ExecuteCommandList(commandList);
+				}
+			}
+
+			if (batch)
+			{
+				commandQueue.ExecuteCommandLists(commandLists);
+				commandLists.clear();
+			}
+		}
+		result.Time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+		result.Stats = commandQueue.GetSubmissionStats();
+		result.CommandAllocators = device->GetCommandAllocatorCount();
+
+		commandQueue.Flush();
+	}
+
+	return result;
+}
+
+static void Print(const char* name, const Result& result, uint32_t numFrames)
+{
+	// Every command list retires its allocator on the fence of its submission.
+	std::printf("%-22s %6.2f submissions, %6.2f signals, %6.2f allocator entries per frame, "
+		"%u allocators, %8.2f us per frame\n", name,
+		static_cast<double>(result.Stats.Submissions) / numFrames,
+		static_cast<double>(result.Stats.Signals) / numFrames,
+		static_cast<double>(result.Stats.CommandLists) / numFrames,
+		result.CommandAllocators,
+		result.Time / numFrames);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t numFrames = argc > 1 ? std::atoi(argv[1]) : 1000;
+	uint32_t numLists = argc > 2 ? std::atoi(argv[2]) : 8;
+	if (numFrames == 0 || numLists == 0)
+	{
+		std::fprintf(stderr, "Usage: %s [frames] [command lists per frame]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%u frames, %u command lists per frame\n", numFrames, numLists);
+	Print("ExecuteCommandList", Run(numFrames, numLists, false), numFrames);
+	Print("ExecuteCommandLists", Run(numFrames, numLists, true), numFrames);
+
+	for (const std::string& error : TakeFakeErrors())
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+	}
+	return 0;
+}
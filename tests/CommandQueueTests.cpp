@@ -0,0 +1,334 @@
+#include "CommandQueue.h"
+#include "FakeD3D12.h"
+#include "ResourceStateTracker.h"
+#include "Test.h"
+
+#include <future>
+#include <thread>
+
+static ComPtr<FakeDevice> CreateFakeDevice()
+{
+	ComPtr<FakeDevice> device;
+	device.Attach(new FakeDevice());
+	return device;
+}
+
+static FakeCommandQueue* GetFakeQueue(CommandQueue& commandQueue)
+{
+	return static_cast<FakeCommandQueue*>(commandQueue.GetD3D12CommandQueue().Get());
+}
+
+static FakeCommandAllocator* GetFakeAllocator(const ComPtr<ID3D12GraphicsCommandList2>& commandList)
+{
+	return static_cast<FakeCommandList*>(commandList.Get())->GetAllocator().Get();
+}
+
+TEST(CommandListIsReusedOnceItsFenceIsReached)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+		auto commandList = commandQueue.GetCommandList();
+		ID3D12GraphicsCommandList2* first = commandList.Get();
+		FakeCommandAllocator* firstAllocator = GetFakeAllocator(commandList);
+		commandQueue.ExecuteCommandList(commandList);
+
+		commandList = commandQueue.GetCommandList();
+		CHECK(commandList.Get() == first);
+		CHECK(GetFakeAllocator(commandList) == firstAllocator);
+		CHECK_EQUAL(1u, firstAllocator->GetResetCount());
+		CHECK_EQUAL(1u, device->GetCommandAllocatorCount());
+		CHECK_EQUAL(1u, device->GetCommandListCount());
+
+		commandQueue.ExecuteCommandList(commandList);
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(AllocatorIsNotResetBeforeItsFenceIsReached)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		FakeCommandQueue* fakeQueue = GetFakeQueue(commandQueue);
+		fakeQueue->SetAutoComplete(false);
+
+		auto commandList = commandQueue.GetCommandList();
+		ID3D12GraphicsCommandList2* first = commandList.Get();
+		FakeCommandAllocator* firstAllocator = GetFakeAllocator(commandList);
+		commandQueue.ExecuteCommandList(commandList);
+
+		// The list can be recorded again right away, but its allocator is
+		// still in use by the GPU.
+		commandList = commandQueue.GetCommandList();
+		CHECK(commandList.Get() == first);
+		CHECK(GetFakeAllocator(commandList) != firstAllocator);
+		CHECK_EQUAL(2u, device->GetCommandAllocatorCount());
+		CHECK_EQUAL(0u, firstAllocator->GetResetCount());
+
+		fakeQueue->CompleteSignals();
+		commandQueue.ExecuteCommandList(commandList);
+
+		commandList = commandQueue.GetCommandList();
+		CHECK(GetFakeAllocator(commandList) == firstAllocator);
+		CHECK_EQUAL(1u, firstAllocator->GetResetCount());
+		CHECK_EQUAL(2u, device->GetCommandAllocatorCount());
+
+		commandQueue.ExecuteCommandList(commandList);
+		fakeQueue->SetAutoComplete(true);
+		fakeQueue->CompleteSignals();
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(CommandListSubmittedOnAnotherThreadReturnsToItsPool)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+		std::promise<ComPtr<ID3D12GraphicsCommandList2>> recorded;
+		std::promise<void> submitted;
+		std::promise<ComPtr<ID3D12GraphicsCommandList2>> recordedAgain;
+		std::thread recorder([&]()
+		{
+			recorded.set_value(commandQueue.GetCommandList());
+			submitted.get_future().wait();
+			recordedAgain.set_value(commandQueue.GetCommandList());
+		});
+
+		auto commandList = recorded.get_future().get();
+		ID3D12GraphicsCommandList2* first = commandList.Get();
+		commandQueue.ExecuteCommandList(commandList);
+
+		// The list went back to the recording thread's pool, not to the pool
+		// of the thread that submitted it.
+		auto otherCommandList = commandQueue.GetCommandList();
+		CHECK(otherCommandList.Get() != first);
+		commandQueue.ExecuteCommandList(otherCommandList);
+
+		submitted.set_value();
+		commandList = recordedAgain.get_future().get();
+		recorder.join();
+		CHECK(commandList.Get() == first);
+		CHECK_EQUAL(2u, device->GetCommandListCount());
+
+		commandQueue.ExecuteCommandList(commandList);
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(CommandListsAreRecordedAndSubmittedConcurrently)
+{
+	const int NumThreads = 8;
+	const int NumIterations = 200;
+
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		FakeCommandQueue* fakeQueue = GetFakeQueue(commandQueue);
+		fakeQueue->SetAutoComplete(false);
+
+		// Completes the submitted work a little later, like a GPU would.
+		std::atomic<bool> stop{ false };
+		std::thread gpu([&]()
+		{
+			while (!stop)
+			{
+				fakeQueue->CompleteSignals();
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		});
+
+		// Half of the lists are submitted by another thread, so they are
+		// handed back to the pools of the threads that recorded them.
+		std::mutex submitMutex;
+		std::vector<ComPtr<ID3D12GraphicsCommandList2>> submitQueue;
+		std::atomic<int> recordersLeft{ NumThreads };
+		std::thread submitter([&]()
+		{
+			for (;;)
+			{
+				bool done = recordersLeft == 0;
+				std::vector<ComPtr<ID3D12GraphicsCommandList2>> commandLists;
+				{
+					std::lock_guard<std::mutex> lock(submitMutex);
+					commandLists.swap(submitQueue);
+				}
+
+				if (!commandLists.empty())
+				{
+					commandQueue.ExecuteCommandLists(commandLists);
+				}
+				else if (done)
+				{
+					break;
+				}
+				std::this_thread::yield();
+			}
+		});
+
+		std::vector<std::thread> recorders;
+		for (int thread = 0; thread < NumThreads; ++thread)
+		{
+			recorders.emplace_back([&, thread]()
+			{
+				for (int i = 0; i < NumIterations; ++i)
+				{
+					auto commandList = commandQueue.GetCommandList();
+					D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+					commandList->ResourceBarrier(1, &barrier);
+
+					if ((i + thread) % 2 == 0)
+					{
+						commandQueue.ExecuteCommandList(commandList);
+					}
+					else
+					{
+						std::lock_guard<std::mutex> lock(submitMutex);
+						submitQueue.push_back(commandList);
+					}
+				}
+				--recordersLeft;
+			});
+		}
+
+		for (auto& recorder : recorders)
+		{
+			recorder.join();
+		}
+		submitter.join();
+		stop = true;
+		gpu.join();
+
+		fakeQueue->SetAutoComplete(true);
+		fakeQueue->CompleteSignals();
+		commandQueue.Flush();
+
+		CommandQueue::SubmissionStats stats = commandQueue.GetSubmissionStats();
+		CHECK_EQUAL(uint64_t(NumThreads * NumIterations), stats.CommandLists);
+		// One signal per submission, and one for the flush.
+		CHECK_EQUAL(stats.Submissions + 1, stats.Signals);
+		CHECK(device->GetCommandListCount() < uint32_t(NumThreads * NumIterations));
+	}
+
+	// Handing a list to two threads at once, or resetting an allocator the
+	// GPU still uses, would have been reported by the fakes.
+	for (const std::string& error : TakeFakeErrors())
+	{
+		Test::ReportFailure(__FILE__, __LINE__, error);
+	}
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(BatchIsSubmittedWithOneSignal)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		FakeCommandQueue* fakeQueue = GetFakeQueue(commandQueue);
+		fakeQueue->SetAutoComplete(false);
+
+		std::vector<ComPtr<ID3D12GraphicsCommandList2>> commandLists;
+		std::vector<FakeCommandAllocator*> allocators;
+		for (int i = 0; i < 3; ++i)
+		{
+			commandLists.push_back(commandQueue.GetCommandList());
+			allocators.push_back(GetFakeAllocator(commandLists.back()));
+		}
+
+		uint64_t fenceValue = commandQueue.ExecuteCommandLists(commandLists);
+		CHECK_EQUAL(1u, fenceValue);
+
+		std::vector<FakeCommandQueue::Call> calls = fakeQueue->GetCalls();
+		CHECK_EQUAL(2u, calls.size());
+		if (calls.size() == 2)
+		{
+			CHECK_EQUAL(FakeCommandQueue::Call::Execute, calls[0].CallType);
+			CHECK_EQUAL(3u, calls[0].CommandLists.size());
+			for (size_t i = 0; i < calls[0].CommandLists.size() && i < commandLists.size(); ++i)
+			{
+				CHECK(calls[0].CommandLists[i] == commandLists[i].Get());
+				CHECK(static_cast<FakeCommandList*>(commandLists[i].Get())->IsClosed());
+			}
+			CHECK_EQUAL(FakeCommandQueue::Call::Signal, calls[1].CallType);
+			CHECK(calls[1].Fence == commandQueue.GetFence().Get());
+			CHECK_EQUAL(fenceValue, calls[1].Value);
+		}
+
+		CommandQueue::SubmissionStats stats = commandQueue.GetSubmissionStats();
+		CHECK_EQUAL(1u, stats.Submissions);
+		CHECK_EQUAL(1u, stats.Signals);
+		CHECK_EQUAL(3u, stats.CommandLists);
+
+		// All three allocators were retired on that one fence value, so they
+		// are all reused once it completes.
+		fakeQueue->CompleteSignals();
+		commandLists.clear();
+		for (int i = 0; i < 3; ++i)
+		{
+			commandLists.push_back(commandQueue.GetCommandList());
+			CHECK(GetFakeAllocator(commandLists.back()) == allocators[i]);
+		}
+		CHECK_EQUAL(3u, device->GetCommandAllocatorCount());
+
+		commandQueue.ExecuteCommandLists(commandLists);
+		fakeQueue->SetAutoComplete(true);
+		fakeQueue->CompleteSignals();
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(PendingBarriersAreSubmittedInTheSameBatch)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> resource;
+	resource.Attach(new FakeResource());
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		ResourceStateTracker::AddGlobalResourceState(resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+		// The first transition of the resource is only resolved at submit
+		// time, into an extra command list that runs first.
+		ResourceStateTracker resourceStateTracker;
+		auto commandList = commandQueue.GetCommandList();
+		resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+		commandQueue.ExecuteCommandList(commandList, resourceStateTracker);
+
+		std::vector<FakeCommandQueue::Call> calls = GetFakeQueue(commandQueue)->GetCalls();
+		CHECK_EQUAL(2u, calls.size());
+		if (calls.size() == 2)
+		{
+			CHECK_EQUAL(FakeCommandQueue::Call::Execute, calls[0].CallType);
+			CHECK_EQUAL(2u, calls[0].CommandLists.size());
+			CHECK(calls[0].CommandLists.back() == commandList.Get());
+			CHECK_EQUAL(FakeCommandQueue::Call::Signal, calls[1].CallType);
+		}
+
+		ResourceStateTracker::RemoveGlobalResourceState(resource.Get());
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	resource = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
@@ -0,0 +1,141 @@
+#include "D3D12Hash.h"
+#include "Test.h"
+
+#include <cstring>
+
+// The descs these tests rely on having padding.
+static_assert(sizeof(D3D12_RENDER_TARGET_BLEND_DESC) == 9 * 4 + 4);
+static_assert(sizeof(D3D12_DEPTH_STENCIL_DESC) == 4 * 4 + 4 + 2 * 16);
+// And the one that has none, but holds floats.
+static_assert(sizeof(D3D12_STATIC_SAMPLER_DESC) == 13 * 4);
+
+// A desc whose padding holds the given byte.
+template<typename T>
+static T Garbage(uint8_t byte)
+{
+	T value;
+	memset(&value, byte, sizeof(value));
+	return value;
+}
+
+static void SetBlendDesc(D3D12_BLEND_DESC& desc)
+{
+	desc.AlphaToCoverageEnable = FALSE;
+	desc.IndependentBlendEnable = TRUE;
+	for (D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.RenderTarget)
+	{
+		renderTarget.BlendEnable = TRUE;
+		renderTarget.LogicOpEnable = FALSE;
+		renderTarget.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+		renderTarget.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+		renderTarget.BlendOp = D3D12_BLEND_OP_ADD;
+		renderTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+		renderTarget.DestBlendAlpha = D3D12_BLEND_ZERO;
+		renderTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+		renderTarget.LogicOp = D3D12_LOGIC_OP_NOOP;
+		renderTarget.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+	}
+}
+
+template<typename DepthStencilDesc>
+static void SetDepthStencilDesc(DepthStencilDesc& desc)
+{
+	desc.DepthEnable = TRUE;
+	desc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+	desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	desc.StencilEnable = TRUE;
+	desc.StencilReadMask = 0xff;
+	desc.StencilWriteMask = 0x0f;
+	desc.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_REPLACE, D3D12_COMPARISON_FUNC_ALWAYS };
+	desc.BackFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_INCR, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_EQUAL };
+}
+
+static D3D12_RASTERIZER_DESC CreateRasterizerDesc()
+{
+	return D3D12_RASTERIZER_DESC{ D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_BACK, FALSE, 0, 0.0f, 0.0f, TRUE, FALSE, FALSE, 0,
+		D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF };
+}
+
+static D3D12_STATIC_SAMPLER_DESC CreateStaticSamplerDesc()
+{
+	return D3D12_STATIC_SAMPLER_DESC{ D3D12_FILTER_ANISOTROPIC, D3D12_TEXTURE_ADDRESS_MODE_WRAP, D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP, 0.0f, 16, D3D12_COMPARISON_FUNC_NEVER, D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK,
+		0.0f, 1000.0f, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL };
+}
+
+TEST(BlendDescPaddingIsNotHashed)
+{
+	D3D12_BLEND_DESC a = Garbage<D3D12_BLEND_DESC>(0x00);
+	D3D12_BLEND_DESC b = Garbage<D3D12_BLEND_DESC>(0xcd);
+	SetBlendDesc(a);
+	SetBlendDesc(b);
+	CHECK(memcmp(&a, &b, sizeof(a)) != 0);
+	CHECK_EQUAL(HashBlendDesc(a), HashBlendDesc(b));
+
+	b.RenderTarget[7].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED;
+	CHECK(HashBlendDesc(a) != HashBlendDesc(b));
+}
+
+TEST(DepthStencilDescPaddingIsNotHashed)
+{
+	D3D12_DEPTH_STENCIL_DESC a = Garbage<D3D12_DEPTH_STENCIL_DESC>(0x00);
+	D3D12_DEPTH_STENCIL_DESC b = Garbage<D3D12_DEPTH_STENCIL_DESC>(0xcd);
+	SetDepthStencilDesc(a);
+	SetDepthStencilDesc(b);
+	CHECK(memcmp(&a, &b, sizeof(a)) != 0);
+	CHECK_EQUAL(HashDepthStencilDesc(a), HashDepthStencilDesc(b));
+
+	b.StencilWriteMask = 0xf0;
+	CHECK(HashDepthStencilDesc(a) != HashDepthStencilDesc(b));
+
+	D3D12_DEPTH_STENCIL_DESC1 a1 = Garbage<D3D12_DEPTH_STENCIL_DESC1>(0x00);
+	D3D12_DEPTH_STENCIL_DESC1 b1 = Garbage<D3D12_DEPTH_STENCIL_DESC1>(0xcd);
+	SetDepthStencilDesc(a1);
+	SetDepthStencilDesc(b1);
+	a1.DepthBoundsTestEnable = FALSE;
+	b1.DepthBoundsTestEnable = FALSE;
+	CHECK_EQUAL(HashDepthStencilDesc1(a1), HashDepthStencilDesc1(b1));
+
+	b1.DepthBoundsTestEnable = TRUE;
+	CHECK(HashDepthStencilDesc1(a1) != HashDepthStencilDesc1(b1));
+}
+
+TEST(NegativeZeroHashesLikeZero)
+{
+	CHECK_EQUAL(HashFloat(HashOffsetBasis, 0.0f), HashFloat(HashOffsetBasis, -0.0f));
+	CHECK(HashFloat(HashOffsetBasis, 0.0f) != HashFloat(HashOffsetBasis, 1.0f));
+
+	D3D12_RASTERIZER_DESC a = CreateRasterizerDesc();
+	D3D12_RASTERIZER_DESC b = CreateRasterizerDesc();
+	b.DepthBiasClamp = -0.0f;
+	b.SlopeScaledDepthBias = -0.0f;
+	CHECK_EQUAL(HashRasterizerDesc(a), HashRasterizerDesc(b));
+
+	b.SlopeScaledDepthBias = 1.0f;
+	CHECK(HashRasterizerDesc(a) != HashRasterizerDesc(b));
+
+	D3D12_STATIC_SAMPLER_DESC c = CreateStaticSamplerDesc();
+	D3D12_STATIC_SAMPLER_DESC d = CreateStaticSamplerDesc();
+	d.MipLODBias = -0.0f;
+	d.MinLOD = -0.0f;
+	CHECK_EQUAL(HashStaticSamplerDesc(c), HashStaticSamplerDesc(d));
+
+	d.RegisterSpace = 1;
+	CHECK(HashStaticSamplerDesc(c) != HashStaticSamplerDesc(d));
+}
+
+TEST(HashesDependOnTheSeed)
+{
+	D3D12_RT_FORMAT_ARRAY formats = {};
+	formats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	formats.NumRenderTargets = 1;
+	CHECK(HashRTFormatArray(formats) != HashRTFormatArray(formats, 1));
+
+	D3D12_RT_FORMAT_ARRAY other = formats;
+	other.RTFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	CHECK(HashRTFormatArray(formats) != HashRTFormatArray(other));
+
+	DXGI_SAMPLE_DESC sampleDesc = { 1, 0 };
+	DXGI_SAMPLE_DESC swapped = { 0, 1 };
+	CHECK(HashSampleDesc(sampleDesc) != HashSampleDesc(swapped));
+}
@@ -0,0 +1,122 @@
+#include "DeferredReleaseQueue.h"
+#include "Test.h"
+
+#include <vector>
+
+// Appends its id to a log when its last reference is released.
+class LoggedObject final : public IUnknown
+{
+public:
+	static ComPtr<IUnknown> Create(std::vector<int>& log, int id)
+	{
+		ComPtr<IUnknown> object;
+		object.Attach(new LoggedObject(log, id));
+		return object;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppvObject) override
+	{
+		*ppvObject = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++mRefCount;
+	}
+
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		ULONG refCount = --mRefCount;
+		if (refCount == 0)
+		{
+			mLog.push_back(mId);
+			delete this;
+		}
+		return refCount;
+	}
+
+private:
+	LoggedObject(std::vector<int>& log, int id)
+		: mLog(log)
+		, mId(id)
+		, mRefCount(1)
+	{}
+
+	std::vector<int>& mLog;
+	int mId;
+	ULONG mRefCount;
+};
+
+TEST(NothingIsReleasedBeforeItsFenceValue)
+{
+	std::vector<int> log;
+	DeferredReleaseQueue deferredReleases;
+	deferredReleases.Enqueue(1, LoggedObject::Create(log, 1));
+	deferredReleases.Enqueue(2, LoggedObject::Create(log, 2));
+
+	CHECK_EQUAL(0u, deferredReleases.ReleaseCompleted(0));
+	CHECK(log.empty());
+	CHECK_EQUAL(2u, deferredReleases.GetPendingCount());
+
+	CHECK_EQUAL(1u, deferredReleases.ReleaseCompleted(1));
+	CHECK(log == std::vector<int>({ 1 }));
+	CHECK_EQUAL(1u, deferredReleases.GetPendingCount());
+
+	// Completed values don't have to be checked in order.
+	CHECK_EQUAL(0u, deferredReleases.ReleaseCompleted(0));
+	CHECK(log == std::vector<int>({ 1 }));
+
+	deferredReleases.ReleaseAll();
+	CHECK(log == std::vector<int>({ 1, 2 }));
+}
+
+TEST(ObjectsAreReleasedInFenceOrder)
+{
+	std::vector<int> log;
+	DeferredReleaseQueue deferredReleases;
+	deferredReleases.Enqueue(3, LoggedObject::Create(log, 30));
+	deferredReleases.Enqueue(1, LoggedObject::Create(log, 10));
+	deferredReleases.Enqueue(2, LoggedObject::Create(log, 20));
+	deferredReleases.Enqueue(2, LoggedObject::Create(log, 21));
+	deferredReleases.Enqueue(1, LoggedObject::Create(log, 11));
+	deferredReleases.Enqueue(4, LoggedObject::Create(log, 40));
+
+	CHECK_EQUAL(4u, deferredReleases.ReleaseCompleted(2));
+	CHECK(log == std::vector<int>({ 10, 11, 20, 21 }));
+
+	CHECK_EQUAL(2u, deferredReleases.ReleaseCompleted(10));
+	CHECK(log == std::vector<int>({ 10, 11, 20, 21, 30, 40 }));
+	CHECK_EQUAL(0u, deferredReleases.GetPendingCount());
+}
+
+TEST(ReleaseAllReleasesInFenceOrder)
+{
+	std::vector<int> log;
+	{
+		DeferredReleaseQueue deferredReleases;
+		deferredReleases.Enqueue(2, LoggedObject::Create(log, 2));
+		deferredReleases.Enqueue(1, LoggedObject::Create(log, 1));
+		deferredReleases.Enqueue(3, LoggedObject::Create(log, 3));
+
+		deferredReleases.ReleaseAll();
+		CHECK(log == std::vector<int>({ 1, 2, 3 }));
+		CHECK_EQUAL(0u, deferredReleases.GetPendingCount());
+	}
+	CHECK_EQUAL(3u, log.size());
+}
+
+TEST(ObjectReferencedElsewhereOutlivesTheQueue)
+{
+	std::vector<int> log;
+	ComPtr<IUnknown> object = LoggedObject::Create(log, 1);
+	{
+		DeferredReleaseQueue deferredReleases;
+		deferredReleases.Enqueue(1, object);
+		CHECK_EQUAL(1u, deferredReleases.ReleaseCompleted(1));
+	}
+	CHECK(log.empty());
+
+	object = nullptr;
+	CHECK(log == std::vector<int>({ 1 }));
+}
@@ -0,0 +1,411 @@
+#include "FakeD3D12.h"
+
+#include <algorithm>
+
+static std::mutex gErrorMutex;
+static std::vector<std::string> gErrors;
+static std::atomic<int> gLiveObjects{ 0 };
+
+std::vector<std::string> TakeFakeErrors()
+{
+	std::lock_guard<std::mutex> lock(gErrorMutex);
+	return std::move(gErrors);
+}
+
+void ReportFakeError(const std::string& error)
+{
+	std::lock_guard<std::mutex> lock(gErrorMutex);
+	gErrors.push_back(error);
+}
+
+int GetLiveFakeObjectCount()
+{
+	return gLiveObjects.load();
+}
+
+void AddLiveFakeObjects(int count)
+{
+	gLiveObjects.fetch_add(count);
+}
+
+// Hand a new fake out through an IID_PPV_ARGS out parameter.
+template<typename T>
+static HRESULT ReturnObject(T* object, REFIID riid, void** ppvObject)
+{
+	HRESULT hr = object->QueryInterface(riid, ppvObject);
+	object->Release();
+	return hr;
+}
+
+FakeFence::FakeFence(UINT64 initialValue)
+	: mCompletedValue(initialValue)
+{
+}
+
+UINT64 FakeFence::GetCompletedValue()
+{
+	return mCompletedValue.load(std::memory_order_acquire);
+}
+
+HRESULT FakeFence::SetEventOnCompletion(UINT64 value, HANDLE hEvent)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mCompletedValue.load(std::memory_order_acquire) >= value)
+	{
+		::SetEvent(hEvent);
+	}
+	else
+	{
+		mEvents.emplace_back(value, hEvent);
+	}
+	return S_OK;
+}
+
+HRESULT FakeFence::Signal(UINT64 value)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCompletedValue.store(value, std::memory_order_release);
+
+	auto iter = std::remove_if(mEvents.begin(), mEvents.end(), [value](const std::pair<UINT64, HANDLE>& event)
+	{
+		if (event.first <= value)
+		{
+			::SetEvent(event.second);
+			return true;
+		}
+		return false;
+	});
+	mEvents.erase(iter, mEvents.end());
+	return S_OK;
+}
+
+size_t FakeFence::GetPendingEventCount()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mEvents.size();
+}
+
+FakeCommandAllocator::FakeCommandAllocator()
+	: mResetCount(0)
+	, mUnsignaled(false)
+	, mFenceValue(0)
+{
+}
+
+HRESULT FakeCommandAllocator::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mUnsignaled || (mFence && mFence->GetCompletedValue() < mFenceValue))
+	{
+		ReportFakeError("ID3D12CommandAllocator::Reset: command lists are still executing");
+		return E_FAIL;
+	}
+
+	++mResetCount;
+	return S_OK;
+}
+
+void FakeCommandAllocator::Submit()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mUnsignaled = true;
+}
+
+void FakeCommandAllocator::SubmitSignal(ComPtr<ID3D12Fence> fence, UINT64 value)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mUnsignaled = false;
+	mFence = fence;
+	mFenceValue = value;
+}
+
+uint32_t FakeCommandAllocator::GetResetCount()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mResetCount;
+}
+
+FakeCommandList::FakeCommandList(ComPtr<FakeCommandAllocator> allocator)
+	: mAllocator(allocator)
+	, mClosed(false)
+{
+}
+
+HRESULT FakeCommandList::Close()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mClosed)
+	{
+		ReportFakeError("ID3D12GraphicsCommandList::Close: the command list is already closed");
+		return E_FAIL;
+	}
+
+	mClosed = true;
+	return S_OK;
+}
+
+HRESULT FakeCommandList::Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mClosed)
+	{
+		ReportFakeError("ID3D12GraphicsCommandList::Reset: the command list is still recording");
+		return E_FAIL;
+	}
+
+	mAllocator = static_cast<FakeCommandAllocator*>(pAllocator);
+	mClosed = false;
+	mBarrierCalls.clear();
+	mDiscards.clear();
+	return S_OK;
+}
+
+void FakeCommandList::ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (CheckRecording("ResourceBarrier"))
+	{
+		mBarrierCalls.emplace_back(pBarriers, pBarriers + numBarriers);
+	}
+}
+
+void FakeCommandList::DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (CheckRecording("DiscardResource"))
+	{
+		mDiscards.push_back(pResource);
+	}
+}
+
+bool FakeCommandList::IsClosed()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mClosed;
+}
+
+ComPtr<FakeCommandAllocator> FakeCommandList::GetAllocator()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mAllocator;
+}
+
+std::vector<std::vector<D3D12_RESOURCE_BARRIER>> FakeCommandList::GetBarrierCalls()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mBarrierCalls;
+}
+
+std::vector<ID3D12Resource*> FakeCommandList::GetDiscards()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mDiscards;
+}
+
+bool FakeCommandList::CheckRecording(const char* method)
+{
+	if (mClosed)
+	{
+		ReportFakeError(std::string("ID3D12GraphicsCommandList::") + method + ": the command list is closed");
+		return false;
+	}
+	return true;
+}
+
+FakeCommandQueue::FakeCommandQueue()
+	: mAutoComplete(true)
+{
+}
+
+void FakeCommandQueue::ExecuteCommandLists(UINT numCommandLists, ID3D12CommandList* const* ppCommandLists)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (UINT i = 0; i < numCommandLists; ++i)
+	{
+		FakeCommandList* commandList = static_cast<FakeCommandList*>(ppCommandLists[i]);
+		if (!commandList->IsClosed())
+		{
+			ReportFakeError("ID3D12CommandQueue::ExecuteCommandLists: a command list wasn't closed");
+		}
+
+		ComPtr<FakeCommandAllocator> allocator = commandList->GetAllocator();
+		allocator->Submit();
+		mUnsignaledAllocators.push_back(allocator);
+	}
+
+	mCalls.push_back(Call{ Call::Execute, std::vector<ID3D12CommandList*>(ppCommandLists, ppCommandLists + numCommandLists), nullptr, 0 });
+}
+
+HRESULT FakeCommandQueue::Signal(ID3D12Fence* pFence, UINT64 value)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (auto& allocator : mUnsignaledAllocators)
+	{
+		allocator->SubmitSignal(pFence, value);
+	}
+	mUnsignaledAllocators.clear();
+
+	mCalls.push_back(Call{ Call::Signal, {}, pFence, value });
+
+	if (mAutoComplete)
+	{
+		pFence->Signal(value);
+	}
+	else
+	{
+		mPendingSignals.emplace_back(pFence, value);
+	}
+	return S_OK;
+}
+
+HRESULT FakeCommandQueue::Wait(ID3D12Fence* pFence, UINT64 value)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCalls.push_back(Call{ Call::Wait, {}, pFence, value });
+	return S_OK;
+}
+
+void FakeCommandQueue::SetAutoComplete(bool autoComplete)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mAutoComplete = autoComplete;
+}
+
+void FakeCommandQueue::CompleteSignals()
+{
+	std::vector<std::pair<ComPtr<ID3D12Fence>, UINT64>> pendingSignals;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		pendingSignals.swap(mPendingSignals);
+	}
+
+	for (auto& signal : pendingSignals)
+	{
+		signal.first->Signal(signal.second);
+	}
+}
+
+std::vector<FakeCommandQueue::Call> FakeCommandQueue::GetCalls()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCalls;
+}
+
+FakeHeap::FakeHeap(const D3D12_HEAP_DESC& desc)
+	: mDesc(desc)
+{
+}
+
+const D3D12_HEAP_DESC& FakeHeap::GetDesc() const
+{
+	return mDesc;
+}
+
+FakeResource::FakeResource()
+	: mDesc{}
+	, mHeapOffset(0)
+{
+}
+
+FakeResource::FakeResource(const D3D12_RESOURCE_DESC& desc, ComPtr<FakeHeap> heap, UINT64 heapOffset)
+	: mDesc(desc)
+	, mHeap(heap)
+	, mHeapOffset(heapOffset)
+{
+}
+
+const D3D12_RESOURCE_DESC& FakeResource::GetDesc() const
+{
+	return mDesc;
+}
+
+ComPtr<FakeHeap> FakeResource::GetHeap() const
+{
+	return mHeap;
+}
+
+UINT64 FakeResource::GetHeapOffset() const
+{
+	return mHeapOffset;
+}
+
+FakeDevice::FakeDevice()
+	: mCommandAllocatorCount(0)
+	, mCommandListCount(0)
+{
+}
+
+HRESULT FakeDevice::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue)
+{
+	return ReturnObject(new FakeCommandQueue(), riid, ppCommandQueue);
+}
+
+HRESULT FakeDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator)
+{
+	mCommandAllocatorCount.fetch_add(1, std::memory_order_relaxed);
+	return ReturnObject(new FakeCommandAllocator(), riid, ppCommandAllocator);
+}
+
+HRESULT FakeDevice::CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type,
+	ID3D12CommandAllocator* pCommandAllocator, ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList)
+{
+	mCommandListCount.fetch_add(1, std::memory_order_relaxed);
+	return ReturnObject(new FakeCommandList(static_cast<FakeCommandAllocator*>(pCommandAllocator)), riid, ppCommandList);
+}
+
+HRESULT FakeDevice::CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** ppFence)
+{
+	return ReturnObject(new FakeFence(initialValue), riid, ppFence);
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO FakeDevice::GetResourceAllocationInfo(UINT visibleMask,
+	UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs)
+{
+	const UINT64 pageSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	D3D12_RESOURCE_ALLOCATION_INFO info = { 0, pageSize };
+	for (UINT i = 0; i < numResourceDescs; ++i)
+	{
+		const D3D12_RESOURCE_DESC& desc = pResourceDescs[i];
+		UINT64 size = desc.Width * desc.Height * desc.DepthOrArraySize * 4;
+		info.SizeInBytes += (size + pageSize - 1) / pageSize * pageSize;
+	}
+	return info;
+}
+
+HRESULT FakeDevice::CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap)
+{
+	return ReturnObject(new FakeHeap(*pDesc), riid, ppvHeap);
+}
+
+HRESULT FakeDevice::CreatePlacedResource(ID3D12Heap* pHeap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* pDesc,
+	D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource)
+{
+	return ReturnObject(new FakeResource(*pDesc, static_cast<FakeHeap*>(pHeap), heapOffset), riid, ppvResource);
+}
+
+HRESULT FakeDevice::CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T blobLength,
+	REFIID riid, void** ppPipelineLibrary)
+{
+	*ppPipelineLibrary = nullptr;
+	return E_NOTIMPL;
+}
+
+HRESULT FakeDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc,
+	REFIID riid, void** ppPipelineState)
+{
+	*ppPipelineState = nullptr;
+	return E_NOTIMPL;
+}
+
+uint32_t FakeDevice::GetCommandAllocatorCount() const
+{
+	return mCommandAllocatorCount.load(std::memory_order_relaxed);
+}
+
+uint32_t FakeDevice::GetCommandListCount() const
+{
+	return mCommandListCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// D3D12 objects that run on the CPU, for testing the engine without a GPU.
+//
+// The command queue plays the GPU: a fence signal it receives completes
+// right away, or, with auto-complete off, once the test calls
+// CompleteSignals. Misuse that the debug layer would report, like
+// resetting a command allocator whose work hasn't finished, is collected
+// and returned by TakeFakeErrors.
+
+// The misuse found since the last call.
+std::vector<std::string> TakeFakeErrors();
+void ReportFakeError(const std::string& error);
+
+// Fake objects that haven't been released yet, to find leaked references.
+int GetLiveFakeObjectCount();
+void AddLiveFakeObjects(int count);
+
+// Reference counting, QueryInterface and private data of a fake that
+// implements Interface. Bases are the interfaces Interface derives from,
+// which QueryInterface answers to as well.
+template<typename Interface, typename... Bases>
+class FakeObject : public Interface
+{
+public:
+	FakeObject();
+	virtual ~FakeObject();
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+	{
+		if (riid == StubUuidOf<Interface>() || ((riid == StubUuidOf<Bases>()) || ...) || riid == StubUuidOf<IUnknown>())
+		{
+			AddRef();
+			*ppvObject = static_cast<Interface*>(this);
+			return S_OK;
+		}
+
+		*ppvObject = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return mRefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		ULONG refCount = mRefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+		if (refCount == 0)
+		{
+			delete this;
+		}
+		return refCount;
+	}
+
+	HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override;
+	HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* pData) override;
+	HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override;
+
+	HRESULT STDMETHODCALLTYPE SetName(LPCWSTR name) override
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mName = name;
+		return S_OK;
+	}
+
+	std::wstring GetName()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mName;
+	}
+
+protected:
+	std::mutex mMutex;
+
+private:
+	struct PrivateData
+	{
+		GUID Guid;
+		std::vector<BYTE> Data;
+		ComPtr<IUnknown> Object;
+	};
+
+	PrivateData* FindPrivateData(REFGUID guid);
+
+	std::atomic<ULONG> mRefCount;
+	std::vector<PrivateData> mPrivateData;
+	std::wstring mName;
+};
+
+template<typename Interface, typename... Bases>
+FakeObject<Interface, Bases...>::FakeObject()
+	: mRefCount(1)
+{
+	AddLiveFakeObjects(1);
+}
+
+template<typename Interface, typename... Bases>
+FakeObject<Interface, Bases...>::~FakeObject()
+{
+	AddLiveFakeObjects(-1);
+}
+
+template<typename Interface, typename... Bases>
+typename FakeObject<Interface, Bases...>::PrivateData* FakeObject<Interface, Bases...>::FindPrivateData(REFGUID guid)
+{
+	for (PrivateData& privateData : mPrivateData)
+	{
+		if (privateData.Guid == guid)
+		{
+			return &privateData;
+		}
+	}
+	return nullptr;
+}
+
+template<typename Interface, typename... Bases>
+HRESULT FakeObject<Interface, Bases...>::GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	PrivateData* privateData = FindPrivateData(guid);
+	if (!privateData)
+	{
+		*pDataSize = 0;
+		return E_FAIL;
+	}
+
+	// Interfaces are returned with a new reference, like D3D12 does.
+	UINT size = privateData->Object ? sizeof(IUnknown*) : static_cast<UINT>(privateData->Data.size());
+	if (!pData)
+	{
+		*pDataSize = size;
+		return S_OK;
+	}
+	if (*pDataSize < size)
+	{
+		return E_INVALIDARG;
+	}
+
+	*pDataSize = size;
+	if (privateData->Object)
+	{
+		privateData->Object.CopyTo(static_cast<IUnknown**>(pData));
+	}
+	else
+	{
+		std::memcpy(pData, privateData->Data.data(), size);
+	}
+	return S_OK;
+}
+
+template<typename Interface, typename... Bases>
+HRESULT FakeObject<Interface, Bases...>::SetPrivateData(REFGUID guid, UINT dataSize, const void* pData)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	PrivateData* privateData = FindPrivateData(guid);
+	if (!privateData)
+	{
+		mPrivateData.push_back(PrivateData{ guid });
+		privateData = &mPrivateData.back();
+	}
+
+	const BYTE* bytes = static_cast<const BYTE*>(pData);
+	privateData->Data.assign(bytes, bytes + dataSize);
+	privateData->Object = nullptr;
+	return S_OK;
+}
+
+template<typename Interface, typename... Bases>
+HRESULT FakeObject<Interface, Bases...>::SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	PrivateData* privateData = FindPrivateData(guid);
+	if (!privateData)
+	{
+		mPrivateData.push_back(PrivateData{ guid });
+		privateData = &mPrivateData.back();
+	}
+
+	privateData->Data.clear();
+	privateData->Object = const_cast<IUnknown*>(pData);
+	return S_OK;
+}
+
+class FakeFence : public FakeObject<ID3D12Fence, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	explicit FakeFence(UINT64 initialValue = 0);
+
+	UINT64 STDMETHODCALLTYPE GetCompletedValue() override;
+	HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 value, HANDLE hEvent) override;
+	// Set the completed value from the CPU.
+	HRESULT STDMETHODCALLTYPE Signal(UINT64 value) override;
+
+	// Events set with SetEventOnCompletion that are still waiting.
+	size_t GetPendingEventCount();
+
+private:
+	std::atomic<UINT64> mCompletedValue;
+	std::vector<std::pair<UINT64, HANDLE>> mEvents;
+};
+
+class FakeCommandAllocator : public FakeObject<ID3D12CommandAllocator, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	FakeCommandAllocator();
+
+	// Fails if command lists recorded with it haven't finished on the GPU.
+	HRESULT STDMETHODCALLTYPE Reset() override;
+
+	// Called by the queue: the allocator's commands were submitted, and the
+	// fence signal that follows them.
+	void Submit();
+	void SubmitSignal(ComPtr<ID3D12Fence> fence, UINT64 value);
+
+	uint32_t GetResetCount();
+
+private:
+	uint32_t mResetCount;
+	// Submitted, but no fence signal has been submitted after it yet.
+	bool mUnsignaled;
+	ComPtr<ID3D12Fence> mFence;
+	UINT64 mFenceValue;
+};
+
+class FakeCommandList : public FakeObject<ID3D12GraphicsCommandList2, ID3D12GraphicsCommandList1,
+	ID3D12GraphicsCommandList, ID3D12CommandList, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	explicit FakeCommandList(ComPtr<FakeCommandAllocator> allocator);
+
+	HRESULT STDMETHODCALLTYPE Close() override;
+	HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) override;
+	void STDMETHODCALLTYPE ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) override;
+	void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion) override;
+
+	bool IsClosed();
+	ComPtr<FakeCommandAllocator> GetAllocator();
+
+	// What was recorded since the last Reset. Each ResourceBarrier call is
+	// one entry.
+	std::vector<std::vector<D3D12_RESOURCE_BARRIER>> GetBarrierCalls();
+	std::vector<ID3D12Resource*> GetDiscards();
+
+private:
+	bool CheckRecording(const char* method);
+
+	ComPtr<FakeCommandAllocator> mAllocator;
+	bool mClosed;
+	std::vector<std::vector<D3D12_RESOURCE_BARRIER>> mBarrierCalls;
+	std::vector<ID3D12Resource*> mDiscards;
+};
+
+class FakeCommandQueue : public FakeObject<ID3D12CommandQueue, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	struct Call
+	{
+		enum Type
+		{
+			Execute,
+			Signal,
+			Wait,
+		};
+
+		Type CallType;
+		// For Execute.
+		std::vector<ID3D12CommandList*> CommandLists;
+		// For Signal and Wait.
+		ID3D12Fence* Fence;
+		UINT64 Value;
+	};
+
+	FakeCommandQueue();
+
+	void STDMETHODCALLTYPE ExecuteCommandLists(UINT numCommandLists, ID3D12CommandList* const* ppCommandLists) override;
+	HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 value) override;
+	// Only recorded; the fake GPU never waits.
+	HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence* pFence, UINT64 value) override;
+
+	// With auto-complete off, fence signals wait for CompleteSignals, like
+	// work that is still running on the GPU.
+	void SetAutoComplete(bool autoComplete);
+	void CompleteSignals();
+
+	std::vector<Call> GetCalls();
+
+private:
+	bool mAutoComplete;
+	std::vector<Call> mCalls;
+	std::vector<ComPtr<FakeCommandAllocator>> mUnsignaledAllocators;
+	std::vector<std::pair<ComPtr<ID3D12Fence>, UINT64>> mPendingSignals;
+};
+
+// Only holds private data, like the hash PipelineStateCache stores with it.
+class FakeRootSignature : public FakeObject<ID3D12RootSignature, ID3D12DeviceChild, ID3D12Object>
+{
+};
+
+class FakeHeap : public FakeObject<ID3D12Heap, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	explicit FakeHeap(const D3D12_HEAP_DESC& desc);
+
+	const D3D12_HEAP_DESC& GetDesc() const;
+
+private:
+	D3D12_HEAP_DESC mDesc;
+};
+
+class FakeResource : public FakeObject<ID3D12Resource, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>
+{
+public:
+	FakeResource();
+	FakeResource(const D3D12_RESOURCE_DESC& desc, ComPtr<FakeHeap> heap, UINT64 heapOffset);
+
+	const D3D12_RESOURCE_DESC& GetDesc() const;
+	ComPtr<FakeHeap> GetHeap() const;
+	UINT64 GetHeapOffset() const;
+
+private:
+	D3D12_RESOURCE_DESC mDesc;
+	ComPtr<FakeHeap> mHeap;
+	UINT64 mHeapOffset;
+};
+
+class FakeDevice : public FakeObject<ID3D12Device2, ID3D12Device1, ID3D12Device, ID3D12Object>
+{
+public:
+	FakeDevice();
+
+	HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override;
+	HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator) override;
+	HRESULT STDMETHODCALLTYPE CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type,
+		ID3D12CommandAllocator* pCommandAllocator, ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList) override;
+	HRESULT STDMETHODCALLTYPE CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** ppFence) override;
+	// Four bytes per texel, in 64 KiB pages.
+	D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT visibleMask,
+		UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) override;
+	HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override;
+	HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap* pHeap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* pDesc,
+		D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) override;
+	// Nothing compiles pipelines, so these fail with E_NOTIMPL.
+	HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T blobLength,
+		REFIID riid, void** ppPipelineLibrary) override;
+	HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc,
+		REFIID riid, void** ppPipelineState) override;
+
+	// Objects created so far.
+	uint32_t GetCommandAllocatorCount() const;
+	uint32_t GetCommandListCount() const;
+
+private:
+	std::atomic<uint32_t> mCommandAllocatorCount;
+	std::atomic<uint32_t> mCommandListCount;
+};
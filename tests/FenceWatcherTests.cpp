@@ -0,0 +1,144 @@
+#include "FakeD3D12.h"
+#include "FenceWatcher.h"
+#include "Test.h"
+
+#include <condition_variable>
+#include <memory>
+#include <thread>
+
+// Collects the callbacks that ran, in the order they ran.
+class CallbackLog
+{
+public:
+	FenceWatcher::Callback Add(int id)
+	{
+		return [this, id]()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIds.push_back(id);
+			mThreads.push_back(std::this_thread::get_id());
+			mCondition.notify_all();
+		};
+	}
+
+	// Wait until count callbacks have run, and return their ids.
+	std::vector<int> WaitFor(size_t count)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCondition.wait_for(lock, std::chrono::seconds(10), [this, count]() { return mIds.size() >= count; });
+		return mIds;
+	}
+
+	std::vector<std::thread::id> GetThreads()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mThreads;
+	}
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<int> mIds;
+	std::vector<std::thread::id> mThreads;
+};
+
+static ComPtr<FakeFence> CreateFakeFence(UINT64 initialValue = 0)
+{
+	ComPtr<FakeFence> fence;
+	fence.Attach(new FakeFence(initialValue));
+	return fence;
+}
+
+TEST(CallbacksRunInFenceOrder)
+{
+	ComPtr<FakeFence> fence = CreateFakeFence();
+	CallbackLog log;
+	{
+		FenceWatcher fenceWatcher(fence);
+		fenceWatcher.AddCallback(3, log.Add(3));
+		fenceWatcher.AddCallback(1, log.Add(1));
+		fenceWatcher.AddCallback(2, log.Add(20));
+		fenceWatcher.AddCallback(2, log.Add(21));
+
+		fence->Signal(1);
+		CHECK(log.WaitFor(1) == std::vector<int>({ 1 }));
+
+		// Callbacks for the same value run in the order they were added.
+		fence->Signal(3);
+		CHECK(log.WaitFor(4) == std::vector<int>({ 1, 20, 21, 3 }));
+		CHECK_EQUAL(0u, fenceWatcher.GetPendingCount());
+	}
+
+	for (std::thread::id thread : log.GetThreads())
+	{
+		CHECK(thread != std::this_thread::get_id());
+	}
+	fence = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(CallbackForCompletedValueRunsRightAway)
+{
+	ComPtr<FakeFence> fence = CreateFakeFence(5);
+	CallbackLog log;
+	{
+		FenceWatcher fenceWatcher(fence);
+		fenceWatcher.AddCallback(5, log.Add(5));
+		fenceWatcher.AddCallback(2, log.Add(2));
+
+		// Already run, on this thread, before AddCallback returned.
+		CHECK(log.GetThreads() == std::vector<std::thread::id>(2, std::this_thread::get_id()));
+		CHECK(log.WaitFor(2) == std::vector<int>({ 5, 2 }));
+		CHECK_EQUAL(0u, fenceWatcher.GetPendingCount());
+		CHECK_EQUAL(0u, fence->GetPendingEventCount());
+	}
+
+	fence = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(CallbackCanAddCallbacks)
+{
+	ComPtr<FakeFence> fence = CreateFakeFence();
+	CallbackLog log;
+	{
+		FenceWatcher fenceWatcher(fence);
+		FenceWatcher::Callback second = log.Add(2);
+		FenceWatcher::Callback first = log.Add(1);
+		fenceWatcher.AddCallback(1, [&]()
+		{
+			first();
+			fenceWatcher.AddCallback(2, second);
+		});
+
+		fence->Signal(2);
+		CHECK(log.WaitFor(2) == std::vector<int>({ 1, 2 }));
+	}
+
+	fence = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(ShutdownDropsCallbacksThatAreStillPending)
+{
+	ComPtr<FakeFence> fence = CreateFakeFence();
+	CallbackLog log;
+	auto captured = std::make_shared<int>(0);
+	{
+		FenceWatcher fenceWatcher(fence);
+		fenceWatcher.AddCallback(1, [&log, captured]() { log.Add(1)(); });
+		fenceWatcher.AddCallback(2, [&log, captured]() { log.Add(2)(); });
+		CHECK_EQUAL(2u, fenceWatcher.GetPendingCount());
+		CHECK_EQUAL(3, captured.use_count());
+
+		// The first callback runs, on the waiter thread or during shutdown.
+		fence->Signal(1);
+	}
+
+	CHECK(log.WaitFor(1) == std::vector<int>({ 1 }));
+	// What the dropped callback captured is released.
+	CHECK_EQUAL(1, captured.use_count());
+
+	fence = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
@@ -0,0 +1,125 @@
+#include "FramePipeline.h"
+#include "Test.h"
+
+#include <chrono>
+#include <future>
+
+using namespace std::chrono_literals;
+
+// Long enough for a thread that isn't blocked to get through.
+static const auto BlockedTimeout = 50ms;
+
+template<typename T>
+static bool IsBlocked(std::future<T>& future)
+{
+	return future.wait_for(BlockedTimeout) == std::future_status::timeout;
+}
+
+TEST(FramesUseTheSlotOfTheirFrameNumber)
+{
+	FramePipeline pipeline(3);
+	CHECK_EQUAL(3u, pipeline.GetDepth());
+
+	// Update two frames ahead, then keep the render thread one behind.
+	for (uint32_t frame = 0; frame < 2; ++frame)
+	{
+		CHECK_EQUAL(frame % 3, pipeline.BeginUpdate());
+		pipeline.EndUpdate();
+	}
+	for (uint32_t frame = 0; frame < 10; ++frame)
+	{
+		CHECK_EQUAL((frame + 2) % 3, pipeline.BeginUpdate());
+		pipeline.EndUpdate();
+		CHECK_EQUAL(frame % 3, pipeline.BeginRender());
+		pipeline.EndRender();
+	}
+
+	CHECK_EQUAL(12u, pipeline.GetUpdatedFrameCount());
+	CHECK_EQUAL(10u, pipeline.GetRenderedFrameCount());
+}
+
+TEST(UpdatesStayAtMostDepthFramesAhead)
+{
+	FramePipeline pipeline(2);
+	CHECK_EQUAL(0u, pipeline.TryBeginUpdate());
+	pipeline.EndUpdate();
+	CHECK_EQUAL(1u, pipeline.TryBeginUpdate());
+	pipeline.EndUpdate();
+	CHECK_EQUAL(FramePipeline::InvalidSlot, pipeline.TryBeginUpdate());
+
+	// The slot of the frame being rendered is still in use.
+	CHECK_EQUAL(0u, pipeline.BeginRender());
+	CHECK_EQUAL(FramePipeline::InvalidSlot, pipeline.TryBeginUpdate());
+	pipeline.EndRender();
+	CHECK_EQUAL(0u, pipeline.TryBeginUpdate());
+	pipeline.EndUpdate();
+
+	// A depth of 0 is treated as 1: update and render take turns.
+	FramePipeline single(0);
+	CHECK_EQUAL(1u, single.GetDepth());
+	CHECK_EQUAL(0u, single.TryBeginUpdate());
+	single.EndUpdate();
+	CHECK_EQUAL(FramePipeline::InvalidSlot, single.TryBeginUpdate());
+	CHECK_EQUAL(0u, single.BeginRender());
+	single.EndRender();
+	CHECK_EQUAL(0u, single.TryBeginUpdate());
+	single.EndUpdate();
+}
+
+TEST(BeginUpdateWaitsForAFreeSlot)
+{
+	FramePipeline pipeline(1);
+	pipeline.BeginUpdate();
+	pipeline.EndUpdate();
+
+	std::future<uint32_t> update = std::async(std::launch::async, [&pipeline]() { return pipeline.BeginUpdate(); });
+	CHECK(IsBlocked(update));
+
+	CHECK_EQUAL(0u, pipeline.BeginRender());
+	CHECK(IsBlocked(update));
+	pipeline.EndRender();
+	CHECK_EQUAL(0u, update.get());
+	pipeline.EndUpdate();
+}
+
+TEST(BeginRenderWaitsForAPublishedFrame)
+{
+	FramePipeline pipeline(2);
+	std::future<uint32_t> render = std::async(std::launch::async, [&pipeline]() { return pipeline.BeginRender(); });
+	CHECK(IsBlocked(render));
+
+	// A frame that is being updated isn't published yet.
+	CHECK_EQUAL(0u, pipeline.BeginUpdate());
+	CHECK(IsBlocked(render));
+	pipeline.EndUpdate();
+	CHECK_EQUAL(0u, render.get());
+	pipeline.EndRender();
+}
+
+TEST(StopWakesBlockedCallers)
+{
+	FramePipeline full(1);
+	full.BeginUpdate();
+	full.EndUpdate();
+	FramePipeline empty(1);
+
+	std::future<uint32_t> update = std::async(std::launch::async, [&full]() { return full.BeginUpdate(); });
+	std::future<uint32_t> render = std::async(std::launch::async, [&empty]() { return empty.BeginRender(); });
+	CHECK(IsBlocked(update));
+	CHECK(IsBlocked(render));
+
+	full.Stop();
+	empty.Stop();
+	CHECK_EQUAL(FramePipeline::InvalidSlot, update.get());
+	CHECK_EQUAL(FramePipeline::InvalidSlot, render.get());
+	CHECK(full.IsStopped());
+	CHECK(empty.IsStopped());
+
+	// Once stopped, nothing is handed out anymore, not even the frame that
+	// was published but not rendered.
+	CHECK_EQUAL(FramePipeline::InvalidSlot, full.BeginRender());
+	CHECK_EQUAL(FramePipeline::InvalidSlot, empty.TryBeginUpdate());
+	CHECK_EQUAL(FramePipeline::InvalidSlot, empty.BeginUpdate());
+	CHECK_EQUAL(1u, full.GetUpdatedFrameCount());
+	CHECK_EQUAL(0u, full.GetRenderedFrameCount());
+}
@@ -0,0 +1,132 @@
+#include "FrameScheduler.h"
+#include "Test.h"
+
+using namespace std::chrono_literals;
+
+using Duration = FrameScheduler::Duration;
+
+// 100 frames per second, so frames are due every 10 ms.
+static const double FrameRate = 100.0;
+
+TEST(FirstFrameStartsTheCadence)
+{
+	Duration now = 1000ms;
+	FrameScheduler scheduler(FrameRate, [&now]() { return now; });
+
+	// Nothing to pace against before the first frame.
+	CHECK(scheduler.IsFrameDue());
+	CHECK_EQUAL(Duration(0).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	scheduler.BeginFrame();
+	CHECK_EQUAL(Duration(10ms).count(), scheduler.GetTimeUntilNextFrame().count());
+	CHECK(!scheduler.IsFrameDue());
+
+	now += 4ms;
+	CHECK_EQUAL(Duration(6ms).count(), scheduler.GetTimeUntilNextFrame().count());
+	CHECK(!scheduler.IsFrameDue());
+
+	now += 6ms;
+	CHECK(scheduler.IsFrameDue());
+	// Never negative once the frame is late.
+	now += 3ms;
+	CHECK_EQUAL(Duration(0).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	CHECK_EQUAL(1u, scheduler.GetFrameCount());
+	CHECK_EQUAL(0u, scheduler.GetMissedFrameCount());
+}
+
+TEST(LateAndEarlyFramesKeepTheCadence)
+{
+	Duration now = 0ms;
+	FrameScheduler scheduler(FrameRate, [&now]() { return now; });
+	scheduler.BeginFrame();
+
+	// 3 ms late. The next frame is still due at 20 ms, not 23 ms.
+	now = 13ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(Duration(7ms).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	// Started early, at 15 ms. The one after is due at 30 ms.
+	now = 15ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(Duration(15ms).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	// Just under a whole interval late is still caught up.
+	now = 39ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(Duration(1ms).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	CHECK_EQUAL(4u, scheduler.GetFrameCount());
+	CHECK_EQUAL(0u, scheduler.GetMissedFrameCount());
+}
+
+TEST(FrameLateByAWholeIntervalIsMissed)
+{
+	Duration now = 0ms;
+	FrameScheduler scheduler(FrameRate, [&now]() { return now; });
+	scheduler.BeginFrame();
+
+	// Due at 10 ms, started at 20 ms. Catching up would start the next frame
+	// right away, so the cadence restarts from now instead.
+	now = 20ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(1u, scheduler.GetMissedFrameCount());
+	CHECK_EQUAL(Duration(10ms).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	// The new cadence is kept like the old one.
+	now = 35ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(1u, scheduler.GetMissedFrameCount());
+	CHECK_EQUAL(Duration(5ms).count(), scheduler.GetTimeUntilNextFrame().count());
+
+	// Several intervals late still counts as one missed frame.
+	now = 100ms;
+	scheduler.BeginFrame();
+	CHECK_EQUAL(2u, scheduler.GetMissedFrameCount());
+	CHECK_EQUAL(Duration(10ms).count(), scheduler.GetTimeUntilNextFrame().count());
+	CHECK_EQUAL(4u, scheduler.GetFrameCount());
+}
+
+TEST(ResetStartsANewCadence)
+{
+	Duration now = 0ms;
+	FrameScheduler scheduler(FrameRate, [&now]() { return now; });
+	scheduler.BeginFrame();
+	now = 10ms;
+	scheduler.BeginFrame();
+
+	scheduler.Reset();
+	CHECK(scheduler.IsFrameDue());
+
+	// Being idle for a long time isn't a missed frame.
+	now = 1234ms;
+	CHECK(scheduler.IsFrameDue());
+	scheduler.BeginFrame();
+	CHECK_EQUAL(0u, scheduler.GetMissedFrameCount());
+	CHECK_EQUAL(Duration(10ms).count(), scheduler.GetTimeUntilNextFrame().count());
+	// The counters keep counting.
+	CHECK_EQUAL(3u, scheduler.GetFrameCount());
+
+	// Changing the frame rate starts a new cadence too.
+	now = 1300ms;
+	scheduler.SetTargetFrameRate(50.0);
+	CHECK_EQUAL(50.0, scheduler.GetTargetFrameRate());
+	CHECK(scheduler.IsFrameDue());
+	scheduler.BeginFrame();
+	CHECK_EQUAL(0u, scheduler.GetMissedFrameCount());
+	CHECK_EQUAL(Duration(20ms).count(), scheduler.GetTimeUntilNextFrame().count());
+}
+
+TEST(ZeroFrameRateRunsFramesBackToBack)
+{
+	Duration now = 0ms;
+	FrameScheduler scheduler(0.0, [&now]() { return now; });
+	for (int i = 0; i < 3; ++i)
+	{
+		scheduler.BeginFrame();
+		CHECK(scheduler.IsFrameDue());
+		now += 100ms;
+	}
+	CHECK_EQUAL(3u, scheduler.GetFrameCount());
+	CHECK_EQUAL(0u, scheduler.GetMissedFrameCount());
+}
@@ -0,0 +1,207 @@
+#include "FrameStatistics.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using FrameTime = FrameStatistics::FrameTime;
+
+// Frames with the given CPU times and no GPU times.
+static std::vector<FrameTime> CPUFrames(const std::vector<double>& cpuTimes)
+{
+	std::vector<FrameTime> frames;
+	for (size_t i = 0; i < cpuTimes.size(); ++i)
+	{
+		frames.push_back(FrameTime{ i, cpuTimes[i], 0.0 });
+	}
+	return frames;
+}
+
+TEST(PercentilesAreNearestRank)
+{
+	// 1 to 100 ms, in random order.
+	std::vector<double> times;
+	for (int i = 1; i <= 100; ++i)
+	{
+		times.push_back(i);
+	}
+	std::shuffle(times.begin(), times.end(), std::mt19937(3));
+
+	FrameStatistics::Report report = FrameStatistics::ComputeReport(CPUFrames(times));
+	CHECK_EQUAL(100u, report.NumFrames);
+	CHECK_EQUAL(50.5, report.CPU.Mean);
+	CHECK_EQUAL(50.0, report.CPU.P50);
+	CHECK_EQUAL(95.0, report.CPU.P95);
+	CHECK_EQUAL(99.0, report.CPU.P99);
+	CHECK_EQUAL(100.0, report.CPU.Max);
+
+	// The rank is ceil(p / 100 * n): with 10 frames P95 is the 10th.
+	report = FrameStatistics::ComputeReport(CPUFrames({ 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 }));
+	CHECK_EQUAL(5.0, report.CPU.P50);
+	CHECK_EQUAL(10.0, report.CPU.P95);
+	CHECK_EQUAL(10.0, report.CPU.P99);
+
+	// A single frame is every percentile.
+	report = FrameStatistics::ComputeReport(CPUFrames({ 16.0 }));
+	CHECK_EQUAL(16.0, report.CPU.P50);
+	CHECK_EQUAL(16.0, report.CPU.P99);
+	CHECK_EQUAL(16.0, report.CPU.Max);
+
+	report = FrameStatistics::ComputeReport({});
+	CHECK_EQUAL(0u, report.NumFrames);
+	CHECK_EQUAL(0.0, report.CPU.Mean);
+	CHECK_EQUAL(0.0, report.CPU.P50);
+	CHECK(report.Hitches.empty());
+}
+
+TEST(HistogramClampsTimesOutsideItsRange)
+{
+	// Buckets of 2 ms: [0, 2), [2, 4), [4, 6) and [6, inf).
+	FrameStatistics::Report report = FrameStatistics::ComputeReport(
+		CPUFrames({ -1.0, 0.0, 1.9, 2.0, 7.9, 8.0, 1000.0 }), 2.0, 2.0, 4);
+	CHECK_EQUAL(2.0, report.BucketWidth);
+	CHECK(report.CPUHistogram == std::vector<uint32_t>({ 3, 1, 0, 3 }));
+	// Unmeasured GPU times count as 0.
+	CHECK(report.GPUHistogram == std::vector<uint32_t>({ 7, 0, 0, 0 }));
+}
+
+TEST(HitchesAreSlowerThanFactorTimesTheMedian)
+{
+	std::vector<FrameTime> frames;
+	for (uint64_t i = 0; i < 10; ++i)
+	{
+		frames.push_back(FrameTime{ i, 10.0, 5.0 });
+	}
+	// Exactly twice the median isn't a hitch, more is.
+	frames[3].CPUTime = 20.0;
+	frames[5].CPUTime = 20.5;
+	frames[7].GPUTime = 10.5;
+
+	FrameStatistics::Report report = FrameStatistics::ComputeReport(frames, 2.0);
+	CHECK_EQUAL(2.0, report.HitchFactor);
+	CHECK_EQUAL(2u, report.Hitches.size());
+	if (report.Hitches.size() == 2)
+	{
+		CHECK_EQUAL(5u, report.Hitches[0].Frame);
+		CHECK_EQUAL(7u, report.Hitches[1].Frame);
+	}
+
+	report = FrameStatistics::ComputeReport(frames, 1.9);
+	CHECK_EQUAL(3u, report.Hitches.size());
+
+	// Without GPU times, only CPU times can make a hitch.
+	report = FrameStatistics::ComputeReport(CPUFrames({ 10, 10, 10, 30 }), 2.0);
+	CHECK_EQUAL(1u, report.Hitches.size());
+}
+
+TEST(CSVHasAHeaderAndALinePerFrame)
+{
+	std::ostringstream stream;
+	FrameStatistics::WriteCSV(stream, { FrameTime{ 1, 16.5, 8.25 }, FrameTime{ 2, 17.0, 0.0 } });
+	CHECK_EQUAL(std::string("frame,cpu_ms,gpu_ms\n1,16.5,8.25\n2,17,0\n"), stream.str());
+
+	std::ostringstream empty;
+	FrameStatistics::WriteCSV(empty, {});
+	CHECK_EQUAL(std::string("frame,cpu_ms,gpu_ms\n"), empty.str());
+}
+
+TEST(JSONReport)
+{
+	std::vector<FrameTime> frames = { FrameTime{ 1, 2.0, 1.0 }, FrameTime{ 2, 2.0, 1.0 }, FrameTime{ 3, 5.0, 1.0 } };
+
+	std::ostringstream stream;
+	FrameStatistics::WriteJSON(stream, FrameStatistics::ComputeReport(frames, 2.0, 2.0, 4));
+	CHECK_EQUAL(std::string(
+		"{\n"
+		"  \"frames\": 3,\n"
+		"  \"cpu_ms\": { \"mean\": 3, \"p50\": 2, \"p95\": 5, \"p99\": 5, \"max\": 5 },\n"
+		"  \"gpu_ms\": { \"mean\": 1, \"p50\": 1, \"p95\": 1, \"p99\": 1, \"max\": 1 },\n"
+		"  \"histogram_bucket_ms\": 2,\n"
+		"  \"cpu_histogram\": [0, 2, 1, 0],\n"
+		"  \"gpu_histogram\": [3, 0, 0, 0],\n"
+		"  \"hitch_factor\": 2,\n"
+		"  \"hitches\": [\n"
+		"    { \"frame\": 3, \"cpu_ms\": 5, \"gpu_ms\": 1 }\n"
+		"  ]\n"
+		"}\n"), stream.str());
+
+	std::ostringstream noHitches;
+	FrameStatistics::WriteJSON(noHitches, FrameStatistics::ComputeReport(frames, 3.0, 2.0, 4));
+	CHECK(noHitches.str().find("  \"hitches\": []\n}\n") != std::string::npos);
+}
+
+TEST(RingKeepsTheLatestFrames)
+{
+	FrameStatistics statistics(4);
+	CHECK_EQUAL(4u, statistics.GetCapacity());
+	CHECK(statistics.GetFrames().empty());
+
+	for (uint64_t frame = 0; frame < 6; ++frame)
+	{
+		statistics.AddFrame(frame, frame * 1.0, frame * 0.5);
+	}
+	CHECK_EQUAL(6u, statistics.GetFrameCount());
+
+	std::vector<FrameTime> frames = statistics.GetFrames();
+	CHECK_EQUAL(4u, frames.size());
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		CHECK_EQUAL(i + 2, frames[i].Frame);
+		CHECK_EQUAL((i + 2) * 1.0, frames[i].CPUTime);
+		CHECK_EQUAL((i + 2) * 0.5, frames[i].GPUTime);
+	}
+	CHECK_EQUAL(4u, statistics.GetReport().NumFrames);
+
+	FrameStatistics single(0);
+	CHECK_EQUAL(1u, single.GetCapacity());
+}
+
+// Readers copy the ring while it is written. Every frame they get must be
+// one that was added, never a mix of two, and in order.
+TEST(ReadersNeverSeeTornFrames)
+{
+	const uint64_t numFrames = 200000;
+	FrameStatistics statistics(64);
+	std::atomic<bool> done(false);
+
+	std::vector<std::thread> readers;
+	std::atomic<uint64_t> framesRead(0);
+	for (int i = 0; i < 3; ++i)
+	{
+		readers.emplace_back([&]()
+		{
+			while (!done.load(std::memory_order_acquire))
+			{
+				std::vector<FrameTime> frames = statistics.GetFrames();
+				CHECK(frames.size() <= statistics.GetCapacity());
+				for (size_t j = 0; j < frames.size(); ++j)
+				{
+					CHECK_EQUAL(static_cast<double>(frames[j].Frame), frames[j].CPUTime);
+					CHECK_EQUAL(frames[j].Frame * 2.0, frames[j].GPUTime);
+					CHECK(j == 0 || frames[j - 1].Frame < frames[j].Frame);
+				}
+				framesRead.fetch_add(frames.size(), std::memory_order_relaxed);
+			}
+		});
+	}
+
+	for (uint64_t frame = 0; frame < numFrames; ++frame)
+	{
+		statistics.AddFrame(frame, static_cast<double>(frame), frame * 2.0);
+	}
+	done.store(true, std::memory_order_release);
+	for (std::thread& reader : readers)
+	{
+		reader.join();
+	}
+
+	CHECK(framesRead.load() > 0);
+	CHECK_EQUAL(numFrames, statistics.GetFrameCount());
+	std::vector<FrameTime> frames = statistics.GetFrames();
+	CHECK_EQUAL(64u, frames.size());
+	CHECK_EQUAL(numFrames - 64, frames.front().Frame);
+}
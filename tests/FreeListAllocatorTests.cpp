@@ -0,0 +1,167 @@
+#include "FreeListAllocator.h"
+#include "Test.h"
+
+#include <random>
+#include <vector>
+
+TEST(AllocationsComeFromTheStart)
+{
+	FreeListAllocator allocator(100);
+	CHECK_EQUAL(0u, allocator.Allocate(10));
+	CHECK_EQUAL(10u, allocator.Allocate(20));
+	CHECK_EQUAL(30u, allocator.Allocate(30));
+
+	CHECK_EQUAL(100u, allocator.GetSize());
+	CHECK_EQUAL(40u, allocator.GetFreeCount());
+	CHECK_EQUAL(1u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(40u, allocator.GetLargestFreeRange());
+}
+
+TEST(FreedRangesAreCoalescedWithTheirNeighbours)
+{
+	FreeListAllocator allocator(100);
+	allocator.Allocate(10);
+	allocator.Allocate(20);
+	allocator.Allocate(30);
+
+	allocator.Free(10, 20);
+	CHECK_EQUAL(2u, allocator.GetFreeRangeCount());
+
+	// Merges with the next range.
+	allocator.Free(0, 10);
+	CHECK_EQUAL(2u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(40u, allocator.GetLargestFreeRange());
+
+	// Merges with the ranges on both sides.
+	allocator.Free(30, 30);
+	CHECK_EQUAL(1u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(100u, allocator.GetFreeCount());
+	CHECK_EQUAL(100u, allocator.GetLargestFreeRange());
+	CHECK_EQUAL(0u, allocator.Allocate(100));
+}
+
+TEST(AllocationIsABestFit)
+{
+	FreeListAllocator allocator(100);
+	allocator.Allocate(15);
+	allocator.Allocate(10);
+	allocator.Allocate(5);
+	allocator.Allocate(10);
+
+	// Free ranges of 15 at 0, 5 at 25 and 60 at 40.
+	allocator.Free(0, 15);
+	allocator.Free(25, 5);
+	CHECK_EQUAL(3u, allocator.GetFreeRangeCount());
+
+	CHECK_EQUAL(25u, allocator.Allocate(5));
+	CHECK_EQUAL(0u, allocator.Allocate(12));
+	CHECK_EQUAL(40u, allocator.Allocate(20));
+	// What is left of the first range is still the best fit.
+	CHECK_EQUAL(12u, allocator.Allocate(3));
+	CHECK_EQUAL(1u, allocator.GetFreeRangeCount());
+}
+
+TEST(AllocationFailsWhenNoRangeIsLargeEnough)
+{
+	FreeListAllocator allocator(100);
+	CHECK_EQUAL(FreeListAllocator::InvalidOffset, allocator.Allocate(0));
+	CHECK_EQUAL(FreeListAllocator::InvalidOffset, allocator.Allocate(101));
+
+	CHECK_EQUAL(0u, allocator.Allocate(100));
+	CHECK_EQUAL(FreeListAllocator::InvalidOffset, allocator.Allocate(1));
+	CHECK_EQUAL(0u, allocator.GetFreeCount());
+	CHECK_EQUAL(0u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(0u, allocator.GetLargestFreeRange());
+}
+
+TEST(FragmentedFreeSpace)
+{
+	FreeListAllocator allocator(100);
+	for (uint32_t i = 0; i < 10; ++i)
+	{
+		CHECK_EQUAL(i * 10, allocator.Allocate(10));
+	}
+
+	// Half of the slots are free, but only in ranges of 10.
+	for (uint32_t offset = 0; offset < 100; offset += 20)
+	{
+		allocator.Free(offset, 10);
+	}
+	CHECK_EQUAL(50u, allocator.GetFreeCount());
+	CHECK_EQUAL(5u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(10u, allocator.GetLargestFreeRange());
+	CHECK_EQUAL(FreeListAllocator::InvalidOffset, allocator.Allocate(20));
+
+	for (uint32_t offset = 10; offset < 100; offset += 20)
+	{
+		allocator.Free(offset, 10);
+	}
+	CHECK_EQUAL(1u, allocator.GetFreeRangeCount());
+	CHECK_EQUAL(100u, allocator.GetLargestFreeRange());
+}
+
+// Random allocations and frees, checked against a map of the used slots.
+TEST(RandomAllocationsDoNotOverlap)
+{
+	const uint32_t size = 1024;
+	FreeListAllocator allocator(size);
+	std::vector<bool> used(size, false);
+
+	struct Range
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+	std::vector<Range> ranges;
+
+	std::mt19937 random(12);
+	std::uniform_int_distribution<uint32_t> count(1, 64);
+	for (int i = 0; i < 10000; ++i)
+	{
+		if (ranges.empty() || random() % 3 != 0)
+		{
+			Range range{ 0, count(random) };
+			range.offset = allocator.Allocate(range.count);
+			if (range.offset == FreeListAllocator::InvalidOffset)
+			{
+				CHECK(allocator.GetLargestFreeRange() < range.count);
+				continue;
+			}
+
+			CHECK(range.offset + range.count <= size);
+			for (uint32_t slot = range.offset; slot < range.offset + range.count; ++slot)
+			{
+				CHECK(!used[slot]);
+				used[slot] = true;
+			}
+			ranges.push_back(range);
+		}
+		else
+		{
+			size_t index = random() % ranges.size();
+			Range range = ranges[index];
+			ranges[index] = ranges.back();
+			ranges.pop_back();
+
+			allocator.Free(range.offset, range.count);
+			for (uint32_t slot = range.offset; slot < range.offset + range.count; ++slot)
+			{
+				used[slot] = false;
+			}
+		}
+
+		uint32_t freeCount = 0;
+		uint32_t freeRangeCount = 0;
+		for (uint32_t slot = 0; slot < size; ++slot)
+		{
+			if (!used[slot])
+			{
+				++freeCount;
+				freeRangeCount += (slot == 0 || used[slot - 1]) ? 1 : 0;
+			}
+		}
+		CHECK_EQUAL(freeCount, allocator.GetFreeCount());
+		// Every free range is merged with its neighbours.
+		CHECK_EQUAL(freeRangeCount, allocator.GetFreeRangeCount());
+	}
+}
@@ -0,0 +1,277 @@
+#include "GraphicsCommandList.h"
+#include "Test.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Stands in for ID3D12GraphicsCommandList2 and records the name of every
+// call it receives.
+class RecordingCommandList
+{
+public:
+	void SetPipelineState(ID3D12PipelineState*) { Record("SetPipelineState"); }
+	void SetGraphicsRootSignature(ID3D12RootSignature*) { Record("SetGraphicsRootSignature"); }
+	void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) { Record("SetDescriptorHeaps"); }
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { Record("IASetPrimitiveTopology"); }
+	void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) { Record("IASetVertexBuffers"); }
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) { Record("IASetIndexBuffer"); }
+	void RSSetViewports(UINT, const D3D12_VIEWPORT*) { Record("RSSetViewports"); }
+	void RSSetScissorRects(UINT, const D3D12_RECT*) { Record("RSSetScissorRects"); }
+	void OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) { Record("OMSetRenderTargets"); }
+	void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) { Record("SetGraphicsRoot32BitConstants"); }
+	void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) { Record("SetGraphicsRootDescriptorTable"); }
+	void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { Record("SetGraphicsRootConstantBufferView"); }
+	void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { Record("SetGraphicsRootShaderResourceView"); }
+	void SetGraphicsRootUnorderedAccessView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { Record("SetGraphicsRootUnorderedAccessView"); }
+	void DrawInstanced(UINT, UINT, UINT, UINT) { Record("DrawInstanced"); }
+	void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) { Record("DrawIndexedInstanced"); }
+
+	// The calls received since the last TakeCalls.
+	std::vector<std::string> TakeCalls()
+	{
+		return std::move(mCalls);
+	}
+
+private:
+	void Record(const char* call)
+	{
+		mCalls.push_back(call);
+	}
+
+	std::vector<std::string> mCalls;
+};
+
+using RecordingGraphicsCommandList = GraphicsCommandListT<RecordingCommandList>;
+using Calls = std::vector<std::string>;
+
+// The wrapper only compares these pointers, so they don't have to point to
+// real objects.
+template<typename T>
+static T* FakePointer(uintptr_t value)
+{
+	return reinterpret_cast<T*>(value);
+}
+
+static D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle(UINT64 ptr)
+{
+	return D3D12_GPU_DESCRIPTOR_HANDLE{ ptr };
+}
+
+static void CheckStats(RecordingGraphicsCommandList& commandList, uint32_t issued, uint32_t elided)
+{
+	CHECK_EQUAL(issued, commandList.GetStats().Issued);
+	CHECK_EQUAL(elided, commandList.GetStats().Elided);
+}
+
+TEST(RedundantStateIsElided)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	ID3D12PipelineState* pipelineState = FakePointer<ID3D12PipelineState>(0x10);
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer = { 0x1000, 256, 16 };
+	D3D12_INDEX_BUFFER_VIEW indexBuffer = { 0x2000, 64, DXGI_FORMAT_R16_UINT };
+	D3D12_VIEWPORT viewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+	D3D12_RECT scissorRect = { 0, 0, 1280, 720 };
+	D3D12_CPU_DESCRIPTOR_HANDLE rtv = { 0x100 };
+	D3D12_CPU_DESCRIPTOR_HANDLE dsv = { 0x200 };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		commandList.SetPipelineState(pipelineState);
+		commandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		commandList.IASetVertexBuffers(0, 1, &vertexBuffer);
+		commandList.IASetIndexBuffer(&indexBuffer);
+		commandList.RSSetViewports(1, &viewport);
+		commandList.RSSetScissorRects(1, &scissorRect);
+		commandList.OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+	}
+	CHECK(recorder.TakeCalls() == Calls({ "SetPipelineState", "IASetPrimitiveTopology", "IASetVertexBuffers",
+		"IASetIndexBuffer", "RSSetViewports", "RSSetScissorRects", "OMSetRenderTargets" }));
+	CheckStats(commandList, 7, 7);
+
+	// Changing a value is issued.
+	viewport.Width = 640.0f;
+	commandList.RSSetViewports(1, &viewport);
+	commandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x20));
+	D3D12_CPU_DESCRIPTOR_HANDLE otherDsv = { 0x300 };
+	commandList.OMSetRenderTargets(1, &rtv, FALSE, &otherDsv);
+	CHECK(recorder.TakeCalls() == Calls({ "RSSetViewports", "IASetPrimitiveTopology", "SetPipelineState", "OMSetRenderTargets" }));
+	CheckStats(commandList, 11, 7);
+}
+
+TEST(NullViewsUnbind)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer = { 0x1000, 256, 16 };
+	D3D12_INDEX_BUFFER_VIEW indexBuffer = { 0x2000, 64, DXGI_FORMAT_R16_UINT };
+	commandList.IASetVertexBuffers(0, 1, &vertexBuffer);
+	commandList.IASetIndexBuffer(&indexBuffer);
+	commandList.IASetVertexBuffers(0, 1, nullptr);
+	commandList.IASetIndexBuffer(nullptr);
+	commandList.IASetVertexBuffers(0, 1, nullptr);
+	commandList.IASetIndexBuffer(nullptr);
+	CHECK(recorder.TakeCalls() == Calls({ "IASetVertexBuffers", "IASetIndexBuffer", "IASetVertexBuffers", "IASetIndexBuffer" }));
+	CheckStats(commandList, 4, 2);
+
+	// Binding more slots than were bound before is issued.
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffers[2] = { vertexBuffer, vertexBuffer };
+	commandList.IASetVertexBuffers(0, 1, vertexBuffers);
+	commandList.IASetVertexBuffers(0, 2, vertexBuffers);
+	commandList.IASetVertexBuffers(1, 1, vertexBuffers);
+	CHECK(recorder.TakeCalls() == Calls({ "IASetVertexBuffers", "IASetVertexBuffers" }));
+}
+
+TEST(RootArgumentsAreElidedPerParameter)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x10));
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	commandList.SetGraphicsRootDescriptorTable(2, GPUHandle(0x100));
+	commandList.SetGraphicsRootConstantBufferView(3, 0x4000);
+	commandList.SetGraphicsRootConstantBufferView(3, 0x4000);
+	commandList.SetGraphicsRootConstantBufferView(3, 0x4100);
+	CHECK(recorder.TakeCalls() == Calls({ "SetGraphicsRootSignature", "SetGraphicsRootDescriptorTable",
+		"SetGraphicsRootDescriptorTable", "SetGraphicsRootConstantBufferView", "SetGraphicsRootConstantBufferView" }));
+	CheckStats(commandList, 5, 2);
+
+	// Constants are compared per value, so setting a subset of the ones
+	// already bound is elided, and setting one more is not.
+	const uint32_t constants[4] = { 1, 2, 3, 4 };
+	commandList.SetGraphicsRoot32BitConstants(0, 3, constants, 0);
+	commandList.SetGraphicsRoot32BitConstants(0, 2, constants + 1, 1);
+	commandList.SetGraphicsRoot32BitConstant(0, 3, 2);
+	commandList.SetGraphicsRoot32BitConstant(0, 4, 3);
+	commandList.SetGraphicsRoot32BitConstant(0, 5, 3);
+	CHECK(recorder.TakeCalls() == Calls({ "SetGraphicsRoot32BitConstants", "SetGraphicsRoot32BitConstants",
+		"SetGraphicsRoot32BitConstants" }));
+	CheckStats(commandList, 8, 4);
+}
+
+TEST(RootSignatureChangeInvalidatesRootArguments)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	const uint32_t constant = 7;
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x10));
+	commandList.SetGraphicsRoot32BitConstants(0, 1, &constant, 0);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	recorder.TakeCalls();
+
+	// The same root signature keeps the arguments.
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x10));
+	commandList.SetGraphicsRoot32BitConstants(0, 1, &constant, 0);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	CHECK(recorder.TakeCalls().empty());
+
+	// Another one unbinds them, so the same arguments are issued again.
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x20));
+	commandList.SetGraphicsRoot32BitConstants(0, 1, &constant, 0);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	CHECK(recorder.TakeCalls() == Calls({ "SetGraphicsRootSignature", "SetGraphicsRoot32BitConstants",
+		"SetGraphicsRootDescriptorTable" }));
+	CheckStats(commandList, 6, 3);
+}
+
+TEST(DescriptorHeapChangeInvalidatesRootArguments)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	ID3D12DescriptorHeap* heaps[2] = { FakePointer<ID3D12DescriptorHeap>(0x10), FakePointer<ID3D12DescriptorHeap>(0x20) };
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x30));
+	commandList.SetDescriptorHeaps(2, heaps);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	recorder.TakeCalls();
+
+	// The same heaps keep the tables.
+	commandList.SetDescriptorHeaps(2, heaps);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	CHECK(recorder.TakeCalls().empty());
+
+	// Fewer heaps, or other heaps, unbind them. The root signature stays.
+	commandList.SetDescriptorHeaps(1, heaps);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	heaps[0] = FakePointer<ID3D12DescriptorHeap>(0x40);
+	commandList.SetDescriptorHeaps(1, heaps);
+	commandList.SetGraphicsRootDescriptorTable(1, GPUHandle(0x100));
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x30));
+	CHECK(recorder.TakeCalls() == Calls({ "SetDescriptorHeaps", "SetGraphicsRootDescriptorTable",
+		"SetDescriptorHeaps", "SetGraphicsRootDescriptorTable" }));
+	CheckStats(commandList, 7, 3);
+}
+
+TEST(InvalidateForgetsTheBoundState)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x10));
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x20));
+	commandList.SetGraphicsRootDescriptorTable(0, GPUHandle(0x100));
+	recorder.TakeCalls();
+
+	// State changed on the command list directly, e.g. by a table committed
+	// with the raw pointer, is unknown to the wrapper until it's invalidated.
+	commandList.Get()->SetGraphicsRootDescriptorTable(0, GPUHandle(0x200));
+	commandList.SetGraphicsRootDescriptorTable(0, GPUHandle(0x100));
+	CHECK(recorder.TakeCalls() == Calls({ "SetGraphicsRootDescriptorTable" }));
+
+	commandList.Invalidate();
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x10));
+	commandList.SetGraphicsRootSignature(FakePointer<ID3D12RootSignature>(0x20));
+	commandList.SetGraphicsRootDescriptorTable(0, GPUHandle(0x100));
+	CHECK(recorder.TakeCalls() == Calls({ "SetPipelineState", "SetGraphicsRootSignature", "SetGraphicsRootDescriptorTable" }));
+
+	// Invalidate keeps the counters.
+	CheckStats(commandList, 6, 1);
+}
+
+TEST(ResetClearsTheCounters)
+{
+	RecordingCommandList first;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&first);
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x10));
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x10));
+	CheckStats(commandList, 1, 1);
+
+	// A new command list starts with nothing bound.
+	RecordingCommandList second;
+	commandList.Reset(&second);
+	CHECK(commandList.Get() == &second);
+	CheckStats(commandList, 0, 0);
+	commandList.SetPipelineState(FakePointer<ID3D12PipelineState>(0x10));
+	CHECK(second.TakeCalls() == Calls({ "SetPipelineState" }));
+	CheckStats(commandList, 1, 0);
+}
+
+TEST(DrawsAreAlwaysForwarded)
+{
+	RecordingCommandList recorder;
+	RecordingGraphicsCommandList commandList;
+	commandList.Reset(&recorder);
+
+	commandList.DrawInstanced(3, 1, 0, 0);
+	commandList.DrawInstanced(3, 1, 0, 0);
+	commandList.DrawIndexedInstanced(36, 1, 0, 0, 0);
+	commandList.DrawIndexedInstanced(36, 1, 0, 0, 0);
+	CHECK(recorder.TakeCalls() == Calls({ "DrawInstanced", "DrawInstanced", "DrawIndexedInstanced", "DrawIndexedInstanced" }));
+
+	// Draws don't shadow state, so they aren't counted.
+	CheckStats(commandList, 0, 0);
+}
@@ -0,0 +1,104 @@
+#include "HandleAllocator.h"
+#include "Test.h"
+
+#include <set>
+
+using Handle = HandleAllocator::Handle;
+
+TEST(HandlesAreUniqueUntilTheAllocatorIsFull)
+{
+	HandleAllocator allocator(4);
+	std::set<uint32_t> indices;
+	for (int i = 0; i < 4; ++i)
+	{
+		Handle handle = allocator.Allocate();
+		CHECK(allocator.IsValid(handle));
+		CHECK_EQUAL(0u, HandleAllocator::GetGeneration(handle));
+		indices.insert(HandleAllocator::GetIndex(handle));
+	}
+	CHECK_EQUAL(4u, indices.size());
+	CHECK_EQUAL(4u, allocator.GetAllocatedCount());
+	CHECK_EQUAL(HandleAllocator::InvalidHandle, allocator.Allocate());
+	CHECK(!allocator.IsValid(HandleAllocator::InvalidHandle));
+}
+
+TEST(StaleHandlesAreRejected)
+{
+	HandleAllocator allocator(1);
+	Handle first = allocator.Allocate();
+	CHECK(allocator.Free(first));
+	CHECK(!allocator.IsValid(first));
+	CHECK_EQUAL(0u, allocator.GetAllocatedCount());
+
+	// Freeing twice fails and leaves the free list alone.
+	CHECK(!allocator.Free(first));
+	CHECK_EQUAL(0u, allocator.GetAllocatedCount());
+
+	// The slot is reused with the next generation; the old handle stays stale.
+	Handle second = allocator.Allocate();
+	CHECK_EQUAL(HandleAllocator::GetIndex(first), HandleAllocator::GetIndex(second));
+	CHECK_EQUAL(1u, HandleAllocator::GetGeneration(second));
+	CHECK(allocator.IsValid(second));
+	CHECK(!allocator.IsValid(first));
+	CHECK(!allocator.Free(first));
+	CHECK(allocator.IsValid(second));
+
+	CHECK(!allocator.Free(HandleAllocator::InvalidHandle));
+	CHECK_EQUAL(1u, allocator.GetAllocatedCount());
+}
+
+TEST(FreedSlotsAreReusedInFifoOrder)
+{
+	HandleAllocator allocator(3);
+	Handle a = allocator.Allocate();
+	Handle b = allocator.Allocate();
+	Handle c = allocator.Allocate();
+
+	allocator.Free(b);
+	allocator.Free(a);
+	allocator.Free(c);
+	CHECK_EQUAL(HandleAllocator::GetIndex(b), HandleAllocator::GetIndex(allocator.Allocate()));
+	CHECK_EQUAL(HandleAllocator::GetIndex(a), HandleAllocator::GetIndex(allocator.Allocate()));
+	CHECK_EQUAL(HandleAllocator::GetIndex(c), HandleAllocator::GetIndex(allocator.Allocate()));
+}
+
+TEST(HandleOfTheLastIndexIsNotInvalid)
+{
+	const uint32_t capacity = HandleAllocator::IndexMask;
+	HandleAllocator allocator(capacity);
+	Handle handle = HandleAllocator::InvalidHandle;
+	for (uint32_t i = 0; i < capacity; ++i)
+	{
+		handle = allocator.Allocate();
+	}
+	CHECK_EQUAL(capacity - 1, HandleAllocator::GetIndex(handle));
+	CHECK(handle != HandleAllocator::InvalidHandle);
+	CHECK(allocator.IsValid(handle));
+}
+
+TEST(GenerationWrapsAround)
+{
+	CHECK_EQUAL(20u, HandleAllocator::IndexBits);
+	CHECK_EQUAL(0xFFFu, HandleAllocator::GenerationMask);
+
+	HandleAllocator allocator(1);
+	Handle first = allocator.Allocate();
+	Handle handle = first;
+	for (uint32_t generation = 1; generation <= HandleAllocator::GenerationMask; ++generation)
+	{
+		CHECK(allocator.Free(handle));
+		handle = allocator.Allocate();
+		CHECK_EQUAL(generation, HandleAllocator::GetGeneration(handle));
+	}
+	CHECK_EQUAL(0xFFFu, HandleAllocator::GetGeneration(handle));
+	CHECK(!allocator.IsValid(first));
+
+	// After 2^12 reuses the generation is back at 0. A handle that old can't
+	// be told apart from the new one anymore.
+	CHECK(allocator.Free(handle));
+	handle = allocator.Allocate();
+	CHECK_EQUAL(0u, HandleAllocator::GetGeneration(handle));
+	CHECK_EQUAL(first, handle);
+	CHECK(allocator.IsValid(handle));
+	CHECK(handle != HandleAllocator::InvalidHandle);
+}
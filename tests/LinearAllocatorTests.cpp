@@ -0,0 +1,103 @@
+#include "LinearAllocator.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST(AllocationsBumpTheHead)
+{
+	LinearAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+	CHECK_EQUAL(64u, allocator.Allocate(32, 1));
+	CHECK_EQUAL(96u, allocator.Allocate(1, 1));
+	CHECK_EQUAL(97u, allocator.GetUsedSize());
+	CHECK_EQUAL(256u, allocator.GetCapacity());
+}
+
+TEST(AllocationsAreAligned)
+{
+	LinearAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(10, 1));
+	// The padding in front of an aligned allocation counts as used.
+	CHECK_EQUAL(16u, allocator.Allocate(8, 16));
+	CHECK_EQUAL(24u, allocator.GetUsedSize());
+	CHECK_EQUAL(64u, allocator.Allocate(4, 64));
+	// Already aligned, so there is no padding.
+	CHECK_EQUAL(68u, allocator.Allocate(4, 4));
+	CHECK_EQUAL(72u, allocator.GetUsedSize());
+}
+
+TEST(AllocationFailsWhenTheBlockIsFull)
+{
+	LinearAllocator allocator(256);
+	CHECK_EQUAL(LinearAllocator::InvalidOffset, allocator.Allocate(257, 1));
+	CHECK_EQUAL(0u, allocator.GetUsedSize());
+
+	CHECK_EQUAL(0u, allocator.Allocate(200, 1));
+	// Fits without the padding, but not with it.
+	CHECK_EQUAL(LinearAllocator::InvalidOffset, allocator.Allocate(50, 64));
+	// A failed allocation doesn't take any space.
+	CHECK_EQUAL(200u, allocator.GetUsedSize());
+	// Exactly the rest of the block.
+	CHECK_EQUAL(200u, allocator.Allocate(56, 1));
+	CHECK_EQUAL(LinearAllocator::InvalidOffset, allocator.Allocate(1, 1));
+	CHECK_EQUAL(256u, allocator.GetUsedSize());
+}
+
+TEST(ResetFreesEverything)
+{
+	LinearAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(256, 1));
+	CHECK_EQUAL(LinearAllocator::InvalidOffset, allocator.Allocate(1, 1));
+
+	allocator.Reset();
+	CHECK_EQUAL(0u, allocator.GetUsedSize());
+	CHECK_EQUAL(0u, allocator.Allocate(128, 1));
+	CHECK_EQUAL(128u, allocator.Allocate(128, 128));
+}
+
+TEST(ConcurrentAllocationsDoNotOverlap)
+{
+	const int threadCount = 8;
+	const int allocationsPerThread = 1000;
+	const uint64_t size = 24;
+	const uint64_t alignment = 16;
+	// Room for every allocation, padding included.
+	LinearAllocator allocator(threadCount * allocationsPerThread * 32);
+
+	std::vector<std::vector<uint64_t>> perThread(threadCount);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			for (int i = 0; i < allocationsPerThread; ++i)
+			{
+				perThread[t].push_back(allocator.Allocate(size, alignment));
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::vector<uint64_t> offsets;
+	for (const std::vector<uint64_t>& allocations : perThread)
+	{
+		offsets.insert(offsets.end(), allocations.begin(), allocations.end());
+	}
+	std::sort(offsets.begin(), offsets.end());
+
+	CHECK_EQUAL(static_cast<size_t>(threadCount * allocationsPerThread), offsets.size());
+	for (size_t i = 0; i < offsets.size(); ++i)
+	{
+		CHECK(offsets[i] != LinearAllocator::InvalidOffset);
+		CHECK_EQUAL(0u, offsets[i] % alignment);
+		if (i + 1 < offsets.size())
+		{
+			CHECK(offsets[i] + size <= offsets[i + 1]);
+		}
+	}
+}
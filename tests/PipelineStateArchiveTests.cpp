@@ -0,0 +1,171 @@
+#include "PipelineStateArchive.h"
+#include "Test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Header: magic, format version, version and entry count.
+static const size_t HeaderSize = 4 + 4 + 8 + 8;
+// Before the data of every entry: key, size and checksum.
+static const size_t EntryHeaderSize = 8 + 8 + 8;
+
+static std::vector<uint8_t> Bytes(const std::string& string)
+{
+	return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static void Add(PipelineStateArchive& archive, uint64_t key, const std::string& data)
+{
+	archive.Add(key, data.data(), data.size());
+}
+
+// An archive with entries of 5, 0 and 3 bytes, serialized in key order.
+static PipelineStateArchive CreateArchive(uint64_t version)
+{
+	PipelineStateArchive archive(version);
+	Add(archive, 3, "three");
+	Add(archive, 1, "");
+	Add(archive, 2, "two");
+	return archive;
+}
+
+static bool HasEntry(const PipelineStateArchive& archive, uint64_t key, const std::string& data)
+{
+	const std::vector<uint8_t>* entry = archive.Find(key);
+	return entry && *entry == Bytes(data);
+}
+
+// A path in the temporary directory that is removed again at the end of the test.
+class TempPath
+{
+public:
+	explicit TempPath(const std::string& name)
+		: mPath(std::filesystem::temp_directory_path() / name)
+	{
+		std::filesystem::remove(mPath);
+	}
+
+	~TempPath()
+	{
+		std::filesystem::remove(mPath);
+	}
+
+	const std::filesystem::path& Get() const { return mPath; }
+
+private:
+	std::filesystem::path mPath;
+};
+
+TEST(SavedArchiveLoadsTheSameEntries)
+{
+	TempPath path("PipelineStateArchiveTests.bin");
+
+	PipelineStateArchive archive = CreateArchive(7);
+	CHECK(archive.Save(path.Get()));
+	// The temporary file was renamed over the archive.
+	CHECK(!std::filesystem::exists(path.Get().string() + ".tmp"));
+	CHECK_EQUAL(HeaderSize + 3 * EntryHeaderSize + 5 + 0 + 3, static_cast<size_t>(std::filesystem::file_size(path.Get())));
+
+	PipelineStateArchive loaded(7);
+	Add(loaded, 4, "replaced");
+	CHECK(loaded.Load(path.Get()));
+	CHECK_EQUAL(3u, loaded.GetEntryCount());
+	CHECK(HasEntry(loaded, 1, ""));
+	CHECK(HasEntry(loaded, 2, "two"));
+	CHECK(HasEntry(loaded, 3, "three"));
+	CHECK(loaded.Find(4) == nullptr);
+
+	// The same contents always serialize to the same bytes.
+	CHECK(loaded.Serialize() == archive.Serialize());
+
+	// A missing file loads as an empty archive.
+	TempPath missing("PipelineStateArchiveTests.missing");
+	CHECK(!loaded.Load(missing.Get()));
+	CHECK_EQUAL(0u, loaded.GetEntryCount());
+}
+
+TEST(MismatchedHeaderRejectsTheArchive)
+{
+	std::vector<uint8_t> data = CreateArchive(7).Serialize();
+	PipelineStateArchive archive(7);
+	CHECK(archive.Deserialize(data.data(), data.size()));
+	CHECK_EQUAL(3u, archive.GetEntryCount());
+
+	// Written for another GPU or driver.
+	PipelineStateArchive otherVersion(8);
+	CHECK(!otherVersion.Deserialize(data.data(), data.size()));
+	CHECK_EQUAL(0u, otherVersion.GetEntryCount());
+
+	// The magic, format version and version each start a field of the header.
+	for (size_t offset : { 0, 4, 8 })
+	{
+		std::vector<uint8_t> corrupt = data;
+		corrupt[offset] ^= 0x01;
+		CHECK(!archive.Deserialize(corrupt.data(), corrupt.size()));
+		// Nothing of the rejected archive is kept.
+		CHECK_EQUAL(0u, archive.GetEntryCount());
+	}
+}
+
+TEST(EntryWithABadChecksumIsDropped)
+{
+	std::vector<uint8_t> data = CreateArchive(7).Serialize();
+
+	// Entries are in key order and entry 1 is empty, so the data of entry 2
+	// starts right after the first two entry headers.
+	std::vector<uint8_t> corruptData = data;
+	corruptData[HeaderSize + 2 * EntryHeaderSize] ^= 0x01;
+
+	PipelineStateArchive archive(7);
+	CHECK(archive.Deserialize(corruptData.data(), corruptData.size()));
+	CHECK_EQUAL(2u, archive.GetEntryCount());
+	CHECK(HasEntry(archive, 1, ""));
+	CHECK(archive.Find(2) == nullptr);
+	CHECK(HasEntry(archive, 3, "three"));
+
+	// A wrong key fails the checksum as well, instead of moving the data to another key.
+	std::vector<uint8_t> corruptKey = data;
+	corruptKey[HeaderSize] ^= 0x08;
+	CHECK(archive.Deserialize(corruptKey.data(), corruptKey.size()));
+	CHECK_EQUAL(2u, archive.GetEntryCount());
+	CHECK(archive.Find(1) == nullptr);
+	CHECK(archive.Find(9) == nullptr);
+}
+
+TEST(TruncatedArchiveKeepsTheCompleteEntries)
+{
+	std::vector<uint8_t> data = CreateArchive(7).Serialize();
+	const size_t firstEnd = HeaderSize + EntryHeaderSize;
+	const size_t secondEnd = firstEnd + EntryHeaderSize + 3;
+
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		PipelineStateArchive archive(7);
+		bool loaded = archive.Deserialize(data.data(), size);
+		if (size < HeaderSize)
+		{
+			CHECK(!loaded);
+			CHECK_EQUAL(0u, archive.GetEntryCount());
+		}
+		else
+		{
+			CHECK(loaded);
+			size_t expectedCount = size >= secondEnd ? 2 : size >= firstEnd ? 1 : 0;
+			CHECK_EQUAL(expectedCount, archive.GetEntryCount());
+			CHECK(archive.Find(3) == nullptr);
+		}
+	}
+
+	// The same from a file cut short.
+	TempPath path("PipelineStateArchiveTests.truncated");
+	{
+		std::ofstream file(path.Get(), std::ios::binary);
+		file.write(reinterpret_cast<const char*>(data.data()), data.size() - 1);
+	}
+	PipelineStateArchive archive(7);
+	CHECK(archive.Load(path.Get()));
+	CHECK_EQUAL(2u, archive.GetEntryCount());
+	CHECK(HasEntry(archive, 2, "two"));
+}
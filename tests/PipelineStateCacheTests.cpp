@@ -0,0 +1,228 @@
+// The stand-in d3d12.h has to come first. It defines the d3dx12.h subobject
+// types that PipelineStateStream.h uses, and keeps the real d3dx12.h out.
+#include <d3d12.h>
+
+#include "FakeD3D12.h"
+#include "PipelineStateCache.h"
+#include "PipelineStateStream.h"
+#include "Test.h"
+
+#include <utility>
+#include <vector>
+
+using RootSignature = CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE;
+using InputLayout = CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT;
+using PrimitiveTopology = CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY;
+using VS = CD3DX12_PIPELINE_STATE_STREAM_VS;
+using PS = CD3DX12_PIPELINE_STATE_STREAM_PS;
+using DSVFormat = CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT;
+using RTVFormats = CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS;
+
+// The stream Tutorial2 builds.
+using Stream = PipelineStateStream<RootSignature, InputLayout, PrimitiveTopology, VS, PS, DSVFormat, RTVFormats>;
+
+// Everything a stream points to. Each Pipeline owns its own copies, so
+// equal pipelines only share values, never pointers.
+struct Pipeline
+{
+	explicit Pipeline(ID3D12RootSignature* rootSignature)
+		: RootSignature(rootSignature)
+		, InputElements({
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } })
+		, VertexShader({ 0x44, 0x58, 0x42, 0x43, 0x01 })
+		, PixelShader({ 0x44, 0x58, 0x42, 0x43, 0x02 })
+		, DSVFormat(DXGI_FORMAT_D32_FLOAT)
+		, RTVFormats{}
+	{
+		RTVFormats.NumRenderTargets = 1;
+		RTVFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	Stream Build() const
+	{
+		return Stream(RootSignature,
+			D3D12_INPUT_LAYOUT_DESC{ InputElements.data(), static_cast<UINT>(InputElements.size()) },
+			D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+			D3D12_SHADER_BYTECODE{ VertexShader.data(), VertexShader.size() },
+			D3D12_SHADER_BYTECODE{ PixelShader.data(), PixelShader.size() },
+			DSVFormat, RTVFormats);
+	}
+
+	// The key as Tutorial2 computes it, with the stream's LayoutHash.
+	uint64_t Hash(bool* persistent = nullptr) const
+	{
+		return PipelineStateCache::HashPipelineStateStream(Build(), persistent);
+	}
+
+	ID3D12RootSignature* RootSignature;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
+	std::vector<uint8_t> VertexShader;
+	std::vector<uint8_t> PixelShader;
+	DXGI_FORMAT DSVFormat;
+	D3D12_RT_FORMAT_ARRAY RTVFormats;
+};
+
+static ComPtr<FakeRootSignature> CreateRootSignature(uint64_t hash)
+{
+	ComPtr<FakeRootSignature> rootSignature;
+	rootSignature.Attach(new FakeRootSignature());
+	PipelineStateCache::SetRootSignatureHash(rootSignature.Get(), hash);
+	return rootSignature;
+}
+
+TEST(EqualStreamsHaveTheSameKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	// Another root signature object serialized from the same description.
+	ComPtr<FakeRootSignature> sameRootSignature = CreateRootSignature(1);
+
+	Pipeline a(rootSignature.Get());
+	Pipeline b(sameRootSignature.Get());
+	bool persistent = false;
+	CHECK_EQUAL(a.Hash(), b.Hash(&persistent));
+	CHECK(persistent);
+
+	rootSignature = nullptr;
+	sameRootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(RootSignatureIsPartOfTheKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	ComPtr<FakeRootSignature> otherRootSignature = CreateRootSignature(2);
+	Pipeline pipeline(rootSignature.Get());
+	uint64_t key = pipeline.Hash();
+
+	pipeline.RootSignature = otherRootSignature.Get();
+	CHECK(pipeline.Hash() != key);
+
+	// Without a stored hash only the pointer identifies the root signature,
+	// so the key is not persistent.
+	ComPtr<FakeRootSignature> unhashedRootSignature;
+	unhashedRootSignature.Attach(new FakeRootSignature());
+	pipeline.RootSignature = unhashedRootSignature.Get();
+	bool persistent = true;
+	CHECK(pipeline.Hash(&persistent) != key);
+	CHECK(!persistent);
+
+	rootSignature = nullptr;
+	otherRootSignature = nullptr;
+	unhashedRootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(InputLayoutIsPartOfTheKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	const uint64_t key = Pipeline(rootSignature.Get()).Hash();
+
+	Pipeline format(rootSignature.Get());
+	format.InputElements[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	CHECK(format.Hash() != key);
+
+	Pipeline offset(rootSignature.Get());
+	offset.InputElements[1].AlignedByteOffset = 16;
+	CHECK(offset.Hash() != key);
+
+	Pipeline semantic(rootSignature.Get());
+	semantic.InputElements[1].SemanticName = "NORMAL";
+	CHECK(semantic.Hash() != key);
+
+	Pipeline fewerElements(rootSignature.Get());
+	fewerElements.InputElements.pop_back();
+	CHECK(fewerElements.Hash() != key);
+
+	rootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(ShaderBytecodeIsPartOfTheKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	const uint64_t key = Pipeline(rootSignature.Get()).Hash();
+
+	Pipeline vertexShader(rootSignature.Get());
+	vertexShader.VertexShader.back() ^= 0x80;
+	CHECK(vertexShader.Hash() != key);
+
+	Pipeline pixelShader(rootSignature.Get());
+	pixelShader.PixelShader.push_back(0);
+	CHECK(pixelShader.Hash() != key);
+
+	// The same bytecode in the other stage is a different pipeline.
+	Pipeline swapped(rootSignature.Get());
+	std::swap(swapped.VertexShader, swapped.PixelShader);
+	CHECK(swapped.Hash() != key);
+
+	rootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(FormatsArePartOfTheKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	const uint64_t key = Pipeline(rootSignature.Get()).Hash();
+
+	Pipeline rtvFormat(rootSignature.Get());
+	rtvFormat.RTVFormats.RTFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	CHECK(rtvFormat.Hash() != key);
+
+	Pipeline renderTargetCount(rootSignature.Get());
+	renderTargetCount.RTVFormats.NumRenderTargets = 2;
+	renderTargetCount.RTVFormats.RTFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	CHECK(renderTargetCount.Hash() != key);
+
+	Pipeline dsvFormat(rootSignature.Get());
+	dsvFormat.DSVFormat = DXGI_FORMAT_UNKNOWN;
+	CHECK(dsvFormat.Hash() != key);
+
+	rootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(LayoutHashGivesTheSameKeyAsParsingTheStream)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	Pipeline pipeline(rootSignature.Get());
+	Stream stream = pipeline.Build();
+	CHECK_EQUAL(PipelineStateCache::HashPipelineStateStream(stream.GetDesc()), pipeline.Hash());
+
+	// Without a stored hash both keys are only good for this run.
+	ComPtr<FakeRootSignature> unhashedRootSignature;
+	unhashedRootSignature.Attach(new FakeRootSignature());
+	pipeline.RootSignature = unhashedRootSignature.Get();
+	Stream unhashedStream = pipeline.Build();
+	bool persistent = true;
+	bool typedPersistent = true;
+	CHECK_EQUAL(PipelineStateCache::HashPipelineStateStream(unhashedStream.GetDesc(), &persistent), pipeline.Hash(&typedPersistent));
+	CHECK(!persistent);
+	CHECK(!typedPersistent);
+
+	rootSignature = nullptr;
+	unhashedRootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(LayoutIsPartOfTheKey)
+{
+	ComPtr<FakeRootSignature> rootSignature = CreateRootSignature(1);
+	Pipeline pipeline(rootSignature.Get());
+	const uint64_t key = pipeline.Hash();
+
+	// The same values with the formats before the shaders.
+	using ReorderedStream = PipelineStateStream<RootSignature, InputLayout, PrimitiveTopology, DSVFormat, RTVFormats, VS, PS>;
+	static_assert(ReorderedStream::LayoutHash != Stream::LayoutHash, "Reordering the subobjects should change the layout.");
+	ReorderedStream reordered(pipeline.RootSignature,
+		D3D12_INPUT_LAYOUT_DESC{ pipeline.InputElements.data(), static_cast<UINT>(pipeline.InputElements.size()) },
+		D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+		pipeline.DSVFormat, pipeline.RTVFormats,
+		D3D12_SHADER_BYTECODE{ pipeline.VertexShader.data(), pipeline.VertexShader.size() },
+		D3D12_SHADER_BYTECODE{ pipeline.PixelShader.data(), pipeline.PixelShader.size() });
+	CHECK(PipelineStateCache::HashPipelineStateStream(reordered) != key);
+	CHECK_EQUAL(PipelineStateCache::HashPipelineStateStream(reordered.GetDesc()), PipelineStateCache::HashPipelineStateStream(reordered));
+
+	rootSignature = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
@@ -0,0 +1,142 @@
+// The stand-in d3d12.h has to come first. It defines the d3dx12.h subobject
+// types that PipelineStateStream.h uses, and keeps the real d3dx12.h out.
+#include <d3d12.h>
+
+#include "PipelineStateStream.h"
+#include "Test.h"
+
+#include <cstring>
+#include <memory>
+
+using RootSignature = CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE;
+using InputLayout = CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT;
+using PrimitiveTopology = CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY;
+using VS = CD3DX12_PIPELINE_STATE_STREAM_VS;
+using PS = CD3DX12_PIPELINE_STATE_STREAM_PS;
+using DepthStencil = CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL;
+using DepthStencil1 = CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1;
+using DSVFormat = CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT;
+using RTVFormats = CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS;
+using SampleDesc = CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC;
+using SampleMask = CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK;
+
+// The stream Tutorial2 builds.
+using Stream = PipelineStateStream<RootSignature, InputLayout, PrimitiveTopology, VS, PS, DSVFormat, RTVFormats>;
+
+// Every subobject is pointer aligned, so the stream has no gaps between them.
+static_assert(alignof(RootSignature) == alignof(void*));
+static_assert(alignof(PrimitiveTopology) == alignof(void*));
+static_assert(alignof(RTVFormats) == alignof(void*));
+static_assert(sizeof(PrimitiveTopology) == 8);
+static_assert(sizeof(VS) == 24);
+static_assert(sizeof(RTVFormats) == 40);
+
+static_assert(Stream::OffsetOf<RootSignature> == 0);
+static_assert(Stream::OffsetOf<InputLayout> == 16);
+static_assert(Stream::OffsetOf<PrimitiveTopology> == 40);
+static_assert(Stream::OffsetOf<VS> == 48);
+static_assert(Stream::OffsetOf<PS> == 72);
+static_assert(Stream::OffsetOf<DSVFormat> == 96);
+static_assert(Stream::OffsetOf<RTVFormats> == 104);
+static_assert(sizeof(Stream) == 144);
+
+// LayoutHash depends on the subobject types and their order.
+static_assert(PipelineStateStream<VS, PS>::LayoutHash ==
+	HashCombine(HashCombine(HashOffsetBasis, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS), D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS));
+static_assert(PipelineStateStream<VS, PS>::LayoutHash != PipelineStateStream<PS, VS>::LayoutHash);
+static_assert(PipelineStateStream<VS>::LayoutHash != PipelineStateStream<PS>::LayoutHash);
+
+static_assert(UniquePipelineStateSubobjects<RootSignature, VS, PS>);
+static_assert(UniquePipelineStateSubobjects<DepthStencil1>);
+static_assert(!UniquePipelineStateSubobjects<>);
+static_assert(!UniquePipelineStateSubobjects<VS, PS, VS>);
+// DEPTH_STENCIL1 replaces DEPTH_STENCIL, so they count as the same type.
+static_assert(!UniquePipelineStateSubobjects<DepthStencil, DepthStencil1>);
+static_assert(!UniquePipelineStateSubobjects<VS, int>);
+
+// Declaring a stream that breaks the constraint, e.g.
+//
+//   PipelineStateStream<VS, VS> stream;
+//
+// doesn't compile. Naming the type in a requires expression checks that
+// without breaking the build: it is false when the constraint fails.
+template<typename... Subobjects>
+concept DeclarablePipelineStateStream = requires { typename PipelineStateStream<Subobjects...>; };
+
+static_assert(DeclarablePipelineStateStream<VS, PS>);
+static_assert(!DeclarablePipelineStateStream<VS, VS>);
+static_assert(!DeclarablePipelineStateStream<>);
+
+// The subobject type stored at the start of a subobject.
+template<typename Subobject>
+static D3D12_PIPELINE_STATE_SUBOBJECT_TYPE GetStoredType(const Subobject& subobject)
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type;
+	memcpy(&type, reinterpret_cast<const void*>(std::addressof(subobject)), sizeof(type));
+	return type;
+}
+
+template<typename Subobject>
+static size_t GetOffset(const Stream& stream)
+{
+	const Subobject& subobject = stream.Get<Subobject>();
+	return reinterpret_cast<const uint8_t*>(std::addressof(subobject)) - reinterpret_cast<const uint8_t*>(std::addressof(stream));
+}
+
+TEST(SubobjectsAreWhereOffsetOfSays)
+{
+	Stream stream;
+	CHECK_EQUAL(Stream::OffsetOf<RootSignature>, GetOffset<RootSignature>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<InputLayout>, GetOffset<InputLayout>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<PrimitiveTopology>, GetOffset<PrimitiveTopology>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<VS>, GetOffset<VS>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<PS>, GetOffset<PS>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<DSVFormat>, GetOffset<DSVFormat>(stream));
+	CHECK_EQUAL(Stream::OffsetOf<RTVFormats>, GetOffset<RTVFormats>(stream));
+
+	D3D12_PIPELINE_STATE_STREAM_DESC desc = stream.GetDesc();
+	CHECK_EQUAL(sizeof(Stream), desc.SizeInBytes);
+	CHECK(desc.pPipelineStateSubobjectStream == std::addressof(stream));
+}
+
+TEST(SubobjectsStoreTheirType)
+{
+	Stream stream;
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, GetStoredType(stream.Get<RootSignature>()));
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT, GetStoredType(stream.Get<InputLayout>()));
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, GetStoredType(stream.Get<VS>()));
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, GetStoredType(stream.Get<PS>()));
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, GetStoredType(stream.Get<RTVFormats>()));
+}
+
+TEST(ValuesAreSetInOrder)
+{
+	static const uint8_t vsBytecode[4] = {};
+	static const uint8_t psBytecode[8] = {};
+
+	D3D12_RT_FORMAT_ARRAY rtvFormats = {};
+	rtvFormats.NumRenderTargets = 1;
+	rtvFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	Stream stream(nullptr, D3D12_INPUT_LAYOUT_DESC{ nullptr, 0 }, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+		D3D12_SHADER_BYTECODE{ vsBytecode, sizeof(vsBytecode) }, D3D12_SHADER_BYTECODE{ psBytecode, sizeof(psBytecode) },
+		DXGI_FORMAT_D32_FLOAT, rtvFormats);
+
+	CHECK_EQUAL(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE, static_cast<const D3D12_PRIMITIVE_TOPOLOGY_TYPE&>(stream.Get<PrimitiveTopology>()));
+	CHECK_EQUAL(sizeof(vsBytecode), static_cast<const D3D12_SHADER_BYTECODE&>(stream.Get<VS>()).BytecodeLength);
+	CHECK_EQUAL(sizeof(psBytecode), static_cast<const D3D12_SHADER_BYTECODE&>(stream.Get<PS>()).BytecodeLength);
+	CHECK_EQUAL(DXGI_FORMAT_D32_FLOAT, static_cast<const DXGI_FORMAT&>(stream.Get<DSVFormat>()));
+
+	stream.Set<DSVFormat>(DXGI_FORMAT_UNKNOWN);
+	CHECK_EQUAL(DXGI_FORMAT_UNKNOWN, static_cast<const DXGI_FORMAT&>(stream.Get<DSVFormat>()));
+	CHECK_EQUAL(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, GetStoredType(stream.Get<DSVFormat>()));
+}
+
+TEST(UnsetSubobjectsKeepTheirDefaults)
+{
+	PipelineStateStream<SampleDesc, SampleMask> stream;
+	const DXGI_SAMPLE_DESC& sampleDesc = stream.Get<SampleDesc>();
+	CHECK_EQUAL(1u, sampleDesc.Count);
+	CHECK_EQUAL(0u, sampleDesc.Quality);
+	CHECK_EQUAL(UINT_MAX, static_cast<const UINT&>(stream.Get<SampleMask>()));
+}
@@ -0,0 +1,70 @@
+// Measures the cost of recording zones and of merging them in EndFrame.
+// Built with the tests but not run by ctest:
+//
+//   ProfilerBenchmark [frames] [zones per frame] [depth]
+
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// A chain of nested zones, depth deep.
+static void Nest(uint32_t depth)
+{
+	PROFILE_SCOPE("Zone");
+	if (depth > 1)
+	{
+		Nest(depth - 1);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t numFrames = argc > 1 ? std::atoi(argv[1]) : 1000;
+	uint32_t numZones = argc > 2 ? std::atoi(argv[2]) : 4096;
+	uint32_t depth = argc > 3 ? std::atoi(argv[3]) : 8;
+	if (numFrames == 0 || numZones == 0 || depth == 0)
+	{
+		std::fprintf(stderr, "Usage: %s [frames] [zones per frame] [depth]\n", argv[0]);
+		return 1;
+	}
+
+	Profiler::SetThreadName("Main");
+
+	uint64_t recordTime = 0;
+	uint64_t endFrameTime = 0;
+	uint64_t recordedZones = 0;
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		uint64_t begin = Profiler::Now();
+		{
+			PROFILE_SCOPE("Frame");
+			for (uint32_t zones = 1; zones < numZones; zones += depth)
+			{
+				Nest(depth);
+				recordedZones += depth;
+			}
+		}
+		uint64_t end = Profiler::Now();
+		Profiler::EndFrame();
+
+		recordTime += end - begin;
+		endFrameTime += Profiler::Now() - end;
+	}
+
+	uint64_t droppedZones = 0;
+	for (const Profiler::Thread& thread : Profiler::GetLastFrame().Threads)
+	{
+		droppedZones += thread.DroppedZones;
+	}
+
+	std::printf("%u frames, %u zones per frame, depth %u\n", numFrames, numZones, depth);
+	std::printf("Record:   %.1f ns per zone\n", static_cast<double>(recordTime) / recordedZones);
+	std::printf("EndFrame: %.3f ms per frame, %.1f ns per zone\n",
+		endFrameTime * 1e-6 / numFrames, static_cast<double>(endFrameTime) / recordedZones);
+	if (droppedZones > 0)
+	{
+		std::printf("%llu zones dropped in the last frame\n", static_cast<unsigned long long>(droppedZones));
+	}
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include "Profiler.h"
+#include "Test.h"
+
+#include <sstream>
+#include <thread>
+
+// The tree of the named thread in the last frame, or null if it had none.
+static const Profiler::Thread* FindThread(const Profiler::Frame& frame, const std::string& name)
+{
+	for (const Profiler::Thread& thread : frame.Threads)
+	{
+		if (thread.Name == name)
+		{
+			return &thread;
+		}
+	}
+	return nullptr;
+}
+
+// Drop whatever earlier tests left behind.
+static void BeginTest()
+{
+	Profiler::SetThreadName("Main");
+	Profiler::EndFrame();
+}
+
+static void Leaf()
+{
+	PROFILE_SCOPE("Leaf");
+}
+
+TEST(ZonesMergeIntoACallTree)
+{
+	BeginTest();
+
+	{
+		PROFILE_SCOPE("Frame");
+		{
+			PROFILE_SCOPE("Update");
+			Leaf();
+			Leaf();
+		}
+		{
+			PROFILE_SCOPE("Render");
+			Leaf();
+		}
+		{
+			PROFILE_SCOPE("Update");
+			Leaf();
+		}
+	}
+	Profiler::EndFrame();
+
+	Profiler::Frame lastFrame = Profiler::GetLastFrame();
+	const Profiler::Thread* thread = FindThread(lastFrame, "Main");
+	CHECK(thread != nullptr);
+	if (!thread)
+	{
+		return;
+	}
+
+	CHECK_EQUAL(0u, thread->DroppedZones);
+	CHECK_EQUAL(1u, thread->Zones.size());
+	if (thread->Zones.size() == 1)
+	{
+		const Profiler::Node& frame = thread->Zones[0];
+		CHECK_EQUAL(std::string("Frame"), frame.Name);
+		CHECK_EQUAL(1u, frame.Calls);
+		// Siblings of the same name are counted together, in the order they first ended.
+		CHECK_EQUAL(2u, frame.Children.size());
+		if (frame.Children.size() == 2)
+		{
+			const Profiler::Node& update = frame.Children[0];
+			const Profiler::Node& render = frame.Children[1];
+			CHECK_EQUAL(std::string("Update"), update.Name);
+			CHECK_EQUAL(2u, update.Calls);
+			CHECK_EQUAL(1u, update.Children.size());
+			if (update.Children.size() == 1)
+			{
+				CHECK_EQUAL(std::string("Leaf"), update.Children[0].Name);
+				CHECK_EQUAL(3u, update.Children[0].Calls);
+				CHECK(update.Time >= update.Children[0].Time);
+			}
+
+			CHECK_EQUAL(std::string("Render"), render.Name);
+			CHECK_EQUAL(1u, render.Calls);
+			CHECK_EQUAL(1u, render.Children.size());
+
+			CHECK(frame.Time >= update.Time + render.Time);
+			CHECK(frame.SelfTime <= frame.Time - update.Time - render.Time + 1e-9);
+		}
+	}
+}
+
+TEST(ZonesWaitForTheirParentToEnd)
+{
+	BeginTest();
+
+	{
+		PROFILE_SCOPE("Outer");
+		Leaf();
+		// Outer is still open, so none of its zones are complete.
+		Profiler::EndFrame();
+		CHECK(FindThread(Profiler::GetLastFrame(), "Main") == nullptr);
+
+		Leaf();
+	}
+	Profiler::EndFrame();
+
+	Profiler::Frame lastFrame = Profiler::GetLastFrame();
+	const Profiler::Thread* thread = FindThread(lastFrame, "Main");
+	CHECK(thread != nullptr);
+	if (thread && thread->Zones.size() == 1)
+	{
+		// Both leaves end up under Outer, in the frame Outer ended in.
+		const Profiler::Node& outer = thread->Zones[0];
+		CHECK_EQUAL(std::string("Outer"), outer.Name);
+		CHECK_EQUAL(1u, outer.Children.size());
+		if (outer.Children.size() == 1)
+		{
+			CHECK_EQUAL(std::string("Leaf"), outer.Children[0].Name);
+			CHECK_EQUAL(2u, outer.Children[0].Calls);
+		}
+	}
+	else
+	{
+		CHECK(false);
+	}
+
+	// Nothing is left over for the next frame.
+	Profiler::EndFrame();
+	CHECK(FindThread(Profiler::GetLastFrame(), "Main") == nullptr);
+}
+
+TEST(ThreadsHaveTheirOwnTrees)
+{
+	BeginTest();
+
+	std::thread worker([]()
+	{
+		Profiler::SetThreadName("Worker");
+		PROFILE_SCOPE("Job");
+		Leaf();
+	});
+	worker.join();
+	Leaf();
+	Profiler::EndFrame();
+
+	Profiler::Frame frame = Profiler::GetLastFrame();
+	const Profiler::Thread* main = FindThread(frame, "Main");
+	const Profiler::Thread* workerThread = FindThread(frame, "Worker");
+	CHECK(main != nullptr);
+	CHECK(workerThread != nullptr);
+	if (main && workerThread)
+	{
+		CHECK_EQUAL(1u, main->Zones.size());
+		CHECK_EQUAL(std::string("Leaf"), main->Zones[0].Name);
+		CHECK_EQUAL(1u, workerThread->Zones.size());
+		CHECK_EQUAL(std::string("Job"), workerThread->Zones[0].Name);
+		CHECK_EQUAL(1u, workerThread->Zones[0].Children.size());
+	}
+}
+
+TEST(ReportIndentsChildren)
+{
+	BeginTest();
+
+	{
+		PROFILE_SCOPE("Outer");
+		Leaf();
+	}
+	Profiler::EndFrame();
+
+	Profiler::Frame frame = Profiler::GetLastFrame();
+	std::ostringstream stream;
+	Profiler::WriteReport(stream, frame);
+	std::string report = stream.str();
+	CHECK(report.find("Frame " + std::to_string(frame.Number) + "\n") == 0);
+	CHECK(report.find("Main\n  Outer: ") != std::string::npos);
+	CHECK(report.find("\n    Leaf: ") != std::string::npos);
+	CHECK(report.find(", 1 calls\n") != std::string::npos);
+
+	Profiler::EndFrame();
+	CHECK_EQUAL(frame.Number + 1, Profiler::GetLastFrame().Number);
+}
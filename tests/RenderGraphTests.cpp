@@ -0,0 +1,653 @@
+#include "CommandQueue.h"
+#include "FakeD3D12.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+#include "Test.h"
+
+#include <vector>
+
+using Barrier = RenderGraph::Barrier;
+using BarrierType = RenderGraph::BarrierType;
+
+static const D3D12_RESOURCE_STATES ShaderResource =
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+static ComPtr<FakeDevice> CreateFakeDevice()
+{
+	ComPtr<FakeDevice> device;
+	device.Attach(new FakeDevice());
+	return device;
+}
+
+static ComPtr<FakeResource> CreateFakeResource()
+{
+	ComPtr<FakeResource> resource;
+	resource.Attach(new FakeResource());
+	return resource;
+}
+
+// Four bytes per texel in 64 KiB pages, like the fake device.
+static RenderGraph::AllocationInfoFunction GetAllocationInfo(ComPtr<FakeDevice> device)
+{
+	return [device](const D3D12_RESOURCE_DESC& desc)
+	{
+		return device->GetResourceAllocationInfo(0, 1, &desc);
+	};
+}
+
+static D3D12_RESOURCE_DESC TextureDesc(UINT64 width, UINT height, D3D12_RESOURCE_FLAGS flags)
+{
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Width = width;
+	desc.Height = height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc = { 1, 0 };
+	desc.Flags = flags;
+	return desc;
+}
+
+static D3D12_RESOURCE_DESC RenderTargetDesc(UINT64 width, UINT height)
+{
+	return TextureDesc(width, height, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+}
+
+static void Nothing(RenderGraph&, ID3D12GraphicsCommandList2*)
+{
+}
+
+static void CheckTransition(const Barrier& barrier, uint32_t resource, D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags)
+{
+	CHECK_EQUAL(BarrierType::Transition, barrier.Type);
+	CHECK_EQUAL(resource, barrier.Resource);
+	CHECK_EQUAL(stateBefore, barrier.StateBefore);
+	CHECK_EQUAL(stateAfter, barrier.StateAfter);
+	CHECK_EQUAL(flags, barrier.Flags);
+}
+
+static void CheckTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE)
+{
+	CHECK_EQUAL(D3D12_RESOURCE_BARRIER_TYPE_TRANSITION, barrier.Type);
+	CHECK_EQUAL(flags, barrier.Flags);
+	if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+	{
+		CHECK(barrier.Transition.pResource == resource);
+		CHECK_EQUAL(stateBefore, barrier.Transition.StateBefore);
+		CHECK_EQUAL(stateAfter, barrier.Transition.StateAfter);
+	}
+}
+
+static const RenderGraph::TransientPlacement* FindPlacement(const RenderGraph& renderGraph, uint32_t resource)
+{
+	for (const RenderGraph::TransientPlacement& placement : renderGraph.GetTransientPlacements())
+	{
+		if (placement.Resource == resource)
+		{
+			return &placement;
+		}
+	}
+	return nullptr;
+}
+
+TEST(PassesWhoseResultsAreUnusedAreCulled)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		RenderGraph renderGraph;
+		uint32_t imported = renderGraph.ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		uint32_t first = renderGraph.CreateTexture("First", RenderTargetDesc(128, 128));
+		uint32_t second = renderGraph.CreateTexture("Second", RenderTargetDesc(128, 128));
+		uint32_t readBack = renderGraph.CreateTexture("ReadBack", RenderTargetDesc(128, 128));
+		uint32_t output = renderGraph.CreateTexture("Output", RenderTargetDesc(128, 128));
+		renderGraph.MarkOutput(output);
+
+		// Second is never read, so the pass that writes it is culled. Then
+		// nothing reads First anymore, and its pass goes too.
+		renderGraph.AddPass("WriteFirst", Nothing).Write(first);
+		renderGraph.AddPass("WriteSecond", Nothing).Read(first).Write(second);
+		renderGraph.AddPass("Present", Nothing).Write(imported);
+		renderGraph.AddPass("ReadBack", Nothing).Write(readBack).SetSideEffects();
+		renderGraph.AddPass("Output", Nothing).Write(output);
+		renderGraph.AddPass("WritesNothing", Nothing);
+		renderGraph.Compile(GetAllocationInfo(device));
+
+		CHECK(renderGraph.IsPassCulled(0));
+		CHECK(renderGraph.IsPassCulled(1));
+		CHECK(!renderGraph.IsPassCulled(2));
+		CHECK(!renderGraph.IsPassCulled(3));
+		CHECK(!renderGraph.IsPassCulled(4));
+		CHECK(renderGraph.IsPassCulled(5));
+
+		const std::vector<RenderGraph::CompiledPass>& compiledPasses = renderGraph.GetCompiledPasses();
+		CHECK_EQUAL(3u, compiledPasses.size());
+		if (compiledPasses.size() == 3)
+		{
+			CHECK_EQUAL(2u, compiledPasses[0].Pass);
+			CHECK_EQUAL(3u, compiledPasses[1].Pass);
+			CHECK_EQUAL(4u, compiledPasses[2].Pass);
+		}
+
+		RenderGraph::Stats stats = renderGraph.GetStats();
+		CHECK_EQUAL(6u, stats.Passes);
+		CHECK_EQUAL(3u, stats.CulledPasses);
+
+		// Only the textures of the passes that are left get memory.
+		CHECK_EQUAL(2u, renderGraph.GetTransientPlacements().size());
+		CHECK(!FindPlacement(renderGraph, first));
+		CHECK(!FindPlacement(renderGraph, second));
+		CHECK(FindPlacement(renderGraph, readBack));
+		CHECK(FindPlacement(renderGraph, output));
+
+		// A pass that reads the culled result keeps both passes alive.
+		renderGraph.AddPass("ReadSecond", Nothing).Read(second).Write(imported);
+		renderGraph.Compile(GetAllocationInfo(device));
+		CHECK(!renderGraph.IsPassCulled(0));
+		CHECK(!renderGraph.IsPassCulled(1));
+		CHECK_EQUAL(1u, renderGraph.GetStats().CulledPasses);
+		CHECK_EQUAL(4u, renderGraph.GetTransientPlacements().size());
+	}
+
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(TransitionsAreSplitWhenPassesRunInBetween)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		RenderGraph renderGraph;
+		uint32_t imported = renderGraph.ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		uint32_t split = renderGraph.CreateTexture("Split", RenderTargetDesc(128, 128));
+		uint32_t adjacent = renderGraph.CreateTexture("Adjacent", TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+
+		renderGraph.AddPass("A", Nothing).Write(split).Write(adjacent, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		renderGraph.AddPass("B", Nothing).Write(adjacent, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		renderGraph.AddPass("C", Nothing).Read(adjacent).Write(imported);
+		renderGraph.AddPass("D", Nothing).Read(split).Write(imported);
+		renderGraph.Compile(GetAllocationInfo(device));
+
+		const std::vector<RenderGraph::CompiledPass>& passes = renderGraph.GetCompiledPasses();
+		CHECK_EQUAL(4u, passes.size());
+		if (passes.size() != 4)
+		{
+			return;
+		}
+
+		// Split is used by A and then D, so its transition begins after A and
+		// ends before D.
+		CHECK(passes[0].BarriersBefore.empty());
+		CHECK_EQUAL(1u, passes[0].BarriersAfter.size());
+		if (passes[0].BarriersAfter.size() == 1)
+		{
+			CheckTransition(passes[0].BarriersAfter[0], split, D3D12_RESOURCE_STATE_RENDER_TARGET, ShaderResource,
+				D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+		}
+		CHECK_EQUAL(1u, passes[3].BarriersBefore.size());
+		if (passes[3].BarriersBefore.size() == 1)
+		{
+			CheckTransition(passes[3].BarriersBefore[0], split, D3D12_RESOURCE_STATE_RENDER_TARGET, ShaderResource,
+				D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+		}
+
+		// Adjacent is written as a UAV twice in a row, which needs a UAV
+		// barrier, and then read by the very next pass, so there is nothing
+		// to split.
+		CHECK_EQUAL(1u, passes[1].BarriersBefore.size());
+		if (passes[1].BarriersBefore.size() == 1)
+		{
+			CHECK_EQUAL(BarrierType::UAV, passes[1].BarriersBefore[0].Type);
+			CHECK_EQUAL(adjacent, passes[1].BarriersBefore[0].Resource);
+		}
+		CHECK(passes[1].BarriersAfter.empty());
+		CHECK_EQUAL(1u, passes[2].BarriersBefore.size());
+		if (passes[2].BarriersBefore.size() == 1)
+		{
+			CheckTransition(passes[2].BarriersBefore[0], adjacent, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ShaderResource,
+				D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		}
+
+		// The back buffer is transitioned by the tracker, not by the graph.
+		for (const RenderGraph::CompiledPass& pass : passes)
+		{
+			for (const Barrier& barrier : pass.BarriersBefore)
+			{
+				CHECK(barrier.Resource != imported);
+			}
+			for (const Barrier& barrier : pass.BarriersAfter)
+			{
+				CHECK(barrier.Resource != imported);
+			}
+		}
+
+		RenderGraph::Stats stats = renderGraph.GetStats();
+		CHECK_EQUAL(4u, stats.Barriers);
+		CHECK_EQUAL(1u, stats.SplitBarriers);
+	}
+
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(TexturesThatAreNotAliveAtTheSameTimeShareMemory)
+{
+	const uint64_t KiB = 1024;
+
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		RenderGraph renderGraph;
+		uint32_t imported = renderGraph.ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		// 256 KiB, 256 KiB and 64 KiB of render targets, and 64 KiB of other textures.
+		uint32_t a = renderGraph.CreateTexture("A", RenderTargetDesc(256, 256));
+		uint32_t b = renderGraph.CreateTexture("B", RenderTargetDesc(256, 256));
+		uint32_t c = renderGraph.CreateTexture("C", RenderTargetDesc(128, 128));
+		uint32_t d = renderGraph.CreateTexture("D", TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+
+		// A is alive in passes 0-1, C in 1-2, B in 2-3 and D in all of them.
+		renderGraph.AddPass("0", Nothing).Write(a).Write(d, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		renderGraph.AddPass("1", Nothing).Read(a).Write(c);
+		renderGraph.AddPass("2", Nothing).Read(c).Write(b);
+		renderGraph.AddPass("3", Nothing).Read(b).Read(d).Write(imported);
+		renderGraph.Compile(GetAllocationInfo(device));
+
+		const RenderGraph::TransientPlacement* placementA = FindPlacement(renderGraph, a);
+		const RenderGraph::TransientPlacement* placementB = FindPlacement(renderGraph, b);
+		const RenderGraph::TransientPlacement* placementC = FindPlacement(renderGraph, c);
+		const RenderGraph::TransientPlacement* placementD = FindPlacement(renderGraph, d);
+		CHECK(placementA && placementB && placementC && placementD);
+		if (!placementA || !placementB || !placementC || !placementD)
+		{
+			return;
+		}
+
+		CHECK_EQUAL(256 * KiB, placementA->Size);
+		CHECK_EQUAL(64 * KiB, placementC->Size);
+		CHECK_EQUAL(0u, placementA->FirstPass);
+		CHECK_EQUAL(1u, placementA->LastPass);
+		CHECK_EQUAL(2u, placementB->FirstPass);
+		CHECK_EQUAL(3u, placementB->LastPass);
+
+		// B takes over the memory of A once A is done. C overlaps both, so it
+		// goes after them.
+		CHECK_EQUAL(0u, placementA->Offset);
+		CHECK_EQUAL(0u, placementB->Offset);
+		CHECK_EQUAL(256 * KiB, placementC->Offset);
+		CHECK(!placementA->Aliased);
+		CHECK(placementB->Aliased);
+		CHECK(!placementC->Aliased);
+
+		// D can't share a heap with render targets.
+		CHECK(placementD->HeapCategory != placementA->HeapCategory);
+		CHECK_EQUAL(placementA->HeapCategory, placementB->HeapCategory);
+		CHECK_EQUAL(placementA->HeapCategory, placementC->HeapCategory);
+		CHECK_EQUAL(0u, placementD->Offset);
+		CHECK(!placementD->Aliased);
+
+		// B's first pass starts with the aliasing barrier.
+		const std::vector<RenderGraph::CompiledPass>& passes = renderGraph.GetCompiledPasses();
+		CHECK(!passes[2].BarriersBefore.empty());
+		if (!passes[2].BarriersBefore.empty())
+		{
+			CHECK_EQUAL(BarrierType::Aliasing, passes[2].BarriersBefore[0].Type);
+			CHECK_EQUAL(b, passes[2].BarriersBefore[0].Resource);
+		}
+
+		RenderGraph::Stats stats = renderGraph.GetStats();
+		CHECK_EQUAL(640 * KiB, stats.TransientSize);
+		// 320 KiB of render targets and 64 KiB of the rest.
+		CHECK_EQUAL(384 * KiB, stats.TransientHeapSize);
+		CHECK_EQUAL(1u, stats.AliasingBarriers);
+	}
+
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(ExecuteRecordsTheCompiledBarriers)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		ResourceStateTracker::AddGlobalResourceState(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		ResourceStateTracker resourceStateTracker;
+		RenderGraph renderGraph(device);
+
+		ID3D12Resource* placedResource = nullptr;
+		for (int frame = 0; frame < 2; ++frame)
+		{
+			renderGraph.Reset();
+			uint32_t imported = renderGraph.ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+			uint32_t texture = renderGraph.CreateTexture("Texture", RenderTargetDesc(128, 128));
+
+			FakeResource* usedResource = nullptr;
+			renderGraph.AddPass("Draw", [&](RenderGraph& graph, ID3D12GraphicsCommandList2*)
+			{
+				usedResource = static_cast<FakeResource*>(graph.GetResource(texture));
+			}).Write(texture);
+			renderGraph.AddPass("Clear", Nothing).Write(imported);
+			renderGraph.AddPass("Post", Nothing).Read(texture).Write(imported);
+			renderGraph.Compile();
+
+			ComPtr<ID3D12GraphicsCommandList2> commandList = commandQueue.GetCommandList();
+			FakeCommandList* fakeCommandList = static_cast<FakeCommandList*>(commandList.Get());
+			renderGraph.Execute(commandQueue, commandList.Get(), resourceStateTracker);
+			commandQueue.ExecuteCommandList(commandList, resourceStateTracker);
+
+			CHECK(usedResource != nullptr);
+			if (!usedResource)
+			{
+				break;
+			}
+			// The heap is rounded up to the MSAA placement alignment.
+			CHECK_EQUAL(static_cast<UINT64>(D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT),
+				usedResource->GetHeap()->GetDesc().SizeInBytes);
+			CHECK_EQUAL(0u, usedResource->GetHeapOffset());
+
+			std::vector<std::vector<D3D12_RESOURCE_BARRIER>> calls = fakeCommandList->GetBarrierCalls();
+			CHECK_EQUAL(4u, calls.size());
+			if (calls.size() != 4)
+			{
+				break;
+			}
+
+			if (frame == 0)
+			{
+				// A new texture may sit on memory another one used, so it
+				// takes it over and is discarded.
+				CHECK_EQUAL(1u, calls[0].size());
+				CHECK_EQUAL(D3D12_RESOURCE_BARRIER_TYPE_ALIASING, calls[0][0].Type);
+				CHECK(calls[0][0].Aliasing.pResourceAfter == usedResource);
+				CHECK(fakeCommandList->GetDiscards() == std::vector<ID3D12Resource*>{ usedResource });
+				placedResource = usedResource;
+			}
+			else
+			{
+				// The texture is reused, and still in the state the last frame
+				// left it in.
+				CHECK(usedResource == placedResource);
+				CHECK_EQUAL(1u, calls[0].size());
+				CheckTransition(calls[0][0], usedResource, ShaderResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+				CHECK(fakeCommandList->GetDiscards().empty());
+			}
+
+			CHECK_EQUAL(1u, calls[1].size());
+			CheckTransition(calls[1][0], usedResource, D3D12_RESOURCE_STATE_RENDER_TARGET, ShaderResource,
+				D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+			CHECK_EQUAL(1u, calls[2].size());
+			CheckTransition(calls[2][0], usedResource, D3D12_RESOURCE_STATE_RENDER_TARGET, ShaderResource,
+				D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+			// The back buffer goes back to its final state through the tracker.
+			CHECK_EQUAL(1u, calls[3].size());
+			CheckTransition(calls[3][0], backBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+		}
+
+		ResourceStateTracker::RemoveGlobalResourceState(backBuffer.Get());
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+static void CheckSubmission(const RenderGraph::Submission& submission, bool asyncCompute, uint32_t firstPass,
+	uint32_t lastPass, uint32_t wait)
+{
+	CHECK_EQUAL(asyncCompute, submission.AsyncCompute);
+	CHECK_EQUAL(firstPass, submission.FirstPass);
+	CHECK_EQUAL(lastPass, submission.LastPass);
+	CHECK_EQUAL(wait, submission.Wait);
+}
+
+// Depth is drawn on the graphics queue, SSAO reads it on the compute queue
+// while Shadows draws, and Lighting uses the results of both.
+struct AsyncComputeFrame
+{
+	uint32_t BackBuffer;
+	uint32_t Depth;
+	uint32_t AmbientOcclusion;
+	uint32_t Shadows;
+};
+
+static AsyncComputeFrame AddAsyncComputeFrame(RenderGraph& renderGraph, ID3D12Resource* backBuffer)
+{
+	AsyncComputeFrame frame;
+	frame.BackBuffer = renderGraph.ImportResource("BackBuffer", backBuffer, D3D12_RESOURCE_STATE_PRESENT);
+	frame.Depth = renderGraph.CreateTexture("Depth", TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL));
+	frame.AmbientOcclusion = renderGraph.CreateTexture("AmbientOcclusion",
+		TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+	frame.Shadows = renderGraph.CreateTexture("Shadows", RenderTargetDesc(128, 128));
+
+	renderGraph.AddPass("Depth", Nothing).Write(frame.Depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	renderGraph.AddPass("SSAO", Nothing)
+		.Read(frame.Depth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+		.Write(frame.AmbientOcclusion, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+		.SetAsyncCompute();
+	renderGraph.AddPass("Shadows", Nothing).Write(frame.Shadows);
+	renderGraph.AddPass("Lighting", Nothing).Read(frame.AmbientOcclusion).Read(frame.Shadows).Write(frame.BackBuffer);
+	return frame;
+}
+
+TEST(AsyncComputeSubmissionsOnlyWaitForWhatTheyUse)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		RenderGraph renderGraph;
+		AsyncComputeFrame frame = AddAsyncComputeFrame(renderGraph, backBuffer.Get());
+		renderGraph.Compile(GetAllocationInfo(device));
+
+		// SSAO waits for Depth. Shadows doesn't use SSAO, so it only has to
+		// be in a submission of its own because the queue changed. Lighting
+		// waits for SSAO.
+		const std::vector<RenderGraph::Submission>& submissions = renderGraph.GetSubmissions();
+		CHECK_EQUAL(4u, submissions.size());
+		if (submissions.size() == 4)
+		{
+			CheckSubmission(submissions[0], false, 0, 0, RenderGraph::InvalidSubmission);
+			CheckSubmission(submissions[1], true, 1, 1, 0);
+			CheckSubmission(submissions[2], false, 2, 2, RenderGraph::InvalidSubmission);
+			CheckSubmission(submissions[3], false, 3, 3, 1);
+		}
+
+		const std::vector<RenderGraph::CompiledPass>& passes = renderGraph.GetCompiledPasses();
+		CHECK_EQUAL(4u, passes.size());
+		if (passes.size() != 4)
+		{
+			return;
+		}
+		for (uint32_t i = 0; i < passes.size(); ++i)
+		{
+			CHECK_EQUAL(i, passes[i].Submission);
+		}
+
+		// The compute queue can't leave DEPTH_WRITE, so the graphics queue
+		// hands the depth buffer over right after drawing it.
+		CHECK_EQUAL(1u, passes[0].BarriersAfter.size());
+		if (passes[0].BarriersAfter.size() == 1)
+		{
+			CheckTransition(passes[0].BarriersAfter[0], frame.Depth, D3D12_RESOURCE_STATE_DEPTH_WRITE,
+				D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		}
+		CHECK(passes[1].BarriersBefore.empty());
+
+		// Transitions are never split across submissions.
+		CHECK_EQUAL(2u, passes[3].BarriersBefore.size());
+		if (passes[3].BarriersBefore.size() == 2)
+		{
+			CheckTransition(passes[3].BarriersBefore[0], frame.AmbientOcclusion, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+				ShaderResource, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+			CheckTransition(passes[3].BarriersBefore[1], frame.Shadows, D3D12_RESOURCE_STATE_RENDER_TARGET,
+				ShaderResource, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		}
+		// The next frame starts with SSAO on the compute queue, so the
+		// ambient occlusion is put back into the state SSAO writes it in.
+		CHECK_EQUAL(1u, passes[3].BarriersAfter.size());
+		if (passes[3].BarriersAfter.size() == 1)
+		{
+			CheckTransition(passes[3].BarriersAfter[0], frame.AmbientOcclusion, ShaderResource,
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		}
+
+		// Textures used on the compute queue may be alive at any time, so
+		// the shadows can't take over the depth buffer's memory.
+		const RenderGraph::TransientPlacement* depth = FindPlacement(renderGraph, frame.Depth);
+		const RenderGraph::TransientPlacement* ambientOcclusion = FindPlacement(renderGraph, frame.AmbientOcclusion);
+		const RenderGraph::TransientPlacement* shadows = FindPlacement(renderGraph, frame.Shadows);
+		CHECK(depth && ambientOcclusion && shadows);
+		if (depth && ambientOcclusion && shadows)
+		{
+			CHECK(depth->AsyncCompute);
+			CHECK(ambientOcclusion->AsyncCompute);
+			CHECK(!shadows->AsyncCompute);
+			CHECK_EQUAL(depth->HeapCategory, shadows->HeapCategory);
+			CHECK_EQUAL(0u, depth->Offset);
+			CHECK_EQUAL(depth->Size, shadows->Offset);
+			CHECK(!shadows->Aliased);
+		}
+
+		RenderGraph::Stats stats = renderGraph.GetStats();
+		CHECK_EQUAL(1u, stats.AsyncComputePasses);
+		CHECK_EQUAL(4u, stats.Submissions);
+		CHECK_EQUAL(2u, stats.QueueWaits);
+		CHECK_EQUAL(0u, stats.AliasingBarriers);
+	}
+
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(ReadsOnBothQueuesDoNotWaitForEachOther)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	ComPtr<FakeResource> buffer = CreateFakeResource();
+	{
+		RenderGraph renderGraph;
+		uint32_t importedBackBuffer = renderGraph.ImportResource("BackBuffer", backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		uint32_t importedBuffer = renderGraph.ImportResource("Buffer", buffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		uint32_t particles = renderGraph.CreateTexture("Particles", TextureDesc(128, 128, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+
+		// The first use of a resource may change its state, so Simulate waits
+		// for it. The reads after that don't wait for each other.
+		renderGraph.AddPass("Draw", Nothing)
+			.Read(importedBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			.Write(importedBackBuffer);
+		renderGraph.AddPass("Simulate", Nothing)
+			.Read(importedBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			.Write(particles, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+			.SetAsyncCompute();
+		renderGraph.AddPass("DrawAgain", Nothing)
+			.Read(importedBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			.Write(importedBackBuffer);
+		// Writing what the compute queue reads waits for it, and so does
+		// reading what it writes. Both wait for the same submission, so they
+		// share one.
+		renderGraph.AddPass("Update", Nothing)
+			.Write(importedBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+		renderGraph.AddPass("Composite", Nothing)
+			.Read(particles)
+			.Write(importedBackBuffer);
+		renderGraph.Compile(GetAllocationInfo(device));
+
+		const std::vector<RenderGraph::Submission>& submissions = renderGraph.GetSubmissions();
+		CHECK_EQUAL(4u, submissions.size());
+		if (submissions.size() == 4)
+		{
+			CheckSubmission(submissions[0], false, 0, 0, RenderGraph::InvalidSubmission);
+			CheckSubmission(submissions[1], true, 1, 1, 0);
+			CheckSubmission(submissions[2], false, 2, 2, RenderGraph::InvalidSubmission);
+			CheckSubmission(submissions[3], false, 3, 4, 1);
+		}
+		CHECK_EQUAL(2u, renderGraph.GetStats().QueueWaits);
+	}
+
+	backBuffer = nullptr;
+	buffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(ExecuteWaitsBetweenTheQueues)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	ComPtr<FakeResource> backBuffer = CreateFakeResource();
+	{
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		CommandQueue computeQueue(device, D3D12_COMMAND_LIST_TYPE_COMPUTE);
+		FakeCommandQueue* fakeQueue = static_cast<FakeCommandQueue*>(commandQueue.GetD3D12CommandQueue().Get());
+		FakeCommandQueue* fakeComputeQueue = static_cast<FakeCommandQueue*>(computeQueue.GetD3D12CommandQueue().Get());
+		// Waits for work that is already done are skipped.
+		fakeQueue->SetAutoComplete(false);
+		fakeComputeQueue->SetAutoComplete(false);
+
+		ResourceStateTracker::AddGlobalResourceState(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		ResourceStateTracker resourceStateTracker;
+		RenderGraph renderGraph(device);
+		AddAsyncComputeFrame(renderGraph, backBuffer.Get());
+		renderGraph.Compile();
+
+		ComPtr<ID3D12GraphicsCommandList2> commandList = renderGraph.Execute(commandQueue, commandQueue.GetCommandList(),
+			resourceStateTracker, computeQueue);
+		commandQueue.ExecuteCommandList(commandList, resourceStateTracker);
+
+		using Call = FakeCommandQueue::Call;
+		ID3D12Fence* fence = commandQueue.GetFence().Get();
+		ID3D12Fence* computeFence = computeQueue.GetFence().Get();
+
+		// Depth is submitted before SSAO can wait for it. Shadows is recorded
+		// while SSAO runs, and submitted before Lighting waits for SSAO.
+		std::vector<Call> calls = fakeQueue->GetCalls();
+		CHECK_EQUAL(7u, calls.size());
+		if (calls.size() == 7)
+		{
+			CHECK_EQUAL(Call::Execute, calls[0].CallType);
+			CHECK_EQUAL(Call::Signal, calls[1].CallType);
+			CHECK_EQUAL(1u, calls[1].Value);
+			CHECK_EQUAL(Call::Execute, calls[2].CallType);
+			CHECK_EQUAL(Call::Signal, calls[3].CallType);
+			CHECK_EQUAL(Call::Wait, calls[4].CallType);
+			CHECK(calls[4].Fence == computeFence);
+			CHECK_EQUAL(1u, calls[4].Value);
+			CHECK_EQUAL(Call::Execute, calls[5].CallType);
+			CHECK_EQUAL(Call::Signal, calls[6].CallType);
+		}
+
+		std::vector<Call> computeCalls = fakeComputeQueue->GetCalls();
+		CHECK_EQUAL(3u, computeCalls.size());
+		if (computeCalls.size() == 3)
+		{
+			CHECK_EQUAL(Call::Wait, computeCalls[0].CallType);
+			CHECK(computeCalls[0].Fence == fence);
+			CHECK_EQUAL(1u, computeCalls[0].Value);
+			CHECK_EQUAL(Call::Execute, computeCalls[1].CallType);
+			CHECK_EQUAL(Call::Signal, computeCalls[2].CallType);
+			CHECK_EQUAL(1u, computeCalls[2].Value);
+		}
+
+		ResourceStateTracker::RemoveGlobalResourceState(backBuffer.Get());
+		fakeQueue->SetAutoComplete(true);
+		fakeComputeQueue->SetAutoComplete(true);
+		fakeQueue->CompleteSignals();
+		fakeComputeQueue->CompleteSignals();
+		commandQueue.Flush();
+		computeQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	backBuffer = nullptr;
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
@@ -0,0 +1,289 @@
+#include "FakeD3D12.h"
+#include "ResourceStateTracker.h"
+#include "Test.h"
+
+#include <vector>
+
+using Barriers = std::vector<D3D12_RESOURCE_BARRIER>;
+
+static const UINT AllSubresources = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+static ComPtr<FakeCommandList> CreateFakeCommandList()
+{
+	ComPtr<FakeCommandAllocator> allocator;
+	allocator.Attach(new FakeCommandAllocator());
+	ComPtr<FakeCommandList> commandList;
+	commandList.Attach(new FakeCommandList(allocator));
+	return commandList;
+}
+
+// A resource with a global state, removed again at the end of the test.
+class TrackedResource
+{
+public:
+	explicit TrackedResource(D3D12_RESOURCE_STATES state)
+	{
+		mResource.Attach(new FakeResource());
+		ResourceStateTracker::AddGlobalResourceState(mResource.Get(), state);
+	}
+
+	~TrackedResource()
+	{
+		ResourceStateTracker::RemoveGlobalResourceState(mResource.Get());
+	}
+
+	ID3D12Resource* Get() const
+	{
+		return mResource.Get();
+	}
+
+private:
+	ComPtr<FakeResource> mResource;
+};
+
+// What CommandQueue::ExecuteCommandList does with a tracker: resolve the
+// pending transitions and make the final states global.
+static Barriers Submit(ResourceStateTracker& resourceStateTracker)
+{
+	auto lock = ResourceStateTracker::LockGlobalState();
+	Barriers barriers = resourceStateTracker.ResolvePendingResourceBarriers();
+	resourceStateTracker.CommitFinalResourceStates();
+	return barriers;
+}
+
+static void CheckTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource,
+	D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter, UINT subresource = AllSubresources)
+{
+	CHECK_EQUAL(D3D12_RESOURCE_BARRIER_TYPE_TRANSITION, barrier.Type);
+	CHECK_EQUAL(D3D12_RESOURCE_BARRIER_FLAG_NONE, barrier.Flags);
+	if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+	{
+		CHECK(barrier.Transition.pResource == resource);
+		CHECK_EQUAL(stateBefore, barrier.Transition.StateBefore);
+		CHECK_EQUAL(stateAfter, barrier.Transition.StateAfter);
+		CHECK_EQUAL(subresource, barrier.Transition.Subresource);
+	}
+}
+
+TEST(FirstTransitionIsResolvedAtSubmit)
+{
+	TrackedResource resource(D3D12_RESOURCE_STATE_COMMON);
+	ComPtr<FakeCommandList> commandList = CreateFakeCommandList();
+
+	// Nothing is known about the state before, so nothing is recorded.
+	ResourceStateTracker resourceStateTracker;
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+	CHECK(commandList->GetBarrierCalls().empty());
+
+	Barriers barriers = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, barriers.size());
+	if (barriers.size() == 1)
+	{
+		CheckTransition(barriers[0], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+	CHECK_EQUAL(1u, resourceStateTracker.GetStats().PendingBarriers);
+	CHECK_EQUAL(0u, resourceStateTracker.GetStats().Barriers);
+
+	// The next command list starts from the state the last one left.
+	resourceStateTracker.Reset();
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	barriers = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, barriers.size());
+	if (barriers.size() == 1)
+	{
+		CheckTransition(barriers[0], resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	// A resource that is already in the state needs no barrier at all.
+	resourceStateTracker.Reset();
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	CHECK(Submit(resourceStateTracker).empty());
+	CHECK(TakeFakeErrors().empty());
+}
+
+TEST(TransitionsAreBatchedUntilFlushed)
+{
+	TrackedResource a(D3D12_RESOURCE_STATE_COMMON);
+	TrackedResource b(D3D12_RESOURCE_STATE_COMMON);
+	ComPtr<FakeCommandList> commandList = CreateFakeCommandList();
+
+	ResourceStateTracker resourceStateTracker;
+	resourceStateTracker.TransitionResource(a.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	resourceStateTracker.TransitionResource(b.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	resourceStateTracker.TransitionResource(a.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	// Already in that state.
+	resourceStateTracker.TransitionResource(a.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	resourceStateTracker.TransitionResource(b.Get(), D3D12_RESOURCE_STATE_DEPTH_READ);
+	resourceStateTracker.UAVBarrier(a.Get());
+	resourceStateTracker.AliasBarrier(a.Get(), b.Get());
+	CHECK(commandList->GetBarrierCalls().empty());
+
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+	// Flushing again records nothing.
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+
+	auto calls = commandList->GetBarrierCalls();
+	CHECK_EQUAL(1u, calls.size());
+	if (calls.size() == 1 && calls[0].size() == 4)
+	{
+		const Barriers& barriers = calls[0];
+		CheckTransition(barriers[0], a.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		CheckTransition(barriers[1], b.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_DEPTH_READ);
+		CHECK_EQUAL(D3D12_RESOURCE_BARRIER_TYPE_UAV, barriers[2].Type);
+		CHECK(barriers[2].UAV.pResource == a.Get());
+		CHECK_EQUAL(D3D12_RESOURCE_BARRIER_TYPE_ALIASING, barriers[3].Type);
+		CHECK(barriers[3].Aliasing.pResourceBefore == a.Get());
+		CHECK(barriers[3].Aliasing.pResourceAfter == b.Get());
+	}
+	else
+	{
+		CHECK(!"Expected one call with 4 barriers.");
+	}
+
+	ResourceStateTracker::Stats stats = resourceStateTracker.GetStats();
+	CHECK_EQUAL(4u, stats.Barriers);
+	CHECK_EQUAL(1u, stats.Flushes);
+
+	// The pending transitions are to the first states used.
+	Barriers pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(2u, pending.size());
+	if (pending.size() == 2)
+	{
+		CheckTransition(pending[0], a.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		CheckTransition(pending[1], b.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	}
+	CHECK_EQUAL(2u, resourceStateTracker.GetStats().PendingBarriers);
+
+	resourceStateTracker.Reset();
+	CHECK_EQUAL(0u, resourceStateTracker.GetStats().Barriers);
+	CHECK_EQUAL(0u, resourceStateTracker.GetStats().Flushes);
+	CHECK(TakeFakeErrors().empty());
+}
+
+TEST(WholeResourceTransitionGathersItsSubresources)
+{
+	TrackedResource resource(D3D12_RESOURCE_STATE_COMMON);
+	ComPtr<FakeCommandList> commandList = CreateFakeCommandList();
+
+	ResourceStateTracker resourceStateTracker;
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, 3);
+	// Back in the state of the rest, so it needs no barrier below.
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, 3);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+
+	auto calls = commandList->GetBarrierCalls();
+	CHECK_EQUAL(1u, calls.size());
+	if (calls.size() == 1 && calls[0].size() == 5)
+	{
+		const Barriers& barriers = calls[0];
+		CheckTransition(barriers[0], resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2);
+		CheckTransition(barriers[1], resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE, 3);
+		CheckTransition(barriers[2], resource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, 3);
+		// Subresource 2 is moved back to the state of the rest first.
+		CheckTransition(barriers[3], resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST, 2);
+		CheckTransition(barriers[4], resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	}
+	else
+	{
+		CHECK(!"Expected one call with 5 barriers.");
+	}
+
+	Barriers pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, pending.size());
+	if (pending.size() == 1)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+
+	// The whole resource ended up as a render target.
+	resourceStateTracker.Reset();
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2);
+	pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, pending.size());
+	if (pending.size() == 1)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2);
+	}
+	CHECK(TakeFakeErrors().empty());
+}
+
+TEST(SubresourceStatesCarryOverToTheNextCommandList)
+{
+	TrackedResource resource(D3D12_RESOURCE_STATE_COMMON);
+	ComPtr<FakeCommandList> commandList = CreateFakeCommandList();
+
+	// A command list that only uses two subresources leaves the rest alone.
+	ResourceStateTracker resourceStateTracker;
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, 0);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, 1);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0);
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+
+	auto calls = commandList->GetBarrierCalls();
+	CHECK_EQUAL(1u, calls.size());
+	if (calls.size() == 1 && calls[0].size() == 1)
+	{
+		CheckTransition(calls[0][0], resource.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0);
+	}
+
+	Barriers pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(2u, pending.size());
+	if (pending.size() == 2)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET, 0);
+		CheckTransition(pending[1], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST, 1);
+	}
+
+	// The next command list uses the whole resource. Its pending transition
+	// first moves the two subresources back to the state of the rest.
+	resourceStateTracker.Reset();
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+	pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(3u, pending.size());
+	if (pending.size() == 3)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON, 0);
+		CheckTransition(pending[1], resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON, 1);
+		CheckTransition(pending[2], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	}
+
+	// After that every subresource is in the same state again.
+	resourceStateTracker.Reset();
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, 1);
+	pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, pending.size());
+	if (pending.size() == 1)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST, 1);
+	}
+	CHECK(TakeFakeErrors().empty());
+}
+
+TEST(ResetForgetsTheCommandList)
+{
+	TrackedResource resource(D3D12_RESOURCE_STATE_COMMON);
+	ComPtr<FakeCommandList> commandList = CreateFakeCommandList();
+
+	// A command list that is dropped without being submitted doesn't change
+	// the global state.
+	ResourceStateTracker resourceStateTracker;
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	resourceStateTracker.Reset();
+
+	resourceStateTracker.TransitionResource(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	resourceStateTracker.FlushResourceBarriers(commandList.Get());
+	CHECK(commandList->GetBarrierCalls().empty());
+
+	Barriers pending = Submit(resourceStateTracker);
+	CHECK_EQUAL(1u, pending.size());
+	if (pending.size() == 1)
+	{
+		CheckTransition(pending[0], resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+	CHECK(TakeFakeErrors().empty());
+}
@@ -0,0 +1,112 @@
+// Measures RingAllocator under concurrent producers. Every frame each
+// producer thread makes its allocations, then the frame is retired and the
+// frame the GPU is assumed to have finished is reclaimed. Built with the
+// tests but not run by ctest:
+//
+//   RingAllocatorBenchmark [frames] [allocations per thread and frame] [max threads]
+
+#include "RingAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Frames the fake GPU runs behind the CPU.
+static const uint64_t FramesInFlight = 2;
+static const uint64_t AllocationSize = 256;
+static const uint64_t Alignment = 256;
+
+struct Result
+{
+	double NanosecondsPerAllocation;
+	uint64_t Retries;
+	uint64_t FailedAllocations;
+};
+
+static Result Run(uint32_t numThreads, uint32_t numFrames, uint32_t numAllocations)
+{
+	// Room for every frame in flight, plus the one being recorded.
+	RingAllocator allocator((FramesInFlight + 1) * numThreads * numAllocations * AllocationSize);
+
+	uint64_t frame = 0;
+	std::barrier frameEnd(numThreads, [&]() noexcept
+	{
+		++frame;
+		allocator.Retire(frame);
+		if (frame > FramesInFlight)
+		{
+			allocator.Reclaim(frame - FramesInFlight);
+		}
+	});
+
+	std::atomic<uint64_t> time(0);
+	std::atomic<uint64_t> failedAllocations(0);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		threads.emplace_back([&]()
+		{
+			uint64_t threadTime = 0;
+			uint64_t threadFailures = 0;
+			for (uint32_t j = 0; j < numFrames; ++j)
+			{
+				auto begin = std::chrono::steady_clock::now();
+				for (uint32_t k = 0; k < numAllocations; ++k)
+				{
+					if (allocator.Allocate(AllocationSize, Alignment) == RingAllocator::InvalidOffset)
+					{
+						++threadFailures;
+					}
+				}
+				threadTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+				frameEnd.arrive_and_wait();
+			}
+			time.fetch_add(threadTime);
+			failedAllocations.fetch_add(threadFailures);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	Result result = {};
+	result.NanosecondsPerAllocation = static_cast<double>(time.load()) / (static_cast<uint64_t>(numThreads) * numFrames * numAllocations);
+	result.Retries = allocator.GetRetryCount();
+	result.FailedAllocations = failedAllocations.load();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t numFrames = argc > 1 ? std::atoi(argv[1]) : 1000;
+	uint32_t numAllocations = argc > 2 ? std::atoi(argv[2]) : 1024;
+	uint32_t maxThreads = argc > 3 ? std::atoi(argv[3]) : std::max(std::thread::hardware_concurrency(), 1u);
+	if (numFrames == 0 || numAllocations == 0 || maxThreads == 0)
+	{
+		std::fprintf(stderr, "Usage: %s [frames] [allocations per thread and frame] [max threads]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%u frames, %u allocations of %llu bytes per thread and frame\n",
+		numFrames, numAllocations, static_cast<unsigned long long>(AllocationSize));
+	for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		Result result = Run(numThreads, numFrames, numAllocations);
+		uint64_t allocations = static_cast<uint64_t>(numThreads) * numFrames * numAllocations;
+		std::printf("%2u threads: %7.1f ns per allocation, %10llu CAS retries (%.3f per allocation)",
+			numThreads, result.NanosecondsPerAllocation, static_cast<unsigned long long>(result.Retries),
+			static_cast<double>(result.Retries) / allocations);
+		if (result.FailedAllocations > 0)
+		{
+			std::printf(", %llu failed", static_cast<unsigned long long>(result.FailedAllocations));
+		}
+		std::printf("\n");
+	}
+	return 0;
+}
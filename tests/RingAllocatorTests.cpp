@@ -0,0 +1,202 @@
+#include "RingAllocator.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct Allocation
+{
+	uint64_t offset;
+	uint64_t size;
+	uint64_t alignment;
+};
+
+// Allocations that are in use at the same time must be aligned, inside the
+// ring and must not overlap.
+static void CheckAllocations(std::vector<Allocation> allocations, uint64_t capacity)
+{
+	std::sort(allocations.begin(), allocations.end(), [](const Allocation& a, const Allocation& b) { return a.offset < b.offset; });
+	for (size_t i = 0; i < allocations.size(); ++i)
+	{
+		const Allocation& allocation = allocations[i];
+		CHECK_EQUAL(0u, allocation.offset % allocation.alignment);
+		CHECK(allocation.offset + allocation.size <= capacity);
+		if (i + 1 < allocations.size())
+		{
+			CHECK(allocation.offset + allocation.size <= allocations[i + 1].offset);
+		}
+	}
+}
+
+TEST(AllocationsAreContiguous)
+{
+	RingAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+	CHECK_EQUAL(64u, allocator.Allocate(32, 1));
+	CHECK_EQUAL(128u, allocator.Allocate(16, 64));
+	CHECK_EQUAL(144u, allocator.GetUsedSize());
+	CHECK_EQUAL(256u, allocator.GetCapacity());
+}
+
+TEST(RingWrapsAroundOnceSpaceIsReclaimed)
+{
+	RingAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+	CHECK_EQUAL(64u, allocator.Allocate(64, 1));
+	CHECK_EQUAL(128u, allocator.Allocate(64, 1));
+	allocator.Retire(1);
+
+	// The 64 bytes at the end of the ring are free, but an allocation never
+	// straddles the end, and the start is still in use.
+	CHECK_EQUAL(RingAllocator::InvalidOffset, allocator.Allocate(100, 1));
+
+	allocator.Reclaim(1);
+	CHECK_EQUAL(0u, allocator.GetUsedSize());
+
+	// Skips the 64 bytes at the end and wraps around to the start.
+	CHECK_EQUAL(0u, allocator.Allocate(100, 1));
+	CHECK_EQUAL(164u, allocator.GetUsedSize());
+
+	// The skipped bytes stay in use until the allocation is reclaimed, so
+	// only the 92 bytes up to them are free.
+	CHECK_EQUAL(RingAllocator::InvalidOffset, allocator.Allocate(93, 1));
+	CHECK_EQUAL(100u, allocator.Allocate(92, 1));
+	CHECK_EQUAL(256u, allocator.GetUsedSize());
+}
+
+TEST(AlignmentPaddingAtTheEndOfTheRing)
+{
+	RingAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(200, 1));
+	allocator.Retire(1);
+	allocator.Reclaim(1);
+
+	// Aligning 200 up to 64 is the end of the ring, so the allocation starts
+	// at 0 and the 56 bytes of padding count as used.
+	CHECK_EQUAL(0u, allocator.Allocate(16, 64));
+	CHECK_EQUAL(72u, allocator.GetUsedSize());
+	allocator.Retire(2);
+	allocator.Reclaim(2);
+
+	CHECK_EQUAL(16u, allocator.Allocate(176, 1));
+	allocator.Retire(3);
+	allocator.Reclaim(3);
+
+	// Aligning 232 up to 16 gives 240, and 240 + 32 doesn't fit before the
+	// end: both the alignment padding and the rest of the ring are skipped.
+	CHECK_EQUAL(192u, allocator.Allocate(40, 16));
+	CHECK_EQUAL(0u, allocator.Allocate(32, 16));
+	CHECK_EQUAL(40u + 8u + 16u + 32u, allocator.GetUsedSize());
+}
+
+TEST(AllocationLargerThanTheRingFails)
+{
+	RingAllocator allocator(256);
+	CHECK_EQUAL(RingAllocator::InvalidOffset, allocator.Allocate(257, 1));
+	CHECK_EQUAL(0u, allocator.Allocate(256, 256));
+	CHECK_EQUAL(RingAllocator::InvalidOffset, allocator.Allocate(1, 1));
+	CHECK_EQUAL(256u, allocator.GetUsedSize());
+}
+
+TEST(SpaceIsOnlyReclaimedOnceItsFenceCompletes)
+{
+	RingAllocator allocator(256);
+	CHECK_EQUAL(0u, allocator.Allocate(128, 1));
+	allocator.Retire(1);
+	CHECK_EQUAL(128u, allocator.Allocate(64, 1));
+	allocator.Retire(2);
+	// Nothing was allocated since the last retirement, so there is nothing
+	// for fence value 3 to own.
+	allocator.Retire(3);
+	CHECK_EQUAL(192u, allocator.Allocate(64, 1));
+
+	allocator.Reclaim(0);
+	CHECK_EQUAL(256u, allocator.GetUsedSize());
+
+	allocator.Reclaim(1);
+	CHECK_EQUAL(128u, allocator.GetUsedSize());
+	CHECK_EQUAL(0u, allocator.Allocate(128, 1));
+	CHECK_EQUAL(RingAllocator::InvalidOffset, allocator.Allocate(1, 1));
+
+	// Reclaiming skips past fence values that own nothing; the allocations
+	// made after the last retirement stay in use.
+	allocator.Reclaim(3);
+	CHECK_EQUAL(192u, allocator.GetUsedSize());
+
+	allocator.Retire(4);
+	allocator.Reclaim(4);
+	CHECK_EQUAL(0u, allocator.GetUsedSize());
+}
+
+// Producers allocate concurrently. Between rounds, the allocations of the
+// round are retired and those of the round before are reclaimed, so two
+// rounds are in use at any time, like two frames in flight.
+TEST(ConcurrentAllocationsDoNotOverlap)
+{
+	const uint64_t capacity = 256 * 1024;
+	const int threadCount = 8;
+	const int allocationsPerRound = 64;
+	const uint64_t roundCount = 100;
+
+	RingAllocator allocator(capacity);
+	std::vector<Allocation> previousRound;
+	size_t succeeded = 0;
+	size_t failed = 0;
+
+	for (uint64_t round = 1; round <= roundCount; ++round)
+	{
+		std::vector<std::vector<Allocation>> perThread(threadCount);
+		std::vector<size_t> failures(threadCount, 0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				std::mt19937 random(static_cast<unsigned>(round * threadCount + t));
+				std::uniform_int_distribution<uint64_t> size(1, 256);
+				std::uniform_int_distribution<int> alignmentShift(0, 8);
+				for (int i = 0; i < allocationsPerRound; ++i)
+				{
+					Allocation allocation{ 0, size(random), 1ull << alignmentShift(random) };
+					allocation.offset = allocator.Allocate(allocation.size, allocation.alignment);
+					if (allocation.offset == RingAllocator::InvalidOffset)
+					{
+						++failures[t];
+					}
+					else
+					{
+						perThread[t].push_back(allocation);
+					}
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		std::vector<Allocation> currentRound;
+		for (int t = 0; t < threadCount; ++t)
+		{
+			currentRound.insert(currentRound.end(), perThread[t].begin(), perThread[t].end());
+			failed += failures[t];
+		}
+		succeeded += currentRound.size();
+
+		std::vector<Allocation> inUse = previousRound;
+		inUse.insert(inUse.end(), currentRound.begin(), currentRound.end());
+		CheckAllocations(inUse, capacity);
+		CHECK(allocator.GetUsedSize() <= capacity);
+
+		allocator.Retire(round);
+		allocator.Reclaim(round - 1);
+		previousRound = std::move(currentRound);
+	}
+
+	// Most allocations fit, and the ring is empty once everything is reclaimed.
+	CHECK(succeeded > failed);
+	allocator.Reclaim(roundCount);
+	CHECK_EQUAL(0u, allocator.GetUsedSize());
+}
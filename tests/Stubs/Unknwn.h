@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <type_traits>
+
+// Every interface gets a unique made-up IID the first time it is asked for.
+inline GUID MakeStubGuid()
+{
+	static std::atomic<uint32_t> nextGuid{ 1 };
+	GUID guid = {};
+	guid.Data1 = nextGuid.fetch_add(1, std::memory_order_relaxed);
+	return guid;
+}
+
+template<typename T>
+const GUID& StubUuidOf()
+{
+	static const GUID guid = MakeStubGuid();
+	return guid;
+}
+
+#define __uuidof(T) StubUuidOf<T>()
+#define IID_PPV_ARGS(ppType) StubUuidOf<std::remove_reference_t<decltype(**(ppType))>>(), reinterpret_cast<void**>(ppType)
+
+struct IUnknown
+{
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+	virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
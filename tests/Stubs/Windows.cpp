@@ -0,0 +1,92 @@
+#include "Windows.h"
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+
+struct Event
+{
+	bool ManualReset;
+	bool Signaled;
+};
+
+// One lock for all events keeps waits on several of them simple. The tests
+// only create a handful.
+static std::mutex gEventMutex;
+static std::condition_variable gEventCondition;
+
+HANDLE CreateEvent(SECURITY_ATTRIBUTES* attributes, BOOL manualReset, BOOL initialState, LPCSTR name)
+{
+	assert(!attributes && !name);
+	return new Event{ manualReset != FALSE, initialState != FALSE };
+}
+
+BOOL SetEvent(HANDLE event)
+{
+	{
+		std::lock_guard<std::mutex> lock(gEventMutex);
+		static_cast<Event*>(event)->Signaled = true;
+	}
+	gEventCondition.notify_all();
+	return TRUE;
+}
+
+BOOL ResetEvent(HANDLE event)
+{
+	std::lock_guard<std::mutex> lock(gEventMutex);
+	static_cast<Event*>(event)->Signaled = false;
+	return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+	return WaitForMultipleObjects(1, &handle, FALSE, milliseconds);
+}
+
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds)
+{
+	assert(!waitAll);
+
+	auto signaledIndex = [count, handles]() -> DWORD
+	{
+		for (DWORD i = 0; i < count; ++i)
+		{
+			if (static_cast<Event*>(handles[i])->Signaled)
+			{
+				return i;
+			}
+		}
+		return count;
+	};
+
+	std::unique_lock<std::mutex> lock(gEventMutex);
+	if (milliseconds == INFINITE)
+	{
+		gEventCondition.wait(lock, [&]() { return signaledIndex() < count; });
+	}
+	else if (!gEventCondition.wait_for(lock, std::chrono::milliseconds(milliseconds), [&]() { return signaledIndex() < count; }))
+	{
+		return WAIT_TIMEOUT;
+	}
+
+	DWORD index = signaledIndex();
+	Event* event = static_cast<Event*>(handles[index]);
+	if (!event->ManualReset)
+	{
+		event->Signaled = false;
+	}
+	return WAIT_OBJECT_0 + index;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+	delete static_cast<Event*>(handle);
+	return TRUE;
+}
+
+void OutputDebugStringA(LPCSTR string)
+{
+	std::fputs(string, stderr);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Stand-ins for the parts of the Windows headers that the tested engine
+// sources use, so they build and run with any C++20 compiler. Only what the
+// tests need is declared: using anything else is a compile error instead of
+// a silent difference from Windows.
+//
+// Types have the sizes they have on 64-bit Windows. Unscoped enums without a
+// fixed type are int on MSVC, so the D3D12 stand-ins give them int as well.
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef uint8_t BYTE;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int64_t LONGLONG;
+typedef uint64_t UINT64;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef void* HANDLE;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+
+#define TRUE 1
+#define FALSE 0
+
+#define S_OK ((HRESULT)0)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+
+#define INFINITE 0xFFFFFFFF
+#define DWORD_MAX 0xFFFFFFFFul
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define WAIT_FAILED 0xFFFFFFFF
+
+#define STDMETHODCALLTYPE
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& a, const GUID& b)
+{
+	return std::memcmp(&a, &b, sizeof(GUID)) == 0;
+}
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+struct SECURITY_ATTRIBUTES;
+
+// Events behave like Win32 events: auto-reset ones wake a single wait and
+// reset, manual-reset ones stay signaled until ResetEvent.
+HANDLE CreateEvent(SECURITY_ATTRIBUTES* attributes, BOOL manualReset, BOOL initialState, LPCSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+// Timeouts are in milliseconds. Only waits for any one of the handles are
+// supported.
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+
+void OutputDebugStringA(LPCSTR string);
+
+// The secure CRT overload that takes the size from the array.
+template<size_t Size>
+int swprintf_s(wchar_t (&buffer)[Size], const wchar_t* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int result = std::vswprintf(buffer, Size, format, args);
+	va_end(args);
+	return result;
+}
@@ -0,0 +1,994 @@
+#pragma once
+
+// Stand-ins for the D3D12 declarations the tested engine sources use.
+// Structs and enums have the layouts and values of the real SDK. Interfaces
+// only declare the methods that are called, as pure virtual functions, so
+// the fakes in FakeD3D12.h implement every one of them.
+
+#include <Windows.h>
+#include <Unknwn.h>
+
+#include <climits>
+
+#define DEFINE_STUB_ENUM_FLAG_OPERATORS(ENUMTYPE) \
+	inline constexpr ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(int(a) | int(b)); } \
+	inline constexpr ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(int(a) & int(b)); } \
+	inline constexpr ENUMTYPE operator^(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(int(a) ^ int(b)); } \
+	inline constexpr ENUMTYPE operator~(ENUMTYPE a) { return ENUMTYPE(~int(a)); } \
+	inline ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b) { return a = a | b; } \
+	inline ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b) { return a = a & b; } \
+	inline ENUMTYPE& operator^=(ENUMTYPE& a, ENUMTYPE b) { return a = a ^ b; }
+
+enum DXGI_FORMAT : int
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57,
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT 4194304
+
+enum D3D12_COMMAND_LIST_TYPE : int
+{
+	D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+	D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+	D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+	D3D12_COMMAND_LIST_TYPE_COPY = 3,
+};
+
+enum D3D12_COMMAND_QUEUE_PRIORITY : int
+{
+	D3D12_COMMAND_QUEUE_PRIORITY_NORMAL = 0,
+	D3D12_COMMAND_QUEUE_PRIORITY_HIGH = 100,
+};
+
+enum D3D12_COMMAND_QUEUE_FLAGS : int
+{
+	D3D12_COMMAND_QUEUE_FLAG_NONE = 0,
+	D3D12_COMMAND_QUEUE_FLAG_DISABLE_GPU_TIMEOUT = 0x1,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_COMMAND_QUEUE_FLAGS)
+
+struct D3D12_COMMAND_QUEUE_DESC
+{
+	D3D12_COMMAND_LIST_TYPE Type;
+	INT Priority;
+	D3D12_COMMAND_QUEUE_FLAGS Flags;
+	UINT NodeMask;
+};
+
+enum D3D12_FENCE_FLAGS : int
+{
+	D3D12_FENCE_FLAG_NONE = 0,
+	D3D12_FENCE_FLAG_SHARED = 0x1,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_FENCE_FLAGS)
+
+enum D3D12_RESOURCE_STATES : int
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	D3D12_RESOURCE_STATE_STREAM_OUT = 0x100,
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+	D3D12_RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+	D3D12_RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+	D3D12_RESOURCE_STATE_PRESENT = 0,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+enum D3D12_RESOURCE_BARRIER_TYPE : int
+{
+	D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+	D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+	D3D12_RESOURCE_BARRIER_TYPE_UAV = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS : int
+{
+	D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+	D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+	D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_BARRIER_FLAGS)
+
+enum D3D12_RESOURCE_DIMENSION : int
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4,
+};
+
+enum D3D12_TEXTURE_LAYOUT : int
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+};
+
+enum D3D12_RESOURCE_FLAGS : int
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+	D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE = 0x8,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	UINT64 Alignment;
+	UINT64 Width;
+	UINT Height;
+	UINT16 DepthOrArraySize;
+	UINT16 MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_DEPTH_STENCIL_VALUE
+{
+	FLOAT Depth;
+	UINT8 Stencil;
+};
+
+struct D3D12_CLEAR_VALUE
+{
+	DXGI_FORMAT Format;
+	union
+	{
+		FLOAT Color[4];
+		D3D12_DEPTH_STENCIL_VALUE DepthStencil;
+	};
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+	UINT64 SizeInBytes;
+	UINT64 Alignment;
+};
+
+enum D3D12_HEAP_TYPE : int
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3,
+	D3D12_HEAP_TYPE_CUSTOM = 4,
+};
+
+enum D3D12_CPU_PAGE_PROPERTY : int
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+};
+
+enum D3D12_MEMORY_POOL : int
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+enum D3D12_HEAP_FLAGS : int
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+	D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+	D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+	D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES = 0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+struct D3D12_HEAP_DESC
+{
+	UINT64 SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	UINT64 Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+
+enum D3D12_BLEND : int
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_COLOR = 3,
+	D3D12_BLEND_INV_SRC_COLOR = 4,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6,
+};
+
+enum D3D12_BLEND_OP : int
+{
+	D3D12_BLEND_OP_ADD = 1,
+	D3D12_BLEND_OP_SUBTRACT = 2,
+	D3D12_BLEND_OP_REV_SUBTRACT = 3,
+	D3D12_BLEND_OP_MIN = 4,
+	D3D12_BLEND_OP_MAX = 5,
+};
+
+enum D3D12_LOGIC_OP : int
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_SET = 1,
+	D3D12_LOGIC_OP_COPY = 2,
+	D3D12_LOGIC_OP_NOOP = 4,
+};
+
+enum D3D12_COLOR_WRITE_ENABLE : int
+{
+	D3D12_COLOR_WRITE_ENABLE_RED = 1,
+	D3D12_COLOR_WRITE_ENABLE_GREEN = 2,
+	D3D12_COLOR_WRITE_ENABLE_BLUE = 4,
+	D3D12_COLOR_WRITE_ENABLE_ALPHA = 8,
+	D3D12_COLOR_WRITE_ENABLE_ALL = 15,
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+enum D3D12_DEPTH_WRITE_MASK : int
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1,
+};
+
+enum D3D12_COMPARISON_FUNC : int
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8,
+};
+
+enum D3D12_STENCIL_OP : int
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+	D3D12_STENCIL_OP_ZERO = 2,
+	D3D12_STENCIL_OP_REPLACE = 3,
+	D3D12_STENCIL_OP_INCR_SAT = 4,
+	D3D12_STENCIL_OP_DECR_SAT = 5,
+	D3D12_STENCIL_OP_INVERT = 6,
+	D3D12_STENCIL_OP_INCR = 7,
+	D3D12_STENCIL_OP_DECR = 8,
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC1
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+	BOOL DepthBoundsTestEnable;
+};
+
+enum D3D12_FILL_MODE : int
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3,
+};
+
+enum D3D12_CULL_MODE : int
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3,
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE : int
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1,
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	UINT ForcedSampleCount;
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+
+struct D3D12_RT_FORMAT_ARRAY
+{
+	DXGI_FORMAT RTFormats[8];
+	UINT NumRenderTargets;
+};
+
+enum D3D12_FILTER : int
+{
+	D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D12_FILTER_ANISOTROPIC = 0x55,
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE : int
+{
+	D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR = 2,
+	D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3,
+	D3D12_TEXTURE_ADDRESS_MODE_BORDER = 4,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR_ONCE = 5,
+};
+
+enum D3D12_STATIC_BORDER_COLOR : int
+{
+	D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK = 0,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK = 1,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE = 2,
+};
+
+enum D3D12_SHADER_VISIBILITY : int
+{
+	D3D12_SHADER_VISIBILITY_ALL = 0,
+	D3D12_SHADER_VISIBILITY_VERTEX = 1,
+	D3D12_SHADER_VISIBILITY_HULL = 2,
+	D3D12_SHADER_VISIBILITY_DOMAIN = 3,
+	D3D12_SHADER_VISIBILITY_GEOMETRY = 4,
+	D3D12_SHADER_VISIBILITY_PIXEL = 5,
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+	D3D12_FILTER Filter;
+	D3D12_TEXTURE_ADDRESS_MODE AddressU;
+	D3D12_TEXTURE_ADDRESS_MODE AddressV;
+	D3D12_TEXTURE_ADDRESS_MODE AddressW;
+	FLOAT MipLODBias;
+	UINT MaxAnisotropy;
+	D3D12_COMPARISON_FUNC ComparisonFunc;
+	D3D12_STATIC_BORDER_COLOR BorderColor;
+	FLOAT MinLOD;
+	FLOAT MaxLOD;
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+enum D3D12_PIPELINE_STATE_SUBOBJECT_TYPE : int
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE = 0,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS = 1,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS = 2,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS = 3,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS = 4,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS = 5,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS = 6,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT = 7,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND = 8,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK = 9,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER = 10,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL = 11,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT = 12,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE = 13,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY = 14,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS = 15,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT = 16,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC = 17,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK = 18,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO = 19,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS = 20,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1 = 21,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING = 22,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS = 24,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS = 25,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID = 26,
+};
+
+struct D3D12_PIPELINE_STATE_STREAM_DESC
+{
+	SIZE_T SizeInBytes;
+	void* pPipelineStateSubobjectStream;
+};
+
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	SIZE_T BytecodeLength;
+};
+
+enum D3D12_INPUT_CLASSIFICATION : int
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1,
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+	UINT NumElements;
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE : int
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH = 4,
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS : int
+{
+	D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+	D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG = 0x1,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_PIPELINE_STATE_FLAGS)
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE : int
+{
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF = 1,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF = 2,
+};
+
+struct D3D12_SO_DECLARATION_ENTRY
+{
+	UINT Stream;
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	BYTE StartComponent;
+	BYTE ComponentCount;
+	BYTE OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY* pSODeclaration;
+	UINT NumEntries;
+	const UINT* pBufferStrides;
+	UINT NumStrides;
+	UINT RasterizedStream;
+};
+
+struct D3D12_VIEW_INSTANCE_LOCATION
+{
+	UINT ViewportArrayIndex;
+	UINT RenderTargetArrayIndex;
+};
+
+enum D3D12_VIEW_INSTANCING_FLAGS : int
+{
+	D3D12_VIEW_INSTANCING_FLAG_NONE = 0,
+	D3D12_VIEW_INSTANCING_FLAG_ENABLE_VIEW_INSTANCE_MASKING = 0x1,
+};
+DEFINE_STUB_ENUM_FLAG_OPERATORS(D3D12_VIEW_INSTANCING_FLAGS)
+
+struct D3D12_VIEW_INSTANCING_DESC
+{
+	UINT ViewInstanceCount;
+	const D3D12_VIEW_INSTANCE_LOCATION* pViewInstanceLocations;
+	D3D12_VIEW_INSTANCING_FLAGS Flags;
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void* pCachedBlob;
+	SIZE_T CachedBlobSizeInBytes;
+};
+
+#define D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE 16
+
+enum D3D_PRIMITIVE_TOPOLOGY : int
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+};
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+struct D3D12_VIEWPORT
+{
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+typedef RECT D3D12_RECT;
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+	SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+struct D3D12_DISCARD_REGION;
+
+struct ID3D12Object : IUnknown
+{
+	virtual HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* pData) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetName(LPCWSTR name) = 0;
+};
+
+struct ID3D12DeviceChild : ID3D12Object {};
+struct ID3D12Pageable : ID3D12DeviceChild {};
+struct ID3D12RootSignature : ID3D12DeviceChild {};
+// ID3DBlob is declared in d3dcommon.h, which d3d12.h includes.
+struct ID3D10Blob : IUnknown
+{
+	virtual void* STDMETHODCALLTYPE GetBufferPointer() = 0;
+	virtual SIZE_T STDMETHODCALLTYPE GetBufferSize() = 0;
+};
+typedef ID3D10Blob ID3DBlob;
+
+struct ID3D12PipelineState : ID3D12Pageable
+{
+	virtual HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) = 0;
+};
+struct ID3D12DescriptorHeap : ID3D12Pageable {};
+struct ID3D12Heap : ID3D12Pageable {};
+struct ID3D12Resource : ID3D12Pageable {};
+
+struct ID3D12CommandAllocator : ID3D12Pageable
+{
+	virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+};
+
+struct ID3D12Fence : ID3D12Pageable
+{
+	virtual UINT64 STDMETHODCALLTYPE GetCompletedValue() = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 value, HANDLE hEvent) = 0;
+	virtual HRESULT STDMETHODCALLTYPE Signal(UINT64 value) = 0;
+};
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+	ID3D12Resource* pResource;
+	UINT Subresource;
+	D3D12_RESOURCE_STATES StateBefore;
+	D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+	ID3D12Resource* pResourceBefore;
+	ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+	ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+	D3D12_RESOURCE_BARRIER_TYPE Type;
+	D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	union
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+		D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+		D3D12_RESOURCE_UAV_BARRIER UAV;
+	};
+};
+
+struct ID3D12CommandList : ID3D12DeviceChild {};
+
+struct ID3D12GraphicsCommandList : ID3D12CommandList
+{
+	virtual HRESULT STDMETHODCALLTYPE Close() = 0;
+	virtual HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) = 0;
+	virtual void STDMETHODCALLTYPE ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) = 0;
+	virtual void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion) = 0;
+};
+
+struct ID3D12GraphicsCommandList1 : ID3D12GraphicsCommandList {};
+struct ID3D12GraphicsCommandList2 : ID3D12GraphicsCommandList1 {};
+
+struct ID3D12CommandQueue : ID3D12Pageable
+{
+	virtual void STDMETHODCALLTYPE ExecuteCommandLists(UINT numCommandLists, ID3D12CommandList* const* ppCommandLists) = 0;
+	virtual HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 value) = 0;
+	virtual HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence* pFence, UINT64 value) = 0;
+};
+
+struct ID3D12Device : ID3D12Object
+{
+	virtual HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) = 0;
+	virtual HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator) = 0;
+	virtual HRESULT STDMETHODCALLTYPE CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type,
+		ID3D12CommandAllocator* pCommandAllocator, ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList) = 0;
+	virtual HRESULT STDMETHODCALLTYPE CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** ppFence) = 0;
+	virtual D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT visibleMask,
+		UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) = 0;
+	virtual HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) = 0;
+	virtual HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap* pHeap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* pDesc,
+		D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) = 0;
+};
+
+struct ID3D12PipelineLibrary : ID3D12DeviceChild
+{
+	virtual HRESULT STDMETHODCALLTYPE StorePipeline(LPCWSTR pName, ID3D12PipelineState* pPipeline) = 0;
+	virtual SIZE_T STDMETHODCALLTYPE GetSerializedSize() = 0;
+	virtual HRESULT STDMETHODCALLTYPE Serialize(void* pData, SIZE_T dataSizeInBytes) = 0;
+};
+
+struct ID3D12PipelineLibrary1 : ID3D12PipelineLibrary
+{
+	virtual HRESULT STDMETHODCALLTYPE LoadPipeline(LPCWSTR pName, const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc,
+		REFIID riid, void** ppPipelineState) = 0;
+};
+
+struct ID3D12Device1 : ID3D12Device
+{
+	virtual HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T blobLength,
+		REFIID riid, void** ppPipelineLibrary) = 0;
+};
+
+struct ID3D12Device2 : ID3D12Device1
+{
+	virtual HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc,
+		REFIID riid, void** ppPipelineState) = 0;
+};
+
+// pch.h includes the real d3dx12.h right after this header. Its include guard
+// is defined here so it is skipped, and the few helpers the engine uses from
+// it are defined below instead.
+#define __D3DX12_H__
+
+struct CD3DX12_RESOURCE_BARRIER : public D3D12_RESOURCE_BARRIER
+{
+	CD3DX12_RESOURCE_BARRIER() = default;
+	explicit CD3DX12_RESOURCE_BARRIER(const D3D12_RESOURCE_BARRIER& o) noexcept
+		: D3D12_RESOURCE_BARRIER(o)
+	{}
+
+	static inline CD3DX12_RESOURCE_BARRIER Transition(
+		ID3D12Resource* pResource,
+		D3D12_RESOURCE_STATES stateBefore,
+		D3D12_RESOURCE_STATES stateAfter,
+		UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+		D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE) noexcept
+	{
+		CD3DX12_RESOURCE_BARRIER result = {};
+		D3D12_RESOURCE_BARRIER& barrier = result;
+		result.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		result.Flags = flags;
+		barrier.Transition.pResource = pResource;
+		barrier.Transition.StateBefore = stateBefore;
+		barrier.Transition.StateAfter = stateAfter;
+		barrier.Transition.Subresource = subresource;
+		return result;
+	}
+
+	static inline CD3DX12_RESOURCE_BARRIER Aliasing(
+		ID3D12Resource* pResourceBefore,
+		ID3D12Resource* pResourceAfter) noexcept
+	{
+		CD3DX12_RESOURCE_BARRIER result = {};
+		D3D12_RESOURCE_BARRIER& barrier = result;
+		result.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+		barrier.Aliasing.pResourceBefore = pResourceBefore;
+		barrier.Aliasing.pResourceAfter = pResourceAfter;
+		return result;
+	}
+
+	static inline CD3DX12_RESOURCE_BARRIER UAV(
+		ID3D12Resource* pResource) noexcept
+	{
+		CD3DX12_RESOURCE_BARRIER result = {};
+		D3D12_RESOURCE_BARRIER& barrier = result;
+		result.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.UAV.pResource = pResource;
+		return result;
+	}
+};
+
+struct CD3DX12_HEAP_PROPERTIES : public D3D12_HEAP_PROPERTIES
+{
+	CD3DX12_HEAP_PROPERTIES() = default;
+	explicit CD3DX12_HEAP_PROPERTIES(
+		D3D12_HEAP_TYPE type,
+		UINT creationNodeMask = 1,
+		UINT nodeMask = 1) noexcept
+	{
+		Type = type;
+		CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		CreationNodeMask = creationNodeMask;
+		VisibleNodeMask = nodeMask;
+	}
+};
+
+struct DefaultSampleMask { operator UINT() noexcept { return UINT_MAX; } };
+struct DefaultSampleDesc { operator DXGI_SAMPLE_DESC() noexcept { return DXGI_SAMPLE_DESC{ 1, 0 }; } };
+
+template <typename InnerStructType, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type, typename DefaultArg = InnerStructType>
+class alignas(void*) CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT
+{
+private:
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE pssType;
+	InnerStructType pssInner;
+public:
+	CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT() noexcept : pssType(Type), pssInner(DefaultArg()) {}
+	CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT(InnerStructType const& i) noexcept : pssType(Type), pssInner(i) {}
+	CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT& operator=(InnerStructType const& i) noexcept { pssType = Type; pssInner = i; return *this; }
+	operator InnerStructType const&() const noexcept { return pssInner; }
+	operator InnerStructType&() noexcept { return pssInner; }
+	InnerStructType* operator&() noexcept { return &pssInner; }
+	InnerStructType const* operator&() const noexcept { return &pssInner; }
+};
+
+// d3dx12.h uses its CD3DX12_*_DESC wrappers as the inner types of the
+// blend, depth stencil and rasterizer subobjects. They add no members, so
+// the plain descs give the same layout.
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< ID3D12RootSignature*, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE> CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_INPUT_LAYOUT_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT> CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_PRIMITIVE_TOPOLOGY_TYPE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY> CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS> CD3DX12_PIPELINE_STATE_STREAM_VS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS> CD3DX12_PIPELINE_STATE_STREAM_PS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_BLEND_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND> CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_DEPTH_STENCIL_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL> CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_DEPTH_STENCIL_DESC1, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1> CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< DXGI_FORMAT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT> CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_RASTERIZER_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER> CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_RT_FORMAT_ARRAY, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS> CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< DXGI_SAMPLE_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, DefaultSampleDesc> CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< UINT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, DefaultSampleMask> CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_PIPELINE_STATE_FLAGS, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS> CD3DX12_PIPELINE_STATE_STREAM_FLAGS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< UINT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK> CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_INDEX_BUFFER_STRIP_CUT_VALUE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE> CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS> CD3DX12_PIPELINE_STATE_STREAM_GS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_STREAM_OUTPUT_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT> CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS> CD3DX12_PIPELINE_STATE_STREAM_HS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS> CD3DX12_PIPELINE_STATE_STREAM_DS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS> CD3DX12_PIPELINE_STATE_STREAM_AS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS> CD3DX12_PIPELINE_STATE_STREAM_MS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS> CD3DX12_PIPELINE_STATE_STREAM_CS;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_CACHED_PIPELINE_STATE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO> CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO;
+typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_VIEW_INSTANCING_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING> CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING;
+
+// The stream parser of d3dx12.h, visiting the subobjects above.
+struct ID3DX12PipelineParserCallbacks
+{
+	// Subobject Callbacks
+	virtual void FlagsCb(D3D12_PIPELINE_STATE_FLAGS) {}
+	virtual void NodeMaskCb(UINT) {}
+	virtual void RootSignatureCb(ID3D12RootSignature*) {}
+	virtual void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC&) {}
+	virtual void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE) {}
+	virtual void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE) {}
+	virtual void VSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void GSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC&) {}
+	virtual void HSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void DSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void PSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void CSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void ASCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void MSCb(const D3D12_SHADER_BYTECODE&) {}
+	virtual void BlendStateCb(const D3D12_BLEND_DESC&) {}
+	virtual void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC&) {}
+	virtual void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1&) {}
+	virtual void DSVFormatCb(DXGI_FORMAT) {}
+	virtual void RasterizerStateCb(const D3D12_RASTERIZER_DESC&) {}
+	virtual void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY&) {}
+	virtual void SampleDescCb(const DXGI_SAMPLE_DESC&) {}
+	virtual void SampleMaskCb(UINT) {}
+	virtual void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC&) {}
+	virtual void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE&) {}
+
+	// Error Callbacks
+	virtual void ErrorBadInputParameter(UINT /*ParameterIndex*/) {}
+	virtual void ErrorDuplicateSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE /*DuplicateType*/) {}
+	virtual void ErrorUnknownSubobject(UINT /*UnknownTypeValue*/) {}
+
+	virtual ~ID3DX12PipelineParserCallbacks() = default;
+};
+
+inline D3D12_PIPELINE_STATE_SUBOBJECT_TYPE D3DX12GetBaseSubobjectType(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType) noexcept
+{
+	switch (SubobjectType)
+	{
+	case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1:
+		return D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL;
+	default:
+		return SubobjectType;
+	}
+}
+
+// Calls the callback for one subobject and returns its size in the stream.
+template<typename Subobject, typename Inner>
+inline SIZE_T D3DX12ParseSubobject(BYTE* pStream, ID3DX12PipelineParserCallbacks* pCallbacks,
+	void (ID3DX12PipelineParserCallbacks::*callback)(Inner))
+{
+	(pCallbacks->*callback)(*reinterpret_cast<Subobject*>(pStream));
+	return sizeof(Subobject);
+}
+
+inline HRESULT D3DX12ParsePipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& Desc, ID3DX12PipelineParserCallbacks* pCallbacks)
+{
+	if (pCallbacks == nullptr)
+	{
+		return E_INVALIDARG;
+	}
+
+	if (Desc.SizeInBytes == 0 || Desc.pPipelineStateSubobjectStream == nullptr)
+	{
+		pCallbacks->ErrorBadInputParameter(1); // first parameter issue
+		return E_INVALIDARG;
+	}
+
+	using Callbacks = ID3DX12PipelineParserCallbacks;
+	bool SubobjectSeen[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID] = {};
+	for (SIZE_T CurOffset = 0, SizeOfSubobject = 0; CurOffset < Desc.SizeInBytes; CurOffset += SizeOfSubobject)
+	{
+		BYTE* pStream = static_cast<BYTE*>(Desc.pPipelineStateSubobjectStream) + CurOffset;
+		auto SubobjectType = *reinterpret_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE*>(pStream);
+		if (SubobjectType < 0 || SubobjectType >= D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID)
+		{
+			pCallbacks->ErrorUnknownSubobject(SubobjectType);
+			return E_INVALIDARG;
+		}
+		if (SubobjectSeen[D3DX12GetBaseSubobjectType(SubobjectType)])
+		{
+			pCallbacks->ErrorDuplicateSubobject(SubobjectType);
+			return E_INVALIDARG; // disallow subobject duplicates in a stream
+		}
+		SubobjectSeen[SubobjectType] = true;
+		switch (SubobjectType)
+		{
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE>(pStream, pCallbacks, &Callbacks::RootSignatureCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_VS>(pStream, pCallbacks, &Callbacks::VSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_PS>(pStream, pCallbacks, &Callbacks::PSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_DS>(pStream, pCallbacks, &Callbacks::DSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_HS>(pStream, pCallbacks, &Callbacks::HSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_GS>(pStream, pCallbacks, &Callbacks::GSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_CS>(pStream, pCallbacks, &Callbacks::CSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_AS>(pStream, pCallbacks, &Callbacks::ASCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_MS>(pStream, pCallbacks, &Callbacks::MSCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT>(pStream, pCallbacks, &Callbacks::StreamOutputCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC>(pStream, pCallbacks, &Callbacks::BlendStateCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK>(pStream, pCallbacks, &Callbacks::SampleMaskCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER>(pStream, pCallbacks, &Callbacks::RasterizerStateCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL>(pStream, pCallbacks, &Callbacks::DepthStencilStateCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1>(pStream, pCallbacks, &Callbacks::DepthStencilState1Cb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT>(pStream, pCallbacks, &Callbacks::InputLayoutCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE>(pStream, pCallbacks, &Callbacks::IBStripCutValueCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY>(pStream, pCallbacks, &Callbacks::PrimitiveTopologyTypeCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS>(pStream, pCallbacks, &Callbacks::RTVFormatsCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT>(pStream, pCallbacks, &Callbacks::DSVFormatCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC>(pStream, pCallbacks, &Callbacks::SampleDescCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK>(pStream, pCallbacks, &Callbacks::NodeMaskCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO>(pStream, pCallbacks, &Callbacks::CachedPSOCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_FLAGS>(pStream, pCallbacks, &Callbacks::FlagsCb); break;
+		case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING: SizeOfSubobject = D3DX12ParseSubobject<CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING>(pStream, pCallbacks, &Callbacks::ViewInstancingCb); break;
+		default:
+			pCallbacks->ErrorUnknownSubobject(SubobjectType);
+			return E_INVALIDARG;
+		}
+	}
+
+	return S_OK;
+}
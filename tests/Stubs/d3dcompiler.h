@@ -0,0 +1,3 @@
+#pragma once
+
+// Included by pch.h. Nothing from it is used by the tested sources.
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Unknwn.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Microsoft {
+namespace WRL {
+
+// The parts of WRL's ComPtr the engine uses. As with the real one, taking
+// the address releases the pointer, so it can be passed as an out parameter.
+template<typename T>
+class ComPtr
+{
+public:
+	using InterfaceType = T;
+
+	ComPtr() noexcept
+		: mPtr(nullptr)
+	{}
+
+	ComPtr(std::nullptr_t) noexcept
+		: mPtr(nullptr)
+	{}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+	ComPtr(U* ptr) noexcept
+		: mPtr(ptr)
+	{
+		InternalAddRef();
+	}
+
+	ComPtr(const ComPtr& other) noexcept
+		: mPtr(other.mPtr)
+	{
+		InternalAddRef();
+	}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+	ComPtr(const ComPtr<U>& other) noexcept
+		: mPtr(other.Get())
+	{
+		InternalAddRef();
+	}
+
+	ComPtr(ComPtr&& other) noexcept
+		: mPtr(other.mPtr)
+	{
+		other.mPtr = nullptr;
+	}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+	ComPtr(ComPtr<U>&& other) noexcept
+		: mPtr(other.Detach())
+	{}
+
+	~ComPtr()
+	{
+		InternalRelease();
+	}
+
+	ComPtr& operator=(ComPtr other) noexcept
+	{
+		Swap(other);
+		return *this;
+	}
+
+	ComPtr& operator=(std::nullptr_t) noexcept
+	{
+		Reset();
+		return *this;
+	}
+
+	T* Get() const noexcept { return mPtr; }
+	T* operator->() const noexcept { return mPtr; }
+	explicit operator bool() const noexcept { return mPtr != nullptr; }
+
+	T** operator&()
+	{
+		return ReleaseAndGetAddressOf();
+	}
+
+	T* const* GetAddressOf() const noexcept { return &mPtr; }
+	T** GetAddressOf() noexcept { return &mPtr; }
+
+	T** ReleaseAndGetAddressOf()
+	{
+		InternalRelease();
+		return &mPtr;
+	}
+
+	T* Detach() noexcept
+	{
+		T* ptr = mPtr;
+		mPtr = nullptr;
+		return ptr;
+	}
+
+	void Attach(T* ptr)
+	{
+		InternalRelease();
+		mPtr = ptr;
+	}
+
+	ULONG Reset()
+	{
+		return InternalRelease();
+	}
+
+	void Swap(ComPtr& other) noexcept
+	{
+		std::swap(mPtr, other.mPtr);
+	}
+
+	template<typename U>
+	HRESULT As(U** ptr) const
+	{
+		return mPtr->QueryInterface(StubUuidOf<U>(), reinterpret_cast<void**>(ptr));
+	}
+
+	HRESULT CopyTo(T** ptr) const
+	{
+		InternalAddRef();
+		*ptr = mPtr;
+		return S_OK;
+	}
+
+	template<typename U>
+	bool operator==(const ComPtr<U>& other) const noexcept { return mPtr == other.Get(); }
+	bool operator==(std::nullptr_t) const noexcept { return mPtr == nullptr; }
+
+private:
+	void InternalAddRef() const
+	{
+		if (mPtr)
+		{
+			mPtr->AddRef();
+		}
+	}
+
+	ULONG InternalRelease()
+	{
+		ULONG refCount = 0;
+		if (T* ptr = mPtr)
+		{
+			mPtr = nullptr;
+			refCount = ptr->Release();
+		}
+		return refCount;
+	}
+
+	T* mPtr;
+};
+
+}
+}
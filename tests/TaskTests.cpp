@@ -0,0 +1,171 @@
+#include "CommandQueue.h"
+#include "FakeD3D12.h"
+#include "Task.h"
+#include "Test.h"
+#include "ThreadPool.h"
+
+#include <stdexcept>
+#include <thread>
+
+static ComPtr<FakeDevice> CreateFakeDevice()
+{
+	ComPtr<FakeDevice> device;
+	device.Attach(new FakeDevice());
+	return device;
+}
+
+static FakeCommandQueue* GetFakeQueue(CommandQueue& commandQueue)
+{
+	return static_cast<FakeCommandQueue*>(commandQueue.GetD3D12CommandQueue().Get());
+}
+
+// Submits a command list and continues once the GPU is done with it.
+static Task Submit(CommandQueue& commandQueue, std::thread::id& resumedOn)
+{
+	auto commandList = commandQueue.GetCommandList();
+	co_await commandQueue.ExecuteCommandList(commandList);
+	resumedOn = std::this_thread::get_id();
+}
+
+static Task AwaitTask(Task task, bool& resumed)
+{
+	co_await task;
+	resumed = true;
+}
+
+static Task Throw()
+{
+	throw std::runtime_error("failed");
+	co_return;
+}
+
+static Task Schedule(ThreadPool& threadPool, std::thread::id& resumedOn)
+{
+	co_await threadPool.Schedule();
+	resumedOn = std::this_thread::get_id();
+}
+
+TEST(DefaultTaskIsDone)
+{
+	Task task;
+	CHECK(task.IsDone());
+	task.Wait();
+
+	bool resumed = false;
+	Task awaiting = AwaitTask(task, resumed);
+	CHECK(resumed);
+	CHECK(awaiting.IsDone());
+}
+
+TEST(CoroutineResumesOnThreadPoolOnceFenceCompletes)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		auto threadPool = std::make_shared<ThreadPool>(2);
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT, threadPool);
+		FakeCommandQueue* fakeQueue = GetFakeQueue(commandQueue);
+		fakeQueue->SetAutoComplete(false);
+
+		std::thread::id resumedOn;
+		Task task = Submit(commandQueue, resumedOn);
+		CHECK(!task.IsDone());
+
+		fakeQueue->CompleteSignals();
+		task.Wait();
+		CHECK(task.IsDone());
+		CHECK(resumedOn != std::thread::id());
+		CHECK(resumedOn != std::this_thread::get_id());
+
+		fakeQueue->SetAutoComplete(true);
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(CoroutineDoesNotSuspendOnCompletedFence)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		auto threadPool = std::make_shared<ThreadPool>(2);
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT, threadPool);
+
+		// The fake queue completes the signal right away, so the coroutine
+		// runs to the end before Submit returns.
+		std::thread::id resumedOn;
+		Task task = Submit(commandQueue, resumedOn);
+		CHECK(task.IsDone());
+		CHECK(resumedOn == std::this_thread::get_id());
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(AwaitingTaskResumesAfterItCompletes)
+{
+	ComPtr<FakeDevice> device = CreateFakeDevice();
+	{
+		// Without a thread pool, coroutines resume on the fence watcher thread.
+		CommandQueue commandQueue(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		FakeCommandQueue* fakeQueue = GetFakeQueue(commandQueue);
+		fakeQueue->SetAutoComplete(false);
+
+		std::thread::id resumedOn;
+		bool resumed = false;
+		Task awaiting = AwaitTask(Submit(commandQueue, resumedOn), resumed);
+		CHECK(!resumed);
+		CHECK(!awaiting.IsDone());
+
+		fakeQueue->CompleteSignals();
+		awaiting.Wait();
+		CHECK(resumed);
+		CHECK(resumedOn != std::this_thread::get_id());
+
+		// Awaiting a Task that has already finished doesn't suspend.
+		bool resumedAgain = false;
+		Task finished = Submit(commandQueue, resumedOn);
+		fakeQueue->CompleteSignals();
+		finished.Wait();
+		Task awaitingFinished = AwaitTask(finished, resumedAgain);
+		CHECK(resumedAgain);
+
+		fakeQueue->SetAutoComplete(true);
+		commandQueue.Flush();
+	}
+
+	CHECK(TakeFakeErrors().empty());
+	device = nullptr;
+	CHECK_EQUAL(0, GetLiveFakeObjectCount());
+}
+
+TEST(WaitRethrowsException)
+{
+	Task task = Throw();
+	CHECK(task.IsDone());
+
+	bool thrown = false;
+	try
+	{
+		task.Wait();
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+TEST(ScheduleResumesOnWorkerThread)
+{
+	ThreadPool threadPool(1);
+
+	std::thread::id resumedOn;
+	Task task = Schedule(threadPool, resumedOn);
+	task.Wait();
+	CHECK(resumedOn != std::thread::id());
+	CHECK(resumedOn != std::this_thread::get_id());
+}
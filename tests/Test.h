@@ -0,0 +1,87 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// A minimal test harness. Every test file is its own executable, linked with
+// TestMain.cpp, which runs the TESTs in it (only those whose name contains
+// the first argument, if there is one) and fails if a CHECK did.
+//
+// TEST(RingAllocatorWrapsAround)
+// {
+//     RingAllocator allocator(256);
+//     CHECK_EQUAL(0u, allocator.Allocate(64, 1));
+// }
+//
+// Checks may fail on any thread.
+namespace Test
+{
+	using Function = void (*)();
+
+	struct Case
+	{
+		const char* Name;
+		Function Run;
+	};
+
+	std::vector<Case>& GetCases();
+
+	struct Registrar
+	{
+		Registrar(const char* name, Function run)
+		{
+			GetCases().push_back(Case{ name, run });
+		}
+	};
+
+	void ReportFailure(const char* file, int line, const std::string& message);
+
+	template<typename T>
+	std::string ToString(const T& value)
+	{
+		if constexpr (requires(std::ostream& stream) { stream << value; })
+		{
+			std::ostringstream stream;
+			stream << value;
+			return stream.str();
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			return std::to_string(static_cast<std::underlying_type_t<T>>(value));
+		}
+		else
+		{
+			return "?";
+		}
+	}
+}
+
+#define TEST(name) \
+	static void name(); \
+	static Test::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			Test::ReportFailure(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+		} \
+	} while (false)
+
+// Both values are copied, so class constants like
+// RingAllocator::InvalidOffset can be compared without being defined.
+#define CHECK_EQUAL(expected, actual) \
+	do \
+	{ \
+		const auto checkExpected = (expected); \
+		const auto checkActual = (actual); \
+		if (!(checkExpected == checkActual)) \
+		{ \
+			Test::ReportFailure(__FILE__, __LINE__, "CHECK_EQUAL(" #expected ", " #actual "): expected " + \
+				Test::ToString(checkExpected) + ", got " + Test::ToString(checkActual)); \
+		} \
+	} while (false)
@@ -0,0 +1,67 @@
+#include "Test.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <mutex>
+
+static std::mutex gOutputMutex;
+static std::atomic<int> gFailures{ 0 };
+
+std::vector<Test::Case>& Test::GetCases()
+{
+	static std::vector<Case> cases;
+	return cases;
+}
+
+void Test::ReportFailure(const char* file, int line, const std::string& message)
+{
+	gFailures.fetch_add(1);
+
+	std::lock_guard<std::mutex> lock(gOutputMutex);
+	std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int passed = 0;
+	int failed = 0;
+	for (const Test::Case& testCase : Test::GetCases())
+	{
+		if (filter && !std::strstr(testCase.Name, filter))
+		{
+			continue;
+		}
+
+		std::printf("[ RUN  ] %s\n", testCase.Name);
+		std::fflush(stdout);
+
+		int failures = gFailures.load();
+		try
+		{
+			testCase.Run();
+		}
+		catch (const std::exception& e)
+		{
+			Test::ReportFailure(__FILE__, __LINE__, std::string("unexpected exception: ") + e.what());
+		}
+
+		if (gFailures.load() == failures)
+		{
+			std::printf("[ PASS ] %s\n", testCase.Name);
+			++passed;
+		}
+		else
+		{
+			std::printf("[ FAIL ] %s\n", testCase.Name);
+			++failed;
+		}
+		std::fflush(stdout);
+	}
+
+	std::printf("%d passed, %d failed\n", passed, failed);
+	return failed > 0 ? 1 : 0;
+}